@@ -0,0 +1,413 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ * 
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
+#include "batch.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "general.h"
+#include "performance.h"
+
+#if !defined(_WIN32) && !defined(RARCH_CONSOLE) && !defined(ANDROID) && !defined(EMSCRIPTEN)
+#define HAVE_BATCH_WORKERS
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#ifdef __linux__
+#include <sched.h>
+#endif
+#endif
+
+#define BATCH_MAX_ARGS 32
+#define BATCH_OUTPUT_SIZE 4096
+
+struct batch_job
+{
+   char content[PATH_MAX_LENGTH];
+   char movie[PATH_MAX_LENGTH];
+   unsigned frames;
+
+   int pid;
+   int fd;
+   unsigned cpu;
+   char output[BATCH_OUTPUT_SIZE];
+   size_t output_len;
+
+   bool ok;
+   unsigned frames_run;
+   double fps;
+   char hash[16];
+};
+
+/**
+ * batch_parse_jobs:
+ * @path                 : Path to job list.
+ * @num_jobs             : Number of parsed jobs.
+ *
+ * Returns: array of jobs (must be freed), or NULL on failure.
+ **/
+static struct batch_job *batch_parse_jobs(const char *path,
+      unsigned *num_jobs)
+{
+   char line[PATH_MAX_LENGTH * 2];
+   unsigned count = 0, cap = 0;
+   struct batch_job *jobs = NULL;
+   FILE *file = fopen(path, "r");
+
+   if (!file)
+   {
+      RARCH_ERR("Could not open batch job list: \"%s\".\n", path);
+      return NULL;
+   }
+
+   while (fgets(line, sizeof(line), file))
+   {
+      char *frames, *movie;
+      struct batch_job *job = NULL;
+
+      line[strcspn(line, "\r\n")] = '\0';
+      if (!*line || *line == '#')
+         continue;
+
+      frames = strchr(line, '\t');
+      if (!frames)
+      {
+         RARCH_ERR("Malformed batch job (expected content<TAB>frames[<TAB>movie]): \"%s\".\n",
+               line);
+         continue;
+      }
+      *frames++ = '\0';
+
+      movie = strchr(frames, '\t');
+      if (movie)
+         *movie++ = '\0';
+
+      if (count == cap)
+      {
+         struct batch_job *new_jobs = NULL;
+         cap      = cap ? cap * 2 : 16;
+         new_jobs = (struct batch_job*)realloc(jobs, cap * sizeof(*jobs));
+         if (!new_jobs)
+            break;
+         jobs     = new_jobs;
+      }
+
+      job = &jobs[count++];
+      memset(job, 0, sizeof(*job));
+      strlcpy(job->content, line, sizeof(job->content));
+      if (movie)
+         strlcpy(job->movie, movie, sizeof(job->movie));
+      job->frames = strtoul(frames, NULL, 0);
+      job->fd     = -1;
+   }
+
+   fclose(file);
+
+   *num_jobs = count;
+   return jobs;
+}
+
+#ifdef HAVE_BATCH_WORKERS
+/**
+ * batch_spawn:
+ * @self                 : Path to the RetroArch executable.
+ * @job                  : Job to run.
+ *
+ * Forks a headless worker for @job, pinned to @job->cpu, with
+ * its stdout connected to a pipe.
+ *
+ * Returns: true (1) if the worker was started, otherwise false (0).
+ **/
+static bool batch_spawn(const char *self, struct batch_job *job)
+{
+   char frames[32];
+   int fds[2];
+   unsigned argc = 0;
+   const char *argv[BATCH_MAX_ARGS];
+
+   argv[argc++] = self;
+   argv[argc++] = "--headless";
+   if (g_extern.has_set_libretro)
+   {
+      argv[argc++] = "-L";
+      argv[argc++] = g_settings.libretro;
+   }
+   if (*g_extern.config_path)
+   {
+      argv[argc++] = "-c";
+      argv[argc++] = g_extern.config_path;
+   }
+   if (*g_extern.append_config_path)
+   {
+      argv[argc++] = "--appendconfig";
+      argv[argc++] = g_extern.append_config_path;
+   }
+   if (g_extern.headless.hash_state)
+      argv[argc++] = "--hash-state";
+   if (job->frames)
+   {
+      snprintf(frames, sizeof(frames), "%u", job->frames);
+      argv[argc++] = "--max-frames";
+      argv[argc++] = frames;
+   }
+   if (*job->movie)
+   {
+      argv[argc++] = "-P";
+      argv[argc++] = job->movie;
+      argv[argc++] = "--eof-exit";
+   }
+   argv[argc++] = job->content;
+   argv[argc]   = NULL;
+
+   if (pipe(fds) < 0)
+      return false;
+
+   job->pid = fork();
+   if (job->pid < 0)
+   {
+      close(fds[0]);
+      close(fds[1]);
+      return false;
+   }
+
+   if (job->pid == 0)
+   {
+#if defined(__linux__) && defined(CPU_SET)
+      cpu_set_t set;
+      CPU_ZERO(&set);
+      CPU_SET(job->cpu, &set);
+      sched_setaffinity(0, sizeof(set), &set);
+#endif
+      dup2(fds[1], STDOUT_FILENO);
+      close(fds[0]);
+      close(fds[1]);
+
+      execvp(self, (char * const*)argv);
+      _exit(127);
+   }
+
+   close(fds[1]);
+   job->fd = fds[0];
+   return true;
+}
+
+/**
+ * batch_read:
+ * @job                  : Running job.
+ *
+ * Reads available worker output.
+ *
+ * Returns: false (0) once the worker closed its output, otherwise true (1).
+ **/
+static bool batch_read(struct batch_job *job)
+{
+   ssize_t ret;
+   size_t space = sizeof(job->output) - 1 - job->output_len;
+
+   /* Only the tail of the output carries the report. Once
+    * the buffer is full, keep the last half. */
+   if (!space)
+   {
+      size_t keep = sizeof(job->output) / 2;
+      memmove(job->output, job->output + job->output_len - keep, keep);
+      job->output_len = keep;
+      space           = sizeof(job->output) - 1 - keep;
+   }
+
+   ret = read(job->fd, job->output + job->output_len, space);
+
+   if (ret < 0 && errno == EINTR)
+      return true;
+   if (ret <= 0)
+      return false;
+
+   job->output_len += ret;
+   job->output[job->output_len] = '\0';
+   return true;
+}
+
+/**
+ * batch_finish:
+ * @job                  : Job whose worker closed its output.
+ *
+ * Reaps the worker and parses its final hash and FPS report.
+ **/
+static void batch_finish(struct batch_job *job)
+{
+   int status   = 0;
+   double secs  = 0.0;
+   const char *line = NULL;
+
+   close(job->fd);
+   job->fd = -1;
+
+   while (waitpid(job->pid, &status, 0) < 0 && errno == EINTR);
+
+   if ((line = strstr(job->output, " hash: ")))
+      sscanf(line, " hash: %15s", job->hash);
+
+   if ((line = strstr(job->output, "Ran ")))
+      job->ok = sscanf(line, "Ran %u frames in %lf seconds (%lf FPS)",
+            &job->frames_run, &secs, &job->fps) == 3;
+
+   job->ok = job->ok && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+#endif
+
+int rarch_batch_run(const char *self, const char *job_path,
+      unsigned workers)
+{
+#ifdef HAVE_BATCH_WORKERS
+   unsigned i, num_jobs = 0, next = 0, running = 0, failed = 0;
+   unsigned long long total_frames = 0;
+   unsigned num_cpus;
+   double fps_sum = 0.0;
+   retro_time_t start, elapsed;
+   struct pollfd *fds        = NULL;
+   struct batch_job **active = NULL;
+   struct batch_job *jobs    = batch_parse_jobs(job_path, &num_jobs);
+   long cpus                 = sysconf(_SC_NPROCESSORS_ONLN);
+
+   if (!jobs || !num_jobs)
+   {
+      free(jobs);
+      return 1;
+   }
+
+   num_cpus = cpus > 0 ? (unsigned)cpus : 1;
+   if (!workers)
+      workers = num_cpus;
+   if (workers > num_jobs)
+      workers = num_jobs;
+
+   fds    = (struct pollfd*)calloc(workers, sizeof(*fds));
+   active = (struct batch_job**)calloc(workers, sizeof(*active));
+   if (!fds || !active)
+   {
+      free(fds);
+      free(active);
+      free(jobs);
+      return 1;
+   }
+
+   RARCH_LOG("Running %u batch jobs on %u workers.\n", num_jobs, workers);
+
+   signal(SIGPIPE, SIG_IGN);
+   start = rarch_get_time_usec();
+
+   while (next < num_jobs || running)
+   {
+      unsigned slot;
+
+      /* Fill free worker slots. Slot N is pinned to CPU N. */
+      for (slot = 0; slot < workers && next < num_jobs; slot++)
+      {
+         struct batch_job *job = NULL;
+
+         if (active[slot])
+            continue;
+
+         job      = &jobs[next++];
+         job->cpu = slot % num_cpus;
+
+         if (!batch_spawn(self, job))
+         {
+            RARCH_ERR("Failed to start batch worker for \"%s\".\n",
+                  job->content);
+            job->ok = false;
+            continue;
+         }
+
+         active[slot] = job;
+         running++;
+      }
+
+      /* Every job left may have failed to start. Polling
+       * nothing would then block forever. */
+      if (!running)
+         continue;
+
+      for (slot = 0; slot < workers; slot++)
+      {
+         fds[slot].fd      = active[slot] ? active[slot]->fd : -1;
+         fds[slot].events  = POLLIN;
+         fds[slot].revents = 0;
+      }
+
+      if (poll(fds, workers, -1) < 0)
+      {
+         if (errno == EINTR)
+            continue;
+         break;
+      }
+
+      for (slot = 0; slot < workers; slot++)
+      {
+         if (!active[slot] || !fds[slot].revents)
+            continue;
+
+         if (batch_read(active[slot]))
+            continue;
+
+         batch_finish(active[slot]);
+         active[slot] = NULL;
+         running--;
+      }
+   }
+
+   elapsed = rarch_get_time_usec() - start;
+
+   for (i = 0; i < num_jobs; i++)
+   {
+      struct batch_job *job = &jobs[i];
+
+      printf("%-6s %10u frames %10.1f FPS  hash %-8s  %s\n",
+            job->ok ? "OK" : "FAILED", job->frames_run, job->fps,
+            *job->hash ? job->hash : "-", job->content);
+
+      if (!job->ok)
+         failed++;
+      total_frames += job->frames_run;
+      fps_sum      += job->fps;
+   }
+
+   printf("Batch: %u jobs, %u failed, %llu frames in %.3f seconds "
+         "(%.1f aggregate FPS, %.1f average FPS per job).\n",
+         num_jobs, failed, total_frames, elapsed / 1000000.0,
+         elapsed ? total_frames * 1000000.0 / elapsed : 0.0,
+         fps_sum / num_jobs);
+
+   free(fds);
+   free(active);
+   free(jobs);
+   return failed ? 1 : 0;
+#else
+   (void)self;
+   (void)job_path;
+   (void)workers;
+   (void)batch_parse_jobs;
+   RARCH_ERR("Batch mode is not supported on this platform.\n");
+   return 1;
+#endif
+}
@@ -0,0 +1,51 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ * 
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __RARCH_BATCH_H
+#define __RARCH_BATCH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * rarch_batch_run:
+ * @self                 : Path to the RetroArch executable.
+ * @job_path             : Path to job list.
+ * @workers              : Number of parallel workers, 0 for one
+ *                         per online CPU.
+ *
+ * Runs every job of the job list in a headless RetroArch worker
+ * process. Workers are pinned to CPUs where supported. Each line
+ * of the job list holds tab-separated content path, frame count
+ * and optionally a BSV movie to play back. Empty lines and lines
+ * starting with '#' are ignored.
+ *
+ * Core and config selected on the command line (-L, -c,
+ * --appendconfig, --hash-state) are passed on to every worker.
+ * Prints a report with per-job FPS and final hash, plus
+ * aggregate throughput.
+ *
+ * Returns: 0 if all jobs succeeded, otherwise 1.
+ **/
+int rarch_batch_run(const char *self, const char *job_path,
+      unsigned workers);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
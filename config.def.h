@@ -376,6 +376,12 @@ static const unsigned hard_sync_frames = 0;
  */
 static const unsigned frame_delay = 0;
 
+/* Computes the frame delay automatically from measured present
+ * timestamps and core run time, running the core as late as possible
+ * before the predicted next VSync. Overrides frame_delay.
+ */
+static const bool frame_delay_auto = false;
+
 /* Inserts a black frame inbetween frames.
  * Useful for 120 Hz monitors who want to play 60 Hz material with eliminated 
  * ghosting. video_refresh_rate should still be configured as if it 
@@ -487,6 +493,16 @@ static const bool post_filter_record = false;
 /* Screenshots post-shaded GPU output if available. */
 static const bool gpu_screenshot = true;
 
+/* Encodes screenshots on a background thread. */
+static const bool screenshot_threaded = true;
+
+/* zlib compression level of PNG screenshots (0-9).
+ * Lower levels are faster and try fewer PNG filters. */
+static const unsigned screenshot_compression = 6;
+
+/* Splits PNG filtering of screenshots over this many threads. */
+static const unsigned screenshot_filter_threads = 1;
+
 /* Record post-shaded GPU output instead of raw game footage if available. */
 static const bool gpu_record = false;
 
@@ -41,33 +41,113 @@
 #endif
 #endif
 
+/**
+ * read_content_data:
+ * @path         : path to the content file.
+ * @buf          : buffer of the content file.
+ * @length       : size of the content file that has been read from.
+ * @mapped       : set to true if @buf is a private mapping of the
+ *                 file, which has to be released with unmap_file.
+ *
+ * Maps the content file into memory if possible, so it is paged in
+ * on demand instead of being copied up front. Falls back to reading
+ * the whole file, e.g. for content inside archives. Either way, @buf
+ * is writable, as cores may modify the content in place.
+ *
+ * Returns: true if successful, false on error.
+ **/
+static bool read_content_data(const char *path, void **buf,
+      ssize_t *length, bool *mapped)
+{
+   *mapped = false;
+
+   if (!path_contains_compressed_file(path) &&
+         map_file(path, buf, length))
+   {
+      *mapped = true;
+      return true;
+   }
+
+   return read_file(path, buf, length);
+}
+
+static void free_content_data(void *buf, ssize_t length, bool mapped)
+{
+   if (mapped)
+      unmap_file(buf, length);
+   else
+      free(buf);
+}
+
 /**
  * read_content_file:
  * @path         : buffer of the content file.
  * @buf          : size   of the content file.
  * @length       : size of the content file that has been read from.
+ * @mapped       : set to true if @buf is a private mapping of the
+ *                 file, see read_content_data.
  *
  * Read the content file into memory. Also performs soft patching
  * (see patch_content function) in case soft patching has not been
- * blocked by the enduser.
+ * blocked by the enduser. Patches are applied in place where
+ * possible, a mapped file is then copied on write page by page.
  *
  * Returns: true if successful, false on error.
  **/
 static bool read_content_file(const char *path, void **buf,
-      ssize_t *length)
+      ssize_t *length, bool *mapped)
 {
    uint8_t *ret_buf = NULL;
+   bool patch       = !g_extern.block_patch;
 
    RARCH_LOG("Loading content file: %s.\n", path);
-   if (!read_file(path, (void**) &ret_buf, length))
+   if (!read_content_data(path, (void**) &ret_buf, length, mapped))
       return false;
 
    if (*length <= 0)
+   {
+      free_content_data(ret_buf, *length, *mapped);
       return false;
+   }
 
    /* Attempt to apply a patch. */
-   if (!g_extern.block_patch)
-      patch_content(&ret_buf, length);
+   if (patch)
+   {
+      uint8_t *patched_buf = ret_buf;
+      ssize_t  orig_length = *length;
+
+      if (!patch_content(&patched_buf, length, true))
+      {
+         RARCH_WARN("Reloading unpatched content ...\n");
+         free_content_data(ret_buf, orig_length, *mapped);
+         if (!read_content_data(path, (void**) &ret_buf,
+                  length, mapped))
+            return false;
+      }
+      else if (patched_buf != ret_buf)
+      {
+         free_content_data(ret_buf, orig_length, *mapped);
+         ret_buf = patched_buf;
+         *mapped = false;
+      }
+      else if (*mapped && *length != orig_length)
+      {
+         /* Patched in place, but shrunk. The mapping has to
+          * be released with its original size. */
+         uint8_t *copy = (uint8_t*)malloc(*length + 1);
+
+         if (copy)
+         {
+            memcpy(copy, ret_buf, *length);
+            copy[*length] = '\0';
+         }
+         unmap_file(ret_buf, orig_length);
+         *mapped = false;
+         ret_buf = copy;
+         if (!ret_buf)
+            return false;
+      }
+   }
    
    g_extern.content_crc = crc32_calculate(ret_buf, *length);
 
@@ -319,7 +399,8 @@ void save_ram_file(const char *path, int type)
 }
 
 static bool load_content_dont_need_fullpath(
-      struct retro_game_info *info, unsigned i, const char *path)
+      struct retro_game_info *info, unsigned i, const char *path,
+      bool *mapped)
 {
    ssize_t len;
    /* Load the content into memory. */
@@ -329,9 +410,9 @@ static bool load_content_dont_need_fullpath(
    bool ret = false;
 
    if (i == 0)
-      ret = read_content_file(path, (void**)&info->data, &len);
+      ret = read_content_file(path, (void**)&info->data, &len, mapped);
    else
-      ret = read_file(path, (void**)&info->data, &len);
+      ret = read_content_data(path, (void**)&info->data, &len, mapped);
 
    if (!ret || len < 0)
    {
@@ -427,10 +508,13 @@ static bool load_content(const struct retro_subsystem_info *special,
    struct string_list* additional_path_allocs = string_list_new();
    struct retro_game_info *info = (struct retro_game_info*)
       calloc(content->size, sizeof(*info));
+   bool *mapped = (bool*)calloc(content->size, sizeof(*mapped));
 
-   if (!info)
+   if (!info || !mapped)
    {
       string_list_free(additional_path_allocs);
+      free(info);
+      free(mapped);
       return false;
    }
 
@@ -456,7 +540,8 @@ static bool load_content(const struct retro_subsystem_info *special,
 
       if (!need_fullpath && *path)
       {
-         if (!load_content_dont_need_fullpath(&info[i], i, path))
+         if (!load_content_dont_need_fullpath(&info[i], i, path,
+                  &mapped[i]))
             goto end;
       }
       else
@@ -480,11 +565,12 @@ static bool load_content(const struct retro_subsystem_info *special,
 
 end:
    for (i = 0; i < content->size; i++)
-      free((void*)info[i].data);
+      free_content_data((void*)info[i].data, info[i].size, mapped[i]);
 
    string_list_free(additional_path_allocs);
    if (info)
       free(info);
+   free(mapped);
    return ret;
 }
 
@@ -576,7 +662,10 @@ bool init_content_file(void)
    }
 
 #ifdef HAVE_ZLIB
-   /* Try to extract all content we're going to load if appropriate. */
+   /* Point all content we're going to load at the first matching
+    * file inside its archive if appropriate. It is then either
+    * decompressed straight into memory, or extracted by
+    * load_content_need_fullpath if the core needs a real file. */
    for (i = 0; i < content->size; i++)
    {
       const char *ext = NULL;
@@ -593,22 +682,29 @@ bool init_content_file(void)
       if (ext && !strcasecmp(ext, "zip"))
       {
          char temporary_content[PATH_MAX_LENGTH];
+         struct string_list *members = NULL;
+
+         if (!valid_ext)
+         {
+            RARCH_ERR("Libretro implementation does not have any valid extensions. Cannot unzip without knowing this.\n");
+            goto error;
+         }
 
-         strlcpy(temporary_content, content->elems[i].data,
-               sizeof(temporary_content));
+         members = zlib_get_file_list(content->elems[i].data, valid_ext);
 
-         if (!zlib_extract_first_content_file(temporary_content,
-                  sizeof(temporary_content), valid_ext,
-                  *g_settings.extraction_directory ?
-                  g_settings.extraction_directory : NULL))
+         if (!members || !members->size)
          {
             RARCH_ERR("Failed to extract content from zipped file: %s.\n",
-                  temporary_content);
+                  content->elems[i].data);
+            string_list_free(members);
             goto error;
          }
+
+         fill_pathname_join_delim(temporary_content, content->elems[i].data,
+               members->elems[0].data, '#', sizeof(temporary_content));
+         string_list_free(members);
+
          string_list_set(content, i, temporary_content);
-         string_list_append(g_extern.temporary_content,
-               temporary_content, attr);
       }
    }
 #endif
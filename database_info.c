@@ -23,11 +23,19 @@
 #include <file/file_path.h>
 #include "file_ext.h"
 #include <file/dir_list.h>
+#include "performance.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
 
 #ifdef HAVE_CONFIG_H
 #include "config.h"
 #endif
 
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
+
 int database_open_cursor(libretrodb_t *db,
       libretrodb_cursor_t *cur, const char *query)
 {
@@ -46,111 +54,699 @@ int database_open_cursor(libretrodb_t *db,
    return 0;
 }
 
+/* Chunk size used to stream content through the CRC32 hash. */
+#define DATABASE_SCAN_CHUNK_SIZE (256 * 1024)
+
+/* Hashing is mostly I/O bound, so run more workers than cores
+ * to keep several reads in flight. */
+#define DATABASE_SCAN_MAX_THREADS 16
+
+struct database_info_scan_result
+{
+   char *path;
+   /* Name of the matching database entry, NULL if unknown. */
+   char *name;
+   uint32_t crc;
+};
+
+struct database_info_scan_dir
+{
+   dev_t dev;
+   ino_t ino;
+};
+
+struct database_info_scan
+{
+   char *exts;
+
+   /* Directories still to be listed. */
+   struct string_list *dirs;
+   /* Directories listed so far. Symlinks can lead back
+    * into them, which would otherwise never end. */
+   struct database_info_scan_dir *visited;
+   size_t visited_count;
+   size_t visited_cap;
+   /* Every file found so far, hashed in order. */
+   struct string_list *files;
+   size_t files_ptr;
+   /* Workers currently listing a directory or hashing a file. */
+   unsigned busy;
+
+   /* Results not yet consumed by the main thread. */
+   struct database_info_scan_result *results;
+   size_t results_count;
+   size_t results_cap;
+
+   size_t scanned;
+   size_t matched;
+
+   libretrodb_t *dbs;
+   size_t dbs_count;
+
+   uint8_t *buffer;
+
+#ifdef HAVE_THREADS
+   sthread_t *threads[DATABASE_SCAN_MAX_THREADS];
+   unsigned num_threads;
+   slock_t *lock;
+   scond_t *cond;
+   bool quit;
+#endif
+};
+
+static void database_info_scan_lock(struct database_info_scan *scan)
+{
+#ifdef HAVE_THREADS
+   if (scan->lock)
+      slock_lock(scan->lock);
+#endif
+}
+
+static void database_info_scan_unlock(struct database_info_scan *scan)
+{
+#ifdef HAVE_THREADS
+   if (scan->lock)
+      slock_unlock(scan->lock);
+#endif
+}
+
+static bool database_info_scan_done(struct database_info_scan *scan)
+{
+   return !scan->busy && !scan->dirs->size &&
+      scan->files_ptr >= scan->files->size;
+}
+
+/**
+ * database_info_scan_lookup:
+ * @scan              : Scanner handle.
+ * @crc               : CRC32 of the content.
+ *
+ * Looks up @crc in the 'crc' hash index of every opened database.
+ * The indexes are built when the databases are opened, so lookups
+ * only read and need no locking.
+ *
+ * Returns: name of the matching entry (to be freed by the caller),
+ * or NULL if no database knows about @crc.
+ **/
+static char *database_info_scan_lookup(struct database_info_scan *scan,
+      uint32_t crc)
+{
+   size_t i;
+   uint8_t key[4];
+   char *name = NULL;
+
+   key[0] = (crc >> 24) & 0xff;
+   key[1] = (crc >> 16) & 0xff;
+   key[2] = (crc >>  8) & 0xff;
+   key[3] = (crc >>  0) & 0xff;
+
+   for (i = 0; i < scan->dbs_count && !name; i++)
+   {
+      uint64_t offset;
+      struct rmsgpack_dom_value value;
+
+      if (libretrodb_find_field(&scan->dbs[i], "crc",
+               key, sizeof(key), &offset, 1) < 1)
+         continue;
+
+      /* Only the name is decoded, not the whole entry. */
+      if (libretrodb_read_field(&scan->dbs[i], offset, "name", &value) != 0)
+         continue;
+
+      if (value.type == RDT_STRING)
+         name = strdup(value.string.buff);
+
+      rmsgpack_dom_value_free(&value);
+   }
+
+   return name;
+}
+
+static void database_info_scan_push(struct database_info_scan *scan,
+      const char *path, uint32_t crc)
+{
+   char *name = database_info_scan_lookup(scan, crc);
+   struct database_info_scan_result *result = NULL;
+
+   database_info_scan_lock(scan);
+
+   if (scan->results_count == scan->results_cap)
+   {
+      size_t cap = scan->results_cap ? scan->results_cap * 2 : 64;
+      struct database_info_scan_result *results =
+         (struct database_info_scan_result*)
+         realloc(scan->results, cap * sizeof(*results));
+
+      if (!results)
+      {
+         database_info_scan_unlock(scan);
+         free(name);
+         return;
+      }
+
+      scan->results     = results;
+      scan->results_cap = cap;
+   }
+
+   result       = &scan->results[scan->results_count++];
+   result->path = strdup(path);
+   result->name = name;
+   result->crc  = crc;
+
+   database_info_scan_unlock(scan);
+}
+
 #ifdef HAVE_ZLIB
-static int zlib_compare_crc32(const char *name, const char *valid_exts,
+static int database_info_scan_zip_cb(const char *name, const char *valid_exts,
       const uint8_t *cdata, unsigned cmode, uint32_t csize, uint32_t size,
       uint32_t crc32, void *userdata)
 {
-   RARCH_LOG("CRC32: 0x%x\n", crc32);
+   char path[PATH_MAX_LENGTH];
+   void **args = (void**)userdata;
+   size_t len  = strlen(name);
+
+   /* Skip directory entries. */
+   if (!len || name[len - 1] == '/')
+      return 1;
+
+   /* The central directory already stores the CRC32 of every member,
+    * so there is no need to inflate anything. */
+   snprintf(path, sizeof(path), "%s#%s", (const char*)args[1], name);
+   database_info_scan_push((struct database_info_scan*)args[0], path, crc32);
 
    return 1;
 }
 #endif
 
+#ifdef HAVE_COMPRESSION
+/**
+ * database_info_scan_archive:
+ * @scan              : Scanner handle.
+ * @path              : Path to archive.
+ * @buffer            : Scratch buffer of DATABASE_SCAN_CHUNK_SIZE bytes.
+ *
+ * Hashes every file inside an archive. The CRC32 stored in the
+ * archive is used when there is one, otherwise the member is
+ * decompressed in chunks. Nothing is extracted to disk.
+ **/
+static void database_info_scan_archive(struct database_info_scan *scan,
+      const char *path, uint8_t *buffer)
+{
+   size_t i;
+   struct string_list *members = compressed_file_list_new(path, NULL);
+
+   if (!members)
+   {
+      RARCH_WARN("[Scanner]: Could not process archive \"%s\".\n", path);
+      return;
+   }
+
+   for (i = 0; i < members->size; i++)
+   {
+      char member_path[PATH_MAX_LENGTH];
+      ssize_t len       = 0;
+      uint32_t crc      = 0;
+      compressed_file_t *file = NULL;
+
+      fill_pathname_join_delim(member_path, path,
+            members->elems[i].data, '#', sizeof(member_path));
+
+      file = compressed_file_open(member_path);
+      if (!file)
+         continue;
+
+      if (!compressed_file_crc32(file, &crc))
+      {
+         while ((len = compressed_file_read(file, buffer,
+                     DATABASE_SCAN_CHUNK_SIZE)) > 0)
+            crc = crc32_update(crc, buffer, len);
+      }
+
+      if (compressed_file_close(file) && len == 0)
+         database_info_scan_push(scan, member_path, crc);
+   }
+
+   string_list_free(members);
+}
+#endif
+
+/**
+ * database_info_scan_file:
+ * @scan              : Scanner handle.
+ * @path              : Path to content.
+ * @attr              : Type of the directory entry.
+ * @buffer            : Scratch buffer of DATABASE_SCAN_CHUNK_SIZE bytes.
+ *
+ * Hashes @path and queues the result. Files are streamed through
+ * the hash in chunks, so large content never has to fit in memory.
+ **/
+static void database_info_scan_file(struct database_info_scan *scan,
+      const char *path, int attr, uint8_t *buffer)
+{
+   size_t len;
+   FILE *file   = NULL;
+   uint32_t crc = 0;
+
+#ifdef HAVE_ZLIB
+   if (!strcmp(path_get_extension(path), "zip"))
+   {
+      void *args[2];
+
+      args[0] = scan;
+      args[1] = (void*)path;
+
+      /* Reads the stored CRC32s straight from the central directory. */
+      if (!zlib_parse_file(path, NULL, database_info_scan_zip_cb, args))
+         RARCH_WARN("[Scanner]: Could not process ZIP file \"%s\".\n", path);
+      return;
+   }
+#endif
+#ifdef HAVE_COMPRESSION
+   if (attr == RARCH_COMPRESSED_ARCHIVE)
+   {
+      database_info_scan_archive(scan, path, buffer);
+      return;
+   }
+#endif
+
+   file = fopen(path, "rb");
+   if (!file)
+   {
+      RARCH_WARN("[Scanner]: Could not open \"%s\".\n", path);
+      return;
+   }
+
+   while ((len = fread(buffer, 1, DATABASE_SCAN_CHUNK_SIZE, file)) > 0)
+      crc = crc32_update(crc, buffer, len);
+
+   fclose(file);
+
+   database_info_scan_push(scan, path, crc);
+}
+
+/**
+ * database_info_scan_visit:
+ * @scan              : Scanner handle, not locked by the caller.
+ * @dir               : Directory about to be listed.
+ *
+ * Remembers @dir by device and inode, so that a directory
+ * reached again through a symlink is only listed once.
+ *
+ * Returns: true if @dir should be listed, false if it
+ * was listed before.
+ **/
+static bool database_info_scan_visit(struct database_info_scan *scan,
+      const char *dir)
+{
+   size_t i;
+   struct stat st;
+   bool visit = true;
+
+   /* Without inode numbers there is nothing to compare. */
+   if (stat(dir, &st) != 0 || (!st.st_dev && !st.st_ino))
+      return true;
+
+   database_info_scan_lock(scan);
+
+   for (i = 0; i < scan->visited_count; i++)
+   {
+      if (scan->visited[i].dev == st.st_dev &&
+            scan->visited[i].ino == st.st_ino)
+      {
+         visit = false;
+         break;
+      }
+   }
+
+   if (visit && scan->visited_count == scan->visited_cap)
+   {
+      size_t cap = scan->visited_cap ? scan->visited_cap * 2 : 64;
+      struct database_info_scan_dir *visited =
+         (struct database_info_scan_dir*)
+         realloc(scan->visited, cap * sizeof(*visited));
+
+      if (visited)
+      {
+         scan->visited     = visited;
+         scan->visited_cap = cap;
+      }
+   }
+
+   if (visit && scan->visited_count < scan->visited_cap)
+   {
+      scan->visited[scan->visited_count].dev = st.st_dev;
+      scan->visited[scan->visited_count].ino = st.st_ino;
+      scan->visited_count++;
+   }
+
+   database_info_scan_unlock(scan);
+   return visit;
+}
+
+/**
+ * database_info_scan_step:
+ * @scan              : Scanner handle, locked by the caller.
+ * @buffer            : Scratch buffer of DATABASE_SCAN_CHUNK_SIZE bytes.
+ *
+ * Lists one pending directory or hashes one pending file.
+ * The lock is dropped while doing the actual I/O.
+ *
+ * Returns: true if any work was done, false if there was
+ * nothing to pick up.
+ **/
+static bool database_info_scan_step(struct database_info_scan *scan,
+      uint8_t *buffer)
+{
+   if (scan->dirs->size)
+   {
+      size_t i;
+      struct string_list *list = NULL;
+      char *dir = scan->dirs->elems[--scan->dirs->size].data;
+
+      scan->busy++;
+      database_info_scan_unlock(scan);
+
+      if (database_info_scan_visit(scan, dir))
+         list = dir_list_new(dir, scan->exts, true);
+      else
+         RARCH_LOG("[Scanner]: Skipping \"%s\", already scanned.\n", dir);
+      free(dir);
+
+      database_info_scan_lock(scan);
+      for (i = 0; list && i < list->size; i++)
+      {
+         if (list->elems[i].attr.i == RARCH_DIRECTORY)
+            string_list_append(scan->dirs,
+                  list->elems[i].data, list->elems[i].attr);
+         else
+            string_list_append(scan->files,
+                  list->elems[i].data, list->elems[i].attr);
+      }
+      scan->busy--;
+
+      string_list_free(list);
+      return true;
+   }
+
+   if (scan->files_ptr < scan->files->size)
+   {
+      /* Elements are separately allocated, so the pointer stays
+       * valid while other workers append to the list. */
+      const char *path = scan->files->elems[scan->files_ptr].data;
+      int attr         = scan->files->elems[scan->files_ptr].attr.i;
+
+      scan->files_ptr++;
+      scan->busy++;
+      database_info_scan_unlock(scan);
+
+      database_info_scan_file(scan, path, attr, buffer);
+
+      database_info_scan_lock(scan);
+      scan->busy--;
+      return true;
+   }
+
+   return false;
+}
+
+#ifdef HAVE_THREADS
+static void database_info_scan_thread(void *data)
+{
+   struct database_info_scan *scan = (struct database_info_scan*)data;
+   uint8_t *buffer = (uint8_t*)malloc(DATABASE_SCAN_CHUNK_SIZE);
+
+   if (!buffer)
+      return;
+
+   slock_lock(scan->lock);
+
+   while (!scan->quit)
+   {
+      if (database_info_scan_step(scan, buffer))
+      {
+         /* Listing a directory may have queued work
+          * for idle workers, finishing may end the scan. */
+         scond_broadcast(scan->cond);
+         continue;
+      }
+
+      if (database_info_scan_done(scan))
+         break;
+
+      scond_wait(scan->cond, scan->lock);
+   }
+
+   slock_unlock(scan->lock);
+   free(buffer);
+}
+#endif
+
+static void database_info_scan_free(struct database_info_scan *scan)
+{
+   size_t i;
+
+   if (!scan)
+      return;
+
+#ifdef HAVE_THREADS
+   if (scan->lock)
+   {
+      slock_lock(scan->lock);
+      scan->quit = true;
+      scond_broadcast(scan->cond);
+      slock_unlock(scan->lock);
+   }
+
+   for (i = 0; i < scan->num_threads; i++)
+      sthread_join(scan->threads[i]);
+
+   if (scan->lock)
+      slock_free(scan->lock);
+   if (scan->cond)
+      scond_free(scan->cond);
+#endif
+
+   for (i = 0; i < scan->results_count; i++)
+   {
+      free(scan->results[i].path);
+      free(scan->results[i].name);
+   }
+   free(scan->results);
+
+   for (i = 0; i < scan->dbs_count; i++)
+      libretrodb_close(&scan->dbs[i]);
+   free(scan->dbs);
+
+   string_list_free(scan->dirs);
+   string_list_free(scan->files);
+   free(scan->visited);
+   free(scan->exts);
+   free(scan->buffer);
+   free(scan);
+}
+
+static void database_info_scan_open_databases(struct database_info_scan *scan)
+{
+   size_t i;
+   struct string_list *list = dir_list_new(
+         g_settings.content_database, "rdb", false);
+
+   if (!list)
+      return;
+
+   scan->dbs = (libretrodb_t*)calloc(list->size, sizeof(*scan->dbs));
+
+   for (i = 0; scan->dbs && i < list->size; i++)
+   {
+      libretrodb_t *db = &scan->dbs[scan->dbs_count];
+
+      if (libretrodb_open(list->elems[i].data, db) != 0)
+      {
+         RARCH_WARN("[Scanner]: Could not open database \"%s\".\n",
+               list->elems[i].data);
+         continue;
+      }
+
+      if (libretrodb_create_hash_index(db, "crc") != 0)
+      {
+         RARCH_WARN("[Scanner]: Could not index database \"%s\".\n",
+               list->elems[i].data);
+         libretrodb_close(db);
+         continue;
+      }
+
+      scan->dbs_count++;
+   }
+
+   string_list_free(list);
+}
+
+#ifdef HAVE_THREADS
+static void database_info_scan_start_threads(struct database_info_scan *scan)
+{
+   unsigned i;
+   unsigned num_threads = rarch_get_cpu_cores() * 2;
+
+   if (num_threads > DATABASE_SCAN_MAX_THREADS)
+      num_threads = DATABASE_SCAN_MAX_THREADS;
+
+   scan->lock = slock_new();
+   scan->cond = scond_new();
+
+   if (!scan->lock || !scan->cond)
+      return;
+
+   for (i = 0; i < num_threads; i++)
+   {
+      scan->threads[scan->num_threads] =
+         sthread_create(database_info_scan_thread, scan);
+      if (!scan->threads[scan->num_threads])
+         break;
+      scan->num_threads++;
+   }
+
+   RARCH_LOG("[Scanner]: Using %u threads.\n", scan->num_threads);
+}
+#endif
+
 database_info_rdl_handle_t *database_info_write_rdl_init(const char *dir)
 {
-   const char *exts = "";
+   union string_list_elem_attr attr;
+   const char *exts = NULL;
    database_info_rdl_handle_t *dbl = (database_info_rdl_handle_t*)calloc(1, sizeof(*dbl));
 
    if (!dbl)
       return NULL;
 
+   dbl->scan = (struct database_info_scan*)calloc(1, sizeof(*dbl->scan));
+   if (!dbl->scan)
+      goto error;
+
    if (g_extern.core_info)
       exts = core_info_list_get_all_extensions(g_extern.core_info);
-   
-   dbl->list      = dir_list_new(dir, exts, false);
-   dbl->list_ptr  = 0;
+
+   /* Without any known extensions, hash everything. */
+   if (exts && *exts)
+      dbl->scan->exts = strdup(exts);
+
+   dbl->scan->dirs   = string_list_new();
+   dbl->scan->files  = string_list_new();
+   dbl->scan->buffer = (uint8_t*)malloc(DATABASE_SCAN_CHUNK_SIZE);
+
+   attr.i = RARCH_DIRECTORY;
+
+   if (!dbl->scan->dirs || !dbl->scan->files || !dbl->scan->buffer ||
+         !string_list_append(dbl->scan->dirs, dir, attr))
+      goto error;
+
+   database_info_scan_open_databases(dbl->scan);
+
+#ifdef HAVE_THREADS
+   database_info_scan_start_threads(dbl->scan);
+#endif
+
    dbl->blocking  = false;
    dbl->iterating = true;
 
    return dbl;
+
+error:
+   database_info_scan_free(dbl->scan);
+   free(dbl);
+   return NULL;
 }
 
 void database_info_write_rdl_free(database_info_rdl_handle_t *dbl)
 {
    if (!dbl)
       return;
-   string_list_free(dbl->list);
+   database_info_scan_free(dbl->scan);
    free(dbl);
 }
 
+/**
+ * database_info_write_rdl_iterate:
+ * @dbl               : Scan handle.
+ *
+ * Consumes the results produced by the scan workers and
+ * reports progress. Without worker threads, one directory or
+ * file is processed per call instead.
+ *
+ * Returns: 1 if the scan has finished or is blocked, 0 otherwise,
+ * -1 on error.
+ **/
 int database_info_write_rdl_iterate(database_info_rdl_handle_t *dbl)
 {
-   char parent_dir[PATH_MAX_LENGTH];
-   const char *name = NULL;
+   size_t i, count, total;
+   struct database_info_scan_result *results = NULL;
+   struct database_info_scan *scan = NULL;
+   bool done;
 
-   if (!dbl)
+   if (!dbl || !dbl->scan)
       return -1;
    if (dbl->blocking)
       return 1;
-   if (dbl->list_ptr < dbl->list->size) {}
-   else
-   {
-      dbl->iterating = false;
-      return 1;
-   }
 
-   name = dbl->list->elems[dbl->list_ptr].data;
+   scan = dbl->scan;
 
-   if (!name)
-      return 0;
+   database_info_scan_lock(scan);
 
-   path_parent_dir(parent_dir);
+#ifdef HAVE_THREADS
+   if (!scan->num_threads)
+#endif
+      database_info_scan_step(scan, scan->buffer);
 
-#ifdef HAVE_ZLIB
-   if (!strcmp(path_get_extension(name), "zip"))
-   {
-      RARCH_LOG("[ZIP]: name: %s\n", name);
+   results             = scan->results;
+   count               = scan->results_count;
+   scan->results       = NULL;
+   scan->results_count = 0;
+   scan->results_cap   = 0;
+   total               = scan->files->size;
+   done                = database_info_scan_done(scan);
 
-      if (!zlib_parse_file(name, NULL, zlib_compare_crc32,
-               (void*)parent_dir))
-         RARCH_LOG("Could not process ZIP file.\n");
-   }
-   else
-#endif
-   {
-      char msg[PATH_MAX_LENGTH];
-      ssize_t ret;
-      uint32_t crc, target_crc = 0;
-      uint8_t *ret_buf = NULL;
-      int read_from = 0;
+   database_info_scan_unlock(scan);
 
-      (void)target_crc;
+   for (i = 0; i < count; i++)
+   {
+      if (results[i].name)
+      {
+         RARCH_LOG("[Scanner]: %s: \"%s\" (CRC32: 0x%08x).\n",
+               results[i].path, results[i].name, (unsigned)results[i].crc);
+         scan->matched++;
+      }
+      else
+         RARCH_LOG("[Scanner]: %s: no match (CRC32: 0x%08x).\n",
+               results[i].path, (unsigned)results[i].crc);
+   }
 
-      read_from = read_file(name, (void**)&ret_buf, &ret);
+   scan->scanned += count;
 
-      if (read_from != 1)
-         return 0;
-      if (ret <= 0)
-         return 0;
+   if (count)
+   {
+      char msg[PATH_MAX_LENGTH];
 
       snprintf(msg, sizeof(msg), "%zu/%zu: Scanning %s...\n",
-            dbl->list_ptr, dbl->list->size, name);
+            scan->scanned, total, path_basename(results[count - 1].path));
 
       msg_queue_clear(g_extern.msg_queue);
       msg_queue_push(g_extern.msg_queue, msg, 1, 180);
+   }
 
-      crc = crc32_calculate(ret_buf, ret);
-
-      RARCH_LOG("CRC32: 0x%x .\n", (unsigned)crc);
-
-      if (ret_buf)
-         free(ret_buf);
+   for (i = 0; i < count; i++)
+   {
+      free(results[i].path);
+      free(results[i].name);
    }
+   free(results);
 
-   dbl->list_ptr++;
+   if (!done)
+      return 0;
 
-   return 0;
+   RARCH_LOG("[Scanner]: Scanned %zu entries, %zu matched.\n",
+         scan->scanned, scan->matched);
+
+   dbl->iterating = false;
+   return 1;
 }
 
 static char *bin_to_hex_alloc(const uint8_t *data, size_t len)
@@ -179,7 +775,10 @@ database_info_list_t *database_info_list_new(const char *rdb_path, const char *q
    if ((libretrodb_open(rdb_path, &db)) != 0)
       return NULL;
    if ((database_open_cursor(&db, &cur, query) != 0))
+   {
+      libretrodb_close(&db);
       return NULL;
+   }
 
    database_info_list = (database_info_list_t*)calloc(1, sizeof(*database_info_list));
    if (!database_info_list)
@@ -307,6 +906,9 @@ database_info_list_t *database_info_list_new(const char *rdb_path, const char *q
    database_info_list->list  = database_info;
    database_info_list->count = k;
 
+   libretrodb_cursor_close(&cur);
+   libretrodb_close(&db);
+
    return database_info_list;
 
 error:
@@ -27,12 +27,14 @@
 extern "C" {
 #endif
 
+struct database_info_scan;
+
 typedef struct
 {
    bool blocking;
    bool iterating;
-   size_t list_ptr;
-   struct string_list *list;
+   /* Worker pool state, owned by database_info.c. */
+   struct database_info_scan *scan;
 } database_info_rdl_handle_t;
 
 typedef struct
@@ -20,6 +20,7 @@
 #include <stdint.h>
 #include <sys/types.h>
 
+#include <stdlib.h>
 #include <string.h>
 #include <retro_miscellaneous.h>
 #include <file/file_path.h>
@@ -168,154 +169,203 @@ static SRes ConvertUtf16toCharString(const uint16_t *s, char *outstring)
    return res;
 }
 
-/* Extract the relative path relative_path from a 7z archive 
- * archive_path and allocate a buf for it to write it in.
- * If optional_outfile is set, extract to that instead and don't alloc buffer.
- */
-int read_7zip_file(const char * archive_path,
-      const char *relative_path, void **buf, const char* optional_outfile)
+struct sevenzip_member
 {
    CFileInStream archiveStream;
    CLookToRead lookStream;
    CSzArEx db;
-   SRes res;
    ISzAlloc allocImp;
    ISzAlloc allocTempImp;
-   uint16_t *temp = NULL;
+   uint32_t index;
+   bool extracted;
+
+   uint32_t blockIndex;
+   uint8_t *outBuffer;
+   size_t outBufferSize;
+   size_t offset;
+   size_t size;
+   size_t pos;
+};
+
+static void log_7zip_error(SRes res)
+{
+   if (res == SZ_ERROR_UNSUPPORTED)
+      RARCH_ERR("7Zip decoder doesn't support this archive\n");
+   else if (res == SZ_ERROR_MEM)
+      RARCH_ERR("7Zip decoder could not allocate memory\n");
+   else if (res == SZ_ERROR_CRC)
+      RARCH_ERR("7Zip decoder encountered a CRC error in the archive\n");
+   else
+      RARCH_ERR("\nUnspecified error in 7-ZIP archive, error number was: #%d\n", res);
+}
+
+/**
+ * open_7zip_member:
+ * @archive_path                : path to 7z archive.
+ * @relative_path               : path of the member inside the archive.
+ * @size                        : uncompressed size of the member.
+ * @crc                         : CRC32 of the member, if stored.
+ * @has_crc                     : whether the archive stores a CRC32
+ *                                for the member.
+ *
+ * Opens a member of a 7z archive. Only the archive headers are
+ * read here, the member is decoded on the first read_7zip_member call.
+ *
+ * Returns: handle to be read with read_7zip_member, NULL on error.
+ **/
+void *open_7zip_member(const char *archive_path,
+      const char *relative_path, size_t *size,
+      uint32_t *crc, bool *has_crc)
+{
+   SRes res;
+   uint32_t i;
+   uint16_t *temp  = NULL;
    size_t tempSize = 0;
-   long outsize = -1;
    bool file_found = false;
+   struct sevenzip_member *member = (struct sevenzip_member*)
+      calloc(1, sizeof(*member));
+
+   if (!member)
+      return NULL;
 
    /*These are the allocation routines.
     * Currently using the non-standard 7zip choices. */
-   allocImp.Alloc = SzAlloc;
-   allocImp.Free = SzFree;
-   allocTempImp.Alloc = SzAllocTemp;
-   allocTempImp.Free = SzFreeTemp;
+   member->allocImp.Alloc     = SzAlloc;
+   member->allocImp.Free      = SzFree;
+   member->allocTempImp.Alloc = SzAllocTemp;
+   member->allocTempImp.Free  = SzFreeTemp;
+   member->blockIndex         = 0xFFFFFFFF;
 
-   if (InFile_Open(&archiveStream.file, archive_path))
+   if (InFile_Open(&member->archiveStream.file, archive_path))
    {
       RARCH_ERR("Could not open %s as 7z archive\n.",archive_path);
-      return -1;
-   }
-   else
-   {
-      RARCH_LOG_OUTPUT("Openend archive %s. Now trying to extract %s\n",
-            archive_path,relative_path);
+      free(member);
+      return NULL;
    }
-   FileInStream_CreateVTable(&archiveStream);
-   LookToRead_CreateVTable(&lookStream, False);
-   lookStream.realStream = &archiveStream.s;
-   LookToRead_Init(&lookStream);
+
+   FileInStream_CreateVTable(&member->archiveStream);
+   LookToRead_CreateVTable(&member->lookStream, False);
+   member->lookStream.realStream = &member->archiveStream.s;
+   LookToRead_Init(&member->lookStream);
    CrcGenerateTable();
-   SzArEx_Init(&db);
-   res = SzArEx_Open(&db, &lookStream.s, &allocImp, &allocTempImp);
-   if (res == SZ_OK)
+   SzArEx_Init(&member->db);
+   res = SzArEx_Open(&member->db, &member->lookStream.s,
+         &member->allocImp, &member->allocTempImp);
+
+   for (i = 0; res == SZ_OK && i < member->db.db.NumFiles; i++)
    {
-      uint32_t i;
-      uint32_t blockIndex = 0xFFFFFFFF;
-      uint8_t *outBuffer = 0;
-      size_t outBufferSize = 0;
+      char infile[PATH_MAX_LENGTH];
+      const CSzFileItem *f = member->db.db.Files + i;
+      size_t len;
 
-      for (i = 0; i < db.db.NumFiles; i++)
+      if (f->IsDir)
+         continue;
+
+      len = SzArEx_GetFileNameUtf16(&member->db, i, NULL);
+      if (len > tempSize)
       {
-         size_t offset = 0;
-         size_t outSizeProcessed = 0;
-         const CSzFileItem *f = db.db.Files + i;
-         size_t len;
-         if (f->IsDir)
+         free(temp);
+         tempSize = len;
+         temp = (uint16_t *)malloc(tempSize * sizeof(temp[0]));
+         if (temp == 0)
          {
-            /* We skip over everything which is not a directory. 
-             * FIXME: Why continue then if f->IsDir is true?*/
-            continue;
+            res = SZ_ERROR_MEM;
+            break;
          }
+      }
+      SzArEx_GetFileNameUtf16(&member->db, i, temp);
+      res = ConvertUtf16toCharString(temp,infile);
 
-         len = SzArEx_GetFileNameUtf16(&db, i, NULL);
-         if (len > tempSize)
-         {
-            free(temp);
-            tempSize = len;
-            temp = (uint16_t *)malloc(tempSize * sizeof(temp[0]));
-            if (temp == 0)
-            {
-               res = SZ_ERROR_MEM;
-               break;
-            }
-         }
-         SzArEx_GetFileNameUtf16(&db, i, temp);
-         char infile[PATH_MAX_LENGTH];
-         res = ConvertUtf16toCharString(temp,infile);
+      if (res == SZ_OK && strcmp(infile,relative_path) == 0)
+      {
+         file_found    = true;
+         member->index = i;
+         member->size  = f->Size;
+         *size         = f->Size;
+         *crc          = f->Crc;
+         *has_crc      = f->CrcDefined;
+         break;
+      }
+   }
 
-         uint64_t filesize = f->Size;
+   free(temp);
 
-         (void)filesize;
+   if (res == SZ_OK && file_found)
+      return member;
 
-         if (strcmp(infile,relative_path) == 0)
-         {
-            /* C LZMA SDK does not support chunked extraction - see here:
-             * sourceforge.net/p/sevenzip/discussion/45798/thread/6fb59aaf/
-             * */
-            file_found = true;
-            res = SzArEx_Extract(&db, &lookStream.s, i,&blockIndex,
-                  &outBuffer, &outBufferSize,&offset, &outSizeProcessed,
-                  &allocImp, &allocTempImp);
-            if (res != SZ_OK)
-            {
-               break; /* This goes to the error section. */
-            }
-            outsize = outSizeProcessed;
-            if (optional_outfile != NULL)
-            {
-               FILE* outsink = fopen(optional_outfile,"wb");
-               if (outsink == NULL)
-               {
-                  RARCH_ERR("Could not open outfilepath %s.\n",
-                        optional_outfile);
-                  IAlloc_Free(&allocImp, outBuffer);
-                  SzArEx_Free(&db, &allocImp);
-                  free(temp);
-                  File_Close(&archiveStream.file);
-                  return -1;
-               }
-               fwrite(outBuffer+offset,1,outsize,outsink);
-               fclose(outsink);
-            }
-            else
-            {
-               /*We could either use the 7Zip allocated buffer,
-                * or create our own and use it.
-                * We would however need to realloc anyways, because RetroArch
-                * expects a \0 at the end, therefore we allocate new,
-                * copy and free the old one. */
-               *buf = malloc(outsize + 1);
-               ((char*)(*buf))[outsize] = '\0';
-               memcpy(*buf,outBuffer+offset,outsize);
-            }
-            IAlloc_Free(&allocImp, outBuffer);
-            break;
-         }
+   if (res != SZ_OK)
+      log_7zip_error(res);
+   else
+      RARCH_ERR("File %s not found in %s\n",relative_path,archive_path);
+
+   close_7zip_member(member);
+   return NULL;
+}
+
+/**
+ * read_7zip_member:
+ * @handle                      : handle returned by open_7zip_member.
+ * @data                        : buffer to copy into.
+ * @len                         : size of @data.
+ *
+ * The C LZMA SDK does not support chunked extraction, see
+ * sourceforge.net/p/sevenzip/discussion/45798/thread/6fb59aaf/
+ * so the whole block is decoded on the first call and then
+ * handed out in pieces.
+ *
+ * Returns: number of bytes read, 0 at the end of the member,
+ * -1 on error.
+ **/
+ssize_t read_7zip_member(void *handle, void *data, size_t len)
+{
+   struct sevenzip_member *member = (struct sevenzip_member*)handle;
+
+   if (!member->extracted)
+   {
+      size_t outSizeProcessed = 0;
+      SRes res = SzArEx_Extract(&member->db, &member->lookStream.s,
+            member->index, &member->blockIndex,
+            &member->outBuffer, &member->outBufferSize,
+            &member->offset, &outSizeProcessed,
+            &member->allocImp, &member->allocTempImp);
+
+      if (res != SZ_OK)
+      {
+         log_7zip_error(res);
+         return -1;
       }
+
+      member->size      = outSizeProcessed;
+      member->extracted = true;
    }
-   SzArEx_Free(&db, &allocImp);
-   free(temp);
 
-   File_Close(&archiveStream.file);
+   if (len > member->size - member->pos)
+      len = member->size - member->pos;
 
-   if (res == SZ_OK && file_found == true)
-      return outsize;
+   memcpy(data, member->outBuffer + member->offset + member->pos, len);
+   member->pos += len;
 
-   /* Error handling */
-   if (!file_found)
-      RARCH_ERR("File %s not found in %s\n",relative_path,archive_path);
-   else if (res == SZ_ERROR_UNSUPPORTED)
-      RARCH_ERR("7Zip decoder doesn't support this archive\n");
-   else if (res == SZ_ERROR_MEM)
-      RARCH_ERR("7Zip decoder could not allocate memory\n");
-   else if (res == SZ_ERROR_CRC)
-      RARCH_ERR("7Zip decoder encountered a CRC error in the archive\n");
-   else
-      RARCH_ERR("\nUnspecified error in 7-ZIP archive, error number was: #%d\n", res);
-   return -1;
+   return len;
+}
+
+/**
+ * close_7zip_member:
+ * @handle                      : handle returned by open_7zip_member.
+ *
+ * Returns: always true, 7z members are CRC checked while decoding.
+ **/
+bool close_7zip_member(void *handle)
+{
+   struct sevenzip_member *member = (struct sevenzip_member*)handle;
+
+   if (!member)
+      return true;
+
+   IAlloc_Free(&member->allocImp, member->outBuffer);
+   SzArEx_Free(&member->db, &member->allocImp);
+   File_Close(&member->archiveStream.file);
+   free(member);
+   return true;
 }
 
 struct string_list *compressed_7zip_file_list_new(const char *path,
@@ -409,7 +459,9 @@ struct string_list *compressed_7zip_file_list_new(const char *path,
 
          union string_list_elem_attr attr;
 
-         if (string_list_find_elem_prefix(ext_list, ".", file_ext))
+         /* No extension list means every file is wanted. */
+         if (!ext_list ||
+               string_list_find_elem_prefix(ext_list, ".", file_ext))
             supported_by_core = true;
 
          /*
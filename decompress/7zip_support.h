@@ -17,12 +17,22 @@
 #ifndef __RARCH_7ZIP_SUPPORT_H
 #define __RARCH_7ZIP_SUPPORT_H
 
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <boolean.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-int read_7zip_file(const char * archive_path,
-      const char *relative_path, void **buf, char const* optional_outfileq);
+void *open_7zip_member(const char *archive_path,
+      const char *relative_path, size_t *size,
+      uint32_t *crc, bool *has_crc);
+
+ssize_t read_7zip_member(void *handle, void *data, size_t len);
+
+bool close_7zip_member(void *handle);
 
 struct string_list *compressed_7zip_file_list_new(const char *path,
       const char* ext);
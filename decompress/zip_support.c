@@ -20,6 +20,7 @@
 #include <stdint.h>
 #include <sys/types.h>
 
+#include <stdlib.h>
 #include <string.h>
 #include <retro_miscellaneous.h>
 #include <file/file_path.h>
@@ -27,166 +28,122 @@
 
 #include "../deps/rzlib/unzip.h"
 
-/* Undefined at the end of the file
- * Don't use outside of this file
- */
-#define RARCH_ZIP_SUPPORT_BUFFER_SIZE_MAX 16384
-
-/* Extract the relative path relative_path from a 
- * zip archive archive_path and allocate a buf for it to write it in. */
-/* This code is inspired by:
- * stackoverflow.com/questions/10440113/simple-way-to-unzip-a-zip-file-using-zlib
+struct zip_member
+{
+   unzFile zipfile;
+};
+
+/**
+ * open_zip_member:
+ * @archive_path                : path to ZIP archive.
+ * @relative_path               : path of the member inside the archive.
+ * @size                        : uncompressed size of the member.
+ * @crc                         : CRC32 of the member, as stored in
+ *                                the archive.
  *
- * optional_outfile if not NULL will be used to extract the file. buf will be 0
- * then.
- */
-
-int read_zip_file(const char * archive_path,
-      const char *relative_path, void **buf, const char* optional_outfile)
+ * Opens a member of a ZIP archive for streaming decompression.
+ *
+ * Returns: handle to be read with read_zip_member, NULL on error.
+ **/
+void *open_zip_member(const char *archive_path,
+      const char *relative_path, size_t *size, uint32_t *crc)
 {
-   uLong i;
-   unz_global_info global_info;
-   ssize_t bytes_read = -1;
-   bool finished_reading = false;
-   unzFile *zipfile = (unzFile*)unzOpen( archive_path );
+   unz_file_info file_info;
+   struct zip_member *member = NULL;
+   unzFile zipfile           = unzOpen(archive_path);
 
    if (!zipfile)
    {
-      RARCH_ERR("Could not open ZIP file %s.\n",archive_path);
-      return -1;
+      RARCH_ERR("Could not open ZIP file %s.\n", archive_path);
+      return NULL;
    }
 
-   /* Get info about the zip file */
-   if (unzGetGlobalInfo(zipfile, &global_info) != UNZ_OK)
+   if (unzLocateFile(zipfile, relative_path, 1) != UNZ_OK)
    {
-      RARCH_ERR("Could not get global ZIP file info of %s."
-                "Could be only a GZIP file without the ZIP part.\n",
-                archive_path);
-      unzClose(zipfile);
-      return -1;
+      RARCH_ERR("File %s not found in %s\n", relative_path, archive_path);
+      goto error;
    }
 
-   for ( i = 0; i < global_info.number_entry; ++i )
+   if (unzGetCurrentFileInfo(zipfile, &file_info,
+            NULL, 0, NULL, 0, NULL, 0) != UNZ_OK)
    {
-      /* Get info about current file. */
-      unz_file_info file_info;
-      char filename[PATH_MAX_LENGTH];
-      char last_char = ' ';
-
-      if (unzGetCurrentFileInfo(
-            zipfile,
-            &file_info,
-            filename,
-            PATH_MAX_LENGTH,
-            NULL, 0, NULL, 0 ) != UNZ_OK )
-      {
-         RARCH_ERR("Could not read file info in ZIP %s.\n",
-               archive_path);
-         unzClose(zipfile);
-         return -1;
-      }
-
-      /* Check if this entry is a directory or file. */
-      last_char = filename[strlen(filename)-1];
-      if ( last_char == '/' || last_char == '\\' )
-      {
-         /* We skip directories */
-      }
-      else if (strcmp(filename,relative_path) == 0)
-      {
-         /* We found the correct file in the zip, now extract it to *buf */
-         if (unzOpenCurrentFile(zipfile) != UNZ_OK )
-         {
-            RARCH_ERR("The file %s in %s could not be read.\n", 
-                  relative_path, archive_path);
-            unzClose(zipfile);
-            return -1;
-         }
-
-         if (optional_outfile != 0)
-         {
-            char read_buffer[RARCH_ZIP_SUPPORT_BUFFER_SIZE_MAX];
-            FILE* outsink = fopen(optional_outfile,"wb");
-            if (outsink == NULL)
-            {
-               RARCH_ERR("Could not open outfilepath %s.\n", optional_outfile);
-               unzCloseCurrentFile(zipfile);
-               unzClose(zipfile);
-               return -1;
-            }
-            bytes_read = 0;
-            do
-            {
-               ssize_t fwrite_bytes;
-
-               bytes_read = unzReadCurrentFile(zipfile, read_buffer,
-                     RARCH_ZIP_SUPPORT_BUFFER_SIZE_MAX );
-               fwrite_bytes = fwrite(read_buffer,1,bytes_read,outsink);
-
-               if (fwrite_bytes == bytes_read)
-                  continue;
-
-               /* couldn't write all bytes */
-               RARCH_ERR("Error writing to %s.\n",optional_outfile);
-               fclose(outsink);
-               unzCloseCurrentFile(zipfile);
-               unzClose(zipfile);
-               return -1;
-            }while(bytes_read > 0);
-
-            fclose(outsink);
-         }
-         else
-         {
-            /* Allocate outbuffer */
-            *buf = malloc(file_info.uncompressed_size + 1 );
-
-            bytes_read = unzReadCurrentFile(zipfile, *buf, file_info.uncompressed_size);
-
-            if (bytes_read != (ssize_t)file_info.uncompressed_size)
-            {
-               RARCH_ERR(
-                  "Tried to read %d bytes, but only got %d of file %s in ZIP %s.\n",
-                  (unsigned int) file_info.uncompressed_size, (int)bytes_read,
-                  relative_path, archive_path);
-               free(*buf);
-               unzCloseCurrentFile(zipfile);
-               unzClose(zipfile);
-
-               return -1;
-            }
-            ((char*)(*buf))[file_info.uncompressed_size] = '\0';
-         }
-         finished_reading = true;
-      }
+      RARCH_ERR("Could not read file info in ZIP %s.\n", archive_path);
+      goto error;
+   }
 
-      unzCloseCurrentFile(zipfile);
+   if (unzOpenCurrentFile(zipfile) != UNZ_OK)
+   {
+      RARCH_ERR("The file %s in %s could not be read.\n",
+            relative_path, archive_path);
+      goto error;
+   }
 
-      if (finished_reading)
-         break;
+   member = (struct zip_member*)calloc(1, sizeof(*member));
+   if (!member)
+   {
+      unzCloseCurrentFile(zipfile);
+      goto error;
+   }
 
-      if ((i + 1) < global_info.number_entry)
-      {
-         if (unzGoToNextFile(zipfile) == UNZ_OK)
-            continue;
+   member->zipfile = zipfile;
+   *size           = file_info.uncompressed_size;
+   *crc            = file_info.crc;
 
-         RARCH_ERR(
-               "Could not iterate to next file in %s. ZIP file might be corrupt.\n",
-               archive_path );
-         unzClose(zipfile);
-         return -1;
-      }
-   }
+   return member;
 
+error:
    unzClose(zipfile);
+   return NULL;
+}
 
-   if(!finished_reading)
-   {
-      RARCH_ERR("File %s not found in %s\n", relative_path, archive_path);
+/**
+ * read_zip_member:
+ * @handle                      : handle returned by open_zip_member.
+ * @data                        : buffer to decompress into.
+ * @len                         : size of @data.
+ *
+ * Inflates the next @len bytes of the member straight into @data.
+ *
+ * Returns: number of bytes read, 0 at the end of the member,
+ * -1 on error.
+ **/
+ssize_t read_zip_member(void *handle, void *data, size_t len)
+{
+   struct zip_member *member = (struct zip_member*)handle;
+   int ret;
+
+   /* unzReadCurrentFile takes an unsigned length. */
+   if (len > 0x7fffffff)
+      len = 0x7fffffff;
+
+   ret = unzReadCurrentFile(member->zipfile, data, len);
+   if (ret < 0)
       return -1;
+   return ret;
+}
+
+/**
+ * close_zip_member:
+ * @handle                      : handle returned by open_zip_member.
+ *
+ * Returns: false if the member was read completely and its CRC32
+ * did not match the stored one, otherwise true.
+ **/
+bool close_zip_member(void *handle)
+{
+   struct zip_member *member = (struct zip_member*)handle;
+   bool ret                  = true;
+
+   if (!member)
+      return true;
+
+   if (unzCloseCurrentFile(member->zipfile) == UNZ_CRCERROR)
+   {
+      RARCH_ERR("CRC error in ZIP member.\n");
+      ret = false;
    }
 
-   return bytes_read;
+   unzClose(member->zipfile);
+   free(member);
+   return ret;
 }
-
-#undef RARCH_ZIP_SUPPORT_BUFFER_SIZE_MAX
@@ -17,12 +17,21 @@
 #ifndef __RARCH_ZIP_SUPPORT_H
 #define __RARCH_ZIP_SUPPORT_H
 
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <boolean.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-int read_zip_file(const char * archive_path,
-      const char *relative_path, void **buf, const char* optional_outfile);
+void *open_zip_member(const char *archive_path,
+      const char *relative_path, size_t *size, uint32_t *crc);
+
+ssize_t read_zip_member(void *handle, void *data, size_t len);
+
+bool close_zip_member(void *handle);
 
 #ifdef __cplusplus
 }
@@ -282,6 +282,10 @@ typedef struct driver
     * TODO: Refactor this better. */
    bool gfx_use_rgba;
 
+   /* Set by the video driver if it takes 0RGB1555 frames as-is,
+    * so that the frontend no longer has to convert them. */
+   bool gfx_native_0rgb1555;
+
 #ifdef HAVE_OVERLAY
    input_overlay_t *overlay;
    input_overlay_state_t overlay_state;
@@ -65,6 +65,11 @@
 #include <unistd.h>
 #endif
 
+#ifdef HAVE_MMAP
+#include <sys/mman.h>
+#include <fcntl.h>
+#endif
+
 /**
  * write_file:
  * @path             : path to file.
@@ -152,38 +157,31 @@ error:
 }
 
 #ifdef HAVE_COMPRESSION
-/* Generic compressed file loader.
- * Extracts to buf, unless optional_filename != 0
- * Then extracts to optional_filename and leaves buf alone.
- */
-bool read_compressed_file(const char * path, void **buf,
-      const char* optional_filename, ssize_t *length)
+/* Chunk size used when extracting to a file. */
+#define COMPRESSED_FILE_CHUNK_SIZE (256 * 1024)
+
+struct compressed_file
+{
+   void *handle;
+   ssize_t (*read)(void *handle, void *data, size_t len);
+   bool (*close)(void *handle);
+   size_t size;
+   uint32_t crc;
+   bool has_crc;
+};
+
+compressed_file_t *compressed_file_open(const char *path)
 {
    const char* file_ext;
    char archive_path[PATH_MAX_LENGTH], *archive_found = NULL;
-
-   if (optional_filename)
-   {
-      /* Safety check.
-       * If optional_filename and optional_filename 
-       * exists, we simply return 0,
-       * hoping that optional_filename is the 
-       * same as requested.
-       */
-      if(path_file_exists(optional_filename))
-      {
-         *length = 0;
-         return true;
-      }
-   }
+   compressed_file_t *file = NULL;
 
    //We split carchive path and relative path:
    strlcpy(archive_path,path,sizeof(archive_path));
    archive_found = (char*)strchr(archive_path,'#');
-   rarch_assert(archive_found != NULL);
 
    //We assure that there is something after the '#' symbol
-   if (strlen(archive_found) <= 1)
+   if (!archive_found || strlen(archive_found) <= 1)
    {
       /*
        * This error condition happens for example, when
@@ -192,8 +190,7 @@ bool read_compressed_file(const char * path, void **buf,
        */
       RARCH_ERR("Could not extract image path and carchive path from "
             "path: %s.\n", path);
-      *length = 0;
-      return false;
+      return NULL;
    }
 
    /* We split the string in two, by putting a \0, where the hash was: */
@@ -201,25 +198,275 @@ bool read_compressed_file(const char * path, void **buf,
    archive_found  += 1;
    file_ext        = path_get_extension(archive_path);
 
+   file = (compressed_file_t*)calloc(1, sizeof(*file));
+   if (!file)
+      return NULL;
+
 #ifdef HAVE_7ZIP
    if (strcasecmp(file_ext,"7z") == 0)
    {
-      *length = read_7zip_file(archive_path,archive_found,buf,optional_filename);
-      if (*length != -1)
-         return true;
+      file->handle = open_7zip_member(archive_path, archive_found,
+            &file->size, &file->crc, &file->has_crc);
+      file->read   = read_7zip_member;
+      file->close  = close_7zip_member;
    }
 #endif
 #ifdef HAVE_ZLIB
    if (strcasecmp(file_ext,"zip") == 0)
    {
-      *length = read_zip_file(archive_path,archive_found,buf,optional_filename);
-      if (*length != -1)
+      file->handle  = open_zip_member(archive_path, archive_found,
+            &file->size, &file->crc);
+      file->has_crc = true;
+      file->read    = read_zip_member;
+      file->close   = close_zip_member;
+   }
+#endif
+
+   if (!file->handle)
+   {
+      free(file);
+      return NULL;
+   }
+
+   return file;
+}
+
+size_t compressed_file_size(compressed_file_t *file)
+{
+   return file->size;
+}
+
+bool compressed_file_crc32(compressed_file_t *file, uint32_t *crc)
+{
+   *crc = file->crc;
+   return file->has_crc;
+}
+
+ssize_t compressed_file_read(compressed_file_t *file, void *data, size_t len)
+{
+   return file->read(file->handle, data, len);
+}
+
+bool compressed_file_close(compressed_file_t *file)
+{
+   bool ret;
+
+   if (!file)
+      return true;
+
+   ret = file->close(file->handle);
+   free(file);
+   return ret;
+}
+
+/* Generic compressed file loader.
+ * Extracts to buf, unless optional_filename != 0
+ * Then extracts to optional_filename and leaves buf alone.
+ */
+bool read_compressed_file(const char * path, void **buf,
+      const char* optional_filename, ssize_t *length)
+{
+   size_t size;
+   bool closed;
+   ssize_t ret             = 0;
+   uint8_t *data           = NULL;
+   size_t total            = 0;
+   FILE *outsink           = NULL;
+   compressed_file_t *file = NULL;
+
+   if (optional_filename)
+   {
+      /* Safety check.
+       * If optional_filename and optional_filename 
+       * exists, we simply return 0,
+       * hoping that optional_filename is the 
+       * same as requested.
+       */
+      if(path_file_exists(optional_filename))
+      {
+         *length = 0;
          return true;
+      }
+   }
+
+   *length = 0;
+
+   file = compressed_file_open(path);
+   if (!file)
+      return false;
+
+   size = compressed_file_size(file);
+
+   if (optional_filename)
+   {
+      outsink = fopen(optional_filename, "wb");
+      if (!outsink)
+      {
+         RARCH_ERR("Could not open outfilepath %s.\n", optional_filename);
+         goto error;
+      }
+      data = (uint8_t*)malloc(COMPRESSED_FILE_CHUNK_SIZE);
+      if (!data)
+         goto error;
+
+      while ((ret = compressed_file_read(file, data,
+                  COMPRESSED_FILE_CHUNK_SIZE)) > 0)
+      {
+         if (fwrite(data, 1, ret, outsink) != (size_t)ret)
+         {
+            RARCH_ERR("Error writing to %s.\n", optional_filename);
+            goto error;
+         }
+         total += ret;
+      }
+
+      free(data);
+      data = NULL;
+
+      if (fclose(outsink) != 0)
+      {
+         outsink = NULL;
+         goto error;
+      }
+      outsink = NULL;
    }
+   else
+   {
+      /* Decompress straight into the buffer handed to the core.
+       * RetroArch expects a \0 at the end. */
+      data = (uint8_t*)malloc(size + 1);
+      if (!data)
+         goto error;
+
+      while (total < size && (ret = compressed_file_read(file,
+                  data + total, size - total)) > 0)
+         total += ret;
+
+      if (total != size)
+      {
+         RARCH_ERR("Tried to read %u bytes, but only got %u of file %s.\n",
+               (unsigned)size, (unsigned)total, path);
+         goto error;
+      }
+
+      data[size] = '\0';
+   }
+
+   /* Close before testing ret, so the handle
+    * is released on failed reads too. */
+   closed = compressed_file_close(file);
+   file   = NULL;
+
+   if (ret < 0 || !closed)
+      goto error;
+
+   if (!optional_filename)
+   {
+      if (buf)
+         *buf = data;
+      else
+         free(data);
+   }
+   *length = total;
+   return true;
+
+error:
+   if (outsink)
+      fclose(outsink);
+   compressed_file_close(file);
+   free(data);
+   *length = -1;
+   return false;
+}
+#endif
+
+/**
+ * map_file:
+ * @path             : path to file.
+ * @buf              : mapping of the file.
+ * @length           : size of the file.
+ *
+ * Maps a file into memory instead of reading it. Like a buffer from
+ * read_file, the mapping is writable. It is private and copy-on-write,
+ * so the file is never modified, and untouched pages cost nothing.
+ * Like read_file, the data is followed by a \0. Files which end on a
+ * page boundary are therefore not mapped. Has to be released with
+ * unmap_file.
+ *
+ * Returns: true on success, false if mapping is not supported
+ * or failed, in which case read_file should be used instead.
+ */
+bool map_file(const char *path, void **buf, ssize_t *length)
+{
+#ifdef HAVE_MMAP
+   struct stat fds;
+   void *data     = MAP_FAILED;
+   long page_size = sysconf(_SC_PAGESIZE);
+   int fd         = open(path, O_RDONLY);
+
+   if (fd < 0)
+      return false;
+
+   if (fstat(fd, &fds) < 0 || !S_ISREG(fds.st_mode) || fds.st_size <= 0)
+   {
+      close(fd);
+      return false;
+   }
+
+   /* RetroArch expects a \0 at the end. The rest of the last page
+    * is zero filled and serves as one, unless there is no rest. */
+   if (page_size <= 0 || fds.st_size % page_size == 0)
+   {
+      close(fd);
+      return false;
+   }
+
+   data = mmap(NULL, fds.st_size, PROT_READ | PROT_WRITE,
+         MAP_PRIVATE, fd, 0);
+
+   /* The mapping keeps its own reference to the file. */
+   close(fd);
+
+   if (data == MAP_FAILED)
+      return false;
+
+   /* Content is hashed and handed to the core front to back,
+    * so start reading ahead right away. */
+#ifdef MADV_SEQUENTIAL
+   madvise(data, fds.st_size, MADV_SEQUENTIAL);
+#endif
+#ifdef MADV_WILLNEED
+   madvise(data, fds.st_size, MADV_WILLNEED);
 #endif
+
+   *buf    = data;
+   *length = fds.st_size;
+   return true;
+#else
+   (void)path;
+   (void)buf;
+   (void)length;
    return false;
+#endif
 }
+
+/**
+ * unmap_file:
+ * @buf              : mapping returned by map_file.
+ * @length           : size returned by map_file.
+ *
+ * Releases a mapping returned by map_file.
+ */
+void unmap_file(void *buf, ssize_t length)
+{
+#ifdef HAVE_MMAP
+   if (buf)
+      munmap(buf, length);
+#else
+   (void)buf;
+   (void)length;
 #endif
+}
 
 /**
  * read_file:
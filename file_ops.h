@@ -29,6 +29,60 @@ extern "C" {
 #endif
 
 #ifdef HAVE_COMPRESSION
+typedef struct compressed_file compressed_file_t;
+
+/**
+ * compressed_file_open:
+ * @path             : path to a file inside an archive,
+ *                     e.g. /path/to/game.zip#game.rom.
+ *
+ * Opens an archive member for streaming decompression.
+ * Nothing is written to disk.
+ *
+ * Returns: handle to the member, NULL on error.
+ */
+compressed_file_t *compressed_file_open(const char *path);
+
+/**
+ * compressed_file_size:
+ * @file             : handle to archive member.
+ *
+ * Returns: uncompressed size of the member.
+ */
+size_t compressed_file_size(compressed_file_t *file);
+
+/**
+ * compressed_file_crc32:
+ * @file             : handle to archive member.
+ * @crc              : CRC32 of the member.
+ *
+ * Gets the CRC32 stored in the archive, without decompressing anything.
+ *
+ * Returns: true if the archive stores a CRC32 for the member.
+ */
+bool compressed_file_crc32(compressed_file_t *file, uint32_t *crc);
+
+/**
+ * compressed_file_read:
+ * @file             : handle to archive member.
+ * @data             : buffer to decompress into.
+ * @len              : size of @data.
+ *
+ * Decompresses the next @len bytes of the member into @data.
+ *
+ * Returns: number of bytes read, 0 at the end of the member,
+ * -1 on error.
+ */
+ssize_t compressed_file_read(compressed_file_t *file, void *data, size_t len);
+
+/**
+ * compressed_file_close:
+ * @file             : handle to archive member.
+ *
+ * Returns: false if the member failed its CRC check, otherwise true.
+ */
+bool compressed_file_close(compressed_file_t *file);
+
 /* Generic compressed file loader.
  * Extracts to buf, unless optional_filename != 0
  * Then extracts to optional_filename and leaves buf alone.
@@ -51,6 +105,33 @@ bool read_compressed_file(const char * path, void **buf,
  */
 int read_file(const char *path, void **buf, ssize_t *length);
 
+/**
+ * map_file:
+ * @path             : path to file.
+ * @buf              : mapping of the file.
+ * @length           : size of the file.
+ *
+ * Maps a file into memory instead of reading it. Like a buffer from
+ * read_file, the mapping is writable. It is private and copy-on-write,
+ * so the file is never modified, and untouched pages cost nothing.
+ * Like read_file, the data is followed by a \0. Files which end on a
+ * page boundary are therefore not mapped. Has to be released with
+ * unmap_file.
+ *
+ * Returns: true on success, false if mapping is not supported
+ * or failed, in which case read_file should be used instead.
+ */
+bool map_file(const char *path, void **buf, ssize_t *length);
+
+/**
+ * unmap_file:
+ * @buf              : mapping returned by map_file.
+ * @length           : size returned by map_file.
+ *
+ * Releases a mapping returned by map_file.
+ */
+void unmap_file(void *buf, ssize_t length);
+
 /**
  * write_file:
  * @path             : path to file.
@@ -304,7 +304,10 @@ returntype main_entry(signature())
    }
 
 #if defined(HAVE_MAIN_LOOP)
-   while (rarch_main_iterate() != -1);
+   if (g_extern.headless.enable && !g_extern.libretro_dummy)
+      rarch_main_run_headless();
+   else
+      while (rarch_main_iterate() != -1);
 
    main_exit(args);
 #endif
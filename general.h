@@ -143,6 +143,7 @@ struct settings
       unsigned swap_interval;
       unsigned hard_sync_frames;
       unsigned frame_delay;
+      bool frame_delay_auto;
 #ifdef GEKKO
       unsigned viwidth;
       bool vfilter;
@@ -165,6 +166,7 @@ struct settings
 
       char filter_dir[PATH_MAX_LENGTH];
       char shader_dir[PATH_MAX_LENGTH];
+      char shader_cache_dir[PATH_MAX_LENGTH];
 
       char font_path[PATH_MAX_LENGTH];
       float font_size;
@@ -180,10 +182,14 @@ struct settings
       bool post_filter_record;
       bool gpu_record;
       bool gpu_screenshot;
+      bool screenshot_threaded;
+      unsigned screenshot_compression;
+      unsigned screenshot_filter_threads;
 
       bool allow_rotate;
       bool shared_context;
       bool force_srgb_disable;
+      bool gpu_pixel_convert;
    } video;
 
    struct
@@ -484,8 +490,28 @@ struct global
    {
       retro_time_t minimum_frame_time;
       retro_time_t last_frame_time;
+
+      retro_time_t start_time;
+      retro_time_t lateness_accum;
+      retro_time_t lateness_max;
+      uint64_t frames;
    } frame_limit;
 
+   struct
+   {
+      retro_time_t run_start;
+      retro_time_t run_time;
+      retro_time_t last_present;
+      retro_time_t period;
+      retro_time_t delay;
+
+      retro_time_t latency_accum;
+      retro_time_t judder_accum;
+      retro_time_t judder_max;
+      retro_time_t delay_accum;
+      uint64_t count;
+   } frame_pacing;
+
    struct
    {
       struct retro_system_info info;
@@ -605,9 +631,14 @@ struct global
    {
       bool is_blocking;
       bool is_finished;
+      /* Chunks have been read, image is being decoded. */
+      bool is_processing;
       transfer_cb_t  cb;
       msg_queue_t *msg_queue;
       struct rpng_t *handle;
+      uint32_t *data;
+      unsigned width;
+      unsigned height;
    } images;
 
    bool exec;
@@ -674,6 +705,9 @@ struct global
    size_t record_gpu_width;
    size_t record_gpu_height;
 
+   /* Frames run by the core since recording started. */
+   uint64_t record_frame_count;
+
    struct
    {
       const void *data;
@@ -685,6 +719,17 @@ struct global
    unsigned frame_count;
    unsigned max_frames;
 
+   struct
+   {
+      bool enable;
+      bool hash_state;
+      unsigned hash_interval;
+      uint32_t hash;
+
+      uint8_t *buffer;
+      size_t buffer_size;
+   } headless;
+
    char title_buf[64];
 
    struct
@@ -1667,6 +1667,7 @@ video_driver_t video_exynos = {
   exynos_gfx_set_rotation,
   exynos_gfx_viewport_info,
   exynos_gfx_read_viewport,
+  NULL, /* read_viewport_async */
 
 #ifdef HAVE_OVERLAY
   NULL, /* overlay_interface */
@@ -22,6 +22,7 @@
 #include "../../driver.h"
 #include "../../performance.h"
 #include <gfx/scaler/scaler.h>
+#include <gfx/scaler/pixconv.h>
 #include <formats/image.h>
 
 #include <stdint.h>
@@ -1250,11 +1251,531 @@ static void gl_init_textures(gl_t *gl, const video_info_t *video)
    glBindTexture(GL_TEXTURE_2D, gl->texture[gl->tex_index]);
 }
 
+#ifdef HAVE_GL_PBO_UPLOAD
+static void gl_upload_init(gl_t *gl)
+{
+   gl->have_upload_pbo = glMapBufferRange && glUnmapBuffer
+      && gl_query_extension(gl, "ARB_map_buffer_range");
+
+#ifdef HAVE_GL_SYNC
+   gl->upload_persistent = gl->have_upload_pbo && gl->have_sync
+      && glBufferStorage && gl_query_extension(gl, "ARB_buffer_storage");
+#endif
+
+   if (gl->upload_persistent)
+      RARCH_LOG("[GL]: Uploading frames through persistently mapped PBOs.\n");
+   else if (gl->have_upload_pbo)
+      RARCH_LOG("[GL]: Uploading frames through PBOs.\n");
+}
+
+static void gl_upload_free(gl_t *gl)
+{
+   unsigned i;
+
+   for (i = 0; i < GL_UPLOAD_RING_SIZE; i++)
+   {
+#ifdef HAVE_GL_SYNC
+      if (gl->upload[i].fence)
+         glDeleteSync(gl->upload[i].fence);
+#endif
+      if (gl->upload[i].pbo)
+         glDeleteBuffers(1, &gl->upload[i].pbo);
+   }
+
+   memset(gl->upload, 0, sizeof(gl->upload));
+   gl->upload_index = 0;
+}
+
+/**
+ * gl_upload_map:
+ * @gl                   : GL driver handle.
+ * @size                 : Number of bytes to be written.
+ *
+ * Binds the next upload buffer to GL_PIXEL_UNPACK_BUFFER
+ * and maps at least @size bytes of it for writing.
+ *
+ * Returns: pointer to the mapped buffer, or NULL on failure.
+ **/
+static void *gl_upload_map(gl_t *gl, size_t size)
+{
+   struct gl_upload *up = &gl->upload[gl->upload_index];
+
+   if (!gl->upload_persistent)
+   {
+      if (!up->pbo)
+         glGenBuffers(1, &up->pbo);
+
+      /* Orphan the previous storage, so that we never
+       * wait for the GPU to finish reading last frame. */
+      glBindBuffer(GL_PIXEL_UNPACK_BUFFER, up->pbo);
+      glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+      up->size = size;
+
+      return glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size,
+            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+   }
+
+#ifdef HAVE_GL_SYNC
+   /* This buffer was used GL_UPLOAD_RING_SIZE frames ago,
+    * which normally has completed long since. */
+   if (up->fence)
+   {
+      glClientWaitSync(up->fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+      glDeleteSync(up->fence);
+      up->fence = NULL;
+   }
+#endif
+
+   if (up->size < size)
+   {
+      /* Buffer storage is immutable, so grow by replacing it. */
+      if (up->pbo)
+         glDeleteBuffers(1, &up->pbo);
+
+      glGenBuffers(1, &up->pbo);
+      glBindBuffer(GL_PIXEL_UNPACK_BUFFER, up->pbo);
+      glBufferStorage(GL_PIXEL_UNPACK_BUFFER, size, NULL,
+            GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT);
+      up->ptr  = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size,
+            GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT);
+      up->size = up->ptr ? size : 0;
+   }
+   else
+      glBindBuffer(GL_PIXEL_UNPACK_BUFFER, up->pbo);
+
+   return up->ptr;
+}
+
+/**
+ * gl_upload_frame:
+ * @gl                   : GL driver handle.
+ * @frame                : Frame to upload.
+ * @width                : Width of frame.
+ * @height               : Height of frame.
+ * @pitch                : Pitch of frame.
+ *
+ * Uploads a frame to the currently bound texture through
+ * a mapped pixel unpack buffer. A 16-bit frame that has to be
+ * converted is converted straight into the mapped buffer.
+ *
+ * Returns: true if successful, false if the caller has to
+ * upload from client memory instead.
+ **/
+static bool gl_upload_frame(gl_t *gl, const void *frame,
+      unsigned width, unsigned height, unsigned pitch)
+{
+   uint8_t *ptr      = NULL;
+   bool convert      = gl->base_size == 2 && !gl->have_es2_compat;
+   unsigned out_size = convert ? sizeof(uint32_t) : gl->base_size;
+   unsigned stride   = convert ? width * sizeof(uint32_t) : pitch;
+   size_t size       = 0;
+
+   if (!width || !height)
+      return false;
+
+   size = stride * (height - 1) + width * out_size;
+   ptr  = (uint8_t*)gl_upload_map(gl, size);
+
+   if (!ptr)
+   {
+      glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+      return false;
+   }
+
+   if (convert)
+      gl_convert_frame_rgb16_32(gl, ptr, frame, width, height, pitch);
+   else
+      memcpy(ptr, frame, size);
+
+   if (!gl->upload_persistent)
+      glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+   glPixelStorei(GL_UNPACK_ALIGNMENT, video_pixel_get_alignment(stride));
+   glPixelStorei(GL_UNPACK_ROW_LENGTH, stride / out_size);
+   glTexSubImage2D(GL_TEXTURE_2D,
+         0, 0, 0, width, height, gl->texture_type,
+         gl->texture_fmt, NULL);
+   glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+
+#ifdef HAVE_GL_SYNC
+   if (gl->upload_persistent)
+   {
+      gl->upload[gl->upload_index].fence =
+         glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+      gl->upload_index = (gl->upload_index + 1) % GL_UPLOAD_RING_SIZE;
+   }
+#endif
+
+   glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+   return true;
+}
+#endif
+
+#ifdef HAVE_GL_PIXCONV
+static const char *pixconv_vertex =
+   "COMPAT_ATTRIBUTE vec2 VertexCoord;\n"
+   "COMPAT_ATTRIBUTE vec2 TexCoord;\n"
+   "COMPAT_VARYING vec2 tex;\n"
+   "void main()\n"
+   "{\n"
+   "   gl_Position = vec4(VertexCoord, 0.0, 1.0);\n"
+   "   tex = TexCoord;\n"
+   "}\n";
+
+/* 16-bit frames arrive as two 8-bit channels, low byte first.
+ * Components are widened by bit replication, like the CPU converters. */
+static const char *pixconv_fragment =
+   "uniform sampler2D Source;\n"
+   "COMPAT_VARYING vec2 tex;\n"
+   "float expand5(float v) { return (v * 8.0 + floor(v / 4.0)) / 255.0; }\n"
+   "float expand6(float v) { return (v * 4.0 + floor(v / 16.0)) / 255.0; }\n"
+   "void main()\n"
+   "{\n"
+   "   vec4 texel = COMPAT_TEXTURE(Source, tex);\n"
+   "#ifdef PIXCONV_ABGR8888\n"
+   "   COMPAT_FRAGCOLOR = vec4(texel.bgr, 1.0);\n"
+   "#else\n"
+   "   float lo = floor(texel.r * 255.0 + 0.5);\n"
+   "   float hi = floor(texel.PIXCONV_HI * 255.0 + 0.5);\n"
+   "   float b  = mod(lo, 32.0);\n"
+   "#ifdef PIXCONV_0RGB1555\n"
+   "   float r  = floor(mod(hi, 128.0) / 4.0);\n"
+   "   float g  = mod(hi, 4.0) * 8.0 + floor(lo / 32.0);\n"
+   "   COMPAT_FRAGCOLOR = vec4(expand5(r), expand5(g), expand5(b), 1.0);\n"
+   "#else\n"
+   "   float r  = floor(hi / 8.0);\n"
+   "   float g  = mod(hi, 8.0) * 8.0 + floor(lo / 32.0);\n"
+   "   COMPAT_FRAGCOLOR = vec4(expand5(r), expand6(g), expand5(b), 1.0);\n"
+   "#endif\n"
+   "#endif\n"
+   "}\n";
+
+static GLuint gl_pixconv_compile(GLenum type,
+      const char *header, const char *defines, const char *body)
+{
+   GLint status       = GL_FALSE;
+   const char *src[3] = { header, defines, body };
+   GLuint shader      = glCreateShader(type);
+
+   if (!shader)
+      return 0;
+
+   glShaderSource(shader, 3, src, NULL);
+   glCompileShader(shader);
+   glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+
+   if (status != GL_TRUE)
+   {
+      glDeleteShader(shader);
+      return 0;
+   }
+
+   return shader;
+}
+
+static bool gl_pixconv_init_program(gl_t *gl, const char *defines)
+{
+   GLint status = GL_FALSE;
+   GLuint vert  = 0, frag = 0;
+   const char *vert_header =
+      "#define COMPAT_ATTRIBUTE attribute\n"
+      "#define COMPAT_VARYING varying\n";
+   const char *frag_header =
+      "#ifdef GL_ES\n"
+      "#ifdef GL_FRAGMENT_PRECISION_HIGH\n"
+      "precision highp float;\n"
+      "#else\n"
+      "precision mediump float;\n"
+      "#endif\n"
+      "#endif\n"
+      "#define COMPAT_VARYING varying\n"
+      "#define COMPAT_TEXTURE texture2D\n"
+      "#define COMPAT_FRAGCOLOR gl_FragColor\n";
+
+#ifndef HAVE_OPENGLES
+   if (gl->core_context)
+   {
+      vert_header =
+         "#version 140\n"
+         "#define COMPAT_ATTRIBUTE in\n"
+         "#define COMPAT_VARYING out\n";
+      frag_header =
+         "#version 140\n"
+         "out vec4 FragColor;\n"
+         "#define COMPAT_VARYING in\n"
+         "#define COMPAT_TEXTURE texture\n"
+         "#define COMPAT_FRAGCOLOR FragColor\n";
+   }
+#endif
+
+   vert = gl_pixconv_compile(GL_VERTEX_SHADER,
+         vert_header, defines, pixconv_vertex);
+   frag = gl_pixconv_compile(GL_FRAGMENT_SHADER,
+         frag_header, defines, pixconv_fragment);
+
+   if (vert && frag)
+   {
+      gl->pixconv_prog = glCreateProgram();
+      glAttachShader(gl->pixconv_prog, vert);
+      glAttachShader(gl->pixconv_prog, frag);
+      glBindAttribLocation(gl->pixconv_prog, 0, "VertexCoord");
+      glBindAttribLocation(gl->pixconv_prog, 1, "TexCoord");
+      glLinkProgram(gl->pixconv_prog);
+      glGetProgramiv(gl->pixconv_prog, GL_LINK_STATUS, &status);
+   }
+
+   if (vert)
+      glDeleteShader(vert);
+   if (frag)
+      glDeleteShader(frag);
+
+   if (status != GL_TRUE)
+      return false;
+
+   glUseProgram(gl->pixconv_prog);
+   glUniform1i(glGetUniformLocation(gl->pixconv_prog, "Source"), 0);
+   glUseProgram(0);
+   return true;
+}
+
+static void gl_pixconv_free(gl_t *gl)
+{
+   if (gl->pixconv_prog)
+      glDeleteProgram(gl->pixconv_prog);
+   if (gl->pixconv_fbo)
+      glDeleteFramebuffers(1, &gl->pixconv_fbo);
+   if (gl->pixconv_tex)
+      glDeleteTextures(1, &gl->pixconv_tex);
+   if (gl->pixconv_vbo)
+      glDeleteBuffers(1, &gl->pixconv_vbo);
+
+   gl->pixconv_prog   = 0;
+   gl->pixconv_fbo    = 0;
+   gl->pixconv_tex    = 0;
+   gl->pixconv_vbo    = 0;
+   gl->pixconv_mode   = GL_PIXCONV_NONE;
+   gl->pixconv_width  = 0;
+   gl->pixconv_height = 0;
+}
+
+/**
+ * gl_pixconv_init:
+ * @gl                   : GL driver handle.
+ *
+ * If enabled, sets up the shader pass that unpacks
+ * frames which would otherwise be converted on the CPU.
+ * Falls back to CPU conversion if anything is missing.
+ **/
+static void gl_pixconv_init(gl_t *gl)
+{
+   char defines[128];
+   GLenum status;
+   GLenum raw_fmt          = GL_LUMINANCE_ALPHA;
+   GLenum raw_internal_fmt = GL_LUMINANCE_ALPHA;
+   const char *hi          = "a";
+   enum gl_pixconv_mode mode = GL_PIXCONV_NONE;
+
+   if (!g_settings.video.gpu_pixel_convert
+         || gl->hw_render_use || gl->egl_images)
+      return;
+
+#if !defined(HAVE_OPENGLES2) && !defined(HAVE_PSGL)
+   if (!check_fbo_proc(gl))
+      return;
+#endif
+
+   if (gl->base_size == sizeof(uint32_t))
+   {
+#ifdef HAVE_OPENGLES2
+      if (driver.gfx_use_rgba)
+         mode = GL_PIXCONV_ABGR8888;
+#endif
+   }
+   else if (g_extern.system.pix_fmt == RETRO_PIXEL_FORMAT_0RGB1555
+         && !g_extern.filter.filter)
+      mode = GL_PIXCONV_0RGB1555;
+#ifndef HAVE_OPENGLES
+   else if (!gl->have_es2_compat)
+      mode = GL_PIXCONV_RGB565;
+#endif
+
+   if (mode == GL_PIXCONV_NONE)
+      return;
+
+   if (mode == GL_PIXCONV_ABGR8888)
+   {
+      raw_fmt          = GL_RGBA;
+      raw_internal_fmt = GL_RGBA;
+   }
+#ifndef HAVE_OPENGLES
+   else if (gl->core_context)
+   {
+      raw_fmt          = GL_RG;
+      raw_internal_fmt = GL_RG8;
+      hi               = "g";
+   }
+#endif
+
+   snprintf(defines, sizeof(defines), "#define %s\n#define PIXCONV_HI %s\n",
+         mode == GL_PIXCONV_ABGR8888 ? "PIXCONV_ABGR8888" :
+         mode == GL_PIXCONV_0RGB1555 ? "PIXCONV_0RGB1555" : "PIXCONV_RGB565",
+         hi);
+
+   if (!gl_pixconv_init_program(gl, defines))
+   {
+      RARCH_WARN("[GL]: Failed to build pixel conversion shader, converting on CPU.\n");
+      gl_pixconv_free(gl);
+      return;
+   }
+
+   glGenTextures(1, &gl->pixconv_tex);
+   glBindTexture(GL_TEXTURE_2D, gl->pixconv_tex);
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+   glTexImage2D(GL_TEXTURE_2D, 0, raw_internal_fmt, gl->tex_w, gl->tex_h,
+         0, raw_fmt, GL_UNSIGNED_BYTE, NULL);
+
+   glGenBuffers(1, &gl->pixconv_vbo);
+
+   glGenFramebuffers(1, &gl->pixconv_fbo);
+   glBindFramebuffer(RARCH_GL_FRAMEBUFFER, gl->pixconv_fbo);
+   glFramebufferTexture2D(RARCH_GL_FRAMEBUFFER, RARCH_GL_COLOR_ATTACHMENT0,
+         GL_TEXTURE_2D, gl->texture[0], 0);
+   status = glCheckFramebufferStatus(RARCH_GL_FRAMEBUFFER);
+   gl_bind_backbuffer();
+   glBindTexture(GL_TEXTURE_2D, gl->texture[gl->tex_index]);
+
+   if (status != RARCH_GL_FRAMEBUFFER_COMPLETE)
+   {
+      RARCH_WARN("[GL]: Cannot render to frame textures, converting on CPU.\n");
+      gl_pixconv_free(gl);
+      return;
+   }
+
+   gl->pixconv_mode = mode;
+   if (mode == GL_PIXCONV_0RGB1555)
+      driver.gfx_native_0rgb1555 = true;
+
+   RARCH_LOG("[GL]: Converting frames on the GPU.\n");
+}
+
+/**
+ * gl_pixconv_frame:
+ * @gl                   : GL driver handle.
+ * @frame                : Frame to upload.
+ * @width                : Width of frame.
+ * @height               : Height of frame.
+ * @pitch                : Pitch of frame.
+ *
+ * Uploads the raw frame and unpacks it into the current
+ * frame texture. Restores the program, framebuffer and
+ * viewport which gl_frame() has set up for the first pass.
+ **/
+static void gl_pixconv_frame(gl_t *gl, const void *frame,
+      unsigned width, unsigned height, unsigned pitch)
+{
+   const GLvoid *data_buf = frame;
+   unsigned row_length    = pitch / gl->base_size;
+
+#if defined(HAVE_OPENGLES)
+   if (!gl->support_unpack_row_length && row_length != width)
+   {
+      unsigned h;
+      const unsigned line_bytes = width * gl->base_size;
+      uint8_t *dst              = (uint8_t*)gl->conv_buffer;
+      const uint8_t *src        = (const uint8_t*)frame;
+
+      for (h = 0; h < height; h++, src += pitch, dst += line_bytes)
+         memcpy(dst, src, line_bytes);
+
+      data_buf   = gl->conv_buffer;
+      row_length = width;
+   }
+#endif
+
+   glBindTexture(GL_TEXTURE_2D, gl->pixconv_tex);
+   glPixelStorei(GL_UNPACK_ALIGNMENT,
+         video_pixel_get_alignment(row_length * gl->base_size));
+#if defined(HAVE_OPENGLES)
+   if (gl->support_unpack_row_length)
+#endif
+      glPixelStorei(GL_UNPACK_ROW_LENGTH, row_length);
+
+   glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height,
+         gl->pixconv_mode == GL_PIXCONV_ABGR8888 ? GL_RGBA :
+#ifndef HAVE_OPENGLES
+         gl->core_context ? GL_RG :
+#endif
+         GL_LUMINANCE_ALPHA,
+         GL_UNSIGNED_BYTE, data_buf);
+
+#if defined(HAVE_OPENGLES)
+   if (gl->support_unpack_row_length)
+#endif
+      glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+
+   glBindBuffer(GL_ARRAY_BUFFER, gl->pixconv_vbo);
+   if (width != gl->pixconv_width || height != gl->pixconv_height)
+   {
+      GLfloat xamt = (GLfloat)width  / gl->tex_w;
+      GLfloat yamt = (GLfloat)height / gl->tex_h;
+      GLfloat coords[16] = {
+         -1, -1,    0,    0,
+          1, -1, xamt,    0,
+         -1,  1,    0, yamt,
+          1,  1, xamt, yamt,
+      };
+
+      glBufferData(GL_ARRAY_BUFFER, sizeof(coords), coords, GL_STATIC_DRAW);
+      gl->pixconv_width  = width;
+      gl->pixconv_height = height;
+   }
+
+   glBindFramebuffer(RARCH_GL_FRAMEBUFFER, gl->pixconv_fbo);
+   glFramebufferTexture2D(RARCH_GL_FRAMEBUFFER, RARCH_GL_COLOR_ATTACHMENT0,
+         GL_TEXTURE_2D, gl->texture[gl->tex_index], 0);
+   glViewport(0, 0, width, height);
+   glDisable(GL_BLEND);
+
+   glUseProgram(gl->pixconv_prog);
+   glEnableVertexAttribArray(0);
+   glEnableVertexAttribArray(1);
+   glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE,
+         4 * sizeof(GLfloat), (const GLvoid*)0);
+   glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE,
+         4 * sizeof(GLfloat), (const GLvoid*)(2 * sizeof(GLfloat)));
+   glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+   glDisableVertexAttribArray(0);
+   glDisableVertexAttribArray(1);
+   glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+   glBindTexture(GL_TEXTURE_2D, gl->texture[gl->tex_index]);
+   if (gl->fbo_inited)
+      gl_start_frame_fbo(gl);
+   else
+   {
+      gl_bind_backbuffer();
+      gl_set_viewport(gl, gl->win_width, gl->win_height, false, true);
+   }
+   gl->shader->use(gl, 1);
+}
+#endif
+
 static inline void gl_copy_frame(gl_t *gl, const void *frame,
       unsigned width, unsigned height, unsigned pitch)
 {
    RARCH_PERFORMANCE_INIT(copy_frame);
    RARCH_PERFORMANCE_START(copy_frame);
+#ifdef HAVE_GL_PIXCONV
+   if (gl->pixconv_mode)
+   {
+      gl_pixconv_frame(gl, frame, width, height, pitch);
+      RARCH_PERFORMANCE_STOP(copy_frame);
+      return;
+   }
+#endif
 #if defined(HAVE_OPENGLES2)
 #if defined(HAVE_EGL)
    if (gl->egl_images)
@@ -1339,6 +1860,15 @@ static inline void gl_copy_frame(gl_t *gl, const void *frame,
    glUnmapBuffer(GL_TEXTURE_REFERENCE_BUFFER_SCE);
 #else
    const GLvoid *data_buf = frame;
+
+#ifdef HAVE_GL_PBO_UPLOAD
+   if (gl->have_upload_pbo && gl_upload_frame(gl, frame, width, height, pitch))
+   {
+      RARCH_PERFORMANCE_STOP(copy_frame);
+      return;
+   }
+#endif
+
    glPixelStorei(GL_UNPACK_ALIGNMENT, video_pixel_get_alignment(pitch));
 
    if (gl->base_size == 2 && !gl->have_es2_compat)
@@ -1375,36 +1905,249 @@ static inline void gl_set_shader_viewport(gl_t *gl, unsigned shader)
    gl_set_viewport(gl, gl->win_width, gl->win_height, false, true);
 }
 
-#if defined(HAVE_GL_ASYNC_READBACK) && defined(HAVE_MENU)
-static void gl_pbo_async_readback(gl_t *gl)
+#ifdef HAVE_GL_ASYNC_READBACK
+static inline struct gl_readback *gl_readback_slot(gl_t *gl, unsigned i)
 {
-   glBindBuffer(GL_PIXEL_PACK_BUFFER,
-         gl->pbo_readback[gl->pbo_readback_index++]);
-   gl->pbo_readback_index &= 3;
+   return &gl->readback[(gl->readback_first + i) % GL_READBACK_RING_SIZE];
+}
 
-   /* 4 frames back, we can readback. */
-   gl->pbo_readback_valid[gl->pbo_readback_index] = true;
+/**
+ * gl_readback_ready:
+ * @gl                   : GL driver handle.
+ * @rb                   : Readback to check.
+ *
+ * Returns: true (1) if the GPU has finished writing the readback, 
+ * so mapping its PBO will not stall, otherwise false (0).
+ **/
+static bool gl_readback_ready(gl_t *gl, const struct gl_readback *rb)
+{
+   if (rb->queued)
+      return false;
+   if (rb->skipped)
+      return true;
 
-   glPixelStorei(GL_PACK_ROW_LENGTH, 0);
-   glPixelStorei(GL_PACK_ALIGNMENT,
-         video_pixel_get_alignment(gl->vp.width * sizeof(uint32_t)));
+#ifdef HAVE_GL_SYNC
+   if (rb->fence)
+   {
+      GLenum ret = glClientWaitSync(rb->fence, 0, 0);
+      return ret == GL_ALREADY_SIGNALED || ret == GL_CONDITION_SATISFIED;
+   }
+#endif
+
+   /* Without fences, assume the GPU is at most a few frames behind. */
+   return g_extern.frame_count - rb->frame >= GL_READBACK_RING_SIZE - 1;
+}
+
+/**
+ * gl_readback_complete:
+ * @gl                   : GL driver handle.
+ *
+ * Removes the oldest readback from the queue, converts its pixels 
+ * to BGR24 and hands them to the requester. If the GPU is not 
+ * done with it yet, this waits.
+ **/
+static void gl_readback_complete(gl_t *gl)
+{
+   struct gl_readback *rb = gl_readback_slot(gl, 0);
+   size_t size            = rb->width * rb->height * 3;
+   const uint8_t *bgr     = NULL;
+   const uint8_t *ptr     = NULL;
+
+   gl->readback_first = (gl->readback_first + 1) % GL_READBACK_RING_SIZE;
+   gl->readback_count--;
+
+#ifdef HAVE_GL_SYNC
+   if (rb->fence)
+      glDeleteSync(rb->fence);
+   rb->fence = NULL;
+#endif
+
+   if (rb->skipped)
+      goto end;
+
+   if (size > gl->readback_bgr_size)
+   {
+      uint8_t *buf = (uint8_t*)realloc(gl->readback_bgr, size);
+      if (!buf)
+         goto end;
+
+      gl->readback_bgr      = buf;
+      gl->readback_bgr_size = size;
+   }
+
+   RARCH_PERFORMANCE_INIT(readback_complete);
+   RARCH_PERFORMANCE_START(readback_complete);
+
+   glBindBuffer(GL_PIXEL_PACK_BUFFER, rb->pbo);
+#ifdef HAVE_OPENGLES3
+   /* Slower path, but should work on all implementations at least. */
+   ptr = (const uint8_t*)glMapBufferRange(GL_PIXEL_PACK_BUFFER,
+         0, rb->width * rb->height * sizeof(uint32_t), GL_MAP_READ_BIT);
+#else
+   ptr = (const uint8_t*)glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+#endif
+
+   if (ptr)
+   {
+#ifdef HAVE_OPENGLES3
+      unsigned i;
+      uint8_t *dst = gl->readback_bgr;
+
+      for (i = 0; i < rb->width * rb->height; i++, dst += 3, ptr += 4)
+      {
+         dst[0] = ptr[2]; /* RGBA -> BGR. */
+         dst[1] = ptr[1];
+         dst[2] = ptr[0];
+      }
+#else
+      conv_argb8888_bgr24(gl->readback_bgr, ptr,
+            rb->width, rb->height,
+            rb->width * 3, rb->width * sizeof(uint32_t));
+#endif
+      glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+      bgr = gl->readback_bgr;
+   }
+   else
+      RARCH_ERR("[GL]: Failed to map pixel pack buffer.\n");
+
+   glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+   RARCH_PERFORMANCE_STOP(readback_complete);
+
+end:
+   rb->cb(rb->userdata, bgr, rb->width, rb->height);
+   rb->cb       = NULL;
+   rb->userdata = NULL;
+}
+
+/**
+ * gl_readback_poll:
+ * @gl                   : GL driver handle.
+ *
+ * Completes every readback the GPU has finished, in request order.
+ **/
+static void gl_readback_poll(gl_t *gl)
+{
+   while (gl->readback_count && gl_readback_ready(gl,
+            gl_readback_slot(gl, 0)))
+      gl_readback_complete(gl);
+}
+
+/**
+ * gl_readback_issue:
+ * @gl                   : GL driver handle.
+ *
+ * Starts asynchronous reads of the back buffer into the PBOs of 
+ * all queued readbacks, and fences them where ARB_sync is available.
+ **/
+static void gl_readback_issue(gl_t *gl)
+{
+   unsigned i;
+   bool state_reset = false;
+   size_t size      = gl->vp.width * gl->vp.height * sizeof(uint32_t);
 
-   /* Read asynchronously into PBO buffer. */
    RARCH_PERFORMANCE_INIT(async_readback);
    RARCH_PERFORMANCE_START(async_readback);
-   glReadBuffer(GL_BACK);
+
+   for (i = 0; i < gl->readback_count; i++)
+   {
+      struct gl_readback *rb = gl_readback_slot(gl, i);
+
+      if (!rb->queued)
+         continue;
+
+      rb->queued = false;
+      rb->width  = gl->vp.width;
+      rb->height = gl->vp.height;
+      rb->frame  = g_extern.frame_count;
+
+#ifdef HAVE_MENU
+      /* Don't readback if we're in menu mode. */
+      if (gl->menu_texture_enable)
+      {
+         rb->skipped = true;
+         continue;
+      }
+#endif
+
+      if (!state_reset)
+      {
+#ifdef HAVE_FBO
+         /* Reset state which could easily mess up libretro core. */
+         if (gl->hw_render_fbo_init)
+         {
+            gl->shader->use(gl, 0);
+            glBindTexture(GL_TEXTURE_2D, 0);
+#ifndef NO_GL_FF_VERTEX
+            gl_disable_client_arrays(gl);
+#endif
+         }
+#endif
+
+         glPixelStorei(GL_PACK_ROW_LENGTH, 0);
+         glPixelStorei(GL_PACK_ALIGNMENT,
+               video_pixel_get_alignment(gl->vp.width * sizeof(uint32_t)));
+         glReadBuffer(GL_BACK);
+         state_reset = true;
+      }
+
+      if (!rb->pbo)
+         glGenBuffers(1, &rb->pbo);
+
+      glBindBuffer(GL_PIXEL_PACK_BUFFER, rb->pbo);
+      if (rb->pbo_size < size)
+      {
+         glBufferData(GL_PIXEL_PACK_BUFFER, size, NULL, GL_STREAM_READ);
+         rb->pbo_size = size;
+      }
+
+      /* Read asynchronously into PBO buffer. */
 #ifdef HAVE_OPENGLES3
-   glReadPixels(gl->vp.x, gl->vp.y,
-         gl->vp.width, gl->vp.height,
-         GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+      glReadPixels(gl->vp.x, gl->vp.y,
+            gl->vp.width, gl->vp.height,
+            GL_RGBA, GL_UNSIGNED_BYTE, NULL);
 #else
-   glReadPixels(gl->vp.x, gl->vp.y,
-         gl->vp.width, gl->vp.height,
-         GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV, NULL);
+      glReadPixels(gl->vp.x, gl->vp.y,
+            gl->vp.width, gl->vp.height,
+            GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV, NULL);
 #endif
-   RARCH_PERFORMANCE_STOP(async_readback);
+
+#ifdef HAVE_GL_SYNC
+      if (gl->have_sync)
+         rb->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+#endif
+   }
 
    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+   RARCH_PERFORMANCE_STOP(async_readback);
+}
+
+/**
+ * gl_readback_free:
+ * @gl                   : GL driver handle.
+ *
+ * Fails all outstanding readbacks and frees their PBOs.
+ **/
+static void gl_readback_free(gl_t *gl)
+{
+   unsigned i;
+
+   while (gl->readback_count)
+   {
+      gl_readback_slot(gl, 0)->skipped = true;
+      gl_readback_complete(gl);
+   }
+
+   for (i = 0; i < GL_READBACK_RING_SIZE; i++)
+   {
+      if (gl->readback[i].pbo)
+         glDeleteBuffers(1, &gl->readback[i].pbo);
+   }
+
+   free(gl->readback_bgr);
+   memset(gl->readback, 0, sizeof(gl->readback));
+   gl->readback_bgr      = NULL;
+   gl->readback_bgr_size = 0;
+   gl->readback_first    = 0;
 }
 #endif
 
@@ -1462,6 +2205,11 @@ static bool gl_frame(void *data, const void *frame,
 
    context_bind_hw_render(gl, false);
 
+#ifdef HAVE_GL_ASYNC_READBACK
+   /* Hand out readbacks of earlier frames which have arrived. */
+   gl_readback_poll(gl);
+#endif
+
 #ifndef HAVE_OPENGLES
    if (gl->core_context)
       glBindVertexArray(gl->vao);
@@ -1624,11 +2372,8 @@ static bool gl_frame(void *data, const void *frame,
             GL_RGBA, GL_UNSIGNED_BYTE, gl->readback_buffer_screenshot);
    }
 #ifdef HAVE_GL_ASYNC_READBACK
-#ifdef HAVE_MENU
-   /* Don't readback if we're in menu mode. */
-   else if (gl->pbo_readback_enable && !gl->menu_texture_enable)
-      gl_pbo_async_readback(gl);
-#endif
+   if (gl->readback_count)
+      gl_readback_issue(gl);
 #endif
 #endif
    /* Disable BFI during fast forward, slow-motion,
@@ -1749,11 +2494,15 @@ static void gl_free(void *data)
    scaler_ctx_gen_reset(&gl->scaler);
 
 #ifdef HAVE_GL_ASYNC_READBACK
-   if (gl->pbo_readback_enable)
-   {
-      glDeleteBuffers(4, gl->pbo_readback);
-      scaler_ctx_gen_reset(&gl->pbo_readback_scaler);
-   }
+   gl_readback_free(gl);
+#endif
+
+#ifdef HAVE_GL_PBO_UPLOAD
+   gl_upload_free(gl);
+#endif
+
+#ifdef HAVE_GL_PIXCONV
+   gl_pixconv_free(gl);
 #endif
 
 #ifdef HAVE_FBO
@@ -1834,6 +2583,10 @@ static bool resolve_extensions(gl_t *gl)
       RARCH_LOG("[GL]: Using ARB_sync to reduce latency.\n");
 #endif
 
+#ifdef HAVE_GL_PBO_UPLOAD
+   gl_upload_init(gl);
+#endif
+
    driver.gfx_use_rgba = false;
 #ifdef HAVE_OPENGLES2
    const char *version = NULL;
@@ -1958,57 +2711,6 @@ static inline void gl_set_texture_fmts(gl_t *gl, bool rgb32)
 #endif
 }
 
-#ifdef HAVE_GL_ASYNC_READBACK
-static void gl_init_pbo_readback(gl_t *gl)
-{
-   unsigned i;
-   struct scaler_ctx *scaler = NULL;
-
-   (void)scaler;
-   /* Only bother with this if we're doing GPU recording.
-    * Check g_extern.recording_enable and not 
-    * driver.recording_data, because recording is 
-    * not initialized yet.
-    */
-   gl->pbo_readback_enable = g_settings.video.gpu_record 
-      && g_extern.recording_enable;
-   if (!gl->pbo_readback_enable)
-      return;
-
-   RARCH_LOG("[GL]: Async PBO readback enabled.\n");
-
-   glGenBuffers(4, gl->pbo_readback);
-   for (i = 0; i < 4; i++)
-   {
-      glBindBuffer(GL_PIXEL_PACK_BUFFER, gl->pbo_readback[i]);
-      glBufferData(GL_PIXEL_PACK_BUFFER, gl->vp.width * 
-            gl->vp.height * sizeof(uint32_t),
-            NULL, GL_STREAM_READ);
-   }
-   glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
-
-#ifndef HAVE_OPENGLES3
-   scaler              = &gl->pbo_readback_scaler;
-   scaler->in_width    = gl->vp.width;
-   scaler->in_height   = gl->vp.height;
-   scaler->out_width   = gl->vp.width;
-   scaler->out_height  = gl->vp.height;
-   scaler->in_stride   = gl->vp.width * sizeof(uint32_t);
-   scaler->out_stride  = gl->vp.width * 3;
-   scaler->in_fmt      = SCALER_FMT_ARGB8888;
-   scaler->out_fmt     = SCALER_FMT_BGR24;
-   scaler->scaler_type = SCALER_TYPE_POINT;
-
-   if (!scaler_ctx_gen_filter(scaler))
-   {
-      gl->pbo_readback_enable = false;
-      RARCH_ERR("Failed to initialize pixel conversion for PBO.\n");
-      glDeleteBuffers(4, gl->pbo_readback);
-   }
-#endif
-}
-#endif
-
 static const gfx_ctx_driver_t *gl_get_context(gl_t *gl)
 {
    const struct retro_hw_render_callback *cb = 
@@ -2400,6 +3102,10 @@ static void *gl_init(const video_info_t *video, const input_driver_t **input, vo
 #endif
 #endif
 
+#ifdef HAVE_GL_PIXCONV
+   gl_pixconv_init(gl);
+#endif
+
    if (input && input_data)
       gl->ctx_driver->input_driver(gl, input, input_data);
    
@@ -2411,10 +3117,6 @@ static void *gl_init(const video_info_t *video, const input_driver_t **input, vo
          RARCH_ERR("[GL]: Failed to initialize font renderer.\n");
    }
 
-#ifdef HAVE_GL_ASYNC_READBACK
-   gl_init_pbo_readback(gl);
-#endif
-
    if (!gl_check_error())
    {
       gl->ctx_driver->destroy(gl);
@@ -2645,8 +3347,11 @@ static bool gl_read_viewport(void *data, uint8_t *buffer)
 #else
 static bool gl_read_viewport(void *data, uint8_t *buffer)
 {
+   unsigned i;
    unsigned num_pixels = 0;
-   gl_t *gl = (gl_t*)data;
+   uint8_t *dst        = NULL;
+   const uint8_t *src  = NULL;
+   gl_t *gl            = (gl_t*)data;
 
    if (!gl)
       return false;
@@ -2656,109 +3361,80 @@ static bool gl_read_viewport(void *data, uint8_t *buffer)
    RARCH_PERFORMANCE_INIT(read_viewport);
    RARCH_PERFORMANCE_START(read_viewport);
 
-#ifdef HAVE_GL_ASYNC_READBACK
-   if (gl->pbo_readback_enable)
-   {
-      const uint8_t *ptr  = NULL;
+   /* Synchronous readback, use read_viewport_async() 
+    * where stalling the pipeline matters.
+    *
+    * GLES2 only guarantees GL_RGBA/GL_UNSIGNED_BYTE 
+    * readbacks so do just that.
+    * GLES2 also doesn't support reading back data 
+    * from front buffer, so render a cached frame 
+    * and have gl_frame() do the readback while it's 
+    * in the back buffer.
+    *
+    * Keep codepath similar for GLES and desktop GL.
+    */
 
-      /* Don't readback if we're in menu mode. */
-      if (!gl->pbo_readback_valid[gl->pbo_readback_index]) 
-      {
-         /* We haven't buffered up enough frames yet, come back later. */
-         context_bind_hw_render(gl, true);
-         return false;
-      }
+   num_pixels = gl->vp.width * gl->vp.height;
 
-      gl->pbo_readback_valid[gl->pbo_readback_index] = false;
-      glBindBuffer(GL_PIXEL_PACK_BUFFER, gl->pbo_readback[gl->pbo_readback_index]);
-#ifdef HAVE_OPENGLES3
-      /* Slower path, but should work on all implementations at least. */
-      num_pixels = gl->vp.width * gl->vp.height;
-      ptr = (const uint8_t*)glMapBufferRange(GL_PIXEL_PACK_BUFFER,
-            0, num_pixels * sizeof(uint32_t), GL_MAP_READ_BIT);
+   gl->readback_buffer_screenshot = malloc(num_pixels * sizeof(uint32_t));
+   if (!gl->readback_buffer_screenshot)
+   {
+      RARCH_PERFORMANCE_STOP(read_viewport);
+      context_bind_hw_render(gl, true);
+      return false;
+   }
 
-      if (ptr)
-      {
-         unsigned x, y;
+   rarch_render_cached_frame();
 
-         for (y = 0; y < gl->vp.height; y++)
-         {
-            for (x = 0; x < gl->vp.width; x++, buffer += 3, ptr += 4)
-            {
-               buffer[0] = ptr[2]; /* RGBA -> BGR. */
-               buffer[1] = ptr[1];
-               buffer[2] = ptr[0];
-            }
-         }
-      }
-      else
-      {
-         RARCH_ERR("[GL]: Failed to map pixel unpack buffer.\n");
-         context_bind_hw_render(gl, true);
-         return false;
-      }
-#else
-      ptr = (const uint8_t*)glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
-      if (!ptr)
-      {
-         RARCH_ERR("[GL]: Failed to map pixel unpack buffer.\n");
-         context_bind_hw_render(gl, true);
-         return false;
-      }
+   dst = buffer;
+   src = (const uint8_t*)gl->readback_buffer_screenshot;
 
-      scaler_ctx_scale(&gl->pbo_readback_scaler, buffer, ptr);
-#endif
-      glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
-      glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
-   }
-   else /* Use slow synchronous readbacks. Use this with plain screenshots as we don't really care about performance in this case. */
-#endif
+   for (i = 0; i < num_pixels; i++, dst += 3, src += 4)
    {
-      unsigned i;
-      uint8_t *dst = NULL;
-      const uint8_t *src = NULL;
-
-      /* GLES2 only guarantees GL_RGBA/GL_UNSIGNED_BYTE 
-       * readbacks so do just that.
-       * GLES2 also doesn't support reading back data 
-       * from front buffer, so render a cached frame 
-       * and have gl_frame() do the readback while it's 
-       * in the back buffer.
-       *
-       * Keep codepath similar for GLES and desktop GL.
-       */
-
-      num_pixels = gl->vp.width * gl->vp.height;
-
-      gl->readback_buffer_screenshot = malloc(num_pixels * sizeof(uint32_t));
-      if (!gl->readback_buffer_screenshot)
-      {
-         RARCH_PERFORMANCE_STOP(read_viewport);
-         context_bind_hw_render(gl, true);
-         return false;
-      }
+      dst[0] = src[2]; /* RGBA -> BGR. */
+      dst[1] = src[1];
+      dst[2] = src[0];
+   }
 
-      rarch_render_cached_frame();
+   free(gl->readback_buffer_screenshot);
+   gl->readback_buffer_screenshot = NULL;
 
-      dst = buffer;
-      src = (const uint8_t*)gl->readback_buffer_screenshot;
+   RARCH_PERFORMANCE_STOP(read_viewport);
+   context_bind_hw_render(gl, true);
+   return true;
+}
 
-      for (i = 0; i < num_pixels; i++, dst += 3, src += 4)
-      {
-         dst[0] = src[2]; /* RGBA -> BGR. */
-         dst[1] = src[1];
-         dst[2] = src[0];
-      }
+#ifdef HAVE_GL_ASYNC_READBACK
+static bool gl_read_viewport_async(void *data,
+      video_viewport_read_cb_t cb, void *userdata)
+{
+   struct gl_readback *rb = NULL;
+   gl_t *gl               = (gl_t*)data;
 
-      free(gl->readback_buffer_screenshot);
-      gl->readback_buffer_screenshot = NULL;
+   if (!gl || !cb)
+      return false;
+
+   if (gl->readback_count == GL_READBACK_RING_SIZE)
+   {
+      /* Nothing has been read since the queue filled up. */
+      if (gl_readback_slot(gl, 0)->queued)
+         return false;
+
+      /* The GPU is far behind, so this waits on the oldest read. */
+      context_bind_hw_render(gl, false);
+      gl_readback_complete(gl);
+      context_bind_hw_render(gl, true);
    }
 
-   RARCH_PERFORMANCE_STOP(read_viewport);
-   context_bind_hw_render(gl, true);
+   rb           = gl_readback_slot(gl, gl->readback_count++);
+   rb->cb       = cb;
+   rb->userdata = userdata;
+   rb->queued   = true;
+   rb->skipped  = false;
    return true;
 }
 #endif
+#endif
 
 #ifdef HAVE_OVERLAY
 static void gl_free_overlay(gl_t *gl);
@@ -3134,6 +3810,11 @@ video_driver_t video_gl = {
    gl_viewport_info,
 
    gl_read_viewport,
+#ifdef HAVE_GL_ASYNC_READBACK
+   gl_read_viewport_async,
+#else
+   NULL,
+#endif
 
 #ifdef HAVE_OVERLAY
    gl_get_overlay_interface,
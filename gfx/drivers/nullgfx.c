@@ -130,6 +130,7 @@ video_driver_t video_null = {
    null_gfx_set_rotation,
    null_gfx_viewport_info,
    null_gfx_read_viewport,
+   NULL, /* read_viewport_async */
 
 #ifdef HAVE_OVERLAY
   NULL, /* overlay_interface */
@@ -1074,6 +1074,7 @@ video_driver_t video_omap = {
   omap_gfx_set_rotation,
   omap_gfx_viewport_info,
   omap_gfx_read_viewport,
+  NULL, /* read_viewport_async */
 
 #ifdef HAVE_OVERLAY
   NULL, /* overlay_interface */
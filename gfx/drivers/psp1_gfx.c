@@ -894,6 +894,7 @@ video_driver_t video_psp1 = {
    psp_set_rotation,
    psp_viewport_info,
    psp_read_viewport,
+   NULL, /* read_viewport_async */
 #ifdef HAVE_OVERLAY
    NULL,
 #endif
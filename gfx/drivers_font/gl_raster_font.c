@@ -17,35 +17,126 @@
 #include "../gl_common.h"
 #include "../video_shader_driver.h"
 
-#define emit(c, vx, vy) do { \
-   font_vertex[     2 * (6 * i + c) + 0] = (x + (delta_x + off_x + vx * width) * scale) * inv_win_width; \
-   font_vertex[     2 * (6 * i + c) + 1] = (y + (delta_y - off_y - vy * height) * scale) * inv_win_height; \
-   font_tex_coords[ 2 * (6 * i + c) + 0] = (tex_x + vx * width) * inv_tex_size_x; \
-   font_tex_coords[ 2 * (6 * i + c) + 1] = (tex_y + vy * height) * inv_tex_size_y; \
-   font_color[      4 * (6 * i + c) + 0] = color[0]; \
-   font_color[      4 * (6 * i + c) + 1] = color[1]; \
-   font_color[      4 * (6 * i + c) + 2] = color[2]; \
-   font_color[      4 * (6 * i + c) + 3] = color[3]; \
-} while(0)
+/* Direct-mapped cache of laid out messages. Must be a power of two. */
+#define GL_RASTER_LAYOUT_CACHE_SIZE 64
+
+/* Per glyph: x0, y0, x1, y1 in scaled pixels relative to the pen origin,
+ * followed by s0, t0, s1, t1 in atlas texels. */
+#define GL_RASTER_QUAD_FLOATS 8
+
+struct gl_raster_layout
+{
+   char *msg;
+   uint32_t hash;
+   GLfloat scale;
+   int width;
+   unsigned glyphs;
+   unsigned capacity;
+   GLfloat *quads;
+};
 
-#define MAX_MSG_LEN_CHUNK 64
+/* Vertices queued up for a single draw call. */
+struct gl_raster_block
+{
+   GLfloat *vertex;
+   GLfloat *tex_coord;
+   GLfloat *color;
+   unsigned vertices;
+   unsigned capacity;
+
+   bool active;
+   bool full_screen;
+   unsigned vp_width, vp_height;
+};
 
 typedef struct
 {
    gl_t *gl;
    GLuint tex;
    unsigned tex_width, tex_height;
+   unsigned atlas_generation;
+   /* Atlas rows above this are already in the texture. */
+   unsigned synced_y;
 
    const font_renderer_driver_t *font_driver;
    void *font_data;
+
+   struct gl_raster_layout layouts[GL_RASTER_LAYOUT_CACHE_SIZE];
+   struct gl_raster_block block;
 } gl_raster_t;
 
+static void gl_raster_font_draw_block(gl_raster_t *font);
+
+/**
+ * gl_raster_font_sync_atlas:
+ * @font                 : Pointer to font handle.
+ *
+ * Uploads the atlas rows the font renderer changed
+ * since the last upload, growing the texture if needed.
+ **/
+static void gl_raster_font_sync_atlas(gl_raster_t *font)
+{
+   unsigned top, bottom;
+   uint8_t *tmp_buffer;
+   gl_t *gl                       = font->gl;
+   const struct font_atlas *atlas =
+      font->font_driver->get_atlas(font->font_data);
+
+   if (font->tex_width && atlas->generation == font->atlas_generation)
+      return;
+
+   if (atlas->width > font->tex_width || atlas->height > font->tex_height)
+   {
+      /* Queued vertices are normalized against the old size. */
+      gl_raster_font_draw_block(font);
+
+      font->tex_width  = next_pow2(atlas->width);
+      font->tex_height = next_pow2(atlas->height);
+
+      /* Ideally, we'd use single component textures, but the 
+       * difference in ways to do that between core GL and GLES/legacy GL
+       * is too great to bother going down that route. */
+      glBindTexture(GL_TEXTURE_2D, font->tex);
+      glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, font->tex_width,
+            font->tex_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+      font->synced_y = 0;
+   }
+   else
+      glBindTexture(GL_TEXTURE_2D, font->tex);
+
+   top    = font->synced_y;
+   bottom = atlas->used_height ? atlas->used_height : atlas->height;
+
+   tmp_buffer = (uint8_t*)malloc(atlas->width * (bottom - top) * 4);
+
+   if (tmp_buffer)
+   {
+      unsigned i;
+      uint8_t       *dst = tmp_buffer;
+      const uint8_t *src = atlas->buffer + top * atlas->width;
+
+      for (i = 0; i < atlas->width * (bottom - top); i++)
+      {
+         *dst++ = 0xff;
+         *dst++ = 0xff;
+         *dst++ = 0xff;
+         *dst++ = *src++;
+      }
+
+      glTexSubImage2D(GL_TEXTURE_2D, 0, 0, top, atlas->width,
+            bottom - top, GL_RGBA, GL_UNSIGNED_BYTE, tmp_buffer);
+      free(tmp_buffer);
+
+      font->synced_y = atlas->open_y;
+   }
+
+   font->atlas_generation = atlas->generation;
+   glBindTexture(GL_TEXTURE_2D, gl->texture[gl->tex_index]);
+}
+
 static void *gl_raster_font_init_font(void *gl_data,
       const char *font_path, float font_size)
 {
-   unsigned width, height;
-   uint8_t *tmp_buffer;
-   const struct font_atlas *atlas = NULL;
    gl_raster_t *font = (gl_raster_t*)calloc(1, sizeof(*font));
 
    if (!font)
@@ -68,47 +159,25 @@ static void *gl_raster_font_init_font(void *gl_data,
    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 
-   atlas = font->font_driver->get_atlas(font->font_data);
-
-   width = next_pow2(atlas->width);
-   height = next_pow2(atlas->height);
-
-   /* Ideally, we'd use single component textures, but the 
-    * difference in ways to do that between core GL and GLES/legacy GL
-    * is too great to bother going down that route. */
-   glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height,
-         0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
-
-   tmp_buffer = (uint8_t*)malloc(atlas->width * atlas->height * 4);
-
-   if (tmp_buffer)
+   if (font->font_driver->set_max_height)
    {
-      unsigned i;
-      uint8_t       *dst = tmp_buffer;
-      const uint8_t *src = atlas->buffer;
-
-      for (i = 0; i < atlas->width * atlas->height; i++)
-      {
-         *dst++ = 0xff;
-         *dst++ = 0xff;
-         *dst++ = 0xff;
-         *dst++ = *src++;
-      }
-
-      glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, atlas->width,
-            atlas->height, GL_RGBA, GL_UNSIGNED_BYTE, tmp_buffer);
-      free(tmp_buffer);
+      GLint max_size = 0;
+
+      /* The texture is rounded up to a power of two, so
+       * cap the atlas at the largest one the driver takes. */
+      glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_size);
+      if (max_size > 0)
+         font->font_driver->set_max_height(font->font_data,
+               prev_pow2(max_size));
    }
 
-   font->tex_width  = width;
-   font->tex_height = height;
-
-   glBindTexture(GL_TEXTURE_2D, font->gl->texture[font->gl->tex_index]);
+   gl_raster_font_sync_atlas(font);
    return font;
 }
 
 static void gl_raster_font_free_font(void *data)
 {
+   unsigned i;
    gl_raster_t *font = (gl_raster_t*)data;
    if (!font)
       return;
@@ -116,119 +185,289 @@ static void gl_raster_font_free_font(void *data)
    if (font->font_driver && font->font_data)
       font->font_driver->free(font->font_data);
 
+   for (i = 0; i < GL_RASTER_LAYOUT_CACHE_SIZE; i++)
+   {
+      free(font->layouts[i].msg);
+      free(font->layouts[i].quads);
+   }
+
+   free(font->block.vertex);
+   free(font->block.tex_coord);
+   free(font->block.color);
+
    glDeleteTextures(1, &font->tex);
    free(font);
 }
 
-static int get_message_width(gl_raster_t *font, const char *msg)
+/**
+ * gl_raster_font_utf8_next:
+ * @str                  : Pointer to current position in string.
+ *
+ * Decodes one UTF-8 sequence and advances @str past it.
+ * Malformed bytes are passed through one at a time,
+ * the way they were drawn before UTF-8 was decoded.
+ *
+ * Returns: decoded code point.
+ **/
+static uint32_t gl_raster_font_utf8_next(const char **str)
 {
-   int delta_x;
-   unsigned i, msg_len_full, msg_len;
-
-   msg_len_full   = strlen(msg);
-   msg_len        = min(msg_len_full, MAX_MSG_LEN_CHUNK);
+   unsigned i, len;
+   const uint8_t *s = (const uint8_t*)*str;
+   uint32_t code    = s[0];
 
-   delta_x        = 0;
+   if (code >= 0xc0 && code < 0xe0)
+   {
+      len   = 2;
+      code &= 0x1f;
+   }
+   else if (code >= 0xe0 && code < 0xf0)
+   {
+      len   = 3;
+      code &= 0x0f;
+   }
+   else if (code >= 0xf0 && code < 0xf8)
+   {
+      len   = 4;
+      code &= 0x07;
+   }
+   else
+      len   = 1;
 
-   while (msg_len_full)
+   for (i = 1; i < len; i++)
    {
-      for (i = 0; i < msg_len; i++)
+      if ((s[i] & 0xc0) != 0x80)
       {
-         const struct font_glyph *glyph = 
-            font->font_driver->get_glyph(font->font_data, (uint8_t)msg[i]);
-         if (!glyph)
-            glyph = font->font_driver->get_glyph(font->font_data, '?'); /* Do something smarter here ... */
-         if (!glyph)
-            continue;
-
-         delta_x += glyph->advance_x;
+         *str += 1;
+         return s[0];
       }
+      code = (code << 6) | (s[i] & 0x3f);
+   }
+
+   *str += len;
+   return code;
+}
+
+static uint32_t gl_raster_font_hash(const char *msg, GLfloat scale)
+{
+   uint32_t hash = 5381;
+
+   while (*msg)
+      hash = (hash << 5) + hash + (uint8_t)*msg++;
+
+   return hash ^ (uint32_t)(scale * 1024.0f);
+}
+
+/**
+ * gl_raster_font_get_layout:
+ * @font                 : Pointer to font handle.
+ * @msg                  : Message to lay out.
+ * @scale                : Scale factor.
+ *
+ * Looks up the glyph quads for @msg at @scale in the layout
+ * cache, laying the message out again on a miss. Menus draw
+ * the same labels every frame, so this saves the glyph lookups
+ * and the width pass for align_right.
+ *
+ * Returns: layout, or NULL on allocation failure.
+ **/
+static const struct gl_raster_layout *gl_raster_font_get_layout(
+      gl_raster_t *font, const char *msg, GLfloat scale)
+{
+   size_t len;
+   int delta_x, delta_y;
+   GLfloat *quad                  = NULL;
+   uint32_t hash                  = gl_raster_font_hash(msg, scale);
+   struct gl_raster_layout *layout =
+      &font->layouts[hash & (GL_RASTER_LAYOUT_CACHE_SIZE - 1)];
+
+   if (layout->msg && layout->hash == hash && layout->scale == scale
+         && !strcmp(layout->msg, msg))
+      return layout;
+
+   free(layout->msg);
+   layout->msg    = NULL;
+   layout->glyphs = 0;
+
+   /* Never more glyphs than bytes. */
+   len = strlen(msg);
+   if (len > layout->capacity)
+   {
+      GLfloat *quads = (GLfloat*)realloc(layout->quads,
+            len * GL_RASTER_QUAD_FLOATS * sizeof(GLfloat));
+      if (!quads)
+         return NULL;
+
+      layout->quads    = quads;
+      layout->capacity = len;
+   }
+
+   layout->msg = strdup(msg);
+   if (!layout->msg)
+      return NULL;
 
-      msg_len_full -= msg_len;
-      msg += msg_len;
-      msg_len = min(msg_len_full, MAX_MSG_LEN_CHUNK);
+   layout->hash  = hash;
+   layout->scale = scale;
+   quad          = layout->quads;
+   delta_x       = 0;
+   delta_y       = 0;
+
+   while (*msg)
+   {
+      int off_x, off_y;
+      uint32_t code                  = gl_raster_font_utf8_next(&msg);
+      const struct font_glyph *glyph = 
+         font->font_driver->get_glyph(font->font_data, code);
+      if (!glyph)
+         glyph = font->font_driver->get_glyph(font->font_data, '?'); /* Do something smarter here ... */
+      if (!glyph)
+         continue;
+
+      off_x   = glyph->draw_offset_x;
+      off_y   = glyph->draw_offset_y;
+
+      *quad++ = (delta_x + off_x) * scale;
+      *quad++ = (delta_y - off_y) * scale;
+      *quad++ = (delta_x + off_x + (int)glyph->width) * scale;
+      *quad++ = (delta_y - off_y - (int)glyph->height) * scale;
+      *quad++ = glyph->atlas_offset_x;
+      *quad++ = glyph->atlas_offset_y;
+      *quad++ = glyph->atlas_offset_x + glyph->width;
+      *quad++ = glyph->atlas_offset_y + glyph->height;
+
+      delta_x += glyph->advance_x;
+      delta_y -= glyph->advance_y;
+      layout->glyphs++;
    }
 
-   return delta_x;
+   layout->width = delta_x;
+   return layout;
 }
 
-static void render_message(gl_raster_t *font, const char *msg, GLfloat scale,
-      const GLfloat color[4], GLfloat pos_x, GLfloat pos_y, bool align_right)
+static bool gl_raster_font_reserve(struct gl_raster_block *block,
+      unsigned vertices)
 {
-   int x, y, delta_x, delta_y;
-   float inv_tex_size_x, inv_tex_size_y, inv_win_width, inv_win_height;
-   unsigned i, msg_len_full, msg_len;
-   GLfloat font_tex_coords[2 * 6 * MAX_MSG_LEN_CHUNK];
-   GLfloat font_vertex[2 * 6 * MAX_MSG_LEN_CHUNK]; 
-   GLfloat font_color[4 * 6 * MAX_MSG_LEN_CHUNK];
-   gl_t *gl = font->gl;
+   GLfloat *ptr      = NULL;
+   unsigned capacity = block->capacity ? block->capacity : 1024;
 
-   glBindTexture(GL_TEXTURE_2D, font->tex);
+   if (block->vertices + vertices <= block->capacity)
+      return true;
+
+   while (capacity < block->vertices + vertices)
+      capacity *= 2;
+
+   if (!(ptr = (GLfloat*)realloc(block->vertex,
+               2 * capacity * sizeof(GLfloat))))
+      return false;
+   block->vertex = ptr;
 
-   msg_len_full   = strlen(msg);
-   msg_len        = min(msg_len_full, MAX_MSG_LEN_CHUNK);
+   if (!(ptr = (GLfloat*)realloc(block->tex_coord,
+               2 * capacity * sizeof(GLfloat))))
+      return false;
+   block->tex_coord = ptr;
 
-   x              = roundf(pos_x * gl->vp.width);
-   y              = roundf(pos_y * gl->vp.height);
-   delta_x        = 0;
-   delta_y        = 0;
+   if (!(ptr = (GLfloat*)realloc(block->color,
+               4 * capacity * sizeof(GLfloat))))
+      return false;
+   block->color = ptr;
+
+   block->capacity = capacity;
+   return true;
+}
+
+#define emit(vx, vy, s, t) do { \
+   *vertex++    = vx; \
+   *vertex++    = vy; \
+   *tex_coord++ = s; \
+   *tex_coord++ = t; \
+} while(0)
+
+static void render_message(gl_raster_t *font,
+      const struct gl_raster_layout *layout, const GLfloat color[4],
+      GLfloat pos_x, GLfloat pos_y, bool align_right)
+{
+   int x, y;
+   unsigned i;
+   float inv_tex_size_x, inv_tex_size_y, inv_win_width, inv_win_height;
+   struct gl_raster_block *block = &font->block;
+   GLfloat *vertex               = block->vertex + 2 * block->vertices;
+   GLfloat *tex_coord            = block->tex_coord + 2 * block->vertices;
+   GLfloat *font_color           = block->color + 4 * block->vertices;
+   const GLfloat *quad           = layout->quads;
+
+   x              = roundf(pos_x * block->vp_width);
+   y              = roundf(pos_y * block->vp_height);
 
    if (align_right)
-      x -= get_message_width(font, msg);
+      x -= layout->width;
 
    inv_tex_size_x = 1.0f / font->tex_width;
    inv_tex_size_y = 1.0f / font->tex_height;
-   inv_win_width  = 1.0f / font->gl->vp.width;
-   inv_win_height = 1.0f / font->gl->vp.height;
+   inv_win_width  = 1.0f / block->vp_width;
+   inv_win_height = 1.0f / block->vp_height;
 
-   while (msg_len_full)
+   for (i = 0; i < layout->glyphs; i++, quad += GL_RASTER_QUAD_FLOATS)
    {
-      /* Rebind shaders so attrib cache gets reset. */
-      if (gl->shader && gl->shader->use)
-         gl->shader->use(gl, GL_SHADER_STOCK_BLEND);
+      GLfloat x0 = (x + quad[0]) * inv_win_width;
+      GLfloat y0 = (y + quad[1]) * inv_win_height;
+      GLfloat x1 = (x + quad[2]) * inv_win_width;
+      GLfloat y1 = (y + quad[3]) * inv_win_height;
+      GLfloat s0 = quad[4] * inv_tex_size_x;
+      GLfloat t0 = quad[5] * inv_tex_size_y;
+      GLfloat s1 = quad[6] * inv_tex_size_x;
+      GLfloat t1 = quad[7] * inv_tex_size_y;
+
+      emit(x0, y1, s0, t1); /* Bottom-left */
+      emit(x1, y1, s1, t1); /* Bottom-right */
+      emit(x0, y0, s0, t0); /* Top-left */
+
+      emit(x1, y0, s1, t0); /* Top-right */
+      emit(x0, y0, s0, t0); /* Top-left */
+      emit(x1, y1, s1, t1); /* Bottom-right */
+   }
 
-      for (i = 0; i < msg_len; i++)
-      {
-         int off_x, off_y, tex_x, tex_y, width, height;
-         const struct font_glyph *glyph = 
-            font->font_driver->get_glyph(font->font_data, (uint8_t)msg[i]);
-         if (!glyph)
-            glyph = font->font_driver->get_glyph(font->font_data, '?'); /* Do something smarter here ... */
-         if (!glyph)
-            continue;
-
-         off_x  = glyph->draw_offset_x;
-         off_y  = glyph->draw_offset_y;
-         tex_x  = glyph->atlas_offset_x;
-         tex_y  = glyph->atlas_offset_y;
-         width  = glyph->width;
-         height = glyph->height;
-
-         emit(0, 0, 1); /* Bottom-left */
-         emit(1, 1, 1); /* Bottom-right */
-         emit(2, 0, 0); /* Top-left */
-
-         emit(3, 1, 0); /* Top-right */
-         emit(4, 0, 0); /* Top-left */
-         emit(5, 1, 1); /* Bottom-right */
+   for (i = 0; i < 6 * layout->glyphs; i++, font_color += 4)
+      memcpy(font_color, color, 4 * sizeof(GLfloat));
+
+   block->vertices += 6 * layout->glyphs;
+}
 #undef emit
 
-         delta_x += glyph->advance_x;
-         delta_y -= glyph->advance_y;
-      }
+/**
+ * gl_raster_font_draw_block:
+ * @font                 : Pointer to font handle.
+ *
+ * Draws all queued vertices with a single draw call
+ * and empties the queue.
+ **/
+static void gl_raster_font_draw_block(gl_raster_t *font)
+{
+   struct gl_raster_block *block = &font->block;
+   gl_t *gl = font->gl;
 
-      gl->coords.tex_coord = font_tex_coords;
-      gl->coords.vertex    = font_vertex;
-      gl->coords.color     = font_color;
-      gl->coords.vertices  = 6 * msg_len;
-      gl->shader->set_coords(&gl->coords);
-      gl->shader->set_mvp(gl, &gl->mvp_no_rot);
-      glDrawArrays(GL_TRIANGLES, 0, 6 * msg_len);
-
-      msg_len_full -= msg_len;
-      msg += msg_len;
-      msg_len = min(msg_len_full, MAX_MSG_LEN_CHUNK);
-   }
+   if (!block->vertices)
+      return;
+
+   gl_set_viewport(gl, gl->win_width, gl->win_height,
+         block->full_screen, false);
+   glEnable(GL_BLEND);
+   glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+   glBlendEquation(GL_FUNC_ADD);
+
+   glBindTexture(GL_TEXTURE_2D, font->tex);
+
+   /* Rebind shaders so attrib cache gets reset. */
+   if (gl->shader && gl->shader->use)
+      gl->shader->use(gl, GL_SHADER_STOCK_BLEND);
+
+   gl->coords.tex_coord = block->tex_coord;
+   gl->coords.vertex    = block->vertex;
+   gl->coords.color     = block->color;
+   gl->coords.vertices  = block->vertices;
+   gl->shader->set_coords(&gl->coords);
+   gl->shader->set_mvp(gl, &gl->mvp_no_rot);
+   glDrawArrays(GL_TRIANGLES, 0, block->vertices);
+
+   block->vertices = 0;
 
    /* Post - Go back to old rendering path. */
    gl->coords.vertex    = gl->vertex_ptr;
@@ -236,6 +475,9 @@ static void render_message(gl_raster_t *font, const char *msg, GLfloat scale,
    gl->coords.color     = gl->white_color_ptr;
    gl->coords.vertices  = 4;
    glBindTexture(GL_TEXTURE_2D, gl->texture[gl->tex_index]);
+
+   glDisable(GL_BLEND);
+   gl_set_viewport(gl, gl->win_width, gl->win_height, false, true);
 }
 
 static void gl_raster_font_render_msg(void *data, const char *msg,
@@ -247,6 +489,7 @@ static void gl_raster_font_render_msg(void *data, const char *msg,
    bool full_screen;
    bool align_right;
    gl_t *gl = NULL;
+   const struct gl_raster_layout *layout = NULL;
    gl_raster_t *font = (gl_raster_t*)data;
 
    if (!font)
@@ -292,11 +535,28 @@ static void gl_raster_font_render_msg(void *data, const char *msg,
       drop_mod = 0.3f;
    }
 
-   gl_set_viewport(gl, gl->win_width, gl->win_height,
-         full_screen, false);
-   glEnable(GL_BLEND);
-   glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-   glBlendEquation(GL_FUNC_ADD);
+   layout = gl_raster_font_get_layout(font, msg, scale);
+   if (!layout || !layout->glyphs)
+      return;
+
+   /* Laying out may have added glyphs to the atlas. */
+   gl_raster_font_sync_atlas(font);
+
+   if (font->block.full_screen != full_screen)
+      gl_raster_font_draw_block(font);
+
+   if (!font->block.vertices)
+   {
+      gl_set_viewport(gl, gl->win_width, gl->win_height,
+            full_screen, false);
+      font->block.full_screen = full_screen;
+      font->block.vp_width    = gl->vp.width;
+      font->block.vp_height   = gl->vp.height;
+   }
+
+   if (!gl_raster_font_reserve(&font->block,
+            6 * layout->glyphs * ((drop_x || drop_y) ? 2 : 1)))
+      return;
 
    if (drop_x || drop_y)
    {
@@ -305,14 +565,14 @@ static void gl_raster_font_render_msg(void *data, const char *msg,
       color_dark[2] = color[2] * drop_mod;
       color_dark[3] = color[3];
 
-      render_message(font, msg, scale, color_dark,
-            x + scale * drop_x / gl->vp.width, y + 
-            scale * drop_y / gl->vp.height, align_right);
+      render_message(font, layout, color_dark,
+            x + scale * drop_x / font->block.vp_width, y + 
+            scale * drop_y / font->block.vp_height, align_right);
    }
-   render_message(font, msg, scale, color, x, y, align_right);
+   render_message(font, layout, color, x, y, align_right);
 
-   glDisable(GL_BLEND);
-   gl_set_viewport(gl, gl->win_width, gl->win_height, false, true);
+   if (!font->block.active)
+      gl_raster_font_draw_block(font);
 }
 
 static const struct font_glyph *gl_raster_font_get_glyph(
@@ -322,7 +582,26 @@ static const struct font_glyph *gl_raster_font_get_glyph(
 
    if (!font)
       return NULL;
-   return font->font_driver->get_glyph((void*)font->font_driver, code);
+   return font->font_driver->get_glyph(font->font_data, code);
+}
+
+static void gl_raster_font_begin_block(void *data)
+{
+   gl_raster_t *font = (gl_raster_t*)data;
+
+   if (font)
+      font->block.active = true;
+}
+
+static void gl_raster_font_flush_block(void *data)
+{
+   gl_raster_t *font = (gl_raster_t*)data;
+
+   if (!font)
+      return;
+
+   gl_raster_font_draw_block(font);
+   font->block.active = false;
 }
 
 gl_font_renderer_t gl_raster_font = {
@@ -331,4 +610,6 @@ gl_font_renderer_t gl_raster_font = {
    gl_raster_font_render_msg,
    "GL raster",
    gl_raster_font_get_glyph,
+   gl_raster_font_begin_block,
+   gl_raster_font_flush_block,
 };
@@ -134,6 +134,7 @@ font_renderer_driver_t bitmap_font_renderer = {
    font_renderer_bmp_get_glyph,
    font_renderer_bmp_free,
    font_renderer_bmp_get_default_font,
+   NULL,
    "bitmap",
 };
 
@@ -292,5 +292,6 @@ font_renderer_driver_t coretext_font_renderer = {
   font_renderer_ct_get_glyph,
   font_renderer_ct_free,
   font_renderer_ct_get_default_font,
+  NULL,
   "coretext",
 };
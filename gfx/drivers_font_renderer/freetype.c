@@ -28,13 +28,38 @@
 #define FT_ATLAS_COLS 16
 #define FT_ATLAS_SIZE (FT_ATLAS_ROWS * FT_ATLAS_COLS)
 
+/* The atlas grows by doubling its row count
+ * when glyphs outside of ASCII are requested. */
+#define FT_ATLAS_MAX_ROWS 256
+
+/* Maps non-ASCII codes to atlas slots. Must be a power of two. */
+#define FT_GLYPH_MAP_SIZE 8192
+#define FT_GLYPH_MISSING -1
+
+struct ft_glyph_entry
+{
+   uint32_t code; /* 0 marks an empty entry. */
+   int slot;
+};
+
 typedef struct freetype_renderer
 {
    FT_Library lib;
    FT_Face face;
 
    struct font_atlas atlas;
-   struct font_glyph glyphs[FT_ATLAS_SIZE];
+   unsigned cell_width;
+   unsigned cell_height;
+   unsigned rows;
+   unsigned max_rows;
+   unsigned glyph_count;
+
+   /* One block per atlas row, so glyph pointers stay
+    * valid while the atlas grows. */
+   struct font_glyph *glyphs[FT_ATLAS_MAX_ROWS];
+
+   struct ft_glyph_entry map[FT_GLYPH_MAP_SIZE];
+   unsigned map_count;
 } font_renderer_t;
 
 static const struct font_atlas *font_renderer_ft_get_atlas(void *data)
@@ -45,22 +70,166 @@ static const struct font_atlas *font_renderer_ft_get_atlas(void *data)
    return &handle->atlas;
 }
 
+static bool font_renderer_ft_grow_atlas(font_renderer_t *handle)
+{
+   unsigned i, rows;
+   size_t old_size, new_size;
+   uint8_t *buffer = NULL;
+
+   if (handle->rows >= handle->max_rows)
+      return false;
+
+   rows = handle->rows ? handle->rows * 2 : FT_ATLAS_ROWS;
+   if (rows > handle->max_rows)
+      rows = handle->max_rows;
+
+   old_size = handle->atlas.width * handle->atlas.height;
+   new_size = handle->atlas.width * rows * handle->cell_height;
+
+   buffer = (uint8_t*)realloc(handle->atlas.buffer, new_size);
+   if (!buffer)
+      return false;
+
+   memset(buffer + old_size, 0, new_size - old_size);
+   handle->atlas.buffer = buffer;
+   handle->atlas.height = rows * handle->cell_height;
+
+   for (i = handle->rows; i < rows; i++)
+   {
+      handle->glyphs[i] = (struct font_glyph*)
+         calloc(FT_ATLAS_COLS, sizeof(struct font_glyph));
+      if (!handle->glyphs[i])
+         break;
+   }
+
+   if (i == handle->rows)
+      return false;
+
+   handle->rows = i;
+   return true;
+}
+
+static bool font_renderer_ft_render_glyph(font_renderer_t *handle,
+      uint32_t code, unsigned slot)
+{
+   unsigned r;
+   uint8_t *dst             = NULL;
+   const uint8_t *src       = NULL;
+   FT_GlyphSlot ft_slot     = NULL;
+   struct font_glyph *glyph = NULL;
+
+   if (slot >= handle->rows * FT_ATLAS_COLS
+         && !font_renderer_ft_grow_atlas(handle))
+      return false;
+
+   if (FT_Load_Char(handle->face, code, FT_LOAD_RENDER))
+      return false;
+
+   ft_slot = handle->face->glyph;
+   glyph   = &handle->glyphs[slot / FT_ATLAS_COLS][slot % FT_ATLAS_COLS];
+
+   /* Glyphs larger than the cell size picked from ASCII are clipped. */
+   glyph->width          = min((unsigned)ft_slot->bitmap.width,
+         handle->cell_width);
+   glyph->height         = min((unsigned)ft_slot->bitmap.rows,
+         handle->cell_height);
+   glyph->atlas_offset_x = (slot % FT_ATLAS_COLS) * handle->cell_width;
+   glyph->atlas_offset_y = (slot / FT_ATLAS_COLS) * handle->cell_height;
+   glyph->advance_x      = ft_slot->advance.x >> 6;
+   glyph->advance_y      = ft_slot->advance.y >> 6;
+   glyph->draw_offset_x  = ft_slot->bitmap_left;
+   glyph->draw_offset_y  = -ft_slot->bitmap_top;
+
+   dst = handle->atlas.buffer + glyph->atlas_offset_x
+      + glyph->atlas_offset_y * handle->atlas.width;
+   src = (const uint8_t*)ft_slot->bitmap.buffer;
+
+   /* Some glyphs can be blank. */
+   if (src)
+      for (r = 0; r < glyph->height;
+            r++, dst += handle->atlas.width, src += ft_slot->bitmap.pitch)
+         memcpy(dst, src, glyph->width);
+
+   /* Slots are handed out in order, so only this row can still change. */
+   handle->atlas.open_y      = glyph->atlas_offset_y;
+   handle->atlas.used_height = glyph->atlas_offset_y + handle->cell_height;
+   handle->atlas.generation++;
+   return true;
+}
+
+static const struct font_glyph *font_renderer_ft_lookup_glyph(
+      font_renderer_t *handle, uint32_t code)
+{
+   int slot = FT_GLYPH_MISSING;
+   unsigned i = (code * 2654435761u) & (FT_GLYPH_MAP_SIZE - 1);
+
+   while (handle->map[i].code)
+   {
+      if (handle->map[i].code == code)
+      {
+         slot = handle->map[i].slot;
+         if (slot == FT_GLYPH_MISSING)
+            return NULL;
+         return &handle->glyphs[slot / FT_ATLAS_COLS][slot % FT_ATLAS_COLS];
+      }
+
+      i = (i + 1) & (FT_GLYPH_MAP_SIZE - 1);
+   }
+
+   /* Keep probe sequences short. Codes which don't fit anymore
+    * simply show up as missing. */
+   if (handle->map_count >= FT_GLYPH_MAP_SIZE * 3 / 4)
+      return NULL;
+
+   if (FT_Get_Char_Index(handle->face, code)
+         && font_renderer_ft_render_glyph(handle, code, handle->glyph_count))
+      slot = handle->glyph_count++;
+
+   handle->map[i].code = code;
+   handle->map[i].slot = slot;
+   handle->map_count++;
+
+   if (slot == FT_GLYPH_MISSING)
+      return NULL;
+   return &handle->glyphs[slot / FT_ATLAS_COLS][slot % FT_ATLAS_COLS];
+}
+
 static const struct font_glyph *font_renderer_ft_get_glyph(
       void *data, uint32_t code)
 {
    font_renderer_t *handle = (font_renderer_t*)data;
    if (!handle)
       return NULL;
-   return code < FT_ATLAS_SIZE ? &handle->glyphs[code] : NULL;
+
+   if (code < FT_ATLAS_SIZE)
+      return &handle->glyphs[code / FT_ATLAS_COLS][code % FT_ATLAS_COLS];
+   return font_renderer_ft_lookup_glyph(handle, code);
+}
+
+static void font_renderer_ft_set_max_height(void *data,
+      unsigned max_height)
+{
+   unsigned rows;
+   font_renderer_t *handle = (font_renderer_t*)data;
+   if (!handle || !handle->cell_height)
+      return;
+
+   rows = min(max_height / handle->cell_height, FT_ATLAS_MAX_ROWS);
+
+   /* Rows already handed out stay. */
+   handle->max_rows = max(rows, handle->rows);
 }
 
 static void font_renderer_ft_free(void *data)
 {
+   unsigned i;
    font_renderer_t *handle = (font_renderer_t*)data;
    if (!handle)
       return;
 
    free(handle->atlas.buffer);
+   for (i = 0; i < handle->rows; i++)
+      free(handle->glyphs[i]);
 
    if (handle->face)
       FT_Done_Face(handle->face);
@@ -72,90 +241,38 @@ static void font_renderer_ft_free(void *data)
 static bool font_renderer_create_atlas(font_renderer_t *handle)
 {
    unsigned i;
-   bool ret = true;
-
-   uint8_t *buffer[FT_ATLAS_SIZE] = {NULL};
-   unsigned pitches[FT_ATLAS_SIZE] = {0};
-
-   unsigned max_width = 0;
+   unsigned max_width  = 0;
    unsigned max_height = 0;
 
+   /* Size the cells after ASCII, with room for
+    * full-width glyphs at the current pixel size. */
    for (i = 0; i < FT_ATLAS_SIZE; i++)
    {
-      struct font_glyph *glyph = &handle->glyphs[i];
-
-      if (!glyph)
-         continue;
-
       if (FT_Load_Char(handle->face, i, FT_LOAD_RENDER))
-      {
-         ret = false;
-         goto end;
-      }
+         return false;
 
-      FT_Render_Glyph(handle->face->glyph, FT_RENDER_MODE_NORMAL);
-      FT_GlyphSlot slot = handle->face->glyph;
-
-      /* Some glyphs can be blank. */
-      buffer[i] = (uint8_t*)calloc(slot->bitmap.rows * slot->bitmap.pitch, 1);
-
-      glyph->width = slot->bitmap.width;
-      glyph->height = slot->bitmap.rows;
-      pitches[i] = slot->bitmap.pitch;
-
-      glyph->advance_x = slot->advance.x >> 6;
-      glyph->advance_y = slot->advance.y >> 6;
-      glyph->draw_offset_x = slot->bitmap_left;
-      glyph->draw_offset_y = -slot->bitmap_top;
-
-      if (buffer[i])
-         memcpy(buffer[i], slot->bitmap.buffer,
-               slot->bitmap.rows * pitches[i]);
-      max_width = max(max_width, (unsigned)slot->bitmap.width);
-      max_height = max(max_height, (unsigned)slot->bitmap.rows);
+      max_width  = max(max_width, (unsigned)handle->face->glyph->bitmap.width);
+      max_height = max(max_height, (unsigned)handle->face->glyph->bitmap.rows);
    }
 
-   handle->atlas.width = max_width * FT_ATLAS_COLS;
-   handle->atlas.height = max_height * FT_ATLAS_ROWS;
+   handle->cell_width   = max(max_width,
+         (unsigned)handle->face->size->metrics.x_ppem);
+   handle->cell_height  = max(max_height,
+         (unsigned)handle->face->size->metrics.y_ppem);
+   handle->atlas.width  = handle->cell_width * FT_ATLAS_COLS;
+   handle->atlas.height = 0;
+   handle->max_rows     = FT_ATLAS_MAX_ROWS;
 
-   handle->atlas.buffer = (uint8_t*)
-      calloc(handle->atlas.width * handle->atlas.height, 1);
+   if (!font_renderer_ft_grow_atlas(handle))
+      return false;
 
-   if (!handle->atlas.buffer)
-   {
-      ret = false;
-      goto end;
-   }
-
-   /* Blit our texture atlas. */
+   /* ASCII is always present and indexed directly. */
    for (i = 0; i < FT_ATLAS_SIZE; i++)
-   {
-      unsigned r, c;
-      uint8_t *dst      = NULL;
-      unsigned offset_x = (i % FT_ATLAS_COLS) * max_width;
-      unsigned offset_y = (i / FT_ATLAS_COLS) * max_height;
+      if (!font_renderer_ft_render_glyph(handle, i, i))
+         return false;
 
-      handle->glyphs[i].atlas_offset_x = offset_x;
-      handle->glyphs[i].atlas_offset_y = offset_y;
-
-      dst = (uint8_t*)handle->atlas.buffer;
-      dst += offset_x + offset_y * handle->atlas.width;
-
-      if (buffer[i])
-      {
-         const uint8_t *src = (const uint8_t*)buffer[i];
-
-         for (r = 0; r < handle->glyphs[i].height;
-               r++, dst += handle->atlas.width, src += pitches[i])
-            for (c = 0; c < handle->glyphs[i].width; c++)
-               dst[c] = src[c];
-      }
-   }
-
-end:
-   for (i = 0; i < FT_ATLAS_SIZE; i++)
-      free(buffer[i]);
-   return ret;
+   handle->glyph_count = FT_ATLAS_SIZE;
+   return true;
 }
 
 static void *font_renderer_ft_init(const char *font_path, float font_size)
@@ -232,5 +349,6 @@ font_renderer_driver_t freetype_font_renderer = {
    font_renderer_ft_get_glyph,
    font_renderer_ft_free,
    font_renderer_ft_get_default_font,
+   font_renderer_ft_set_max_height,
    "freetype",
 };
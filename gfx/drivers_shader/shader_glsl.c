@@ -22,6 +22,7 @@
 #include "../video_state_tracker.h"
 #include "../../dynamic.h"
 #include "../../file_ops.h"
+#include "../../hash.h"
 
 #ifdef HAVE_CONFIG_H
 #include "../../config.h"
@@ -41,6 +42,13 @@
 
 #define PREV_TEXTURES (MAX_TEXTURES - 1)
 
+#if !defined(HAVE_OPENGLES) || defined(HAVE_OPENGLES3)
+#define HAVE_GLSL_PROGRAM_CACHE
+#endif
+
+#define GLSL_CACHE_MAGIC   0x42505347 /* "GSPB" */
+#define GLSL_CACHE_VERSION 1
+
 
 /* Cache the VBO. */
 struct cache_vbo
@@ -63,31 +71,46 @@ struct glsl_attrib
 
 static gfx_ctx_proc_t (*glsl_get_proc_address)(const char*);
 
+/* Uniform location along with the value last written to it,
+ * so that unchanged values don't have to be sent again. */
+struct glsl_uniform
+{
+   GLint loc;
+   bool valid;
+   GLint i;
+   GLfloat f[2];
+};
+
 struct shader_uniforms_frame
 {
-   int texture;
-   int input_size;
-   int texture_size;
+   struct glsl_uniform texture;
+   struct glsl_uniform input_size;
+   struct glsl_uniform texture_size;
    int tex_coord;
 };
 
 struct shader_uniforms
 {
    int mvp;
+   bool mvp_valid;
+   math_matrix_4x4 mvp_value;
+
    int tex_coord;
    int vertex_coord;
    int color;
    int lut_tex_coord;
 
-   int input_size;
-   int output_size;
-   int texture_size;
+   struct glsl_uniform input_size;
+   struct glsl_uniform output_size;
+   struct glsl_uniform texture_size;
 
-   int frame_count;
+   struct glsl_uniform frame_count;
    unsigned frame_count_mod;
-   int frame_direction;
+   struct glsl_uniform frame_direction;
 
-   int lut_texture[GFX_MAX_TEXTURES];
+   struct glsl_uniform lut_texture[GFX_MAX_TEXTURES];
+   struct glsl_uniform parameter[GFX_MAX_PARAMETERS];
+   struct glsl_uniform state[GFX_MAX_VARIABLES];
    
    struct shader_uniforms_frame orig;
    struct shader_uniforms_frame pass[GFX_MAX_SHADERS];
@@ -207,6 +230,7 @@ typedef struct glsl_shader_data
 {
    struct video_shader *glsl_shader;
    struct shader_uniforms gl_uniforms[GFX_MAX_SHADERS];
+   unsigned gl_uniform_slot[GFX_MAX_SHADERS];
    struct cache_vbo glsl_vbo[GFX_MAX_SHADERS];
    char glsl_alias_define[1024];
    unsigned glsl_active_index;
@@ -215,8 +239,22 @@ typedef struct glsl_shader_data
    GLuint gl_teximage[GFX_MAX_TEXTURES];
    GLint gl_attribs[PREV_TEXTURES + 1 + 4 + GFX_MAX_SHADERS];
    state_tracker_t *gl_state_tracker;
+   bool program_cache;
 } glsl_shader_data_t;
 
+struct glsl_cache_header
+{
+   uint32_t magic;
+   uint32_t version;
+   uint32_t format;
+   uint32_t size;
+};
+
+static const char glsl_vertex_define[] =
+   "#define VERTEX\n#define PARAMETER_UNIFORM\n";
+static const char glsl_fragment_define[] =
+   "#define FRAGMENT\n#define PARAMETER_UNIFORM\n";
+
 static bool glsl_core;
 static unsigned glsl_major;
 static unsigned glsl_minor;
@@ -267,6 +305,44 @@ static GLint get_attrib(glsl_shader_data_t *glsl,
    return -1;
 }
 
+static void glsl_uniform_init(struct glsl_uniform *uni, GLint loc)
+{
+   uni->loc   = loc;
+   uni->valid = false;
+}
+
+static void glsl_uniform1i(struct glsl_uniform *uni, GLint value)
+{
+   if (uni->loc < 0 || (uni->valid && uni->i == value))
+      return;
+
+   glUniform1i(uni->loc, value);
+   uni->i     = value;
+   uni->valid = true;
+}
+
+static void glsl_uniform1f(struct glsl_uniform *uni, GLfloat value)
+{
+   if (uni->loc < 0 || (uni->valid && uni->f[0] == value))
+      return;
+
+   glUniform1f(uni->loc, value);
+   uni->f[0]  = value;
+   uni->valid = true;
+}
+
+static void glsl_uniform2fv(struct glsl_uniform *uni, const GLfloat *value)
+{
+   if (uni->loc < 0 || (uni->valid
+            && uni->f[0] == value[0] && uni->f[1] == value[1]))
+      return;
+
+   glUniform2fv(uni->loc, 1, value);
+   uni->f[0]  = value[0];
+   uni->f[1]  = value[1];
+   uni->valid = true;
+}
+
 static void print_shader_log(GLuint obj)
 {
    char *info_log;
@@ -367,24 +443,220 @@ static bool link_program(GLuint prog)
    return true;
 }
 
-static GLuint compile_program(glsl_shader_data_t *glsl,
-      const char *vertex,
+#ifdef HAVE_GLSL_PROGRAM_CACHE
+/**
+ * glsl_cache_init:
+ *
+ * Checks whether linked programs can be cached on disk,
+ * i.e. a cache directory is configured and the driver
+ * can hand out program binaries.
+ *
+ * Returns: true if the program cache can be used, otherwise false.
+ **/
+static bool glsl_cache_init(void)
+{
+   GLint formats   = 0;
+   const char *dir = g_settings.video.shader_cache_dir;
+
+   if (!*dir)
+      return false;
+
+#ifndef HAVE_OPENGLES
+   if (!glGetProgramBinary || !glProgramBinary || !glProgramParameteri)
+   {
+      RARCH_WARN("[GLSL]: Program binaries not supported, shader cache disabled.\n");
+      return false;
+   }
+#endif
+
+   glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+   if (formats <= 0)
+   {
+      RARCH_WARN("[GLSL]: Driver exposes no program binary formats, shader cache disabled.\n");
+      return false;
+   }
+
+   if (!path_is_directory(dir) && !path_mkdir(dir))
+   {
+      RARCH_WARN("[GLSL]: Cannot create shader cache directory \"%s\".\n", dir);
+      return false;
+   }
+
+   RARCH_LOG("[GLSL]: Using shader cache in \"%s\".\n", dir);
+   return true;
+}
+
+/**
+ * glsl_cache_path:
+ * @glsl                 : GLSL shader handle.
+ * @vertex               : Vertex shader source, or NULL.
+ * @fragment             : Fragment shader source, or NULL.
+ * @path                 : Output path of the cache entry.
+ * @size                 : Size of @path.
+ *
+ * Names the cache entry of a program after a SHA-256 hash of
+ * everything the binary depends on: the GL driver strings,
+ * the GLSL version, the defines and the shader sources.
+ *
+ * Returns: true if successful, otherwise false.
+ **/
+static bool glsl_cache_path(glsl_shader_data_t *glsl,
+      const char *vertex, const char *fragment,
+      char *path, size_t size)
+{
+   unsigned i;
+   char version[64]   = {0};
+   char hash[65]      = {0};
+   char name[80]      = {0};
+   size_t len         = 0;
+   uint8_t *key       = NULL;
+   const char *parts[9];
+
+   snprintf(version, sizeof(version), "%u %u.%u %d %d %d",
+         GLSL_CACHE_VERSION, glsl_major, glsl_minor, glsl_core,
+         vertex != NULL, fragment != NULL);
+
+   parts[0] = (const char*)glGetString(GL_VENDOR);
+   parts[1] = (const char*)glGetString(GL_RENDERER);
+   parts[2] = (const char*)glGetString(GL_VERSION);
+   parts[3] = version;
+   parts[4] = glsl_vertex_define;
+   parts[5] = glsl_fragment_define;
+   parts[6] = glsl->glsl_alias_define;
+   parts[7] = vertex;
+   parts[8] = fragment;
+
+   for (i = 0; i < ARRAY_SIZE(parts); i++)
+      len += (parts[i] ? strlen(parts[i]) : 0) + 1;
+
+   key = (uint8_t*)malloc(len);
+   if (!key)
+      return false;
+
+   /* Keep the terminators, so that moving text from
+    * one part into the next changes the hash. */
+   len = 0;
+   for (i = 0; i < ARRAY_SIZE(parts); i++)
+   {
+      size_t part_len = parts[i] ? strlen(parts[i]) : 0;
+      if (part_len)
+         memcpy(key + len, parts[i], part_len);
+      key[len + part_len] = '\0';
+      len += part_len + 1;
+   }
+
+   sha256_hash(hash, key, len);
+   free(key);
+
+   snprintf(name, sizeof(name), "%s.glslbin", hash);
+   fill_pathname_join(path, g_settings.video.shader_cache_dir, name, size);
+   return true;
+}
+
+/**
+ * glsl_cache_load:
+ * @prog                 : Program object to load into.
+ * @path                 : Path of the cache entry.
+ *
+ * Loads a previously cached program binary into @prog.
+ * Fails if there is no entry or the driver rejects it,
+ * e.g. after a driver update.
+ *
+ * Returns: true if @prog is linked and ready to use, otherwise false.
+ **/
+static bool glsl_cache_load(GLuint prog, const char *path)
+{
+   GLint status                     = GL_FALSE;
+   ssize_t len                      = 0;
+   void *buf                        = NULL;
+   const struct glsl_cache_header *header = NULL;
+
+   if (!path_file_exists(path))
+      return false;
+
+   if (!read_file(path, &buf, &len))
+      return false;
+
+   header = (const struct glsl_cache_header*)buf;
+
+   if (len < (ssize_t)sizeof(*header)
+         || header->magic   != GLSL_CACHE_MAGIC
+         || header->version != GLSL_CACHE_VERSION
+         || header->size    != len - sizeof(*header))
+   {
+      RARCH_WARN("[GLSL]: Ignoring invalid shader cache entry \"%s\".\n", path);
+      free(buf);
+      return false;
+   }
+
+   glProgramBinary(prog, header->format,
+         (const uint8_t*)buf + sizeof(*header), header->size);
+   free(buf);
+
+   glGetProgramiv(prog, GL_LINK_STATUS, &status);
+   if (status != GL_TRUE)
+   {
+      RARCH_LOG("[GLSL]: Driver rejected cached program, recompiling.\n");
+      return false;
+   }
+
+   return true;
+}
+
+/**
+ * glsl_cache_save:
+ * @prog                 : Linked program object.
+ * @path                 : Path of the cache entry.
+ *
+ * Stores the binary of @prog in the shader cache.
+ **/
+static void glsl_cache_save(GLuint prog, const char *path)
+{
+   GLint size     = 0;
+   GLenum format  = 0;
+   uint8_t *buf   = NULL;
+   struct glsl_cache_header header;
+
+   glGetProgramiv(prog, GL_PROGRAM_BINARY_LENGTH, &size);
+   if (size <= 0)
+      return;
+
+   buf = (uint8_t*)malloc(sizeof(header) + size);
+   if (!buf)
+      return;
+
+   glGetProgramBinary(prog, size, &size, &format, buf + sizeof(header));
+
+   if (size > 0)
+   {
+      header.magic   = GLSL_CACHE_MAGIC;
+      header.version = GLSL_CACHE_VERSION;
+      header.format  = format;
+      header.size    = size;
+      memcpy(buf, &header, sizeof(header));
+
+      if (!write_file(path, buf, sizeof(header) + size))
+         RARCH_WARN("[GLSL]: Failed to write shader cache entry \"%s\".\n", path);
+   }
+
+   free(buf);
+}
+#endif
+
+static bool compile_program_source(glsl_shader_data_t *glsl,
+      GLuint prog, const char *vertex,
       const char *fragment, unsigned i)
 {
-   GLuint vert = 0, frag = 0, prog = glCreateProgram();
-   if (!prog)
-      return 0;
+   GLuint vert = 0, frag = 0;
 
    if (vertex)
    {
       RARCH_LOG("Found GLSL vertex shader.\n");
       vert = glCreateShader(GL_VERTEX_SHADER);
-      if (!compile_shader(
-               glsl,
-               vert, "#define VERTEX\n#define PARAMETER_UNIFORM\n", vertex))
+      if (!compile_shader(glsl, vert, glsl_vertex_define, vertex))
       {
          RARCH_ERR("Failed to compile vertex shader #%u\n", i);
-         return 0;
+         return false;
       }
 
       glAttachShader(prog, vert);
@@ -394,39 +666,80 @@ static GLuint compile_program(glsl_shader_data_t *glsl,
    {
       RARCH_LOG("Found GLSL fragment shader.\n");
       frag = glCreateShader(GL_FRAGMENT_SHADER);
-      if (!compile_shader(glsl, frag,
-               "#define FRAGMENT\n#define PARAMETER_UNIFORM\n", fragment))
+      if (!compile_shader(glsl, frag, glsl_fragment_define, fragment))
       {
          RARCH_ERR("Failed to compile fragment shader #%u\n", i);
-         return 0;
+         return false;
       }
 
       glAttachShader(prog, frag);
    }
 
-   if (vertex || fragment)
+   RARCH_LOG("Linking GLSL program.\n");
+   if (!link_program(prog))
    {
-      RARCH_LOG("Linking GLSL program.\n");
-      if (!link_program(prog))
-      {
-         RARCH_ERR("Failed to link program #%u.\n", i);
+      RARCH_ERR("Failed to link program #%u.\n", i);
+      return false;
+   }
+
+   /* Clean up dead memory. We're not going to relink the program.
+    * Detaching first seems to kill some mobile drivers 
+    * (according to the intertubes anyways). */
+   if (vert)
+      glDeleteShader(vert);
+   if (frag)
+      glDeleteShader(frag);
+
+   return true;
+}
+
+static GLuint compile_program(glsl_shader_data_t *glsl,
+      const char *vertex,
+      const char *fragment, unsigned i)
+{
+   GLint location;
+   bool cached = false;
+   GLuint prog = glCreateProgram();
+#ifdef HAVE_GLSL_PROGRAM_CACHE
+   char cache_path[PATH_MAX_LENGTH] = {0};
+#endif
+
+   if (!prog)
+      return 0;
+
+   if (!vertex && !fragment)
+      return prog;
+
+#ifdef HAVE_GLSL_PROGRAM_CACHE
+   if (glsl->program_cache
+         && glsl_cache_path(glsl, vertex, fragment,
+            cache_path, sizeof(cache_path)))
+   {
+      cached = glsl_cache_load(prog, cache_path);
+      if (cached)
+         RARCH_LOG("Loaded GLSL program #%u from shader cache.\n", i);
+      else
+         glProgramParameteri(prog,
+               GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+   }
+#endif
+
+   if (!cached)
+   {
+      if (!compile_program_source(glsl, prog, vertex, fragment, i))
          return 0;
-      }
 
-      /* Clean up dead memory. We're not going to relink the program.
-       * Detaching first seems to kill some mobile drivers 
-       * (according to the intertubes anyways). */
-      if (vert)
-         glDeleteShader(vert);
-      if (frag)
-         glDeleteShader(frag);
-
-      glUseProgram(prog);
-      GLint location = get_uniform(glsl, prog, "Texture");
-      glUniform1i(location, 0);
-      glUseProgram(0);
+#ifdef HAVE_GLSL_PROGRAM_CACHE
+      if (*cache_path)
+         glsl_cache_save(prog, cache_path);
+#endif
    }
 
+   glUseProgram(prog);
+   location = get_uniform(glsl, prog, "Texture");
+   glUniform1i(location, 0);
+   glUseProgram(0);
+
    return prog;
 }
 
@@ -544,9 +857,9 @@ static void gl_glsl_set_attribs(glsl_shader_data_t *glsl,
 
 static void clear_uniforms_frame(struct shader_uniforms_frame *frame)
 {
-   frame->texture      = -1;
-   frame->texture_size = -1;
-   frame->input_size   = -1;
+   glsl_uniform_init(&frame->texture, -1);
+   glsl_uniform_init(&frame->texture_size, -1);
+   glsl_uniform_init(&frame->input_size, -1);
    frame->tex_coord    = -1;
 }
 
@@ -562,12 +875,15 @@ static void find_uniforms_frame(glsl_shader_data_t *glsl,
    snprintf(input_size, sizeof(input_size), "%s%s", base, "InputSize");
    snprintf(tex_coord, sizeof(tex_coord), "%s%s", base, "TexCoord");
 
-   if (frame->texture < 0)
-      frame->texture = get_uniform(glsl, prog, texture);
-   if (frame->texture_size < 0)
-      frame->texture_size = get_uniform(glsl, prog, texture_size);
-   if (frame->input_size < 0)
-      frame->input_size = get_uniform(glsl, prog, input_size);
+   if (frame->texture.loc < 0)
+      glsl_uniform_init(&frame->texture,
+            get_uniform(glsl, prog, texture));
+   if (frame->texture_size.loc < 0)
+      glsl_uniform_init(&frame->texture_size,
+            get_uniform(glsl, prog, texture_size));
+   if (frame->input_size.loc < 0)
+      glsl_uniform_init(&frame->input_size,
+            get_uniform(glsl, prog, input_size));
    if (frame->tex_coord < 0)
       frame->tex_coord = get_attrib(glsl, prog, tex_coord);
 }
@@ -582,20 +898,35 @@ static void find_uniforms(glsl_shader_data_t *glsl,
    glUseProgram(prog);
 
    uni->mvp           = get_uniform(glsl, prog, "MVPMatrix");
+   uni->mvp_valid     = false;
    uni->tex_coord     = get_attrib(glsl, prog, "TexCoord");
    uni->vertex_coord  = get_attrib(glsl, prog, "VertexCoord");
    uni->color         = get_attrib(glsl, prog, "Color");
    uni->lut_tex_coord = get_attrib(glsl, prog, "LUTTexCoord");
 
-   uni->input_size    = get_uniform(glsl, prog, "InputSize");
-   uni->output_size   = get_uniform(glsl, prog, "OutputSize");
-   uni->texture_size  = get_uniform(glsl, prog, "TextureSize");
+   glsl_uniform_init(&uni->input_size,
+         get_uniform(glsl, prog, "InputSize"));
+   glsl_uniform_init(&uni->output_size,
+         get_uniform(glsl, prog, "OutputSize"));
+   glsl_uniform_init(&uni->texture_size,
+         get_uniform(glsl, prog, "TextureSize"));
 
-   uni->frame_count     = get_uniform(glsl, prog, "FrameCount");
-   uni->frame_direction = get_uniform(glsl, prog, "FrameDirection");
+   glsl_uniform_init(&uni->frame_count,
+         get_uniform(glsl, prog, "FrameCount"));
+   glsl_uniform_init(&uni->frame_direction,
+         get_uniform(glsl, prog, "FrameDirection"));
 
    for (i = 0; i < glsl->glsl_shader->luts; i++)
-      uni->lut_texture[i] = glGetUniformLocation(prog, glsl->glsl_shader->lut[i].id);
+      glsl_uniform_init(&uni->lut_texture[i],
+            glGetUniformLocation(prog, glsl->glsl_shader->lut[i].id));
+
+   for (i = 0; i < glsl->glsl_shader->num_parameters; i++)
+      glsl_uniform_init(&uni->parameter[i],
+            glGetUniformLocation(prog, glsl->glsl_shader->parameters[i].id));
+
+   for (i = 0; i < glsl->glsl_shader->variables; i++)
+      glsl_uniform_init(&uni->state[i],
+            glGetUniformLocation(prog, glsl->glsl_shader->variable[i].id));
 
    clear_uniforms_frame(&uni->orig);
    find_uniforms_frame(glsl, prog, &uni->orig, "Orig");
@@ -743,6 +1074,10 @@ static bool gl_glsl_init(void *data, const char *path)
    }
 #endif
 
+#ifdef HAVE_GLSL_PROGRAM_CACHE
+   glsl->program_cache = glsl_cache_init();
+#endif
+
    glsl->glsl_shader = (struct video_shader*)calloc(1, sizeof(*glsl->glsl_shader));
    if (!glsl->glsl_shader)
    {
@@ -905,6 +1240,23 @@ static bool gl_glsl_init(void *data, const char *path)
       glsl->gl_uniforms[GL_SHADER_STOCK_BLEND] = glsl->gl_uniforms[0];
    }
 
+   /* Indices sharing a program must share the uniform shadow state too,
+    * as uniform values are stored per program. */
+   for (i = 0; i < GFX_MAX_SHADERS; i++)
+   {
+      unsigned j;
+
+      glsl->gl_uniform_slot[i] = i;
+      for (j = 0; j < i; j++)
+      {
+         if (glsl->gl_program[i] && glsl->gl_program[j] == glsl->gl_program[i])
+         {
+            glsl->gl_uniform_slot[i] = j;
+            break;
+         }
+      }
+   }
+
    gl_glsl_reset_attrib(glsl);
 
    for (i = 0; i < GFX_MAX_SHADERS; i++)
@@ -938,7 +1290,7 @@ static void gl_glsl_set_params(void *data, unsigned width, unsigned height,
    struct glsl_attrib attribs[32];
    float input_size[2], output_size[2], texture_size[2];
    unsigned i, texunit = 1;
-   const struct shader_uniforms *uni = NULL;
+   struct shader_uniforms *uni = NULL;
    size_t size = 0, attribs_size = 0;
    const struct gl_tex_info *info = (const struct gl_tex_info*)_info;
    const struct gl_tex_info *prev_info = (const struct gl_tex_info*)_prev_info;
@@ -949,7 +1301,7 @@ static void gl_glsl_set_params(void *data, unsigned width, unsigned height,
    if (!glsl)
       return;
 
-   uni = (const struct shader_uniforms*)&glsl->gl_uniforms[glsl->glsl_active_index];
+   uni = &glsl->gl_uniforms[glsl->gl_uniform_slot[glsl->glsl_active_index]];
 
    (void)data;
 
@@ -963,57 +1315,49 @@ static void gl_glsl_set_params(void *data, unsigned width, unsigned height,
    texture_size[0] = (float)tex_width;
    texture_size[1] = (float)tex_height;
 
-   if (uni->input_size >= 0)
-      glUniform2fv(uni->input_size, 1, input_size);
-
-   if (uni->output_size >= 0)
-      glUniform2fv(uni->output_size, 1, output_size);
+   glsl_uniform2fv(&uni->input_size, input_size);
+   glsl_uniform2fv(&uni->output_size, output_size);
+   glsl_uniform2fv(&uni->texture_size, texture_size);
 
-   if (uni->texture_size >= 0)
-      glUniform2fv(uni->texture_size, 1, texture_size);
-
-   if (uni->frame_count >= 0 && glsl->glsl_active_index)
+   if (glsl->glsl_active_index)
    {
       unsigned modulo = glsl->glsl_shader->pass[glsl->glsl_active_index - 1].frame_count_mod;
 
       if (modulo)
          frame_count %= modulo;
-      glUniform1i(uni->frame_count, frame_count);
+      glsl_uniform1i(&uni->frame_count, frame_count);
    }
 
-   if (uni->frame_direction >= 0)
-      glUniform1i(uni->frame_direction, g_extern.rewind.frame_is_reverse ? -1 : 1);
+   glsl_uniform1i(&uni->frame_direction,
+         g_extern.rewind.frame_is_reverse ? -1 : 1);
 
 
    for (i = 0; i < glsl->glsl_shader->luts; i++)
    {
-      if (uni->lut_texture[i] < 0)
+      if (uni->lut_texture[i].loc < 0)
          continue;
 
       /* Have to rebind as HW render could override this. */
       glActiveTexture(GL_TEXTURE0 + texunit);
       glBindTexture(GL_TEXTURE_2D, glsl->gl_teximage[i]);
-      glUniform1i(uni->lut_texture[i], texunit);
+      glsl_uniform1i(&uni->lut_texture[i], texunit);
       texunit++;
    }
 
    /* Set original texture. */
    if (glsl->glsl_active_index)
    {
-      if (uni->orig.texture >= 0)
+      if (uni->orig.texture.loc >= 0)
       {
          /* Bind original texture. */
          glActiveTexture(GL_TEXTURE0 + texunit);
-         glUniform1i(uni->orig.texture, texunit);
+         glsl_uniform1i(&uni->orig.texture, texunit);
          glBindTexture(GL_TEXTURE_2D, info->tex);
          texunit++;
       }
 
-      if (uni->orig.texture_size >= 0)
-         glUniform2fv(uni->orig.texture_size, 1, info->tex_size);
-
-      if (uni->orig.input_size >= 0)
-         glUniform2fv(uni->orig.input_size, 1, info->input_size);
+      glsl_uniform2fv(&uni->orig.texture_size, info->tex_size);
+      glsl_uniform2fv(&uni->orig.input_size, info->input_size);
 
       /* Pass texture coordinates. */
       if (uni->orig.tex_coord >= 0)
@@ -1031,19 +1375,16 @@ static void gl_glsl_set_params(void *data, unsigned width, unsigned height,
       /* Bind FBO textures. */
       for (i = 0; i < fbo_info_cnt; i++)
       {
-         if (uni->pass[i].texture)
+         if (uni->pass[i].texture.loc >= 0)
          {
             glActiveTexture(GL_TEXTURE0 + texunit);
             glBindTexture(GL_TEXTURE_2D, fbo_info[i].tex);
-            glUniform1i(uni->pass[i].texture, texunit);
+            glsl_uniform1i(&uni->pass[i].texture, texunit);
             texunit++;
          }
 
-         if (uni->pass[i].texture_size >= 0)
-            glUniform2fv(uni->pass[i].texture_size, 1, fbo_info[i].tex_size);
-
-         if (uni->pass[i].input_size >= 0)
-            glUniform2fv(uni->pass[i].input_size, 1, fbo_info[i].input_size);
+         glsl_uniform2fv(&uni->pass[i].texture_size, fbo_info[i].tex_size);
+         glsl_uniform2fv(&uni->pass[i].input_size, fbo_info[i].input_size);
 
          if (uni->pass[i].tex_coord >= 0)
          {
@@ -1062,19 +1403,16 @@ static void gl_glsl_set_params(void *data, unsigned width, unsigned height,
    /* Set previous textures. Only bind if they're actually used. */
    for (i = 0; i < PREV_TEXTURES; i++)
    {
-      if (uni->prev[i].texture >= 0)
+      if (uni->prev[i].texture.loc >= 0)
       {
          glActiveTexture(GL_TEXTURE0 + texunit);
          glBindTexture(GL_TEXTURE_2D, prev_info[i].tex);
-         glUniform1i(uni->prev[i].texture, texunit);
+         glsl_uniform1i(&uni->prev[i].texture, texunit);
          texunit++;
       }
 
-      if (uni->prev[i].texture_size >= 0)
-         glUniform2fv(uni->prev[i].texture_size, 1, prev_info[i].tex_size);
-
-      if (uni->prev[i].input_size >= 0)
-         glUniform2fv(uni->prev[i].input_size, 1, prev_info[i].input_size);
+      glsl_uniform2fv(&uni->prev[i].texture_size, prev_info[i].tex_size);
+      glsl_uniform2fv(&uni->prev[i].input_size, prev_info[i].input_size);
 
       /* Pass texture coordinates. */
       if (uni->prev[i].tex_coord >= 0)
@@ -1102,12 +1440,8 @@ static void gl_glsl_set_params(void *data, unsigned width, unsigned height,
 
    /* #pragma parameters. */
    for (i = 0; i < glsl->glsl_shader->num_parameters; i++)
-   {
-      int location = glGetUniformLocation(
-            glsl->gl_program[glsl->glsl_active_index],
-            glsl->glsl_shader->parameters[i].id);
-      glUniform1f(location, glsl->glsl_shader->parameters[i].current);
-   }
+      glsl_uniform1f(&uni->parameter[i],
+            glsl->glsl_shader->parameters[i].current);
 
    /* Set state parameters. */
    if (glsl->gl_state_tracker)
@@ -1120,18 +1454,13 @@ static void gl_glsl_set_params(void *data, unsigned width, unsigned height,
                GFX_MAX_VARIABLES, frame_count);
 
       for (i = 0; i < cnt; i++)
-      {
-         int location = glGetUniformLocation(
-               glsl->gl_program[glsl->glsl_active_index],
-               state_info[i].id);
-         glUniform1f(location, state_info[i].value);
-      }
+         glsl_uniform1f(&uni->state[i], state_info[i].value);
    }
 }
 
 static bool gl_glsl_set_mvp(void *data, const math_matrix_4x4 *mat)
 {
-   int loc;
+   struct shader_uniforms *uni = NULL;
    glsl_shader_data_t *glsl = (glsl_shader_data_t*)driver.video_shader_data;
 
    (void)data;
@@ -1144,9 +1473,14 @@ static bool gl_glsl_set_mvp(void *data, const math_matrix_4x4 *mat)
       return false;
    }
 
-   loc = glsl->gl_uniforms[glsl->glsl_active_index].mvp;
-   if (loc >= 0)
-      glUniformMatrix4fv(loc, 1, GL_FALSE, mat->data);
+   uni = &glsl->gl_uniforms[glsl->gl_uniform_slot[glsl->glsl_active_index]];
+   if (uni->mvp >= 0 && (!uni->mvp_valid
+            || memcmp(&uni->mvp_value, mat, sizeof(*mat))))
+   {
+      glUniformMatrix4fv(uni->mvp, 1, GL_FALSE, mat->data);
+      uni->mvp_value = *mat;
+      uni->mvp_valid = true;
+   }
 
    return true;
 }
@@ -1320,7 +1654,7 @@ static unsigned gl_glsl_get_prev_textures(void)
 
    for (i = 1; i <= glsl->glsl_shader->passes; i++)
       for (j = 0; j < PREV_TEXTURES; j++)
-         if (glsl->gl_uniforms[i].prev[j].texture >= 0)
+         if (glsl->gl_uniforms[i].prev[j].texture.loc >= 0)
             max_prev = max(j + 1, max_prev);
 
    return max_prev;
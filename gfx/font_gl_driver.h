@@ -31,6 +31,11 @@ typedef struct gl_font_renderer
    const char *ident;
 
    const struct font_glyph *(*get_glyph)(void *data, uint32_t code);
+
+   /* Queue up render_msg calls until flush_block,
+    * which draws them all with a single draw call. */
+   void (*begin_block)(void *data);
+   void (*flush_block)(void *data);
 } gl_font_renderer_t;
 
 extern gl_font_renderer_t gl_raster_font;
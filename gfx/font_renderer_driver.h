@@ -53,6 +53,17 @@ struct font_atlas
    uint8_t *buffer; /* Alpha channel. */
    unsigned width;
    unsigned height;
+
+   /* Bumped by renderers which add glyphs on demand,
+    * so that users know when to upload the atlas again.
+    * Already placed glyphs never move when the atlas grows. */
+   unsigned generation;
+
+   /* Such renderers fill the atlas top to bottom. Rows above
+    * open_y are final, rows from open_y up to used_height may
+    * still receive glyphs. Both are 0 for static atlases. */
+   unsigned open_y;
+   unsigned used_height;
 };
 
 typedef struct font_renderer_driver
@@ -61,13 +72,18 @@ typedef struct font_renderer_driver
 
    const struct font_atlas *(*get_atlas)(void *data);
 
-   /* Returns NULL if no glyph for this code is found. */
+   /* Returns NULL if no glyph for this code is found.
+    * May add the glyph to the atlas, see font_atlas::generation. */
    const struct font_glyph *(*get_glyph)(void *data, uint32_t code);
 
    void (*free)(void *data);
 
    const char *(*get_default_font)(void);
 
+   /* Optional. Keeps the atlas at most max_height texels tall.
+    * Glyphs which don't fit anymore are reported as missing. */
+   void (*set_max_height)(void *data, unsigned max_height);
+
    const char *ident;
 } font_renderer_driver_t;
 
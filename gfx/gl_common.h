@@ -44,6 +44,14 @@
 #define HAVE_GL_ASYNC_READBACK
 #endif
 
+#if !defined(HAVE_OPENGLES) && !defined(HAVE_PSGL)
+#define HAVE_GL_PBO_UPLOAD
+#endif
+
+#if defined(HAVE_FBO) && !defined(HAVE_PSGL) && !defined(MSB_FIRST)
+#define HAVE_GL_PIXCONV
+#endif
+
 #if defined(HAVE_PSGL)
 #define RARCH_GL_FRAMEBUFFER GL_FRAMEBUFFER_OES
 #define RARCH_GL_FRAMEBUFFER_COMPLETE GL_FRAMEBUFFER_COMPLETE_OES
@@ -154,6 +162,9 @@
 /* Platform specific workarounds/hacks. */
 #if defined(__CELLOS_LV2__)
 #define NO_GL_READ_PIXELS
+#undef HAVE_GL_ASYNC_READBACK
+#undef HAVE_GL_PBO_UPLOAD
+#undef HAVE_GL_PIXCONV
 
 /* Performance hacks. */
 #ifdef HAVE_GCMGL
@@ -253,6 +264,56 @@ struct gl_coords
    unsigned vertices;
 };
 
+#ifdef HAVE_GL_PBO_UPLOAD
+#define GL_UPLOAD_RING_SIZE 3
+
+struct gl_upload
+{
+   GLuint pbo;
+   size_t size;
+   /* Persistent mapping of pbo, if buffer storage is used. */
+   void *ptr;
+#ifdef HAVE_GL_SYNC
+   GLsync fence;
+#endif
+};
+#endif
+
+#ifdef HAVE_GL_PIXCONV
+/* Frame formats unpacked by a shader pass
+ * instead of being converted on the CPU. */
+enum gl_pixconv_mode
+{
+   GL_PIXCONV_NONE = 0,
+   GL_PIXCONV_RGB565,
+   GL_PIXCONV_0RGB1555,
+   GL_PIXCONV_ABGR8888
+};
+#endif
+
+#ifdef HAVE_GL_ASYNC_READBACK
+#define GL_READBACK_RING_SIZE 4
+
+struct gl_readback
+{
+   GLuint pbo;
+   size_t pbo_size;
+#ifdef HAVE_GL_SYNC
+   GLsync fence;
+#endif
+   video_viewport_read_cb_t cb;
+   void *userdata;
+   unsigned width;
+   unsigned height;
+   unsigned frame;
+
+   /* Not read yet, waits for the next gl_frame(). */
+   bool queued;
+   /* Nothing to read, completes with a NULL buffer. */
+   bool skipped;
+};
+#endif
+
 typedef struct gl
 {
    const gfx_ctx_driver_t *ctx_driver;
@@ -337,6 +398,18 @@ typedef struct gl
    bool egl_images;
    video_info_t video_info;
 
+#ifdef HAVE_GL_PIXCONV
+   /* Raw frames go to pixconv_tex and are unpacked
+    * into texture[tex_index] by pixconv_prog. */
+   enum gl_pixconv_mode pixconv_mode;
+   GLuint pixconv_tex;
+   GLuint pixconv_fbo;
+   GLuint pixconv_prog;
+   GLuint pixconv_vbo;
+   unsigned pixconv_width;
+   unsigned pixconv_height;
+#endif
+
 #ifdef HAVE_OVERLAY
    unsigned overlays;
    bool overlay_enable;
@@ -348,15 +421,24 @@ typedef struct gl
 #endif
 
 #ifdef HAVE_GL_ASYNC_READBACK
-   /* PBOs used for asynchronous viewport readbacks. */
-   GLuint pbo_readback[4];
-   bool pbo_readback_valid[4];
-   bool pbo_readback_enable;
-   unsigned pbo_readback_index;
-   struct scaler_ctx pbo_readback_scaler;
+   /* FIFO of asynchronous viewport readbacks, oldest first. */
+   struct gl_readback readback[GL_READBACK_RING_SIZE];
+   unsigned readback_first;
+   unsigned readback_count;
+   uint8_t *readback_bgr;
+   size_t readback_bgr_size;
 #endif
    void *readback_buffer_screenshot;
 
+#ifdef HAVE_GL_PBO_UPLOAD
+   /* Frames are written into pixel unpack buffers,
+    * either a ring of persistently mapped ones or a single orphaned one. */
+   struct gl_upload upload[GL_UPLOAD_RING_SIZE];
+   unsigned upload_index;
+   bool have_upload_pbo;
+   bool upload_persistent;
+#endif
+
 #if defined(HAVE_MENU)
    GLuint menu_texture;
    bool menu_texture_enable;
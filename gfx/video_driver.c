@@ -374,6 +374,7 @@ void uninit_video_input(void)
 
    rarch_main_command(RARCH_CMD_SHADER_DIR_DEINIT);
    video_monitor_compute_fps_statistics();
+   video_monitor_compute_pacing_statistics();
 }
 
 void init_video(void)
@@ -470,6 +471,8 @@ void init_video(void)
    /* Need to grab the "real" video driver interface on a reinit. */
    find_video_driver();
 
+   driver.gfx_native_0rgb1555 = false;
+
 #ifdef HAVE_THREADS
    if (g_settings.video.threaded && !g_extern.system.hw_render_callback.context_type)
    {
@@ -523,6 +526,7 @@ void init_video(void)
    rarch_main_command(RARCH_CMD_OVERLAY_INIT);
 
    g_extern.measure_data.frame_time_samples_count = 0;
+   video_monitor_pacing_reset();
 
    g_extern.frame_cache.width = 4;
    g_extern.frame_cache.height = 4;
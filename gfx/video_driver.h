@@ -117,6 +117,13 @@ typedef struct video_poke_interface
    struct video_shader *(*get_current_shader)(void *data);
 } video_poke_interface_t;
 
+/* Receives the result of a read_viewport_async() request.
+ * @buffer holds @width * @height pixels in BGR byte order (24bpp),
+ * bottom-up, and is only valid during the call. It is NULL if the
+ * frame could not be read back. */
+typedef void (*video_viewport_read_cb_t)(void *userdata,
+      const uint8_t *buffer, unsigned width, unsigned height);
+
 typedef struct video_driver
 {
    /* Should the video driver act as an input driver as well?
@@ -162,6 +169,12 @@ typedef struct video_driver
    /* Reads out in BGR byte order (24bpp). */
    bool (*read_viewport)(void *data, uint8_t *buffer);
 
+   /* Queues a readback of the next rendered frame without stalling
+    * the GPU. @cb is called from a later frame() once the pixels
+    * have arrived, in request order. Might not be implemented. */
+   bool (*read_viewport_async)(void *data, video_viewport_read_cb_t cb,
+         void *userdata);
+
 #ifdef HAVE_OVERLAY
    void (*overlay_interface)(void *data, const video_overlay_interface_t **iface);
 #endif
@@ -214,3 +214,198 @@ bool video_monitor_get_fps(char *buf, size_t size,
 
    return true;
 }
+
+/* Weight (as a power of two) of new samples in the
+ * moving averages used by the frame pacer. */
+#define PACING_SMOOTH_SHIFT 4
+
+/* Automatic frame delay is capped like video_frame_delay. */
+#define PACING_MAX_DELAY_USEC 15000
+
+static retro_time_t video_monitor_pacing_expected_period(void)
+{
+   if (g_extern.frame_pacing.period)
+      return g_extern.frame_pacing.period;
+   if (g_settings.video.refresh_rate <= 0.0f)
+      return 0;
+   return (retro_time_t)roundf(1000000.0f / g_settings.video.refresh_rate);
+}
+
+/**
+ * video_monitor_pacing_reset:
+ *
+ * Resets frame pacing state and statistics.
+ * Called whenever the video driver is (re)initialized.
+ **/
+void video_monitor_pacing_reset(void)
+{
+   memset(&g_extern.frame_pacing, 0, sizeof(g_extern.frame_pacing));
+}
+
+/**
+ * video_monitor_pacing_run_start:
+ *
+ * Marks the point where the core is about to run a frame.
+ * Input is polled from within the core's run callback, so this
+ * is used as the start of input-to-present latency.
+ **/
+void video_monitor_pacing_run_start(void)
+{
+   g_extern.frame_pacing.run_start = rarch_get_time_usec();
+}
+
+/**
+ * video_monitor_pacing_frame_ready:
+ *
+ * Marks the point where the core has handed over its frame.
+ * Tracks a decaying peak of the time the core needs to run
+ * one frame.
+ **/
+void video_monitor_pacing_frame_ready(void)
+{
+   retro_time_t run_time;
+
+   if (!g_extern.frame_pacing.run_start)
+      return;
+
+   run_time = rarch_get_time_usec() - g_extern.frame_pacing.run_start;
+
+   if (run_time > g_extern.frame_pacing.run_time)
+      g_extern.frame_pacing.run_time = run_time;
+   else
+      g_extern.frame_pacing.run_time -=
+         (g_extern.frame_pacing.run_time - run_time) >> PACING_SMOOTH_SHIFT;
+}
+
+/**
+ * video_monitor_pacing_frame_presented:
+ * @present_time       : Time the frame was presented.
+ * @run_start          : Time the core started running the
+ *                       presented frame (0 if unknown).
+ *
+ * Feeds a present timestamp from the video driver into the
+ * frame pacer, refining the estimated VSync interval and
+ * updating latency and judder statistics.
+ **/
+void video_monitor_pacing_frame_presented(retro_time_t present_time,
+      retro_time_t run_start)
+{
+   retro_time_t expected = video_monitor_pacing_expected_period();
+
+   if (g_extern.frame_pacing.last_present && expected)
+   {
+      retro_time_t interval = present_time -
+         g_extern.frame_pacing.last_present;
+
+      /* Ignore intervals which clearly are not a single refresh,
+       * such as dropped frames or pauses. */
+      if (interval > expected / 2 && interval < expected + expected / 2)
+      {
+         retro_time_t judder;
+
+         if (!g_extern.frame_pacing.period)
+            g_extern.frame_pacing.period = expected;
+         g_extern.frame_pacing.period +=
+            (interval - g_extern.frame_pacing.period) >> PACING_SMOOTH_SHIFT;
+
+         judder = interval - g_extern.frame_pacing.period;
+         if (judder < 0)
+            judder = -judder;
+
+         g_extern.frame_pacing.judder_accum += judder;
+         if (judder > g_extern.frame_pacing.judder_max)
+            g_extern.frame_pacing.judder_max = judder;
+
+         if (run_start && present_time > run_start)
+         {
+            g_extern.frame_pacing.latency_accum += present_time - run_start;
+            g_extern.frame_pacing.delay_accum   += g_extern.frame_pacing.delay;
+            g_extern.frame_pacing.count++;
+         }
+      }
+   }
+
+   g_extern.frame_pacing.last_present = present_time;
+}
+
+/**
+ * video_monitor_pacing_frame_delay:
+ *
+ * Predicts the next VSync from the last present timestamp and
+ * computes how long the core can be delayed while still
+ * finishing its frame in time.
+ *
+ * Returns: delay in microseconds, 0 if no delay should be applied.
+ **/
+retro_time_t video_monitor_pacing_frame_delay(void)
+{
+   retro_time_t now, next_vsync, delay;
+   retro_time_t period = video_monitor_pacing_expected_period();
+
+   g_extern.frame_pacing.delay = 0;
+
+   if (!g_extern.frame_pacing.last_present || !period)
+      return 0;
+
+   now        = rarch_get_time_usec();
+   next_vsync = g_extern.frame_pacing.last_present + period;
+   while (next_vsync <= now)
+      next_vsync += period;
+
+   /* Keep a safety margin of 1/8th of a refresh for scheduling jitter. */
+   delay = next_vsync - now - g_extern.frame_pacing.run_time - (period >> 3);
+
+   if (delay <= 0)
+      return 0;
+   if (delay > PACING_MAX_DELAY_USEC)
+      delay = PACING_MAX_DELAY_USEC;
+
+   g_extern.frame_pacing.delay = delay;
+   return delay;
+}
+
+/**
+ * video_monitor_pacing_statistics:
+ * @latency            : Average time from core run to present (usec).
+ * @judder             : Average deviation of present intervals (usec).
+ * @judder_max         : Largest deviation of present intervals (usec).
+ * @delay              : Average automatic frame delay (usec).
+ *
+ * Gets frame pacing statistics for the current run.
+ *
+ * Returns: true (1) on success, false (0) if no frames
+ * have been measured yet.
+ **/
+bool video_monitor_pacing_statistics(double *latency, double *judder,
+      double *judder_max, double *delay)
+{
+   uint64_t count = g_extern.frame_pacing.count;
+
+   if (!count)
+      return false;
+
+   *latency    = (double)g_extern.frame_pacing.latency_accum / count;
+   *judder     = (double)g_extern.frame_pacing.judder_accum / count;
+   *judder_max = (double)g_extern.frame_pacing.judder_max;
+   *delay      = (double)g_extern.frame_pacing.delay_accum / count;
+
+   return true;
+}
+
+/**
+ * video_monitor_compute_pacing_statistics:
+ *
+ * Logs frame pacing statistics.
+ **/
+void video_monitor_compute_pacing_statistics(void)
+{
+   double latency, judder, judder_max, delay;
+
+   if (!video_monitor_pacing_statistics(&latency, &judder,
+            &judder_max, &delay))
+      return;
+
+   RARCH_LOG("Frame pacing: %.3f ms average latency, %.3f ms average judder (%.3f ms max), %.3f ms average frame delay, based on %u frames.\n",
+         latency / 1000.0, judder / 1000.0, judder_max / 1000.0,
+         delay / 1000.0, (unsigned)g_extern.frame_pacing.count);
+}
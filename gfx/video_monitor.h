@@ -19,6 +19,7 @@
 
 #include <boolean.h>
 #include <stddef.h>
+#include "../libretro.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -75,6 +76,72 @@ bool video_monitor_fps_statistics(double *refresh_rate,
 bool video_monitor_get_fps(char *buf, size_t size,
       char *buf_fps, size_t size_fps);
 
+/**
+ * video_monitor_pacing_reset:
+ *
+ * Resets frame pacing state and statistics.
+ * Called whenever the video driver is (re)initialized.
+ **/
+void video_monitor_pacing_reset(void);
+
+/**
+ * video_monitor_pacing_run_start:
+ *
+ * Marks the point where the core is about to run a frame.
+ **/
+void video_monitor_pacing_run_start(void);
+
+/**
+ * video_monitor_pacing_frame_ready:
+ *
+ * Marks the point where the core has handed over its frame.
+ **/
+void video_monitor_pacing_frame_ready(void);
+
+/**
+ * video_monitor_pacing_frame_presented:
+ * @present_time       : Time the frame was presented.
+ * @run_start          : Time the core started running the
+ *                       presented frame (0 if unknown).
+ *
+ * Feeds a present timestamp from the video driver into the
+ * frame pacer.
+ **/
+void video_monitor_pacing_frame_presented(retro_time_t present_time,
+      retro_time_t run_start);
+
+/**
+ * video_monitor_pacing_frame_delay:
+ *
+ * Predicts the next VSync and computes how long the core can be
+ * delayed while still finishing its frame in time.
+ *
+ * Returns: delay in microseconds, 0 if no delay should be applied.
+ **/
+retro_time_t video_monitor_pacing_frame_delay(void);
+
+/**
+ * video_monitor_pacing_statistics:
+ * @latency            : Average time from core run to present (usec).
+ * @judder             : Average deviation of present intervals (usec).
+ * @judder_max         : Largest deviation of present intervals (usec).
+ * @delay              : Average automatic frame delay (usec).
+ *
+ * Gets frame pacing statistics for the current run.
+ *
+ * Returns: true (1) on success, false (0) if no frames
+ * have been measured yet.
+ **/
+bool video_monitor_pacing_statistics(double *latency, double *judder,
+      double *judder_max, double *delay);
+
+/**
+ * video_monitor_compute_pacing_statistics:
+ *
+ * Logs frame pacing statistics.
+ **/
+void video_monitor_compute_pacing_statistics(void);
+
 #ifdef __cplusplus
 }
 #endif
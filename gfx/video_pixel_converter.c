@@ -17,6 +17,7 @@
 #include "video_pixel_converter.h"
 #include <gfx/scaler/pixconv.h>
 #include "../general.h"
+#include "../performance.h"
 
 void deinit_pixel_converter(void)
 {
@@ -44,6 +45,7 @@ bool init_video_pixel_converter(unsigned size)
 
    /* TODO: Pick either ARGB8888 or RGB565 depending on driver. */
    driver.scaler.out_fmt     = SCALER_FMT_RGB565;
+   driver.scaler.threads     = rarch_get_cpu_cores();
 
    if (!scaler_ctx_gen_filter(&driver.scaler))
       return false;
@@ -16,6 +16,7 @@
 
 #include "video_thread_wrapper.h"
 #include "video_viewport.h"
+#include "video_monitor.h"
 #include "../performance.h"
 #include <file/dir_list.h>
 #include <stdlib.h>
@@ -84,6 +85,105 @@ static void thread_update_driver_state(thread_video_t *thr)
    }
 }
 
+static inline struct thread_readback *thread_readback_slot(
+      thread_video_t *thr, unsigned i)
+{
+   return &thr->frame.readback[
+      (thr->frame.readback_first + i) % THREAD_READBACK_MAX];
+}
+
+/* Runs on the video thread. Keeps a copy of the pixels,
+ * as they are only valid during the call. */
+static void thread_readback_done(void *userdata,
+      const uint8_t *buffer, unsigned width, unsigned height)
+{
+   struct thread_readback *rb = (struct thread_readback*)userdata;
+   size_t size                = width * height * 3;
+
+   rb->failed = !buffer;
+
+   if (buffer && size > rb->buffer_size)
+   {
+      uint8_t *buf = (uint8_t*)realloc(rb->buffer, size);
+
+      if (buf)
+      {
+         rb->buffer      = buf;
+         rb->buffer_size = size;
+      }
+      else
+         rb->failed = true;
+   }
+
+   if (!rb->failed)
+      memcpy(rb->buffer, buffer, size);
+
+   rb->width  = width;
+   rb->height = height;
+   rb->state  = THREAD_READBACK_DONE;
+}
+
+/**
+ * thread_start_readbacks:
+ * @thr                  : Thread wrapper handle.
+ *
+ * Passes async viewport reads requested by the main thread on 
+ * to the driver, right before it renders the next frame. 
+ * Must be called with the frame lock held.
+ **/
+static void thread_start_readbacks(thread_video_t *thr)
+{
+   unsigned i;
+
+   for (i = 0; i < thr->frame.readback_count; i++)
+   {
+      struct thread_readback *rb = thread_readback_slot(thr, i);
+
+      if (rb->state != THREAD_READBACK_REQUESTED)
+         continue;
+
+      rb->state = THREAD_READBACK_PENDING;
+      if (!thr->driver->read_viewport_async(thr->driver_data,
+               thread_readback_done, rb))
+         thread_readback_done(rb, NULL, 0, 0);
+   }
+}
+
+/**
+ * thread_deliver_readbacks:
+ * @thr                  : Thread wrapper handle.
+ *
+ * Hands finished async viewport reads to their requesters 
+ * on the main thread, in request order.
+ **/
+static void thread_deliver_readbacks(thread_video_t *thr)
+{
+   for (;;)
+   {
+      struct thread_readback *rb = NULL;
+
+      slock_lock(thr->frame.lock);
+      if (thr->frame.readback_count && thread_readback_slot(thr, 0)->state
+            == THREAD_READBACK_DONE)
+         rb = thread_readback_slot(thr, 0);
+      slock_unlock(thr->frame.lock);
+
+      if (!rb)
+         break;
+
+      /* The video thread doesn't touch finished slots. */
+      rb->cb(rb->userdata, rb->failed ? NULL : rb->buffer,
+            rb->width, rb->height);
+
+      slock_lock(thr->frame.lock);
+      rb->state = THREAD_READBACK_FREE;
+      thr->frame.readback_first =
+         (thr->frame.readback_first + 1) % THREAD_READBACK_MAX;
+      thr->frame.readback_count--;
+      slock_unlock(thr->frame.lock);
+   }
+}
+
 static void thread_loop(void *data)
 {
    thread_video_t *thr = (thread_video_t*)data;
@@ -308,16 +408,22 @@ static void thread_loop(void *data)
          bool focus = false;
          bool has_windowed = true;
          struct video_viewport vp = {0};
+         retro_time_t present_time;
 
          slock_lock(thr->frame.lock);
 
          thread_update_driver_state(thr);
+         thread_start_readbacks(thr);
 
          if (thr->driver && thr->driver->frame)
             ret = thr->driver->frame(thr->driver_data,
                thr->frame.buffer, thr->frame.width, thr->frame.height,
                thr->frame.pitch, *thr->frame.msg ? thr->frame.msg : NULL);
 
+         /* With VSync, frame() returns once the frame has been 
+          * presented, so this is our best present timestamp. */
+         present_time = rarch_get_time_usec();
+
          slock_unlock(thr->frame.lock);
 
          if (thr->driver && thr->driver->alive)
@@ -338,6 +444,9 @@ static void thread_loop(void *data)
          thr->has_windowed = has_windowed;
          thr->frame.updated = false;
          thr->vp = vp;
+         thr->present_time = present_time;
+         thr->present_run_start = thr->frame.run_start;
+         thr->present_count++;
          scond_signal(thr->cond_cmd);
          slock_unlock(thr->lock);
       }
@@ -422,6 +531,8 @@ static bool thread_frame(void *data, const void *frame_,
    unsigned copy_stride;
    const uint8_t *src  = NULL;
    uint8_t *dst        = NULL;
+   retro_time_t present_time      = 0;
+   retro_time_t present_run_start = 0;
    thread_video_t *thr = (thread_video_t*)data;
 
    /* If called from within read_viewport, we're actually in the 
@@ -436,6 +547,8 @@ static bool thread_frame(void *data, const void *frame_,
       return false;
    }
 
+   thread_deliver_readbacks(thr);
+
    RARCH_PERFORMANCE_INIT(thr_frame);
    RARCH_PERFORMANCE_START(thr_frame);
 
@@ -449,9 +562,18 @@ static bool thread_frame(void *data, const void *frame_,
 
    if (!thr->nonblock)
    {
-      retro_time_t target_frame_time = (retro_time_t)
-         roundf(1000000LL / g_settings.video.refresh_rate);
-      retro_time_t target = thr->last_time + target_frame_time;
+      retro_time_t target_frame_time = g_extern.frame_pacing.period;
+      retro_time_t target;
+
+      if (!target_frame_time)
+         target_frame_time = (retro_time_t)
+            roundf(1000000LL / g_settings.video.refresh_rate);
+
+      /* Wait at most until the predicted next present. */
+      if (thr->present_time > thr->last_time - target_frame_time)
+         target = thr->present_time + target_frame_time;
+      else
+         target = thr->last_time + target_frame_time;
 
       /* Ideally, use absolute time, but that is only a good idea on POSIX. */
       while (thr->frame.updated)
@@ -478,10 +600,11 @@ static bool thread_frame(void *data, const void *frame_,
             memcpy(dst, src, copy_stride);
       }
 
-      thr->frame.updated = true;
-      thr->frame.width  = width;
-      thr->frame.height = height;
-      thr->frame.pitch  = copy_stride;
+      thr->frame.updated   = true;
+      thr->frame.width     = width;
+      thr->frame.height    = height;
+      thr->frame.pitch     = copy_stride;
+      thr->frame.run_start = g_extern.frame_pacing.run_start;
 
       if (msg)
          strlcpy(thr->frame.msg, msg, sizeof(thr->frame.msg));
@@ -502,8 +625,18 @@ static bool thread_frame(void *data, const void *frame_,
    else
       thr->miss_count++;
 
+   if (thr->present_count != thr->present_count_seen)
+   {
+      present_time      = thr->present_time;
+      present_run_start = thr->present_run_start;
+      thr->present_count_seen = thr->present_count;
+   }
+
    slock_unlock(thr->lock);
 
+   if (present_time)
+      video_monitor_pacing_frame_presented(present_time, present_run_start);
+
    RARCH_PERFORMANCE_STOP(thr_frame);
 
    thr->last_time = rarch_get_time_usec();
@@ -620,8 +753,31 @@ static bool thread_read_viewport(void *data, uint8_t *buffer)
    return thr->cmd_data.b;
 }
 
+static bool thread_read_viewport_async(void *data,
+      video_viewport_read_cb_t cb, void *userdata)
+{
+   struct thread_readback *rb = NULL;
+   thread_video_t *thr        = (thread_video_t*)data;
+
+   if (!thr || !cb)
+      return false;
+
+   slock_lock(thr->frame.lock);
+   if (thr->frame.readback_count < THREAD_READBACK_MAX)
+   {
+      rb           = thread_readback_slot(thr, thr->frame.readback_count++);
+      rb->cb       = cb;
+      rb->userdata = userdata;
+      rb->state    = THREAD_READBACK_REQUESTED;
+   }
+   slock_unlock(thr->frame.lock);
+
+   return rb != NULL;
+}
+
 static void thread_free(void *data)
 {
+   unsigned i;
    thread_video_t *thr = (thread_video_t*)data;
    if (!thr)
       return;
@@ -630,6 +786,18 @@ static void thread_free(void *data)
    thread_wait_reply(thr, CMD_FREE);
    sthread_join(thr->thread);
 
+   /* Reads which never reached the driver fail. */
+   for (i = 0; i < thr->frame.readback_count; i++)
+   {
+      struct thread_readback *rb = thread_readback_slot(thr, i);
+      if (rb->state != THREAD_READBACK_DONE)
+         thread_readback_done(rb, NULL, 0, 0);
+   }
+   thread_deliver_readbacks(thr);
+
+   for (i = 0; i < THREAD_READBACK_MAX; i++)
+      free(thr->frame.readback[i].buffer);
+
 #if defined(HAVE_MENU)
    free(thr->texture.frame);
 #endif
@@ -898,6 +1066,7 @@ static const video_driver_t video_thread = {
    thread_set_rotation,
    thread_viewport_info,
    thread_read_viewport,
+   thread_read_viewport_async,
 #ifdef HAVE_OVERLAY
    thread_get_overlay_interface, /* get_overlay_interface */
 #endif
@@ -912,6 +1081,8 @@ static void thread_set_callbacks(thread_video_t *thr,
    /* Disable optional features if not present. */
    if (!drv->read_viewport)
       thr->video_thread.read_viewport = NULL;
+   if (!drv->read_viewport_async)
+      thr->video_thread.read_viewport_async = NULL;
    if (!drv->set_rotation)
       thr->video_thread.set_rotation = NULL;
    if (!drv->set_shader)
@@ -23,6 +23,31 @@
 #include <rthreads/rthreads.h>
 #include "font_gl_driver.h"
 
+#define THREAD_READBACK_MAX 8
+
+enum thread_readback_state
+{
+   THREAD_READBACK_FREE = 0,
+   /* Waiting to be passed on with the next frame. */
+   THREAD_READBACK_REQUESTED,
+   /* Owned by the driver until it calls back. */
+   THREAD_READBACK_PENDING,
+   /* Pixels copied, waiting for delivery on the main thread. */
+   THREAD_READBACK_DONE
+};
+
+struct thread_readback
+{
+   enum thread_readback_state state;
+   video_viewport_read_cb_t cb;
+   void *userdata;
+   uint8_t *buffer;
+   size_t buffer_size;
+   unsigned width;
+   unsigned height;
+   bool failed;
+};
+
 enum thread_cmd
 {
    CMD_NONE = 0,
@@ -99,6 +124,13 @@ typedef struct thread_video
    unsigned hit_count;
    unsigned miss_count;
 
+   /* Timestamp of the last frame presented by the driver thread,
+    * and the time the core started running that frame. */
+   retro_time_t present_time;
+   retro_time_t present_run_start;
+   unsigned present_count;
+   unsigned present_count_seen;
+
    float *alpha_mod;
    unsigned alpha_mods;
    bool alpha_update;
@@ -178,9 +210,16 @@ typedef struct thread_video
       unsigned width;
       unsigned height;
       unsigned pitch;
+      retro_time_t run_start;
       bool updated;
       bool within_thread;
       char msg[PATH_MAX_LENGTH];
+
+      /* FIFO of async viewport reads, oldest first.
+       * Slot states are protected by the frame lock. */
+      struct thread_readback readback[THREAD_READBACK_MAX];
+      unsigned readback_first;
+      unsigned readback_count;
    } frame;
 
    video_driver_t video_thread;
@@ -630,12 +630,15 @@ RETROARCH
 #include "../retroarch.c"
 #include "../runloop.c"
 #include "../runloop_data.c"
+#include "../batch.c"
 
 /*============================================================
 RECORDING
 ============================================================ */
 #include "../movie.c"
 #include "../record/record_driver.c"
+#include "../record/rcap.c"
+#include "../record/drivers/rcap.c"
 
 /*============================================================
 THREAD
@@ -1,6 +1,6 @@
 /*  RetroArch - A frontend for libretro.
  *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
- *  Copyright (C) 2011-2015 - Daniel De Matteis
+ *  Copyright (C) 2010-2015 - Daniel De Matteis
  * 
  *  RetroArch is free software: you can redistribute it and/or modify it under the terms
  *  of the GNU General Public License as published by the Free Software Found-
@@ -14,34 +14,13 @@
  *  If not, see <http://www.gnu.org/licenses/>.
  */
 
-/*
- *  sha1.h
- *
- *  Copyright (C) 1998, 2009
- *  Paul E. Jones <paulej@packetizer.com>
- *  All Rights Reserved
- *
- *****************************************************************************
- *  $Id: sha1.h 12 2009-06-22 19:34:25Z paulej $
- *****************************************************************************
- *
- *  Description:
- *      This class implements the Secure Hashing Standard as defined
- *      in FIPS PUB 180-1 published April 17, 1995.
- *
- *      Many of the variable names in the SHA1Context, especially the
- *      single character names, were used because those were the names
- *      used in the publication.
- *
- *      Please read the file sha1.c for more information.
- *
- */
 
 #ifndef __RARCH_HASH_H
 #define __RARCH_HASH_H
 
 #include <stdint.h>
 #include <stddef.h>
+#include <boolean.h>
 
 #include <compat/msvc.h>
 #ifdef HAVE_CONFIG_H
@@ -58,40 +37,74 @@
  **/
 void sha256_hash(char *out, const uint8_t *in, size_t size);
 
-#ifdef HAVE_ZLIB
-#include <zlib.h>
-
-static inline uint32_t crc32_calculate(const uint8_t *data, size_t length)
-{
-   return crc32(0, data, length);
-}
-
-static inline uint32_t crc32_adjust(uint32_t crc, uint8_t data)
-{
-   /* zlib and nall have different
-    * assumptions on "sign" for this function. */
-   return ~crc32(~crc, &data, 1);
-}
-#else
-uint32_t crc32_calculate(const uint8_t *data, size_t length);
-uint32_t crc32_adjust(uint32_t crc, uint8_t data);
-#endif
+/** 
+ * sha1_hash:
+ * @out               : Output, at least 41 characters.
+ * @in                : Input.
+ * @size              : Size of @in.
+ *
+ * Hashes SHA1 and outputs a human readable string.
+ **/
+void sha1_hash(char *out, const uint8_t *in, size_t size);
 
-typedef struct SHA1Context
-{
-   unsigned Message_Digest[5]; /* Message Digest (output)          */
+/**
+ * sha1_calculate:
+ * @path              : Path to file.
+ * @result            : Output, at least 41 characters.
+ *
+ * Hashes the file at @path with SHA1 and outputs
+ * an upper case hex string.
+ *
+ * Returns: 0 on success, -1 on failure.
+ **/
+int sha1_calculate(const char *path, char *result);
 
-   unsigned Length_Low;        /* Message length in bits           */
-   unsigned Length_High;       /* Message length in bits           */
+/**
+ * crc32_update:
+ * @crc               : CRC32 of the data so far, 0 to start.
+ * @data              : Input.
+ * @length            : Size of @data.
+ *
+ * Continues a CRC32 over @data. Same convention as zlib's crc32(),
+ * so a buffer may be hashed in any number of pieces.
+ *
+ * Uses PCLMULQDQ or the ARMv8 CRC32 instructions
+ * when the CPU has them, slicing-by-8 otherwise.
+ *
+ * Returns: CRC32 of all data so far.
+ **/
+uint32_t crc32_update(uint32_t crc, const uint8_t *data, size_t length);
 
-   unsigned char Message_Block[64]; /* 512-bit message blocks      */
-   int Message_Block_Index;    /* Index into message block array   */
+/**
+ * crc32_calculate:
+ * @data              : Input.
+ * @length            : Size of @data.
+ *
+ * Returns: CRC32 of @data.
+ **/
+uint32_t crc32_calculate(const uint8_t *data, size_t length);
 
-   int Computed;               /* Is the digest computed?          */
-   int Corrupted;              /* Is the message digest corruped?  */
-} SHA1Context;
+/**
+ * crc32_adjust:
+ * @crc               : Running CRC32 state, starts out as ~0.
+ * @data              : Next byte.
+ *
+ * Feeds a single byte. Unlike crc32_update, the state is not
+ * inverted, so the final CRC32 is ~crc.
+ *
+ * Returns: new CRC32 state.
+ **/
+uint32_t crc32_adjust(uint32_t crc, uint8_t data);
 
-int sha1_calculate(const char *path, char *result);
+/**
+ * crc32_set_hardware:
+ * @enable            : Whether to use CRC32 instructions if available.
+ *
+ * Picks the CRC32 implementation. This is done on first use
+ * anyway, so this is only needed to compare implementations.
+ *
+ * Returns: true if a hardware implementation is used.
+ **/
+bool crc32_set_hardware(bool enable);
 
 #endif
-
@@ -25,6 +25,12 @@
 
 #include <retro_inline.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
 #undef GOTO_END_ERROR
 #define GOTO_END_ERROR() do { \
    fprintf(stderr, "[RPNG]: Error in line %d.\n", __LINE__); \
@@ -73,6 +79,49 @@ static INLINE int paeth(int a, int b, int c)
    return c;
 }
 
+#if defined(__SSE2__)
+static INLINE __m128i png_select_epi16(__m128i mask, __m128i a, __m128i b)
+{
+   return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+static INLINE __m128i png_abs_epi16(__m128i x)
+{
+   return _mm_max_epi16(x, _mm_sub_epi16(_mm_setzero_si128(), x));
+}
+
+/* Paeth prediction filter on eight 16-bit lanes. */
+static INLINE __m128i png_paeth_epi16(__m128i a, __m128i b, __m128i c)
+{
+   /* p = a + b - c, so |p - a| = |b - c| and |p - b| = |a - c|. */
+   __m128i pa = _mm_sub_epi16(b, c);
+   __m128i pb = _mm_sub_epi16(a, c);
+   __m128i pc = png_abs_epi16(_mm_add_epi16(pa, pb));
+   __m128i smallest;
+
+   pa       = png_abs_epi16(pa);
+   pb       = png_abs_epi16(pb);
+   smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+
+   /* Ties favor a over b over c. */
+   return png_select_epi16(_mm_cmpeq_epi16(smallest, pa), a,
+         png_select_epi16(_mm_cmpeq_epi16(smallest, pb), b, c));
+}
+#elif defined(__ARM_NEON__)
+/* Paeth prediction filter on eight bytes. */
+static INLINE uint8x8_t png_paeth_u8(uint8x8_t a, uint8x8_t b, uint8x8_t c)
+{
+   uint16x8_t pa       = vabdl_u8(b, c);
+   uint16x8_t pb       = vabdl_u8(a, c);
+   uint16x8_t pc       = vabdq_u16(vaddl_u8(a, b), vaddl_u8(c, c));
+   uint16x8_t smallest = vminq_u16(pc, vminq_u16(pa, pb));
+   uint8x8_t nearest   = vbsl_u8(vmovn_u16(vceqq_u16(smallest, pb)), b, c);
+
+   /* Ties favor a over b over c. */
+   return vbsl_u8(vmovn_u16(vceqq_u16(smallest, pa)), a, nearest);
+}
+#endif
+
 static INLINE uint32_t dword_be(const uint8_t *buf)
 {
    return (buf[0] << 24) | (buf[1] << 16) | (buf[2] << 8) | (buf[3] << 0);
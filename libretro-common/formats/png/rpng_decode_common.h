@@ -23,6 +23,16 @@
 #ifndef _RPNG_DECODE_COMMON_H
 #define _RPNG_DECODE_COMMON_H
 
+static const struct adam7_pass adam7_passes[] = {
+   { 0, 0, 8, 8 },
+   { 4, 0, 8, 8 },
+   { 0, 4, 4, 8 },
+   { 2, 0, 4, 4 },
+   { 0, 2, 2, 4 },
+   { 1, 0, 2, 2 },
+   { 0, 1, 1, 2 },
+};
+
 static void png_pass_geom(const struct png_ihdr *ihdr,
       unsigned width, unsigned height,
       unsigned *bpp_out, unsigned *pitch_out, size_t *pass_size)
@@ -71,184 +81,234 @@ static void png_pass_geom(const struct png_ihdr *ihdr,
       *pitch_out = pitch;
 }
 
-static void deinterlace_pass(uint32_t *data, const struct png_ihdr *ihdr,
-      const uint32_t *input, unsigned pass_width, unsigned pass_height,
-      const struct adam7_pass *pass)
+#if defined(__SSE2__)
+static INLINE __m128i png_load_pixel(const uint8_t *p, unsigned bpp)
 {
-   unsigned x, y;
-
-   data += pass->y * ihdr->width + pass->x;
-
-   for (y = 0; y < pass_height;
-         y++, data += ihdr->width * pass->stride_y, input += pass_width)
-   {
-      uint32_t *out = data;
-     
-      for (x = 0; x < pass_width; x++, out += pass->stride_x)
-         *out = input[x];
-   }
+   int32_t v = 0;
+   memcpy(&v, p, bpp);
+   return _mm_cvtsi32_si128(v);
 }
 
-static bool png_reverse_filter(uint32_t *data, const struct png_ihdr *ihdr,
-      const uint8_t *inflate_buf, size_t inflate_buf_size,
-      const uint32_t *palette)
+static INLINE void png_store_pixel(uint8_t *p, __m128i v, unsigned bpp)
 {
-   unsigned i, h;
-   unsigned bpp;
-   unsigned pitch;
-   size_t pass_size;
-   uint8_t *prev_scanline = NULL;
-   uint8_t *decoded_scanline = NULL;
-   bool ret = true;
-
-   png_pass_geom(ihdr, ihdr->width, ihdr->height, &bpp, &pitch, &pass_size);
+   int32_t x = _mm_cvtsi128_si32(v);
+   memcpy(p, &x, bpp);
+}
 
-   if (inflate_buf_size < pass_size)
-      return false;
+#elif defined(__ARM_NEON__)
+static INLINE uint8x8_t png_load_pixel(const uint8_t *p, unsigned bpp)
+{
+   uint32_t v = 0;
+   memcpy(&v, p, bpp);
+   return vreinterpret_u8_u32(vdup_n_u32(v));
+}
 
-   prev_scanline    = (uint8_t*)calloc(1, pitch);
-   decoded_scanline = (uint8_t*)calloc(1, pitch);
+static INLINE void png_store_pixel(uint8_t *p, uint8x8_t v, unsigned bpp)
+{
+   uint32_t x = vget_lane_u32(vreinterpret_u32_u8(v), 0);
+   memcpy(p, &x, bpp);
+}
+#endif
 
-   if (!prev_scanline || !decoded_scanline)
-      GOTO_END_ERROR();
+static void png_unfilter_sub(uint8_t *out, const uint8_t *in,
+      unsigned pitch, unsigned bpp)
+{
+   unsigned i = 0;
 
-   for (h = 0; h < ihdr->height;
-         h++, inflate_buf += pitch, data += ihdr->width)
+#if defined(__SSE2__)
+   if (bpp == 4)
    {
-      unsigned filter = *inflate_buf++;
+      /* Prefix sum over four pixels at a time. */
+      __m128i a = _mm_setzero_si128();
 
-      switch (filter)
+      for (; i + 16 <= pitch; i += 16)
       {
-         case 0: /* None */
-            memcpy(decoded_scanline, inflate_buf, pitch);
-            break;
-
-         case 1: /* Sub */
-            for (i = 0; i < bpp; i++)
-               decoded_scanline[i] = inflate_buf[i];
-            for (i = bpp; i < pitch; i++)
-               decoded_scanline[i] = decoded_scanline[i - bpp] + inflate_buf[i];
-            break;
-
-         case 2: /* Up */
-            for (i = 0; i < pitch; i++)
-               decoded_scanline[i] = prev_scanline[i] + inflate_buf[i];
-            break;
-
-         case 3: /* Average */
-            for (i = 0; i < bpp; i++)
-            {
-               uint8_t avg = prev_scanline[i] >> 1;
-               decoded_scanline[i] = avg + inflate_buf[i];
-            }
-            for (i = bpp; i < pitch; i++)
-            {
-               uint8_t avg = (decoded_scanline[i - bpp] + prev_scanline[i]) >> 1;
-               decoded_scanline[i] = avg + inflate_buf[i];
-            }
-            break;
-
-         case 4: /* Paeth */
-            for (i = 0; i < bpp; i++)
-               decoded_scanline[i] = paeth(0, prev_scanline[i], 0) + inflate_buf[i];
-            for (i = bpp; i < pitch; i++)
-               decoded_scanline[i] = paeth(decoded_scanline[i - bpp],
-                     prev_scanline[i], prev_scanline[i - bpp]) + inflate_buf[i];
-            break;
-
-         default:
-            GOTO_END_ERROR();
+         __m128i x = _mm_loadu_si128((const __m128i*)(in + i));
+         x = _mm_add_epi8(x, _mm_slli_si128(x, 4));
+         x = _mm_add_epi8(x, _mm_slli_si128(x, 8));
+         x = _mm_add_epi8(x, a);
+         _mm_storeu_si128((__m128i*)(out + i), x);
+         a = _mm_shuffle_epi32(x, _MM_SHUFFLE(3, 3, 3, 3));
       }
-
-      if (ihdr->color_type == 0)
-         copy_line_bw(data, decoded_scanline, ihdr->width, ihdr->depth);
-      else if (ihdr->color_type == 2)
-         copy_line_rgb(data, decoded_scanline, ihdr->width, ihdr->depth);
-      else if (ihdr->color_type == 3)
-         copy_line_plt(data, decoded_scanline, ihdr->width,
-               ihdr->depth, palette);
-      else if (ihdr->color_type == 4)
-         copy_line_gray_alpha(data, decoded_scanline, ihdr->width,
-               ihdr->depth);
-      else if (ihdr->color_type == 6)
-         copy_line_rgba(data, decoded_scanline, ihdr->width, ihdr->depth);
-
-      memcpy(prev_scanline, decoded_scanline, pitch);
    }
+#endif
 
-end:
-   free(decoded_scanline);
-   free(prev_scanline);
-   return ret;
+   if (i == 0)
+   {
+      for (; i < bpp; i++)
+         out[i] = in[i];
+   }
+   for (; i < pitch; i++)
+      out[i] = out[i - bpp] + in[i];
 }
 
-static bool png_reverse_filter_adam7(uint32_t *data,
-      const struct png_ihdr *ihdr,
-      const uint8_t *inflate_buf, size_t inflate_buf_size,
-      const uint32_t *palette)
+static void png_unfilter_up(uint8_t *out, const uint8_t *in,
+      const uint8_t *prev, unsigned pitch)
 {
-   unsigned pass;
-   static const struct adam7_pass passes[] = {
-      { 0, 0, 8, 8 },
-      { 4, 0, 8, 8 },
-      { 0, 4, 4, 8 },
-      { 2, 0, 4, 4 },
-      { 0, 2, 2, 4 },
-      { 1, 0, 2, 2 },
-      { 0, 1, 1, 2 },
-   };
-
-   for (pass = 0; pass < ARRAY_SIZE(passes); pass++)
+   unsigned i = 0;
+
+#if defined(__SSE2__)
+   for (; i + 16 <= pitch; i += 16)
    {
-      unsigned pass_width, pass_height;
-      size_t pass_size;
-      struct png_ihdr tmp_ihdr;
-      uint32_t *tmp_data = NULL;
+      __m128i x = _mm_loadu_si128((const __m128i*)(in + i));
+      __m128i b = _mm_loadu_si128((const __m128i*)(prev + i));
+      _mm_storeu_si128((__m128i*)(out + i), _mm_add_epi8(x, b));
+   }
+#elif defined(__ARM_NEON__)
+   for (; i + 16 <= pitch; i += 16)
+      vst1q_u8(out + i, vaddq_u8(vld1q_u8(in + i), vld1q_u8(prev + i)));
+#endif
 
-      if (ihdr->width <= passes[pass].x ||
-            ihdr->height <= passes[pass].y) /* Empty pass */
-         continue;
+   for (; i < pitch; i++)
+      out[i] = prev[i] + in[i];
+}
 
-      pass_width  = (ihdr->width - 
-            passes[pass].x + passes[pass].stride_x - 1) / passes[pass].stride_x;
-      pass_height = (ihdr->height - passes[pass].y + 
-            passes[pass].stride_y - 1) / passes[pass].stride_y;
+static void png_unfilter_avg(uint8_t *out, const uint8_t *in,
+      const uint8_t *prev, unsigned pitch, unsigned bpp)
+{
+   unsigned i;
 
-      tmp_data = (uint32_t*)malloc(
-            pass_width * pass_height * sizeof(uint32_t));
+#if defined(__SSE2__)
+   if (bpp == 3 || bpp == 4)
+   {
+      const __m128i one = _mm_set1_epi8(1);
+      __m128i a         = _mm_setzero_si128();
 
-      if (!tmp_data)
-         return false;
+      for (i = 0; i + bpp <= pitch; i += bpp)
+      {
+         __m128i b   = png_load_pixel(prev + i, bpp);
+         /* _mm_avg_epu8 rounds up, PNG rounds down. */
+         __m128i avg = _mm_sub_epi8(_mm_avg_epu8(a, b),
+               _mm_and_si128(_mm_xor_si128(a, b), one));
+         a = _mm_add_epi8(avg, png_load_pixel(in + i, bpp));
+         png_store_pixel(out + i, a, bpp);
+      }
+      return;
+   }
+#elif defined(__ARM_NEON__)
+   if (bpp == 3 || bpp == 4)
+   {
+      uint8x8_t a = vdup_n_u8(0);
+
+      for (i = 0; i + bpp <= pitch; i += bpp)
+      {
+         uint8x8_t b = png_load_pixel(prev + i, bpp);
+         a = vadd_u8(vhadd_u8(a, b), png_load_pixel(in + i, bpp));
+         png_store_pixel(out + i, a, bpp);
+      }
+      return;
+   }
+#endif
 
-      tmp_ihdr = *ihdr;
-      tmp_ihdr.width = pass_width;
-      tmp_ihdr.height = pass_height;
+   for (i = 0; i < bpp; i++)
+      out[i] = (prev[i] >> 1) + in[i];
+   for (i = bpp; i < pitch; i++)
+      out[i] = ((out[i - bpp] + prev[i]) >> 1) + in[i];
+}
+
+static void png_unfilter_paeth(uint8_t *out, const uint8_t *in,
+      const uint8_t *prev, unsigned pitch, unsigned bpp)
+{
+   unsigned i;
 
-      png_pass_geom(&tmp_ihdr, pass_width,
-            pass_height, NULL, NULL, &pass_size);
+#if defined(__SSE2__)
+   if (bpp == 3 || bpp == 4)
+   {
+      const __m128i zero = _mm_setzero_si128();
+      __m128i a          = zero;
+      __m128i c          = zero;
 
-      if (pass_size > inflate_buf_size)
+      for (i = 0; i + bpp <= pitch; i += bpp)
       {
-         free(tmp_data);
-         return false;
+         __m128i b       = _mm_unpacklo_epi8(
+               png_load_pixel(prev + i, bpp), zero);
+         __m128i nearest = png_paeth_epi16(a, b, c);
+
+         nearest = _mm_add_epi8(_mm_packus_epi16(nearest, nearest),
+               png_load_pixel(in + i, bpp));
+
+         png_store_pixel(out + i, nearest, bpp);
+         a = _mm_unpacklo_epi8(nearest, zero);
+         c = b;
       }
+      return;
+   }
+#elif defined(__ARM_NEON__)
+   if (bpp == 3 || bpp == 4)
+   {
+      uint8x8_t a = vdup_n_u8(0);
+      uint8x8_t c = vdup_n_u8(0);
 
-      if (!png_reverse_filter(tmp_data,
-               &tmp_ihdr, inflate_buf, pass_size, palette))
+      for (i = 0; i + bpp <= pitch; i += bpp)
       {
-         free(tmp_data);
-         return false;
+         uint8x8_t b = png_load_pixel(prev + i, bpp);
+
+         a = vadd_u8(png_paeth_u8(a, b, c), png_load_pixel(in + i, bpp));
+         png_store_pixel(out + i, a, bpp);
+         c = b;
       }
+      return;
+   }
+#endif
 
-      inflate_buf += pass_size;
-      inflate_buf_size -= pass_size;
+   for (i = 0; i < bpp; i++)
+      out[i] = paeth(0, prev[i], 0) + in[i];
+   for (i = bpp; i < pitch; i++)
+      out[i] = paeth(out[i - bpp], prev[i], prev[i - bpp]) + in[i];
+}
 
-      deinterlace_pass(data,
-            ihdr, tmp_data, pass_width, pass_height, &passes[pass]);
-      free(tmp_data);
+/**
+ * png_reverse_filter_line:
+ * @out               : decoded scanline.
+ * @in                : filtered scanline, without the filter byte.
+ * @prev              : previous decoded scanline (zeroed for
+ *                      the first line).
+ * @filter            : filter type byte of the scanline.
+ * @pitch             : scanline size in bytes.
+ * @bpp               : bytes per complete pixel (at least 1).
+ *
+ * Returns: false if the filter type is invalid.
+ **/
+static bool png_reverse_filter_line(uint8_t *out, const uint8_t *in,
+      const uint8_t *prev, unsigned filter, unsigned pitch, unsigned bpp)
+{
+   switch (filter)
+   {
+      case 0: /* None */
+         memcpy(out, in, pitch);
+         break;
+      case 1: /* Sub */
+         png_unfilter_sub(out, in, pitch, bpp);
+         break;
+      case 2: /* Up */
+         png_unfilter_up(out, in, prev, pitch);
+         break;
+      case 3: /* Average */
+         png_unfilter_avg(out, in, prev, pitch, bpp);
+         break;
+      case 4: /* Paeth */
+         png_unfilter_paeth(out, in, prev, pitch, bpp);
+         break;
+      default:
+         return false;
    }
 
    return true;
 }
 
+static void png_copy_line(uint32_t *data, const uint8_t *decoded,
+      const struct png_ihdr *ihdr, unsigned width, const uint32_t *palette)
+{
+   if (ihdr->color_type == 0)
+      copy_line_bw(data, decoded, width, ihdr->depth);
+   else if (ihdr->color_type == 2)
+      copy_line_rgb(data, decoded, width, ihdr->depth);
+   else if (ihdr->color_type == 3)
+      copy_line_plt(data, decoded, width, ihdr->depth, palette);
+   else if (ihdr->color_type == 4)
+      copy_line_gray_alpha(data, decoded, width, ihdr->depth);
+   else if (ihdr->color_type == 6)
+      copy_line_rgba(data, decoded, width, ihdr->depth);
+}
+
 #endif
@@ -35,6 +35,131 @@
 #include "rpng_common.h"
 #include "rpng_decode_common.h"
 
+static void deinterlace_pass(uint32_t *data, const struct png_ihdr *ihdr,
+      const uint32_t *input, unsigned pass_width, unsigned pass_height,
+      const struct adam7_pass *pass)
+{
+   unsigned x, y;
+
+   data += pass->y * ihdr->width + pass->x;
+
+   for (y = 0; y < pass_height;
+         y++, data += ihdr->width * pass->stride_y, input += pass_width)
+   {
+      uint32_t *out = data;
+     
+      for (x = 0; x < pass_width; x++, out += pass->stride_x)
+         *out = input[x];
+   }
+}
+
+static bool png_reverse_filter(uint32_t *data, const struct png_ihdr *ihdr,
+      const uint8_t *inflate_buf, size_t inflate_buf_size,
+      const uint32_t *palette)
+{
+   unsigned h;
+   unsigned bpp;
+   unsigned pitch;
+   size_t pass_size;
+   uint8_t *prev_scanline = NULL;
+   uint8_t *decoded_scanline = NULL;
+   bool ret = true;
+
+   png_pass_geom(ihdr, ihdr->width, ihdr->height, &bpp, &pitch, &pass_size);
+
+   if (inflate_buf_size < pass_size)
+      return false;
+
+   prev_scanline    = (uint8_t*)calloc(1, pitch);
+   decoded_scanline = (uint8_t*)calloc(1, pitch);
+
+   if (!prev_scanline || !decoded_scanline)
+      GOTO_END_ERROR();
+
+   for (h = 0; h < ihdr->height;
+         h++, inflate_buf += pitch, data += ihdr->width)
+   {
+      uint8_t *tmp;
+      unsigned filter = *inflate_buf++;
+
+      if (!png_reverse_filter_line(decoded_scanline, inflate_buf,
+               prev_scanline, filter, pitch, bpp))
+         GOTO_END_ERROR();
+
+      png_copy_line(data, decoded_scanline, ihdr, ihdr->width, palette);
+
+      tmp              = prev_scanline;
+      prev_scanline    = decoded_scanline;
+      decoded_scanline = tmp;
+   }
+
+end:
+   free(decoded_scanline);
+   free(prev_scanline);
+   return ret;
+}
+
+static bool png_reverse_filter_adam7(uint32_t *data,
+      const struct png_ihdr *ihdr,
+      const uint8_t *inflate_buf, size_t inflate_buf_size,
+      const uint32_t *palette)
+{
+   unsigned pass;
+   const struct adam7_pass *passes = adam7_passes;
+
+   for (pass = 0; pass < ARRAY_SIZE(adam7_passes); pass++)
+   {
+      unsigned pass_width, pass_height;
+      size_t pass_size;
+      struct png_ihdr tmp_ihdr;
+      uint32_t *tmp_data = NULL;
+
+      if (ihdr->width <= passes[pass].x ||
+            ihdr->height <= passes[pass].y) /* Empty pass */
+         continue;
+
+      pass_width  = (ihdr->width - 
+            passes[pass].x + passes[pass].stride_x - 1) / passes[pass].stride_x;
+      pass_height = (ihdr->height - passes[pass].y + 
+            passes[pass].stride_y - 1) / passes[pass].stride_y;
+
+      tmp_data = (uint32_t*)malloc(
+            pass_width * pass_height * sizeof(uint32_t));
+
+      if (!tmp_data)
+         return false;
+
+      tmp_ihdr = *ihdr;
+      tmp_ihdr.width = pass_width;
+      tmp_ihdr.height = pass_height;
+
+      png_pass_geom(&tmp_ihdr, pass_width,
+            pass_height, NULL, NULL, &pass_size);
+
+      if (pass_size > inflate_buf_size)
+      {
+         free(tmp_data);
+         return false;
+      }
+
+      if (!png_reverse_filter(tmp_data,
+               &tmp_ihdr, inflate_buf, pass_size, palette))
+      {
+         free(tmp_data);
+         return false;
+      }
+
+      inflate_buf += pass_size;
+      inflate_buf_size -= pass_size;
+
+      deinterlace_pass(data,
+            ihdr, tmp_data, pass_width, pass_height, &passes[pass]);
+      free(tmp_data);
+   }
+
+   return true;
+}
+
 static bool read_chunk_header_fio(FILE *file, struct png_chunk *chunk)
 {
    uint8_t dword[4] = {0};
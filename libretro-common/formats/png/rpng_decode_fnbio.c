@@ -149,10 +149,10 @@ static bool png_realloc_idat(const struct png_chunk *chunk, struct idat_buffer *
    return true;
 }
 
-static bool png_read_plte_into_buf(uint32_t *buffer, unsigned entries)
+static bool png_read_plte_into_buf(const uint8_t *buf,
+      uint32_t *buffer, unsigned entries)
 {
    unsigned i;
-   uint8_t buf[256 * 3];
 
    for (i = 0; i < entries; i++)
    {
@@ -219,10 +219,7 @@ bool rpng_nbio_load_image_argb_iterate(uint8_t *buf, struct rpng_t *rpng)
 
             buf += 8;
 
-            for (i = 0; i < entries; i++)
-               rpng->palette[i] = buf[i];
-
-            if (!png_read_plte_into_buf(rpng->palette, entries))
+            if (!png_read_plte_into_buf(buf, rpng->palette, entries))
                return false;
 
             rpng->has_plte = true;
@@ -257,34 +254,98 @@ bool rpng_nbio_load_image_argb_iterate(uint8_t *buf, struct rpng_t *rpng)
    return true;
 }
 
-bool rpng_nbio_load_image_argb_process(struct rpng_t *rpng,
+/**
+ * png_process_next_pass:
+ * @rpng              : PNG decoder state.
+ *
+ * Sets up geometry and scanline state for the next
+ * non-empty pass.
+ *
+ * Returns: false if there are no more passes.
+ **/
+static bool png_process_next_pass(struct rpng_t *rpng)
+{
+   struct png_ihdr tmp_ihdr;
+   struct rpng_process_t *process = &rpng->process;
+
+   if (rpng->ihdr.interlace != 1)
+   {
+      if (process->initialized)
+         return false;
+      process->pass_width  = rpng->ihdr.width;
+      process->pass_height = rpng->ihdr.height;
+   }
+   else
+   {
+      const struct adam7_pass *pass = NULL;
+
+      for (; process->pass < ARRAY_SIZE(adam7_passes); process->pass++)
+      {
+         pass = &adam7_passes[process->pass];
+
+         /* Empty passes are not stored in the stream. */
+         if (rpng->ihdr.width > pass->x && rpng->ihdr.height > pass->y)
+            break;
+      }
+
+      if (process->pass >= ARRAY_SIZE(adam7_passes))
+         return false;
+
+      process->pass_width  = (rpng->ihdr.width -
+            pass->x + pass->stride_x - 1) / pass->stride_x;
+      process->pass_height = (rpng->ihdr.height -
+            pass->y + pass->stride_y - 1) / pass->stride_y;
+   }
+
+   tmp_ihdr        = rpng->ihdr;
+   tmp_ihdr.width  = process->pass_width;
+   tmp_ihdr.height = process->pass_height;
+   png_pass_geom(&tmp_ihdr, tmp_ihdr.width, tmp_ihdr.height,
+         &process->bpp, &process->pitch, NULL);
+
+   /* Filters treat bytes before the first scanline as zero. */
+   memset(process->prev_scanline, 0, process->pitch);
+   process->h = 0;
+
+   return true;
+}
+
+static bool png_process_init(struct rpng_t *rpng,
       uint32_t **data, unsigned *width, unsigned *height)
 {
-   z_stream stream = {0};
+   unsigned pitch;
+   z_stream *stream = NULL;
+   struct rpng_process_t *process = &rpng->process;
 
-   if (inflateInit(&stream) != Z_OK)
-      return false;
+   *data = NULL;
 
    png_pass_geom(&rpng->ihdr, rpng->ihdr.width,
-         rpng->ihdr.height, NULL, NULL, &rpng->inflate_buf_size);
-   if (rpng->ihdr.interlace == 1) /* To be sure. */
-      rpng->inflate_buf_size *= 2;
-
-   rpng->inflate_buf = (uint8_t*)malloc(rpng->inflate_buf_size);
-   if (!rpng->inflate_buf)
+         rpng->ihdr.height, NULL, &pitch, NULL);
+
+   /* Adam7 passes are never wider than the full image. */
+   process->inflate_scanline = (uint8_t*)malloc(pitch + 1);
+   process->prev_scanline    = (uint8_t*)malloc(pitch);
+   process->decoded_scanline = (uint8_t*)malloc(pitch);
+   process->pass_line        = (uint32_t*)malloc(
+         rpng->ihdr.width * sizeof(uint32_t));
+   stream                    = (z_stream*)calloc(1, sizeof(z_stream));
+
+   if (!process->inflate_scanline || !process->prev_scanline
+         || !process->decoded_scanline || !process->pass_line || !stream)
+   {
+      free(stream);
       return false;
+   }
 
-   stream.next_in   = rpng->idat_buf.data;
-   stream.avail_in  = rpng->idat_buf.size;
-   stream.avail_out = rpng->inflate_buf_size;
-   stream.next_out  = rpng->inflate_buf;
-
-   if (inflate(&stream, Z_FINISH) != Z_STREAM_END)
+   if (inflateInit(stream) != Z_OK)
    {
-      inflateEnd(&stream);
+      free(stream);
       return false;
    }
-   inflateEnd(&stream);
+
+   stream->next_in  = rpng->idat_buf.data;
+   stream->avail_in = rpng->idat_buf.size;
+   process->stream  = stream;
 
    *width  = rpng->ihdr.width;
    *height = rpng->ihdr.height;
@@ -299,24 +360,148 @@ bool rpng_nbio_load_image_argb_process(struct rpng_t *rpng,
    if (!*data)
       return false;
 
+   if (!png_process_next_pass(rpng))
+      return false;
+
+   process->initialized = true;
+   return true;
+}
+
+static bool png_process_line(struct rpng_t *rpng, uint32_t *data)
+{
+   int err;
+   uint8_t *tmp;
+   struct rpng_process_t *process = &rpng->process;
+   z_stream *stream               = (z_stream*)process->stream;
+
+   stream->next_out  = process->inflate_scanline;
+   stream->avail_out = process->pitch + 1;
+
+   err = inflate(stream, Z_NO_FLUSH);
+   if ((err != Z_OK && err != Z_STREAM_END) || stream->avail_out)
+      return false;
+
+   if (!png_reverse_filter_line(process->decoded_scanline,
+            process->inflate_scanline + 1, process->prev_scanline,
+            process->inflate_scanline[0], process->pitch, process->bpp))
+      return false;
+
    if (rpng->ihdr.interlace == 1)
    {
-      if (!png_reverse_filter_adam7(*data,
-               &rpng->ihdr, rpng->inflate_buf, stream.total_out, rpng->palette))
-         return false;
+      unsigned x;
+      const struct adam7_pass *pass = &adam7_passes[process->pass];
+      uint32_t *out = data + (pass->y + process->h * pass->stride_y)
+         * rpng->ihdr.width + pass->x;
+
+      png_copy_line(process->pass_line, process->decoded_scanline,
+            &rpng->ihdr, process->pass_width, rpng->palette);
+
+      for (x = 0; x < process->pass_width; x++, out += pass->stride_x)
+         *out = process->pass_line[x];
    }
-   else if (!png_reverse_filter(*data,
-            &rpng->ihdr, rpng->inflate_buf, stream.total_out, rpng->palette))
-      return false;
+   else
+      png_copy_line(data + process->h * rpng->ihdr.width,
+            process->decoded_scanline, &rpng->ihdr,
+            process->pass_width, rpng->palette);
+
+   tmp                       = process->prev_scanline;
+   process->prev_scanline    = process->decoded_scanline;
+   process->decoded_scanline = tmp;
 
    return true;
 }
 
+static void png_process_free(struct rpng_process_t *process)
+{
+   if (process->stream)
+   {
+      inflateEnd((z_stream*)process->stream);
+      free(process->stream);
+   }
+
+   free(process->inflate_scanline);
+   free(process->prev_scanline);
+   free(process->decoded_scanline);
+   free(process->pass_line);
+
+   memset(process, 0, sizeof(*process));
+}
+
+/**
+ * rpng_nbio_load_image_argb_process_iterate:
+ * @rpng              : PNG decoder state.
+ * @data              : decoded image, allocated on the first call.
+ * @width             : image width.
+ * @height            : image height.
+ * @max_rows          : maximum amount of scanlines to decode.
+ *
+ * Inflates and unfilters at most @max_rows scanlines, so that
+ * large images can be decoded over several frames. Call after
+ * all chunks have been read.
+ *
+ * Returns: RPNG_PROCESS_NEXT if more scanlines remain,
+ * RPNG_PROCESS_END when the image is complete, RPNG_PROCESS_ERROR
+ * on failure (in which case @data is freed).
+ **/
+int rpng_nbio_load_image_argb_process_iterate(struct rpng_t *rpng,
+      uint32_t **data, unsigned *width, unsigned *height,
+      unsigned max_rows)
+{
+   unsigned rows;
+   struct rpng_process_t *process = &rpng->process;
+
+   if (!process->initialized &&
+         !png_process_init(rpng, data, width, height))
+      goto error;
+
+   for (rows = 0; rows < max_rows; rows++)
+   {
+      if (process->h >= process->pass_height)
+      {
+         process->pass++;
+         if (!png_process_next_pass(rpng))
+         {
+            png_process_free(process);
+            return RPNG_PROCESS_END;
+         }
+      }
+
+      if (!png_process_line(rpng, *data))
+         goto error;
+
+      process->h++;
+   }
+
+   return RPNG_PROCESS_NEXT;
+
+error:
+   png_process_free(process);
+   free(*data);
+   *data = NULL;
+   return RPNG_PROCESS_ERROR;
+}
+
+bool rpng_nbio_load_image_argb_process(struct rpng_t *rpng,
+      uint32_t **data, unsigned *width, unsigned *height)
+{
+   int ret;
+
+   do
+   {
+      ret = rpng_nbio_load_image_argb_process_iterate(rpng,
+            data, width, height, rpng->ihdr.height);
+   }while (ret == RPNG_PROCESS_NEXT);
+
+   return ret == RPNG_PROCESS_END;
+}
+
 void rpng_nbio_load_image_free(struct rpng_t *rpng)
 {
    if (!rpng)
       return;
 
+   png_process_free(&rpng->process);
+
    if (rpng->idat_buf.data)
       free(rpng->idat_buf.data);
    if (rpng->inflate_buf)
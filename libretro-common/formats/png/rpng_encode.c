@@ -28,6 +28,10 @@
 #include <stdlib.h>
 #include <string.h>
 
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
+
 #include "rpng_common.h"
 
 #undef GOTO_END_ERROR
@@ -135,11 +139,51 @@ static void copy_bgr24_line(uint8_t *dst, const uint8_t *src, unsigned width)
    }
 }
 
+#if defined(__SSE2__)
+static INLINE __m128i png_sad_epi8(__m128i x)
+{
+   /* |x| for signed bytes, -128 maps to 128. */
+   const __m128i zero = _mm_setzero_si128();
+   return _mm_sad_epu8(_mm_min_epu8(x, _mm_sub_epi8(zero, x)), zero);
+}
+
+static INLINE unsigned png_sad_sum(__m128i acc)
+{
+   return _mm_cvtsi128_si32(acc) + _mm_cvtsi128_si32(_mm_srli_si128(acc, 8));
+}
+#elif defined(__ARM_NEON__)
+static INLINE uint32x4_t png_sad_u8(uint32x4_t acc, uint8x16_t x)
+{
+   uint8x16_t abs_x = vreinterpretq_u8_s8(vabsq_s8(vreinterpretq_s8_u8(x)));
+   return vpadalq_u16(acc, vpaddlq_u8(abs_x));
+}
+
+static INLINE unsigned png_sad_sum(uint32x4_t acc)
+{
+   uint64x2_t sum = vpaddlq_u32(acc);
+   return (unsigned)(vgetq_lane_u64(sum, 0) + vgetq_lane_u64(sum, 1));
+}
+#endif
+
 static unsigned count_sad(const uint8_t *data, size_t size)
 {
-   size_t i;
+   size_t i = 0;
    unsigned cnt = 0;
-   for (i = 0; i < size; i++)
+
+#if defined(__SSE2__)
+   __m128i acc = _mm_setzero_si128();
+   for (; i + 16 <= size; i += 16)
+      acc = _mm_add_epi64(acc,
+            png_sad_epi8(_mm_loadu_si128((const __m128i*)(data + i))));
+   cnt = png_sad_sum(acc);
+#elif defined(__ARM_NEON__)
+   uint32x4_t acc = vdupq_n_u32(0);
+   for (; i + 16 <= size; i += 16)
+      acc = png_sad_u8(acc, vld1q_u8(data + i));
+   cnt = png_sad_sum(acc);
+#endif
+
+   for (; i < size; i++)
       cnt += abs((int8_t)data[i]);
    return cnt;
 }
@@ -147,9 +191,20 @@ static unsigned count_sad(const uint8_t *data, size_t size)
 static unsigned filter_up(uint8_t *target, const uint8_t *line,
       const uint8_t *prev, unsigned width, unsigned bpp)
 {
-   unsigned i;
+   unsigned i = 0;
    width *= bpp;
-   for (i = 0; i < width; i++)
+
+#if defined(__SSE2__)
+   for (; i + 16 <= width; i += 16)
+      _mm_storeu_si128((__m128i*)(target + i), _mm_sub_epi8(
+               _mm_loadu_si128((const __m128i*)(line + i)),
+               _mm_loadu_si128((const __m128i*)(prev + i))));
+#elif defined(__ARM_NEON__)
+   for (; i + 16 <= width; i += 16)
+      vst1q_u8(target + i, vsubq_u8(vld1q_u8(line + i), vld1q_u8(prev + i)));
+#endif
+
+   for (; i < width; i++)
       target[i] = line[i] - prev[i];
 
    return count_sad(target, width);
@@ -162,7 +217,19 @@ static unsigned filter_sub(uint8_t *target, const uint8_t *line,
    width *= bpp;
    for (i = 0; i < bpp; i++)
       target[i] = line[i];
-   for (i = bpp; i < width; i++)
+
+#if defined(__SSE2__)
+   for (; i + 16 <= width; i += 16)
+      _mm_storeu_si128((__m128i*)(target + i), _mm_sub_epi8(
+               _mm_loadu_si128((const __m128i*)(line + i)),
+               _mm_loadu_si128((const __m128i*)(line + i - bpp))));
+#elif defined(__ARM_NEON__)
+   for (; i + 16 <= width; i += 16)
+      vst1q_u8(target + i, vsubq_u8(vld1q_u8(line + i),
+               vld1q_u8(line + i - bpp)));
+#endif
+
+   for (; i < width; i++)
       target[i] = line[i] - line[i - bpp];
 
    return count_sad(target, width);
@@ -175,7 +242,30 @@ static unsigned filter_avg(uint8_t *target, const uint8_t *line,
    width *= bpp;
    for (i = 0; i < bpp; i++)
       target[i] = line[i] - (prev[i] >> 1);
-   for (i = bpp; i < width; i++)
+
+#if defined(__SSE2__)
+   {
+      const __m128i one = _mm_set1_epi8(1);
+
+      for (; i + 16 <= width; i += 16)
+      {
+         __m128i a   = _mm_loadu_si128((const __m128i*)(line + i - bpp));
+         __m128i b   = _mm_loadu_si128((const __m128i*)(prev + i));
+         /* _mm_avg_epu8 rounds up, PNG rounds down. */
+         __m128i avg = _mm_sub_epi8(_mm_avg_epu8(a, b),
+               _mm_and_si128(_mm_xor_si128(a, b), one));
+
+         _mm_storeu_si128((__m128i*)(target + i), _mm_sub_epi8(
+                  _mm_loadu_si128((const __m128i*)(line + i)), avg));
+      }
+   }
+#elif defined(__ARM_NEON__)
+   for (; i + 16 <= width; i += 16)
+      vst1q_u8(target + i, vsubq_u8(vld1q_u8(line + i),
+               vhaddq_u8(vld1q_u8(line + i - bpp), vld1q_u8(prev + i))));
+#endif
+
+   for (; i < width; i++)
       target[i] = line[i] - ((line[i - bpp] + prev[i]) >> 1);
 
    return count_sad(target, width);
@@ -189,30 +279,262 @@ static unsigned filter_paeth(uint8_t *target,
    width *= bpp;
    for (i = 0; i < bpp; i++)
       target[i] = line[i] - paeth(0, prev[i], 0);
-   for (i = bpp; i < width; i++)
+
+#if defined(__SSE2__)
+   {
+      const __m128i zero = _mm_setzero_si128();
+
+      for (; i + 16 <= width; i += 16)
+      {
+         __m128i a  = _mm_loadu_si128((const __m128i*)(line + i - bpp));
+         __m128i b  = _mm_loadu_si128((const __m128i*)(prev + i));
+         __m128i c  = _mm_loadu_si128((const __m128i*)(prev + i - bpp));
+         __m128i lo = png_paeth_epi16(_mm_unpacklo_epi8(a, zero),
+               _mm_unpacklo_epi8(b, zero), _mm_unpacklo_epi8(c, zero));
+         __m128i hi = png_paeth_epi16(_mm_unpackhi_epi8(a, zero),
+               _mm_unpackhi_epi8(b, zero), _mm_unpackhi_epi8(c, zero));
+
+         _mm_storeu_si128((__m128i*)(target + i), _mm_sub_epi8(
+                  _mm_loadu_si128((const __m128i*)(line + i)),
+                  _mm_packus_epi16(lo, hi)));
+      }
+   }
+#elif defined(__ARM_NEON__)
+   for (; i + 16 <= width; i += 16)
+   {
+      uint8x16_t a = vld1q_u8(line + i - bpp);
+      uint8x16_t b = vld1q_u8(prev + i);
+      uint8x16_t c = vld1q_u8(prev + i - bpp);
+      uint8x16_t p = vcombine_u8(
+            png_paeth_u8(vget_low_u8(a), vget_low_u8(b), vget_low_u8(c)),
+            png_paeth_u8(vget_high_u8(a), vget_high_u8(b), vget_high_u8(c)));
+
+      vst1q_u8(target + i, vsubq_u8(vld1q_u8(line + i), p));
+   }
+#endif
+
+   for (; i < width; i++)
       target[i] = line[i] - paeth(line[i - bpp], prev[i], prev[i - bpp]);
 
    return count_sad(target, width);
 }
 
+struct png_encode_band
+{
+   const uint8_t *data;
+   /* Input line above the band, NULL for the first band. */
+   const uint8_t *prev_data;
+   uint8_t *encode_target;
+   unsigned width;
+   unsigned height;
+   unsigned pitch;
+   unsigned bpp;
+   int compression;
+   bool ret;
+};
+
+static void png_copy_encode_line(uint8_t *dst, const uint8_t *src,
+      unsigned width, unsigned bpp)
+{
+   if (bpp == sizeof(uint32_t))
+      copy_argb_line(dst, (const uint32_t*)src, width);
+   else
+      copy_bgr24_line(dst, src, width);
+}
+
+/**
+ * png_encode_band:
+ * @data              : pointer to struct png_encode_band.
+ *
+ * Filters a range of lines into the encode buffer.
+ * Lines only depend on the unfiltered line above, so
+ * bands can be filtered in parallel.
+ **/
+static void png_encode_band(void *data)
+{
+   unsigned h;
+   struct png_encode_band *band = (struct png_encode_band*)data;
+   unsigned width          = band->width;
+   unsigned bpp            = band->bpp;
+   size_t line_size        = width * bpp;
+   const uint8_t *input    = band->data;
+   uint8_t *encode_target  = band->encode_target;
+   uint8_t *rgba_line      = (uint8_t*)malloc(line_size);
+   uint8_t *prev_encoded   = (uint8_t*)calloc(1, line_size);
+   uint8_t *up_filtered    = (uint8_t*)malloc(line_size);
+   uint8_t *sub_filtered   = (uint8_t*)malloc(line_size);
+   uint8_t *avg_filtered   = (uint8_t*)malloc(line_size);
+   uint8_t *paeth_filtered = (uint8_t*)malloc(line_size);
+
+   band->ret = false;
+
+   if (!rgba_line || !prev_encoded || !up_filtered
+         || !sub_filtered || !avg_filtered || !paeth_filtered)
+      goto end;
+
+   if (band->prev_data)
+      png_copy_encode_line(prev_encoded, band->prev_data, width, bpp);
+
+   for (h = 0; h < band->height;
+         h++, encode_target += line_size, input += band->pitch)
+   {
+      uint8_t *tmp;
+      uint8_t filter                 = 0;
+      const uint8_t *chosen_filtered = rgba_line;
+
+      png_copy_encode_line(rgba_line, input, width, bpp);
+
+      /* Try the filtering methods, and choose the method
+       * which has most entries as zero.
+       *
+       * This is probably not very optimal, but it's very 
+       * simple to implement. Low compression levels only
+       * try the cheap filters, level 0 does not filter.
+       */
+      if (band->compression > 0)
+      {
+         unsigned min_sad   = count_sad(rgba_line, line_size);
+         unsigned sub_score = filter_sub(sub_filtered, rgba_line, width, bpp);
+         unsigned up_score  = filter_up(up_filtered, rgba_line,
+               prev_encoded, width, bpp);
+
+         if (sub_score < min_sad)
+         {
+            filter = 1;
+            chosen_filtered = sub_filtered;
+            min_sad = sub_score;
+         }
+
+         if (up_score < min_sad)
+         {
+            filter = 2;
+            chosen_filtered = up_filtered;
+            min_sad = up_score;
+         }
+
+         if (band->compression > 3)
+         {
+            unsigned avg_score   = filter_avg(avg_filtered, rgba_line,
+                  prev_encoded, width, bpp);
+            unsigned paeth_score = filter_paeth(paeth_filtered, rgba_line,
+                  prev_encoded, width, bpp);
+
+            if (avg_score < min_sad)
+            {
+               filter = 3;
+               chosen_filtered = avg_filtered;
+               min_sad = avg_score;
+            }
+
+            if (paeth_score < min_sad)
+            {
+               filter = 4;
+               chosen_filtered = paeth_filtered;
+               min_sad = paeth_score;
+            }
+         }
+      }
+
+      *encode_target++ = filter;
+      memcpy(encode_target, chosen_filtered, line_size);
+
+      tmp          = prev_encoded;
+      prev_encoded = rgba_line;
+      rgba_line    = tmp;
+   }
+
+   band->ret = true;
+
+end:
+   free(rgba_line);
+   free(prev_encoded);
+   free(up_filtered);
+   free(sub_filtered);
+   free(avg_filtered);
+   free(paeth_filtered);
+}
+
+/**
+ * png_encode_lines:
+ *
+ * Filters all lines into @encode_buf, splitting the image
+ * into bands over @threads threads if threading is available.
+ *
+ * Returns: true if successful, otherwise false.
+ **/
+static bool png_encode_lines(uint8_t *encode_buf, const uint8_t *data,
+      unsigned width, unsigned height, unsigned pitch, unsigned bpp,
+      int compression, unsigned threads)
+{
+   unsigned i;
+   bool ret = true;
+   struct png_encode_band bands[RPNG_ENCODE_MAX_THREADS];
+#ifdef HAVE_THREADS
+   sthread_t *workers[RPNG_ENCODE_MAX_THREADS] = {NULL};
+#endif
+
+   if (threads < 1)
+      threads = 1;
+   if (threads > RPNG_ENCODE_MAX_THREADS)
+      threads = RPNG_ENCODE_MAX_THREADS;
+   if (threads > height)
+      threads = height;
+#ifndef HAVE_THREADS
+   threads = 1;
+#endif
+
+   for (i = 0; i < threads; i++)
+   {
+      unsigned start = height * i / threads;
+      unsigned end   = height * (i + 1) / threads;
+
+      bands[i].data          = data + start * pitch;
+      bands[i].prev_data     = start ? data + (start - 1) * pitch : NULL;
+      bands[i].encode_target = encode_buf + start * (width * bpp + 1);
+      bands[i].width         = width;
+      bands[i].height        = end - start;
+      bands[i].pitch         = pitch;
+      bands[i].bpp           = bpp;
+      bands[i].compression   = compression;
+      bands[i].ret           = false;
+   }
+
+#ifdef HAVE_THREADS
+   /* The calling thread takes the first band. */
+   for (i = 1; i < threads; i++)
+      workers[i] = sthread_create(png_encode_band, &bands[i]);
+
+   png_encode_band(&bands[0]);
+
+   for (i = 1; i < threads; i++)
+   {
+      if (workers[i])
+         sthread_join(workers[i]);
+      else
+         png_encode_band(&bands[i]);
+   }
+#else
+   png_encode_band(&bands[0]);
+#endif
+
+   for (i = 0; i < threads; i++)
+      ret = ret && bands[i].ret;
+
+   return ret;
+}
+
 static bool rpng_save_image(const char *path,
       const uint8_t *data,
-      unsigned width, unsigned height, unsigned pitch, unsigned bpp)
+      unsigned width, unsigned height, unsigned pitch, unsigned bpp,
+      int compression, unsigned threads)
 {
-   unsigned h;
    bool ret = true;
    struct png_ihdr ihdr = {0};
 
    size_t encode_buf_size  = 0;
+   size_t deflate_buf_size = 0;
    uint8_t *encode_buf     = NULL;
    uint8_t *deflate_buf    = NULL;
-   uint8_t *rgba_line      = NULL;
-   uint8_t *up_filtered    = NULL;
-   uint8_t *sub_filtered   = NULL;
-   uint8_t *avg_filtered   = NULL;
-   uint8_t *paeth_filtered = NULL;
-   uint8_t *prev_encoded   = NULL;
-   uint8_t *encode_target  = NULL;
 
    z_stream stream = {0};
 
@@ -223,6 +545,9 @@ static bool rpng_save_image(const char *path,
    if (fwrite(png_magic, 1, sizeof(png_magic), file) != sizeof(png_magic))
       GOTO_END_ERROR();
 
+   if (compression < 0 || compression > 9)
+      compression = 6;
+
    ihdr.width = width;
    ihdr.height = height;
    ihdr.depth = 8;
@@ -235,87 +560,26 @@ static bool rpng_save_image(const char *path,
    if (!encode_buf)
       GOTO_END_ERROR();
 
-   prev_encoded = (uint8_t*)calloc(1, width * bpp);
-   if (!prev_encoded)
+   if (!png_encode_lines(encode_buf, data, width, height, pitch, bpp,
+            compression, threads))
       GOTO_END_ERROR();
 
-   rgba_line      = (uint8_t*)malloc(width * bpp);
-   up_filtered    = (uint8_t*)malloc(width * bpp);
-   sub_filtered   = (uint8_t*)malloc(width * bpp);
-   avg_filtered   = (uint8_t*)malloc(width * bpp);
-   paeth_filtered = (uint8_t*)malloc(width * bpp);
-   if (!rgba_line || !up_filtered || !sub_filtered || !avg_filtered || !paeth_filtered)
+   if (deflateInit(&stream, compression) != Z_OK)
       GOTO_END_ERROR();
 
-   encode_target = encode_buf;
-   for (h = 0; h < height;
-         h++, encode_target += width * bpp, data += pitch)
-   {
-      if (bpp == sizeof(uint32_t))
-         copy_argb_line(rgba_line, (const uint32_t*)data, width);
-      else
-         copy_bgr24_line(rgba_line, data, width);
-
-      /* Try every filtering method, and choose the method
-       * which has most entries as zero.
-       *
-       * This is probably not very optimal, but it's very 
-       * simple to implement.
-       */
-      unsigned none_score  = count_sad(rgba_line, width * bpp);
-      unsigned up_score    = filter_up(up_filtered, rgba_line, prev_encoded, width, bpp);
-      unsigned sub_score   = filter_sub(sub_filtered, rgba_line, width, bpp);
-      unsigned avg_score   = filter_avg(avg_filtered, rgba_line, prev_encoded, width, bpp);
-      unsigned paeth_score = filter_paeth(paeth_filtered, rgba_line, prev_encoded, width, bpp);
-
-      uint8_t filter = 0;
-      unsigned min_sad = none_score;
-      const uint8_t *chosen_filtered = rgba_line;
-
-      if (sub_score < min_sad)
-      {
-         filter = 1;
-         chosen_filtered = sub_filtered;
-         min_sad = sub_score;
-      }
-
-      if (up_score < min_sad)
-      {
-         filter = 2;
-         chosen_filtered = up_filtered;
-         min_sad = up_score;
-      }
-
-      if (avg_score < min_sad)
-      {
-         filter = 3;
-         chosen_filtered = avg_filtered;
-         min_sad = avg_score;
-      }
-
-      if (paeth_score < min_sad)
-      {
-         filter = 4;
-         chosen_filtered = paeth_filtered;
-         min_sad = paeth_score;
-      }
-
-      *encode_target++ = filter;
-      memcpy(encode_target, chosen_filtered, width * bpp);
-
-      memcpy(prev_encoded, rgba_line, width * bpp);
-   }
-
-   deflate_buf = (uint8_t*)malloc(encode_buf_size * 2); /* Just to be sure. */
+   deflate_buf_size = deflateBound(&stream, encode_buf_size);
+   deflate_buf      = (uint8_t*)malloc(deflate_buf_size + 8);
    if (!deflate_buf)
+   {
+      deflateEnd(&stream);
       GOTO_END_ERROR();
+   }
 
    stream.next_in   = encode_buf;
    stream.avail_in  = encode_buf_size;
    stream.next_out  = deflate_buf + 8;
-   stream.avail_out = encode_buf_size * 2;
+   stream.avail_out = deflate_buf_size;
 
-   deflateInit(&stream, 9);
    if (deflate(&stream, Z_FINISH) != Z_STREAM_END)
    {
       deflateEnd(&stream);
@@ -336,12 +600,6 @@ end:
       fclose(file);
    free(encode_buf);
    free(deflate_buf);
-   free(rgba_line);
-   free(prev_encoded);
-   free(up_filtered);
-   free(sub_filtered);
-   free(avg_filtered);
-   free(paeth_filtered);
    return ret;
 }
 
@@ -349,14 +607,22 @@ bool rpng_save_image_argb(const char *path, const uint32_t *data,
       unsigned width, unsigned height, unsigned pitch)
 {
    return rpng_save_image(path, (const uint8_t*)data,
-         width, height, pitch, sizeof(uint32_t));
+         width, height, pitch, sizeof(uint32_t), 9, 1);
 }
 
 bool rpng_save_image_bgr24(const char *path, const uint8_t *data,
       unsigned width, unsigned height, unsigned pitch)
 {
    return rpng_save_image(path, (const uint8_t*)data,
-         width, height, pitch, 3);
+         width, height, pitch, 3, 9, 1);
+}
+
+bool rpng_save_image_bgr24_ext(const char *path, const uint8_t *data,
+      unsigned width, unsigned height, unsigned pitch,
+      int compression, unsigned threads)
+{
+   return rpng_save_image(path, (const uint8_t*)data,
+         width, height, pitch, 3, compression, threads);
 }
 
 #endif
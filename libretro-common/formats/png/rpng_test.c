@@ -26,6 +26,7 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <string.h>
+#include <time.h>
 #ifdef HAVE_IMLIB2
 #include <Imlib2.h>
 #endif
@@ -264,18 +265,134 @@ static int test_blocking_rpng(const char *in_path)
    return 0;
 }
 
+static double bench_time(void)
+{
+   struct timespec tv;
+   clock_gettime(CLOCK_MONOTONIC, &tv);
+   return tv.tv_sec + tv.tv_nsec / 1000000000.0;
+}
+
+static int test_benchmark_rpng(const char *in_path, unsigned iterations)
+{
+   unsigned i;
+   size_t file_len;
+   void *ptr                = NULL;
+   unsigned width           = 0;
+   unsigned height          = 0;
+   double blocking_time     = 0.0;
+   double nonblocking_time  = 0.0;
+   double max_slice         = 0.0;
+   unsigned slices          = 0;
+   struct nbio_t* handle    = (struct nbio_t*)nbio_open(in_path, NBIO_READ);
+
+   if (!handle)
+      return 1;
+
+   nbio_begin_read(handle);
+   while (!nbio_iterate(handle));
+   ptr = nbio_get_ptr(handle, &file_len);
+
+   if (!ptr)
+   {
+      nbio_free(handle);
+      return 1;
+   }
+
+   for (i = 0; i < iterations; i++)
+   {
+      uint32_t *data = NULL;
+      double start   = bench_time();
+
+      if (!rpng_load_image_argb(in_path, &data, &width, &height))
+      {
+         nbio_free(handle);
+         return 2;
+      }
+
+      blocking_time += bench_time() - start;
+      free(data);
+   }
+
+   for (i = 0; i < iterations; i++)
+   {
+      int ret;
+      uint32_t *data      = NULL;
+      struct rpng_t *rpng = (struct rpng_t*)calloc(1, sizeof(struct rpng_t));
+      double start        = bench_time();
+
+      if (!rpng)
+         break;
+
+      rpng->buff_data = (uint8_t*)ptr;
+
+      if (!rpng_nbio_load_image_argb_start(rpng))
+      {
+         rpng_nbio_load_image_free(rpng);
+         nbio_free(handle);
+         return 3;
+      }
+
+      while (rpng_nbio_load_image_argb_iterate(
+               rpng->buff_data, rpng))
+         rpng->buff_data += 4 + 4 + rpng->chunk.size + 4;
+
+      /* Decode in slices, as the frontend does across frames. */
+      do
+      {
+         double slice_start = bench_time();
+         double slice;
+
+         ret   = rpng_nbio_load_image_argb_process_iterate(rpng,
+               &data, &width, &height, 16);
+         slice = bench_time() - slice_start;
+
+         if (slice > max_slice)
+            max_slice = slice;
+         slices++;
+      }while (ret == RPNG_PROCESS_NEXT);
+
+      nonblocking_time += bench_time() - start;
+      rpng_nbio_load_image_free(rpng);
+      free(data);
+
+      if (ret != RPNG_PROCESS_END)
+      {
+         nbio_free(handle);
+         return 3;
+      }
+   }
+
+   nbio_free(handle);
+
+   fprintf(stderr, "Image: %u x %u, %u iterations.\n",
+         width, height, iterations);
+   fprintf(stderr, "Blocking:    %8.3f ms/image, %8.2f Mpixels/s.\n",
+         1000.0 * blocking_time / iterations,
+         width * height * (double)iterations / blocking_time / 1000000.0);
+   fprintf(stderr, "Nonblocking: %8.3f ms/image, %8.2f Mpixels/s.\n",
+         1000.0 * nonblocking_time / iterations,
+         width * height * (double)iterations / nonblocking_time / 1000000.0);
+   fprintf(stderr, "Slices:      %8.3f ms max, %u slices of 16 rows.\n",
+         1000.0 * max_slice, slices / iterations);
+
+   return 0;
+}
+
 int main(int argc, char *argv[])
 {
    const char *in_path = "/tmp/test.png";
+   unsigned iterations = 0;
 
-   if (argc > 2)
+   if (argc > 3)
    {
-      fprintf(stderr, "Usage: %s <png file>\n", argv[0]);
+      fprintf(stderr, "Usage: %s <png file> [benchmark iterations]\n", argv[0]);
       return 1;
    }
 
-   if (argc == 2)
+   if (argc >= 2)
       in_path = argv[1];
+   if (argc == 3)
+      iterations = strtoul(argv[2], NULL, 0);
 
    fprintf(stderr, "Doing nonblocking tests...\n");
 
@@ -287,5 +404,16 @@ int main(int argc, char *argv[])
 
    fprintf(stderr, "Doing blocking tests...\n");
 
-   return test_blocking_rpng(in_path);
+   if (test_blocking_rpng(in_path) != 0)
+   {
+      fprintf(stderr, "Blocking test failed.\n");
+      return -1;
+   }
+
+   if (!iterations)
+      return 0;
+
+   fprintf(stderr, "Doing benchmark...\n");
+
+   return test_benchmark_rpng(in_path, iterations);
 }
@@ -25,343 +25,360 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <retro_inline.h>
 
 #ifdef SCALER_NO_SIMD
 #undef __SSE2__
+#undef __ARM_NEON__
 #endif
 
 #if defined(__SSE2__)
 #include <emmintrin.h>
+
+/* SSSE3 and AVX2 paths are compiled with per-function target
+ * attributes and only picked at runtime by conv_init_simd(). */
+#if defined(__clang__) || (defined(__GNUC__) && \
+      (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)))
+#define PIXCONV_RUNTIME_X86
+#define PIXCONV_TARGET(isa) __attribute__((target(isa)))
+#include <tmmintrin.h>
+#include <immintrin.h>
+#endif
+#elif defined(__ARM_NEON__)
+#include <arm_neon.h>
 #endif
 
-#if defined(__SSE2_)
-void conv_rgb565_0rgb1555(void *output_, const void *input_,
+/* All converters are split into a loop over lines
+ * and a line converter, which is picked per CPU. */
+typedef void (*conv_line_t)(void *output, const void *input, int width);
+
+static INLINE void conv_lines(conv_line_t line,
+      void *output_, const void *input_,
       int width, int height,
       int out_stride, int in_stride)
 {
-   int h, w;
-   const uint16_t *input = (const uint16_t*)input_;
-   uint16_t *output = (uint16_t*)output_;
+   int h;
+   const uint8_t *input = (const uint8_t*)input_;
+   uint8_t *output      = (uint8_t*)output_;
 
-   int max_width = width - 7;
+   for (h = 0; h < height;
+         h++, output += out_stride, input += in_stride)
+      line(output, input, width);
+}
 
-   const __m128i hi_mask   = _mm_set1_epi16(0x7fe0);
-   const __m128i lo_mask   = _mm_set1_epi16(0x1f);
+static void conv_rgb565_0rgb1555_line_c(void *output_,
+      const void *input_, int width)
+{
+   int w;
+   const uint16_t *input = (const uint16_t*)input_;
+   uint16_t *output      = (uint16_t*)output_;
 
-   for (h = 0; h < height;
-         h++, output += out_stride >> 1, input += in_stride >> 1)
+   for (w = 0; w < width; w++)
    {
-      for (w = 0; w < max_width; w += 8)
-      {
-         const __m128i in = _mm_loadu_si128((const __m128i*)(input + w));
-         __m128i hi = _mm_and_si128(_mm_slli_epi16(in, 1), hi_mask);
-         __m128i lo = _mm_and_si128(in, lo_mask);
-         _mm_storeu_si128((__m128i*)(output + w), _mm_or_si128(hi, lo));
-      }
-
-      for (; w < width; w++)
-      {
-         uint16_t col = input[w];
-         uint16_t hi = (col >> 1) & 0x7fe0;
-         uint16_t lo = col & 0x1f;
-         output[w] = hi | lo;
-      }
+      uint16_t col = input[w];
+      uint16_t hi = (col >> 1) & 0x7fe0;
+      uint16_t lo = col & 0x1f;
+      output[w] = hi | lo;
    }
 }
-#else
-void conv_rgb565_0rgb1555(void *output_, const void *input_,
-      int width, int height,
-      int out_stride, int in_stride)
+
+static void conv_0rgb1555_rgb565_line_c(void *output_,
+      const void *input_, int width)
 {
-   int h, w;
+   int w;
    const uint16_t *input = (const uint16_t*)input_;
-   uint16_t *output = (uint16_t*)output_;
+   uint16_t *output      = (uint16_t*)output_;
 
-   for (h = 0; h < height;
-         h++, output += out_stride >> 1, input += in_stride >> 1)
+   for (w = 0; w < width; w++)
    {
-      for (w = 0; w < width; w++)
-      {
-         uint16_t col = input[w];
-         uint16_t hi = (col >> 1) & 0x7fe0;
-         uint16_t lo = col & 0x1f;
-         output[w] = hi | lo;
-      }
+      uint16_t col = input[w];
+      uint16_t rg = (col << 1) & ((0x1f << 11) | (0x1f << 6));
+      uint16_t b = col & 0x1f;
+      uint16_t glow = (col >> 4) & (1 << 5);
+      output[w] = rg | b | glow;
    }
 }
 
-#endif
-
-#if defined(__SSE2__)
-void conv_0rgb1555_rgb565(void *output_, const void *input_,
-      int width, int height,
-      int out_stride, int in_stride)
+static void conv_0rgb1555_argb8888_line_c(void *output_,
+      const void *input_, int width)
 {
-   int h, w;
+   int w;
    const uint16_t *input = (const uint16_t*)input_;
-   uint16_t *output = (uint16_t*)output_;
-
-   int max_width = width - 7;
-
-   const __m128i hi_mask   = _mm_set1_epi16(
-         (int16_t)((0x1f << 11) | (0x1f << 6)));
-   const __m128i lo_mask   = _mm_set1_epi16(0x1f);
-   const __m128i glow_mask = _mm_set1_epi16(1 << 5);
+   uint32_t *output      = (uint32_t*)output_;
 
-   for (h = 0; h < height;
-         h++, output += out_stride >> 1, input += in_stride >> 1)
-   {
-      for (w = 0; w < max_width; w += 8)
-      {
-         const __m128i in = _mm_loadu_si128((const __m128i*)(input + w));
-         __m128i rg   = _mm_and_si128(_mm_slli_epi16(in, 1), hi_mask);
-         __m128i b    = _mm_and_si128(in, lo_mask);
-         __m128i glow = _mm_and_si128(_mm_srli_epi16(in, 4), glow_mask);
-         _mm_storeu_si128((__m128i*)(output + w),
-               _mm_or_si128(rg, _mm_or_si128(b, glow)));
-      }
-
-      for (; w < width; w++)
-      {
-         uint16_t col = input[w];
-         uint16_t rg = (col << 1) & ((0x1f << 11) | (0x1f << 6));
-         uint16_t b = col & 0x1f;
-         uint16_t glow = (col >> 4) & (1 << 5);
-         output[w] = rg | b | glow;
-      }
+   for (w = 0; w < width; w++)
+   {
+      uint32_t col = input[w];
+      uint32_t r = (col >> 10) & 0x1f;
+      uint32_t g = (col >>  5) & 0x1f;
+      uint32_t b = (col >>  0) & 0x1f;
+      r = (r << 3) | (r >> 2);
+      g = (g << 3) | (g >> 2);
+      b = (b << 3) | (b >> 2);
+
+      output[w] = (0xffu << 24) | (r << 16) | (g << 8) | (b << 0);
    }
 }
-#else
-void conv_0rgb1555_rgb565(void *output_, const void *input_,
-      int width, int height,
-      int out_stride, int in_stride)
+
+static void conv_rgb565_argb8888_line_c(void *output_,
+      const void *input_, int width)
 {
-   int h, w;
+   int w;
    const uint16_t *input = (const uint16_t*)input_;
-   uint16_t *output = (uint16_t*)output_;
+   uint32_t *output      = (uint32_t*)output_;
 
-   for (h = 0; h < height;
-         h++, output += out_stride >> 1, input += in_stride >> 1)
+   for (w = 0; w < width; w++)
    {
-      for (w = 0; w < width; w++)
-      {
-         uint16_t col = input[w];
-         uint16_t rg = (col << 1) & ((0x1f << 11) | (0x1f << 6));
-         uint16_t b = col & 0x1f;
-         uint16_t glow = (col >> 4) & (1 << 5);
-         output[w] = rg | b | glow;
-      }
+      uint32_t col = input[w];
+      uint32_t r = (col >> 11) & 0x1f;
+      uint32_t g = (col >>  5) & 0x3f;
+      uint32_t b = (col >>  0) & 0x1f;
+      r = (r << 3) | (r >> 2);
+      g = (g << 2) | (g >> 4);
+      b = (b << 3) | (b >> 2);
+
+      output[w] = (0xffu << 24) | (r << 16) | (g << 8) | (b << 0);
    }
 }
-#endif
 
-#if defined(__SSE2__)
-void conv_0rgb1555_argb8888(void *output_, const void *input_,
-      int width, int height,
-      int out_stride, int in_stride)
+static void conv_rgba4444_argb8888_line_c(void *output_,
+      const void *input_, int width)
 {
-   int h, w;
+   int w;
    const uint16_t *input = (const uint16_t*)input_;
    uint32_t *output      = (uint32_t*)output_;
 
-   const __m128i pix_mask_r  = _mm_set1_epi16(0x1f << 10);
-   const __m128i pix_mask_gb = _mm_set1_epi16(0x1f <<  5);
-   const __m128i mul15_mid   = _mm_set1_epi16(0x4200);
-   const __m128i mul15_hi    = _mm_set1_epi16(0x0210);
-   const __m128i a           = _mm_set1_epi16(0x00ff);
+   for (w = 0; w < width; w++)
+   {
+      uint32_t col = input[w];
+      uint32_t r = (col >> 12) & 0xf;
+      uint32_t g = (col >>  8) & 0xf;
+      uint32_t b = (col >>  4) & 0xf;
+      uint32_t a = (col >>  0) & 0xf;
+      r = (r << 4) | r;
+      g = (g << 4) | g;
+      b = (b << 4) | b;
+      a = (a << 4) | a;
+
+      output[w] = (a << 24) | (r << 16) | (g << 8) | (b << 0);
+   }
+}
 
-   int max_width = width - 7;
+static void conv_bgr24_argb8888_line_c(void *output_,
+      const void *input_, int width)
+{
+   int w;
+   const uint8_t *inp = (const uint8_t*)input_;
+   uint32_t *output   = (uint32_t*)output_;
 
-   for (h = 0; h < height;
-         h++, output += out_stride >> 2, input += in_stride >> 1)
-   {
-      for (w = 0; w < max_width; w += 8)
-      {
-         const __m128i in = _mm_loadu_si128((const __m128i*)(input + w));
-         __m128i r = _mm_and_si128(in, pix_mask_r);
-         __m128i g = _mm_and_si128(in, pix_mask_gb);
-         __m128i b = _mm_and_si128(_mm_slli_epi16(in, 5), pix_mask_gb);
-
-         r = _mm_mulhi_epi16(r, mul15_hi);
-         g = _mm_mulhi_epi16(g, mul15_mid);
-         b = _mm_mulhi_epi16(b, mul15_mid);
-
-         __m128i res_lo_bg = _mm_unpacklo_epi8(b, g);
-         __m128i res_hi_bg = _mm_unpackhi_epi8(b, g);
-         __m128i res_lo_ra = _mm_unpacklo_epi8(r, a);
-         __m128i res_hi_ra = _mm_unpackhi_epi8(r, a);
-
-         __m128i res_lo = _mm_or_si128(res_lo_bg,
-               _mm_slli_si128(res_lo_ra, 2));
-         __m128i res_hi = _mm_or_si128(res_hi_bg,
-               _mm_slli_si128(res_hi_ra, 2));
-
-         _mm_storeu_si128((__m128i*)(output + w + 0), res_lo);
-         _mm_storeu_si128((__m128i*)(output + w + 4), res_hi);
-      }
-
-      for (; w < width; w++)
-      {
-         uint32_t col = input[w];
-         uint32_t r = (col >> 10) & 0x1f;
-         uint32_t g = (col >>  5) & 0x1f;
-         uint32_t b = (col >>  0) & 0x1f;
-         r = (r << 3) | (r >> 2);
-         g = (g << 3) | (g >> 2);
-         b = (b << 3) | (b >> 2);
-
-         output[w] = (0xff << 24) | (r << 16) | (g << 8) | (b << 0);
-      }
+   for (w = 0; w < width; w++)
+   {
+      uint32_t b = *inp++;
+      uint32_t g = *inp++;
+      uint32_t r = *inp++;
+      output[w] = (0xffu << 24) | (r << 16) | (g << 8) | (b << 0);
    }
 }
-#else
-void conv_0rgb1555_argb8888(void *output_, const void *input_,
-      int width, int height,
-      int out_stride, int in_stride)
+
+static void conv_argb8888_0rgb1555_line_c(void *output_,
+      const void *input_, int width)
 {
-   int h, w;
-   const uint16_t *input = (const uint16_t*)input_;
-   uint32_t *output      = (uint32_t*)output_;
+   int w;
+   const uint32_t *input = (const uint32_t*)input_;
+   uint16_t *output      = (uint16_t*)output_;
 
-   for (h = 0; h < height;
-         h++, output += out_stride >> 2, input += in_stride >> 1)
+   for (w = 0; w < width; w++)
    {
-      for (w = 0; w < width; w++)
-      {
-         uint32_t col = input[w];
-         uint32_t r = (col >> 10) & 0x1f;
-         uint32_t g = (col >>  5) & 0x1f;
-         uint32_t b = (col >>  0) & 0x1f;
-         r = (r << 3) | (r >> 2);
-         g = (g << 3) | (g >> 2);
-         b = (b << 3) | (b >> 2);
-
-         output[w] = (0xffu << 24) | (r << 16) | (g << 8) | (b << 0);
-      }
+      uint32_t col = input[w];
+      uint16_t r = (col >> 19) & 0x1f;
+      uint16_t g = (col >> 11) & 0x1f;
+      uint16_t b = (col >>  3) & 0x1f;
+      output[w] = (r << 10) | (g << 5) | (b << 0);
    }
 }
-#endif
 
-#if defined(__SSE2__)
-void conv_rgb565_argb8888(void *output_, const void *input_,
-      int width, int height,
-      int out_stride, int in_stride)
+static void conv_argb8888_rgb565_line_c(void *output_,
+      const void *input_, int width)
 {
-   int h, w;
-   const uint16_t *input = (const uint16_t*)input_;
-   uint32_t *output      = (uint32_t*)output_;
+   int w;
+   const uint32_t *input = (const uint32_t*)input_;
+   uint16_t *output      = (uint16_t*)output_;
 
-   const __m128i pix_mask_r = _mm_set1_epi16(0x1f << 10);
-   const __m128i pix_mask_g = _mm_set1_epi16(0x3f <<  5);
-   const __m128i pix_mask_b = _mm_set1_epi16(0x1f <<  5);
-   const __m128i mul16_r    = _mm_set1_epi16(0x0210);
-   const __m128i mul16_g    = _mm_set1_epi16(0x2080);
-   const __m128i mul16_b    = _mm_set1_epi16(0x4200);
-   const __m128i a          = _mm_set1_epi16(0x00ff);
+   for (w = 0; w < width; w++)
+   {
+      uint32_t col = input[w];
+      uint16_t r = (col >> 19) & 0x1f;
+      uint16_t g = (col >> 10) & 0x3f;
+      uint16_t b = (col >>  3) & 0x1f;
+      output[w] = (r << 11) | (g << 5) | (b << 0);
+   }
+}
 
-   int max_width = width - 7;
+static void conv_argb8888_bgr24_line_c(void *output_,
+      const void *input_, int width)
+{
+   int w;
+   const uint32_t *input = (const uint32_t*)input_;
+   uint8_t *out          = (uint8_t*)output_;
 
-   for (h = 0; h < height;
-         h++, output += out_stride >> 2, input += in_stride >> 1)
-   {
-      for (w = 0; w < max_width; w += 8)
-      {
-         const __m128i in = _mm_loadu_si128((const __m128i*)(input + w));
-         __m128i r = _mm_and_si128(_mm_srli_epi16(in, 1), pix_mask_r);
-         __m128i g = _mm_and_si128(in, pix_mask_g);
-         __m128i b = _mm_and_si128(_mm_slli_epi16(in, 5), pix_mask_b);
-
-         r = _mm_mulhi_epi16(r, mul16_r);
-         g = _mm_mulhi_epi16(g, mul16_g);
-         b = _mm_mulhi_epi16(b, mul16_b);
-
-         __m128i res_lo_bg = _mm_unpacklo_epi8(b, g);
-         __m128i res_hi_bg = _mm_unpackhi_epi8(b, g);
-         __m128i res_lo_ra = _mm_unpacklo_epi8(r, a);
-         __m128i res_hi_ra = _mm_unpackhi_epi8(r, a);
-
-         __m128i res_lo = _mm_or_si128(res_lo_bg,
-               _mm_slli_si128(res_lo_ra, 2));
-         __m128i res_hi = _mm_or_si128(res_hi_bg,
-               _mm_slli_si128(res_hi_ra, 2));
-
-         _mm_storeu_si128((__m128i*)(output + w + 0), res_lo);
-         _mm_storeu_si128((__m128i*)(output + w + 4), res_hi);
-      }
-
-      for (; w < width; w++)
-      {
-         uint32_t col = input[w];
-         uint32_t r = (col >> 11) & 0x1f;
-         uint32_t g = (col >>  5) & 0x3f;
-         uint32_t b = (col >>  0) & 0x1f;
-         r = (r << 3) | (r >> 2);
-         g = (g << 2) | (g >> 4);
-         b = (b << 3) | (b >> 2);
-
-         output[w] = (0xff << 24) | (r << 16) | (g << 8) | (b << 0);
-      }
+   for (w = 0; w < width; w++)
+   {
+      uint32_t col = input[w];
+      *out++ = (uint8_t)(col >>  0);
+      *out++ = (uint8_t)(col >>  8);
+      *out++ = (uint8_t)(col >> 16);
    }
 }
-#else
-void conv_rgb565_argb8888(void *output_, const void *input_,
-      int width, int height,
-      int out_stride, int in_stride)
+
+static void conv_argb8888_abgr8888_line_c(void *output_,
+      const void *input_, int width)
 {
-   int h, w;
-   const uint16_t *input = (const uint16_t*)input_;
+   int w;
+   const uint32_t *input = (const uint32_t*)input_;
    uint32_t *output      = (uint32_t*)output_;
 
-   for (h = 0; h < height;
-         h++, output += out_stride >> 2, input += in_stride >> 1)
+   for (w = 0; w < width; w++)
    {
-      for (w = 0; w < width; w++)
-      {
-         uint32_t col = input[w];
-         uint32_t r = (col >> 11) & 0x1f;
-         uint32_t g = (col >>  5) & 0x3f;
-         uint32_t b = (col >>  0) & 0x1f;
-         r = (r << 3) | (r >> 2);
-         g = (g << 2) | (g >> 4);
-         b = (b << 3) | (b >> 2);
+      uint32_t col = input[w];
+      output[w] = ((col << 16) & 0xff0000) | 
+         ((col >> 16) & 0xff) | (col & 0xff00ff00);
+   }
+}
+
+static void conv_0rgb1555_bgr24_line_c(void *output_,
+      const void *input_, int width)
+{
+   int w;
+   const uint16_t *input = (const uint16_t*)input_;
+   uint8_t *out          = (uint8_t*)output_;
 
-         output[w] = (0xffu << 24) | (r << 16) | (g << 8) | (b << 0);
-      }
+   for (w = 0; w < width; w++)
+   {
+      uint32_t col = input[w];
+      uint32_t b = (col >>  0) & 0x1f;
+      uint32_t g = (col >>  5) & 0x1f;
+      uint32_t r = (col >> 10) & 0x1f;
+      b = (b << 3) | (b >> 2);
+      g = (g << 3) | (g >> 2);
+      r = (r << 3) | (r >> 2);
+
+      *out++ = b;
+      *out++ = g;
+      *out++ = r;
    }
 }
-#endif
 
-void conv_rgba4444_argb8888(void *output_, const void *input_,
-      int width, int height,
-      int out_stride, int in_stride)
+static void conv_rgb565_bgr24_line_c(void *output_,
+      const void *input_, int width)
 {
-   int h, w;
+   int w;
    const uint16_t *input = (const uint16_t*)input_;
-   uint32_t *output      = (uint32_t*)output_;
+   uint8_t *out          = (uint8_t*)output_;
 
-   for (h = 0; h < height;
-         h++, output += out_stride >> 2, input += in_stride >> 1)
+   for (w = 0; w < width; w++)
+   {
+      uint32_t col = input[w];
+      uint32_t b = (col >>  0) & 0x1f;
+      uint32_t g = (col >>  5) & 0x3f;
+      uint32_t r = (col >> 11) & 0x1f;
+      b = (b << 3) | (b >> 2);
+      g = (g << 2) | (g >> 4);
+      r = (r << 3) | (r >> 2);
+
+      *out++ = b;
+      *out++ = g;
+      *out++ = r;
+   }
+}
+
+#define YUV_SHIFT 6
+#define YUV_OFFSET (1 << (YUV_SHIFT - 1))
+#define YUV_MAT_Y (1 << 6)
+#define YUV_MAT_U_G (-22)
+#define YUV_MAT_U_B (113)
+#define YUV_MAT_V_R (90)
+#define YUV_MAT_V_G (-46)
+
+static void conv_yuyv_argb8888_line_c(void *output_,
+      const void *input_, int width)
+{
+   int w;
+   const uint8_t *src = (const uint8_t*)input_;
+   uint32_t *dst      = (uint32_t*)output_;
+
+   for (w = 0; w < width; w += 2, src += 4, dst += 2)
    {
-      for (w = 0; w < width; w++)
-      {
-         uint32_t col = input[w];
-         uint32_t r = (col >> 12) & 0xf;
-         uint32_t g = (col >>  8) & 0xf;
-         uint32_t b = (col >>  4) & 0xf;
-         uint32_t a = (col >>  0) & 0xf;
-         r = (r << 4) | r;
-         g = (g << 4) | g;
-         b = (b << 4) | b;
-         a = (a << 4) | a;
+      int _y0 = src[0];
+      int  u = src[1] - 128;
+      int _y1 = src[2];
+      int  v = src[3] - 128;
+
+      uint8_t r0 = clamp_8bit((YUV_MAT_Y * _y0 +                   YUV_MAT_V_R * v + YUV_OFFSET) >> YUV_SHIFT);
+      uint8_t g0 = clamp_8bit((YUV_MAT_Y * _y0 + YUV_MAT_U_G * u + YUV_MAT_V_G * v + YUV_OFFSET) >> YUV_SHIFT);
+      uint8_t b0 = clamp_8bit((YUV_MAT_Y * _y0 + YUV_MAT_U_B * u                   + YUV_OFFSET) >> YUV_SHIFT);
 
-         output[w] = (a << 24) | (r << 16) | (g << 8) | (b << 0);
-      }
+      uint8_t r1 = clamp_8bit((YUV_MAT_Y * _y1 +                   YUV_MAT_V_R * v + YUV_OFFSET) >> YUV_SHIFT);
+      uint8_t g1 = clamp_8bit((YUV_MAT_Y * _y1 + YUV_MAT_U_G * u + YUV_MAT_V_G * v + YUV_OFFSET) >> YUV_SHIFT);
+      uint8_t b1 = clamp_8bit((YUV_MAT_Y * _y1 + YUV_MAT_U_B * u                   + YUV_OFFSET) >> YUV_SHIFT);
+
+      dst[0] = 0xff000000u | (r0 << 16) | (g0 << 8) | (b0 << 0);
+      dst[1] = 0xff000000u | (r1 << 16) | (g1 << 8) | (b1 << 0);
    }
 }
 
 #if defined(__SSE2__)
+/* Expands 8 0RGB1555 pixels into two vectors of 4 ARGB8888 pixels. */
+static INLINE void conv_expand_0rgb1555_sse2(__m128i in,
+      __m128i *res_lo, __m128i *res_hi)
+{
+   const __m128i pix_mask_r  = _mm_set1_epi16(0x1f << 10);
+   const __m128i pix_mask_gb = _mm_set1_epi16(0x1f <<  5);
+   const __m128i mul15_mid   = _mm_set1_epi16(0x4200);
+   const __m128i mul15_hi    = _mm_set1_epi16(0x0210);
+   const __m128i a           = _mm_set1_epi16(0x00ff);
+
+   __m128i r = _mm_and_si128(in, pix_mask_r);
+   __m128i g = _mm_and_si128(in, pix_mask_gb);
+   __m128i b = _mm_and_si128(_mm_slli_epi16(in, 5), pix_mask_gb);
+
+   r = _mm_mulhi_epi16(r, mul15_hi);
+   g = _mm_mulhi_epi16(g, mul15_mid);
+   b = _mm_mulhi_epi16(b, mul15_mid);
+
+   *res_lo = _mm_or_si128(_mm_unpacklo_epi8(b, g),
+         _mm_slli_si128(_mm_unpacklo_epi8(r, a), 2));
+   *res_hi = _mm_or_si128(_mm_unpackhi_epi8(b, g),
+         _mm_slli_si128(_mm_unpackhi_epi8(r, a), 2));
+}
+
+/* Expands 8 RGB565 pixels into two vectors of 4 ARGB8888 pixels. */
+static INLINE void conv_expand_rgb565_sse2(__m128i in,
+      __m128i *res_lo, __m128i *res_hi)
+{
+   const __m128i pix_mask_r = _mm_set1_epi16(0x1f << 10);
+   const __m128i pix_mask_g = _mm_set1_epi16(0x3f <<  5);
+   const __m128i pix_mask_b = _mm_set1_epi16(0x1f <<  5);
+   const __m128i mul16_r    = _mm_set1_epi16(0x0210);
+   const __m128i mul16_g    = _mm_set1_epi16(0x2080);
+   const __m128i mul16_b    = _mm_set1_epi16(0x4200);
+   const __m128i a          = _mm_set1_epi16(0x00ff);
+
+   __m128i r = _mm_and_si128(_mm_srli_epi16(in, 1), pix_mask_r);
+   __m128i g = _mm_and_si128(in, pix_mask_g);
+   __m128i b = _mm_and_si128(_mm_slli_epi16(in, 5), pix_mask_b);
+
+   r = _mm_mulhi_epi16(r, mul16_r);
+   g = _mm_mulhi_epi16(g, mul16_g);
+   b = _mm_mulhi_epi16(b, mul16_b);
+
+   *res_lo = _mm_or_si128(_mm_unpacklo_epi8(b, g),
+         _mm_slli_si128(_mm_unpacklo_epi8(r, a), 2));
+   *res_hi = _mm_or_si128(_mm_unpackhi_epi8(b, g),
+         _mm_slli_si128(_mm_unpackhi_epi8(r, a), 2));
+}
+
 /* :( TODO: Make this saner. */
-static inline void store_bgr24_sse2(void *output, __m128i a,
+static INLINE void store_bgr24_sse2(void *output, __m128i a,
       __m128i b, __m128i c, __m128i d)
 {
    const __m128i mask_0 = _mm_set_epi32(0, 0, 0, 0x00ffffff);
@@ -405,364 +422,316 @@ static inline void store_bgr24_sse2(void *output, __m128i a,
                   _mm_or_si128(c3, _mm_or_si128(c4, c5))))));
 }
 
-void conv_0rgb1555_bgr24(void *output_, const void *input_,
-      int width, int height,
-      int out_stride, int in_stride)
+static void conv_rgb565_0rgb1555_line_sse2(void *output_,
+      const void *input_, int width)
 {
-   int h, w;
+   int w;
    const uint16_t *input = (const uint16_t*)input_;
-   uint8_t *output       = (uint8_t*)output_;
+   uint16_t *output      = (uint16_t*)output_;
 
-   const __m128i pix_mask_r  = _mm_set1_epi16(0x1f << 10);
-   const __m128i pix_mask_gb = _mm_set1_epi16(0x1f <<  5);
-   const __m128i mul15_mid   = _mm_set1_epi16(0x4200);
-   const __m128i mul15_hi    = _mm_set1_epi16(0x0210);
-   const __m128i a           = _mm_set1_epi16(0x00ff);
+   const __m128i hi_mask = _mm_set1_epi16(0x7fe0);
+   const __m128i lo_mask = _mm_set1_epi16(0x1f);
 
-   int max_width = width - 15;
+   for (w = 0; w + 8 <= width; w += 8)
+   {
+      const __m128i in = _mm_loadu_si128((const __m128i*)(input + w));
+      __m128i hi = _mm_and_si128(_mm_srli_epi16(in, 1), hi_mask);
+      __m128i lo = _mm_and_si128(in, lo_mask);
+      _mm_storeu_si128((__m128i*)(output + w), _mm_or_si128(hi, lo));
+   }
 
-   for (h = 0; h < height;
-         h++, output += out_stride, input += in_stride >> 1)
-   {
-      uint8_t *out = output;
-
-      for (w = 0; w < max_width; w += 16, out += 48)
-      {
-         const __m128i in0 = _mm_loadu_si128((const __m128i*)(input + w + 0));
-         const __m128i in1 = _mm_loadu_si128((const __m128i*)(input + w + 8));
-         __m128i r0 = _mm_and_si128(in0, pix_mask_r);
-         __m128i r1 = _mm_and_si128(in1, pix_mask_r);
-         __m128i g0 = _mm_and_si128(in0, pix_mask_gb);
-         __m128i g1 = _mm_and_si128(in1, pix_mask_gb);
-         __m128i b0 = _mm_and_si128(_mm_slli_epi16(in0, 5), pix_mask_gb);
-         __m128i b1 = _mm_and_si128(_mm_slli_epi16(in1, 5), pix_mask_gb);
-
-         r0 = _mm_mulhi_epi16(r0, mul15_hi);
-         r1 = _mm_mulhi_epi16(r1, mul15_hi);
-         g0 = _mm_mulhi_epi16(g0, mul15_mid);
-         g1 = _mm_mulhi_epi16(g1, mul15_mid);
-         b0 = _mm_mulhi_epi16(b0, mul15_mid);
-         b1 = _mm_mulhi_epi16(b1, mul15_mid);
-
-         __m128i res_lo_bg0 = _mm_unpacklo_epi8(b0, g0);
-         __m128i res_lo_bg1 = _mm_unpacklo_epi8(b1, g1);
-         __m128i res_hi_bg0 = _mm_unpackhi_epi8(b0, g0);
-         __m128i res_hi_bg1 = _mm_unpackhi_epi8(b1, g1);
-         __m128i res_lo_ra0 = _mm_unpacklo_epi8(r0, a);
-         __m128i res_lo_ra1 = _mm_unpacklo_epi8(r1, a);
-         __m128i res_hi_ra0 = _mm_unpackhi_epi8(r0, a);
-         __m128i res_hi_ra1 = _mm_unpackhi_epi8(r1, a);
-
-         __m128i res_lo0 = _mm_or_si128(res_lo_bg0,
-               _mm_slli_si128(res_lo_ra0, 2));
-         __m128i res_lo1 = _mm_or_si128(res_lo_bg1,
-               _mm_slli_si128(res_lo_ra1, 2));
-         __m128i res_hi0 = _mm_or_si128(res_hi_bg0,
-               _mm_slli_si128(res_hi_ra0, 2));
-         __m128i res_hi1 = _mm_or_si128(res_hi_bg1,
-               _mm_slli_si128(res_hi_ra1, 2));
-
-         /* Non-POT pixel sizes ftl :( */
-         store_bgr24_sse2(out, res_lo0, res_hi0, res_lo1, res_hi1);
-      }
-
-      for (; w < width; w++)
-      {
-         uint32_t col = input[w];
-         uint32_t b = (col >>  0) & 0x1f;
-         uint32_t g = (col >>  5) & 0x1f;
-         uint32_t r = (col >> 10) & 0x1f;
-         b = (b << 3) | (b >> 2);
-         g = (g << 3) | (g >> 2);
-         r = (r << 3) | (r >> 2);
-
-         *out++ = b;
-         *out++ = g;
-         *out++ = r;
-      }
-   }
-}
-
-void conv_rgb565_bgr24(void *output_, const void *input_,
-      int width, int height,
-      int out_stride, int in_stride)
+   conv_rgb565_0rgb1555_line_c(output + w, input + w, width - w);
+}
+
+static void conv_0rgb1555_rgb565_line_sse2(void *output_,
+      const void *input_, int width)
 {
-   int h, w;
+   int w;
    const uint16_t *input = (const uint16_t*)input_;
-   uint8_t *output      = (uint8_t*)output_;
+   uint16_t *output      = (uint16_t*)output_;
 
-   const __m128i pix_mask_r = _mm_set1_epi16(0x1f << 10);
-   const __m128i pix_mask_g = _mm_set1_epi16(0x3f <<  5);
-   const __m128i pix_mask_b = _mm_set1_epi16(0x1f <<  5);
-   const __m128i mul16_r    = _mm_set1_epi16(0x0210);
-   const __m128i mul16_g    = _mm_set1_epi16(0x2080);
-   const __m128i mul16_b    = _mm_set1_epi16(0x4200);
-   const __m128i a          = _mm_set1_epi16(0x00ff);
+   const __m128i hi_mask   = _mm_set1_epi16(
+         (int16_t)((0x1f << 11) | (0x1f << 6)));
+   const __m128i lo_mask   = _mm_set1_epi16(0x1f);
+   const __m128i glow_mask = _mm_set1_epi16(1 << 5);
 
-   int max_width = width - 15;
-
-   for (h = 0; h < height; h++, output += out_stride, input += in_stride >> 1)
-   {
-      uint8_t *out = output;
-
-      for (w = 0; w < max_width; w += 16, out += 48)
-      {
-         const __m128i in0 = _mm_loadu_si128((const __m128i*)(input + w));
-         const __m128i in1 = _mm_loadu_si128((const __m128i*)(input + w + 8));
-         __m128i r0 = _mm_and_si128(_mm_srli_epi16(in0, 1), pix_mask_r);
-         __m128i g0 = _mm_and_si128(in0, pix_mask_g);
-         __m128i b0 = _mm_and_si128(_mm_slli_epi16(in0, 5), pix_mask_b);
-         __m128i r1 = _mm_and_si128(_mm_srli_epi16(in1, 1), pix_mask_r);
-         __m128i g1 = _mm_and_si128(in1, pix_mask_g);
-         __m128i b1 = _mm_and_si128(_mm_slli_epi16(in1, 5), pix_mask_b);
-
-         r0 = _mm_mulhi_epi16(r0, mul16_r);
-         g0 = _mm_mulhi_epi16(g0, mul16_g);
-         b0 = _mm_mulhi_epi16(b0, mul16_b);
-         r1 = _mm_mulhi_epi16(r1, mul16_r);
-         g1 = _mm_mulhi_epi16(g1, mul16_g);
-         b1 = _mm_mulhi_epi16(b1, mul16_b);
-
-         __m128i res_lo_bg0 = _mm_unpacklo_epi8(b0, g0);
-         __m128i res_hi_bg0 = _mm_unpackhi_epi8(b0, g0);
-         __m128i res_lo_ra0 = _mm_unpacklo_epi8(r0, a);
-         __m128i res_hi_ra0 = _mm_unpackhi_epi8(r0, a);
-         __m128i res_lo_bg1 = _mm_unpacklo_epi8(b1, g1);
-         __m128i res_hi_bg1 = _mm_unpackhi_epi8(b1, g1);
-         __m128i res_lo_ra1 = _mm_unpacklo_epi8(r1, a);
-         __m128i res_hi_ra1 = _mm_unpackhi_epi8(r1, a);
-
-         __m128i res_lo0 = _mm_or_si128(res_lo_bg0,
-               _mm_slli_si128(res_lo_ra0, 2));
-         __m128i res_hi0 = _mm_or_si128(res_hi_bg0,
-               _mm_slli_si128(res_hi_ra0, 2));
-         __m128i res_lo1 = _mm_or_si128(res_lo_bg1,
-               _mm_slli_si128(res_lo_ra1, 2));
-         __m128i res_hi1 = _mm_or_si128(res_hi_bg1,
-               _mm_slli_si128(res_hi_ra1, 2));
-
-         store_bgr24_sse2(out, res_lo0, res_hi0, res_lo1, res_hi1);
-      }
-
-      for (; w < width; w++)
-      {
-         uint32_t col = input[w];
-         uint32_t r = (col >> 11) & 0x1f;
-         uint32_t g = (col >>  5) & 0x3f;
-         uint32_t b = (col >>  0) & 0x1f;
-         r = (r << 3) | (r >> 2);
-         g = (g << 2) | (g >> 4);
-         b = (b << 3) | (b >> 2);
-
-         *out++ = b;
-         *out++ = g;
-         *out++ = r;
-      }
+   for (w = 0; w + 8 <= width; w += 8)
+   {
+      const __m128i in = _mm_loadu_si128((const __m128i*)(input + w));
+      __m128i rg   = _mm_and_si128(_mm_slli_epi16(in, 1), hi_mask);
+      __m128i b    = _mm_and_si128(in, lo_mask);
+      __m128i glow = _mm_and_si128(_mm_srli_epi16(in, 4), glow_mask);
+      _mm_storeu_si128((__m128i*)(output + w),
+            _mm_or_si128(rg, _mm_or_si128(b, glow)));
    }
+
+   conv_0rgb1555_rgb565_line_c(output + w, input + w, width - w);
 }
-#else
-void conv_0rgb1555_bgr24(void *output_, const void *input_,
-      int width, int height,
-      int out_stride, int in_stride)
+
+static void conv_0rgb1555_argb8888_line_sse2(void *output_,
+      const void *input_, int width)
 {
-   int h, w;
+   int w;
    const uint16_t *input = (const uint16_t*)input_;
-   uint8_t *output       = (uint8_t*)output_;
+   uint32_t *output      = (uint32_t*)output_;
 
-   for (h = 0; h < height;
-         h++, output += out_stride, input += in_stride >> 1)
+   for (w = 0; w + 8 <= width; w += 8)
    {
-      uint8_t *out = output;
-      for (w = 0; w < width; w++)
-      {
-         uint32_t col = input[w];
-         uint32_t b = (col >>  0) & 0x1f;
-         uint32_t g = (col >>  5) & 0x1f;
-         uint32_t r = (col >> 10) & 0x1f;
-         b = (b << 3) | (b >> 2);
-         g = (g << 3) | (g >> 2);
-         r = (r << 3) | (r >> 2);
+      __m128i res_lo, res_hi;
+      conv_expand_0rgb1555_sse2(
+            _mm_loadu_si128((const __m128i*)(input + w)), &res_lo, &res_hi);
 
-         *out++ = b;
-         *out++ = g;
-         *out++ = r;
-      }
+      _mm_storeu_si128((__m128i*)(output + w + 0), res_lo);
+      _mm_storeu_si128((__m128i*)(output + w + 4), res_hi);
    }
+
+   conv_0rgb1555_argb8888_line_c(output + w, input + w, width - w);
 }
 
-void conv_rgb565_bgr24(void *output_, const void *input_,
-      int width, int height,
-      int out_stride, int in_stride)
+static void conv_rgb565_argb8888_line_sse2(void *output_,
+      const void *input_, int width)
 {
-   int h, w;
+   int w;
    const uint16_t *input = (const uint16_t*)input_;
-   uint8_t *output       = (uint8_t*)output_;
+   uint32_t *output      = (uint32_t*)output_;
 
-   for (h = 0; h < height;
-         h++, output += out_stride, input += in_stride >> 1)
+   for (w = 0; w + 8 <= width; w += 8)
    {
-      uint8_t *out = output;
-      for (w = 0; w < width; w++)
-      {
-         uint32_t col = input[w];
-         uint32_t b = (col >>  0) & 0x1f;
-         uint32_t g = (col >>  5) & 0x3f;
-         uint32_t r = (col >> 11) & 0x1f;
-         b = (b << 3) | (b >> 2);
-         g = (g << 2) | (g >> 4);
-         r = (r << 3) | (r >> 2);
+      __m128i res_lo, res_hi;
+      conv_expand_rgb565_sse2(
+            _mm_loadu_si128((const __m128i*)(input + w)), &res_lo, &res_hi);
+
+      _mm_storeu_si128((__m128i*)(output + w + 0), res_lo);
+      _mm_storeu_si128((__m128i*)(output + w + 4), res_hi);
+   }
+
+   conv_rgb565_argb8888_line_c(output + w, input + w, width - w);
+}
+
+static void conv_rgba4444_argb8888_line_sse2(void *output_,
+      const void *input_, int width)
+{
+   int w;
+   const uint16_t *input = (const uint16_t*)input_;
+   uint32_t *output      = (uint32_t*)output_;
+
+   const __m128i mask  = _mm_set1_epi16(0xf);
+   const __m128i mul17 = _mm_set1_epi16(0x11);
 
-         *out++ = b;
-         *out++ = g;
-         *out++ = r;
-      }
+   for (w = 0; w + 8 <= width; w += 8)
+   {
+      const __m128i in = _mm_loadu_si128((const __m128i*)(input + w));
+      __m128i r  = _mm_and_si128(_mm_srli_epi16(in, 12), mask);
+      __m128i g  = _mm_and_si128(_mm_srli_epi16(in,  8), mask);
+      __m128i b  = _mm_and_si128(_mm_srli_epi16(in,  4), mask);
+      __m128i a  = _mm_and_si128(in, mask);
+      __m128i bg, ra;
+
+      /* x * 0x11 == (x << 4) | x for 4-bit x. */
+      r  = _mm_mullo_epi16(r, mul17);
+      g  = _mm_mullo_epi16(g, mul17);
+      b  = _mm_mullo_epi16(b, mul17);
+      a  = _mm_mullo_epi16(a, mul17);
+
+      bg = _mm_or_si128(b, _mm_slli_epi16(g, 8));
+      ra = _mm_or_si128(r, _mm_slli_epi16(a, 8));
+
+      _mm_storeu_si128((__m128i*)(output + w + 0), _mm_unpacklo_epi16(bg, ra));
+      _mm_storeu_si128((__m128i*)(output + w + 4), _mm_unpackhi_epi16(bg, ra));
    }
+
+   conv_rgba4444_argb8888_line_c(output + w, input + w, width - w);
 }
-#endif
 
-void conv_bgr24_argb8888(void *output_, const void *input_,
-      int width, int height,
-      int out_stride, int in_stride)
+static void conv_bgr24_argb8888_line_sse2(void *output_,
+      const void *input_, int width)
 {
-   int h, w;
+   int w;
    const uint8_t *input = (const uint8_t*)input_;
    uint32_t *output     = (uint32_t*)output_;
 
-   for (h = 0; h < height;
-         h++, output += out_stride >> 2, input += in_stride)
+   const __m128i mask_0 = _mm_set_epi32(0, 0, 0, 0x00ffffff);
+   const __m128i mask_1 = _mm_set_epi32(0, 0, 0x00ffffff, 0);
+   const __m128i mask_2 = _mm_set_epi32(0, 0x00ffffff, 0, 0);
+   const __m128i mask_3 = _mm_set_epi32(0x00ffffff, 0, 0, 0);
+   const __m128i a      = _mm_set1_epi32(0xff000000);
+
+   /* Loads 16 bytes for 12 bytes worth of pixels,
+    * stay clear of the end of the line. */
+   for (w = 0; w + 6 <= width; w += 4)
    {
-      const uint8_t *inp = input;
-      for (w = 0; w < width; w++)
-      {
-         uint32_t b = *inp++;
-         uint32_t g = *inp++;
-         uint32_t r = *inp++;
-         output[w] = (0xffu << 24) | (r << 16) | (g << 8) | (b << 0);
-      }
+      const __m128i in = _mm_loadu_si128((const __m128i*)(input + w * 3));
+      __m128i res = _mm_or_si128(
+            _mm_or_si128(_mm_and_si128(in, mask_0),
+               _mm_and_si128(_mm_slli_si128(in, 1), mask_1)),
+            _mm_or_si128(_mm_and_si128(_mm_slli_si128(in, 2), mask_2),
+               _mm_and_si128(_mm_slli_si128(in, 3), mask_3)));
+
+      _mm_storeu_si128((__m128i*)(output + w), _mm_or_si128(res, a));
    }
+
+   conv_bgr24_argb8888_line_c(output + w, input + w * 3, width - w);
 }
 
-void conv_argb8888_0rgb1555(void *output_, const void *input_,
-      int width, int height,
-      int out_stride, int in_stride)
+static void conv_argb8888_0rgb1555_line_sse2(void *output_,
+      const void *input_, int width)
 {
-   int h, w;
+   int w;
    const uint32_t *input = (const uint32_t*)input_;
    uint16_t *output      = (uint16_t*)output_;
 
-   for (h = 0; h < height;
-         h++, output += out_stride >> 1, input += in_stride >> 2)
+   const __m128i mask_r = _mm_set1_epi32(0x1f << 10);
+   const __m128i mask_g = _mm_set1_epi32(0x1f <<  5);
+   const __m128i mask_b = _mm_set1_epi32(0x1f <<  0);
+
+   for (w = 0; w + 8 <= width; w += 8)
    {
-      for (w = 0; w < width; w++)
-      {
-         uint32_t col = input[w];
-         uint16_t r = (col >> 19) & 0x1f;
-         uint16_t g = (col >> 11) & 0x1f;
-         uint16_t b = (col >>  3) & 0x1f;
-         output[w] = (r << 10) | (g << 5) | (b << 0);
-      }
+      const __m128i in0 = _mm_loadu_si128((const __m128i*)(input + w + 0));
+      const __m128i in1 = _mm_loadu_si128((const __m128i*)(input + w + 4));
+
+      __m128i res0 = _mm_or_si128(_mm_and_si128(_mm_srli_epi32(in0, 9), mask_r),
+            _mm_or_si128(_mm_and_si128(_mm_srli_epi32(in0, 6), mask_g),
+               _mm_and_si128(_mm_srli_epi32(in0, 3), mask_b)));
+      __m128i res1 = _mm_or_si128(_mm_and_si128(_mm_srli_epi32(in1, 9), mask_r),
+            _mm_or_si128(_mm_and_si128(_mm_srli_epi32(in1, 6), mask_g),
+               _mm_and_si128(_mm_srli_epi32(in1, 3), mask_b)));
+
+      /* 15-bit values, signed saturation never kicks in. */
+      _mm_storeu_si128((__m128i*)(output + w), _mm_packs_epi32(res0, res1));
    }
+
+   conv_argb8888_0rgb1555_line_c(output + w, input + w, width - w);
 }
 
-#if defined(__SSE2__)
-void conv_argb8888_bgr24(void *output_, const void *input_,
-      int width, int height,
-      int out_stride, int in_stride)
+static void conv_argb8888_rgb565_line_sse2(void *output_,
+      const void *input_, int width)
 {
-   int h, w;
+   int w;
    const uint32_t *input = (const uint32_t*)input_;
-   uint8_t *output       = (uint8_t*)output_;
+   uint16_t *output      = (uint16_t*)output_;
 
-   int max_width = width - 15;
+   const __m128i mask_r = _mm_set1_epi32(0x1f << 11);
+   const __m128i mask_g = _mm_set1_epi32(0x3f <<  5);
+   const __m128i mask_b = _mm_set1_epi32(0x1f <<  0);
 
-   for (h = 0; h < height;
-         h++, output += out_stride, input += in_stride >> 2)
+   for (w = 0; w + 8 <= width; w += 8)
    {
-      uint8_t *out = output;
+      const __m128i in0 = _mm_loadu_si128((const __m128i*)(input + w + 0));
+      const __m128i in1 = _mm_loadu_si128((const __m128i*)(input + w + 4));
+
+      __m128i res0 = _mm_or_si128(_mm_and_si128(_mm_srli_epi32(in0, 8), mask_r),
+            _mm_or_si128(_mm_and_si128(_mm_srli_epi32(in0, 5), mask_g),
+               _mm_and_si128(_mm_srli_epi32(in0, 3), mask_b)));
+      __m128i res1 = _mm_or_si128(_mm_and_si128(_mm_srli_epi32(in1, 8), mask_r),
+            _mm_or_si128(_mm_and_si128(_mm_srli_epi32(in1, 5), mask_g),
+               _mm_and_si128(_mm_srli_epi32(in1, 3), mask_b)));
 
-      for (w = 0; w < max_width; w += 16, out += 48)
-      {
-         store_bgr24_sse2(out,
-               _mm_loadu_si128((const __m128i*)(input + w +  0)),
-               _mm_loadu_si128((const __m128i*)(input + w +  4)),
-               _mm_loadu_si128((const __m128i*)(input + w +  8)),
-               _mm_loadu_si128((const __m128i*)(input + w + 12)));
-      }
+      /* Sign extend so packs passes all 16 bits through. */
+      res0 = _mm_srai_epi32(_mm_slli_epi32(res0, 16), 16);
+      res1 = _mm_srai_epi32(_mm_slli_epi32(res1, 16), 16);
 
-      for (; w < width; w++)
-      {
-         uint32_t col = input[w];
-         *out++ = (uint8_t)(col >>  0);
-         *out++ = (uint8_t)(col >>  8);
-         *out++ = (uint8_t)(col >> 16);
-      }
+      _mm_storeu_si128((__m128i*)(output + w), _mm_packs_epi32(res0, res1));
    }
+
+   conv_argb8888_rgb565_line_c(output + w, input + w, width - w);
 }
-#else
-void conv_argb8888_bgr24(void *output_, const void *input_,
-      int width, int height,
-      int out_stride, int in_stride)
+
+static void conv_argb8888_bgr24_line_sse2(void *output_,
+      const void *input_, int width)
 {
-   int h, w;
+   int w;
    const uint32_t *input = (const uint32_t*)input_;
    uint8_t *output       = (uint8_t*)output_;
 
-   for (h = 0; h < height;
-         h++, output += out_stride, input += in_stride >> 2)
+   for (w = 0; w + 16 <= width; w += 16)
    {
-      uint8_t *out = output;
-      for (w = 0; w < width; w++)
-      {
-         uint32_t col = input[w];
-         *out++ = (uint8_t)(col >>  0);
-         *out++ = (uint8_t)(col >>  8);
-         *out++ = (uint8_t)(col >> 16);
-      }
+      store_bgr24_sse2(output + w * 3,
+            _mm_loadu_si128((const __m128i*)(input + w +  0)),
+            _mm_loadu_si128((const __m128i*)(input + w +  4)),
+            _mm_loadu_si128((const __m128i*)(input + w +  8)),
+            _mm_loadu_si128((const __m128i*)(input + w + 12)));
    }
+
+   conv_argb8888_bgr24_line_c(output + w * 3, input + w, width - w);
 }
-#endif
 
-void conv_argb8888_abgr8888(void *output_, const void *input_,
-      int width, int height,
-      int out_stride, int in_stride)
+static void conv_argb8888_abgr8888_line_sse2(void *output_,
+      const void *input_, int width)
 {
-   int h, w;
+   int w;
    const uint32_t *input = (const uint32_t*)input_;
    uint32_t *output      = (uint32_t*)output_;
 
-   for (h = 0; h < height;
-         h++, output += out_stride >> 2, input += in_stride >> 2)
+   const __m128i mask_ag = _mm_set1_epi32(0xff00ff00);
+   const __m128i mask_lo = _mm_set1_epi32(0x000000ff);
+   const __m128i mask_hi = _mm_set1_epi32(0x00ff0000);
+
+   for (w = 0; w + 4 <= width; w += 4)
    {
-      for (w = 0; w < width; w++)
-      {
-         uint32_t col = input[w];
-         output[w] = ((col << 16) & 0xff0000) | 
-            ((col >> 16) & 0xff) | (col & 0xff00ff00);
-      }
+      const __m128i in = _mm_loadu_si128((const __m128i*)(input + w));
+      __m128i res = _mm_or_si128(_mm_and_si128(in, mask_ag),
+            _mm_or_si128(_mm_and_si128(_mm_srli_epi32(in, 16), mask_lo),
+               _mm_and_si128(_mm_slli_epi32(in, 16), mask_hi)));
+      _mm_storeu_si128((__m128i*)(output + w), res);
    }
-}
 
-#define YUV_SHIFT 6
-#define YUV_OFFSET (1 << (YUV_SHIFT - 1))
-#define YUV_MAT_Y (1 << 6)
-#define YUV_MAT_U_G (-22)
-#define YUV_MAT_U_B (113)
-#define YUV_MAT_V_R (90)
-#define YUV_MAT_V_G (-46)
+   conv_argb8888_abgr8888_line_c(output + w, input + w, width - w);
+}
 
-#if defined(__SSE2__)
-void conv_yuyv_argb8888(void *output_, const void *input_,
-      int width, int height,
-      int out_stride, int in_stride)
+static void conv_0rgb1555_bgr24_line_sse2(void *output_,
+      const void *input_, int width)
 {
-   int h, w;
-   const uint8_t *input = (const uint8_t*)input_;
-   uint32_t *output     = (uint32_t*)output_;
+   int w;
+   const uint16_t *input = (const uint16_t*)input_;
+   uint8_t *output       = (uint8_t*)output_;
 
-   const __m128i mask_y = _mm_set1_epi16(0xffu);
-   const __m128i mask_u = _mm_set1_epi32(0xffu << 8);
-   const __m128i mask_v = _mm_set1_epi32(0xffu << 24);
-   const __m128i chroma_offset = _mm_set1_epi16(128);
+   for (w = 0; w + 16 <= width; w += 16)
+   {
+      __m128i res_lo0, res_hi0, res_lo1, res_hi1;
+      conv_expand_0rgb1555_sse2(_mm_loadu_si128((const __m128i*)(input + w + 0)),
+            &res_lo0, &res_hi0);
+      conv_expand_0rgb1555_sse2(_mm_loadu_si128((const __m128i*)(input + w + 8)),
+            &res_lo1, &res_hi1);
+
+      /* Non-POT pixel sizes ftl :( */
+      store_bgr24_sse2(output + w * 3, res_lo0, res_hi0, res_lo1, res_hi1);
+   }
+
+   conv_0rgb1555_bgr24_line_c(output + w * 3, input + w, width - w);
+}
+
+static void conv_rgb565_bgr24_line_sse2(void *output_,
+      const void *input_, int width)
+{
+   int w;
+   const uint16_t *input = (const uint16_t*)input_;
+   uint8_t *output       = (uint8_t*)output_;
+
+   for (w = 0; w + 16 <= width; w += 16)
+   {
+      __m128i res_lo0, res_hi0, res_lo1, res_hi1;
+      conv_expand_rgb565_sse2(_mm_loadu_si128((const __m128i*)(input + w + 0)),
+            &res_lo0, &res_hi0);
+      conv_expand_rgb565_sse2(_mm_loadu_si128((const __m128i*)(input + w + 8)),
+            &res_lo1, &res_hi1);
+
+      store_bgr24_sse2(output + w * 3, res_lo0, res_hi0, res_lo1, res_hi1);
+   }
+
+   conv_rgb565_bgr24_line_c(output + w * 3, input + w, width - w);
+}
+
+static void conv_yuyv_argb8888_line_sse2(void *output_,
+      const void *input_, int width)
+{
+   int w;
+   const uint8_t *src = (const uint8_t*)input_;
+   uint32_t *dst      = (uint32_t*)output_;
+
+   const __m128i mask_y = _mm_set1_epi16(0xffu);
+   const __m128i mask_u = _mm_set1_epi32(0xffu << 8);
+   const __m128i mask_v = _mm_set1_epi32(0xffu << 24);
+   const __m128i chroma_offset = _mm_set1_epi16(128);
    const __m128i round_offset = _mm_set1_epi16(YUV_OFFSET);
 
    const __m128i yuv_mul = _mm_set1_epi16(YUV_MAT_Y);
@@ -773,148 +742,978 @@ void conv_yuyv_argb8888(void *output_, const void *input_,
    const __m128i a       = _mm_cmpeq_epi16(_mm_setzero_si128(),
          _mm_setzero_si128());
 
-   for (h = 0; h < height; h++, output += out_stride >> 2, input += in_stride)
-   {
-      const uint8_t *src = input;
-      uint32_t *dst = output;
-
-      /* Each loop processes 16 pixels. */
-      for (w = 0; w + 16 <= width; w += 16, src += 32, dst += 16)
-      {
-         __m128i yuv0 = _mm_loadu_si128((const __m128i*)(src +  0)); /* [Y0, U0, Y1, V0, Y2, U1, Y3, V1, ...] */
-         __m128i yuv1 = _mm_loadu_si128((const __m128i*)(src + 16)); /* [Y0, U0, Y1, V0, Y2, U1, Y3, V1, ...] */
-
-         __m128i _y0 = _mm_and_si128(yuv0, mask_y); /* [Y0, Y1, Y2, ...] (16-bit) */
-         __m128i u0 = _mm_and_si128(yuv0, mask_u); /* [0, U0, 0, 0, 0, U1, 0, 0, ...] */
-         __m128i v0 = _mm_and_si128(yuv0, mask_v); /* [0, 0, 0, V1, 0, , 0, V1, ...] */
-         __m128i _y1 = _mm_and_si128(yuv1, mask_y); /* [Y0, Y1, Y2, ...] (16-bit) */
-         __m128i u1 = _mm_and_si128(yuv1, mask_u); /* [0, U0, 0, 0, 0, U1, 0, 0, ...] */
-         __m128i v1 = _mm_and_si128(yuv1, mask_v); /* [0, 0, 0, V1, 0, , 0, V1, ...] */
-
-         /* Juggle around to get U and V in the same 16-bit format as Y. */
-         u0 = _mm_srli_si128(u0, 1);
-         v0 = _mm_srli_si128(v0, 3);
-         u1 = _mm_srli_si128(u1, 1);
-         v1 = _mm_srli_si128(v1, 3);
-         __m128i u = _mm_packs_epi32(u0, u1);
-         __m128i v = _mm_packs_epi32(v0, v1);
-
-         /* Apply YUV offsets (U, V) -= (-128, -128). */
-         u = _mm_sub_epi16(u, chroma_offset);
-         v = _mm_sub_epi16(v, chroma_offset);
-
-         /* Upscale chroma horizontally (nearest). */
-         u0 = _mm_unpacklo_epi16(u, u);
-         u1 = _mm_unpackhi_epi16(u, u);
-         v0 = _mm_unpacklo_epi16(v, v);
-         v1 = _mm_unpackhi_epi16(v, v);
-
-         /* Apply transformations. */
-         _y0 = _mm_mullo_epi16(_y0, yuv_mul);
-         _y1 = _mm_mullo_epi16(_y1, yuv_mul);
-         __m128i u0_g   = _mm_mullo_epi16(u0, u_g_mul);
-         __m128i u1_g   = _mm_mullo_epi16(u1, u_g_mul);
-         __m128i u0_b   = _mm_mullo_epi16(u0, u_b_mul);
-         __m128i u1_b   = _mm_mullo_epi16(u1, u_b_mul);
-         __m128i v0_r   = _mm_mullo_epi16(v0, v_r_mul);
-         __m128i v1_r   = _mm_mullo_epi16(v1, v_r_mul);
-         __m128i v0_g   = _mm_mullo_epi16(v0, v_g_mul);
-         __m128i v1_g   = _mm_mullo_epi16(v1, v_g_mul);
-
-         /* Add contibutions from the transformed components. */
-         __m128i r0 = _mm_srai_epi16(_mm_adds_epi16(_mm_adds_epi16(_y0, v0_r),
-                  round_offset), YUV_SHIFT);
-         __m128i g0 = _mm_srai_epi16(_mm_adds_epi16(
-                  _mm_adds_epi16(_mm_adds_epi16(_y0, v0_g), u0_g), round_offset), YUV_SHIFT);
-         __m128i b0 = _mm_srai_epi16(_mm_adds_epi16(
-                  _mm_adds_epi16(_y0, u0_b), round_offset), YUV_SHIFT);
-
-         __m128i r1 = _mm_srai_epi16(_mm_adds_epi16(
-                  _mm_adds_epi16(_y1, v1_r), round_offset), YUV_SHIFT);
-         __m128i g1 = _mm_srai_epi16(_mm_adds_epi16(
-                  _mm_adds_epi16(_mm_adds_epi16(_y1, v1_g), u1_g), round_offset), YUV_SHIFT);
-         __m128i b1 = _mm_srai_epi16(_mm_adds_epi16(
-                  _mm_adds_epi16(_y1, u1_b), round_offset), YUV_SHIFT);
-
-         /* Saturate into 8-bit. */
-         r0 = _mm_packus_epi16(r0, r1);
-         g0 = _mm_packus_epi16(g0, g1);
-         b0 = _mm_packus_epi16(b0, b1);
-
-         /* Interleave into ARGB. */
-         __m128i res_lo_bg = _mm_unpacklo_epi8(b0, g0);
-         __m128i res_hi_bg = _mm_unpackhi_epi8(b0, g0);
-         __m128i res_lo_ra = _mm_unpacklo_epi8(r0, a);
-         __m128i res_hi_ra = _mm_unpackhi_epi8(r0, a);
-         __m128i res0 = _mm_unpacklo_epi16(res_lo_bg, res_lo_ra);
-         __m128i res1 = _mm_unpackhi_epi16(res_lo_bg, res_lo_ra);
-         __m128i res2 = _mm_unpacklo_epi16(res_hi_bg, res_hi_ra);
-         __m128i res3 = _mm_unpackhi_epi16(res_hi_bg, res_hi_ra);
-
-         _mm_storeu_si128((__m128i*)(dst +  0), res0);
-         _mm_storeu_si128((__m128i*)(dst +  4), res1);
-         _mm_storeu_si128((__m128i*)(dst +  8), res2);
-         _mm_storeu_si128((__m128i*)(dst + 12), res3);
-      }
-
-      /* Finish off the rest (if any) in C. */
-      for (; w < width; w += 2, src += 4, dst += 2)
-      {
-         int _y0 = src[0];
-         int  u = src[1] - 128;
-         int _y1 = src[2];
-         int  v = src[3] - 128;
-
-         uint8_t r0 = clamp_8bit((YUV_MAT_Y * _y0 +                   YUV_MAT_V_R * v + YUV_OFFSET) >> YUV_SHIFT);
-         uint8_t g0 = clamp_8bit((YUV_MAT_Y * _y0 + YUV_MAT_U_G * u + YUV_MAT_V_G * v + YUV_OFFSET) >> YUV_SHIFT);
-         uint8_t b0 = clamp_8bit((YUV_MAT_Y * _y0 + YUV_MAT_U_B * u                   + YUV_OFFSET) >> YUV_SHIFT);
-
-         uint8_t r1 = clamp_8bit((YUV_MAT_Y * _y1 +                   YUV_MAT_V_R * v + YUV_OFFSET) >> YUV_SHIFT);
-         uint8_t g1 = clamp_8bit((YUV_MAT_Y * _y1 + YUV_MAT_U_G * u + YUV_MAT_V_G * v + YUV_OFFSET) >> YUV_SHIFT);
-         uint8_t b1 = clamp_8bit((YUV_MAT_Y * _y1 + YUV_MAT_U_B * u                   + YUV_OFFSET) >> YUV_SHIFT);
-
-         dst[0] = 0xff000000u | (r0 << 16) | (g0 << 8) | (b0 << 0);
-         dst[1] = 0xff000000u | (r1 << 16) | (g1 << 8) | (b1 << 0);
-      }
+   /* Each loop processes 16 pixels. */
+   for (w = 0; w + 16 <= width; w += 16, src += 32, dst += 16)
+   {
+      __m128i yuv0 = _mm_loadu_si128((const __m128i*)(src +  0)); /* [Y0, U0, Y1, V0, Y2, U1, Y3, V1, ...] */
+      __m128i yuv1 = _mm_loadu_si128((const __m128i*)(src + 16)); /* [Y0, U0, Y1, V0, Y2, U1, Y3, V1, ...] */
+
+      __m128i _y0 = _mm_and_si128(yuv0, mask_y); /* [Y0, Y1, Y2, ...] (16-bit) */
+      __m128i u0 = _mm_and_si128(yuv0, mask_u); /* [0, U0, 0, 0, 0, U1, 0, 0, ...] */
+      __m128i v0 = _mm_and_si128(yuv0, mask_v); /* [0, 0, 0, V1, 0, , 0, V1, ...] */
+      __m128i _y1 = _mm_and_si128(yuv1, mask_y); /* [Y0, Y1, Y2, ...] (16-bit) */
+      __m128i u1 = _mm_and_si128(yuv1, mask_u); /* [0, U0, 0, 0, 0, U1, 0, 0, ...] */
+      __m128i v1 = _mm_and_si128(yuv1, mask_v); /* [0, 0, 0, V1, 0, , 0, V1, ...] */
+
+      /* Juggle around to get U and V in the same 16-bit format as Y. */
+      u0 = _mm_srli_si128(u0, 1);
+      v0 = _mm_srli_si128(v0, 3);
+      u1 = _mm_srli_si128(u1, 1);
+      v1 = _mm_srli_si128(v1, 3);
+      __m128i u = _mm_packs_epi32(u0, u1);
+      __m128i v = _mm_packs_epi32(v0, v1);
+
+      /* Apply YUV offsets (U, V) -= (-128, -128). */
+      u = _mm_sub_epi16(u, chroma_offset);
+      v = _mm_sub_epi16(v, chroma_offset);
+
+      /* Upscale chroma horizontally (nearest). */
+      u0 = _mm_unpacklo_epi16(u, u);
+      u1 = _mm_unpackhi_epi16(u, u);
+      v0 = _mm_unpacklo_epi16(v, v);
+      v1 = _mm_unpackhi_epi16(v, v);
+
+      /* Apply transformations. */
+      _y0 = _mm_mullo_epi16(_y0, yuv_mul);
+      _y1 = _mm_mullo_epi16(_y1, yuv_mul);
+      __m128i u0_g   = _mm_mullo_epi16(u0, u_g_mul);
+      __m128i u1_g   = _mm_mullo_epi16(u1, u_g_mul);
+      __m128i u0_b   = _mm_mullo_epi16(u0, u_b_mul);
+      __m128i u1_b   = _mm_mullo_epi16(u1, u_b_mul);
+      __m128i v0_r   = _mm_mullo_epi16(v0, v_r_mul);
+      __m128i v1_r   = _mm_mullo_epi16(v1, v_r_mul);
+      __m128i v0_g   = _mm_mullo_epi16(v0, v_g_mul);
+      __m128i v1_g   = _mm_mullo_epi16(v1, v_g_mul);
+
+      /* Add contibutions from the transformed components. */
+      __m128i r0 = _mm_srai_epi16(_mm_adds_epi16(_mm_adds_epi16(_y0, v0_r),
+               round_offset), YUV_SHIFT);
+      __m128i g0 = _mm_srai_epi16(_mm_adds_epi16(
+               _mm_adds_epi16(_mm_adds_epi16(_y0, v0_g), u0_g), round_offset), YUV_SHIFT);
+      __m128i b0 = _mm_srai_epi16(_mm_adds_epi16(
+               _mm_adds_epi16(_y0, u0_b), round_offset), YUV_SHIFT);
+
+      __m128i r1 = _mm_srai_epi16(_mm_adds_epi16(
+               _mm_adds_epi16(_y1, v1_r), round_offset), YUV_SHIFT);
+      __m128i g1 = _mm_srai_epi16(_mm_adds_epi16(
+               _mm_adds_epi16(_mm_adds_epi16(_y1, v1_g), u1_g), round_offset), YUV_SHIFT);
+      __m128i b1 = _mm_srai_epi16(_mm_adds_epi16(
+               _mm_adds_epi16(_y1, u1_b), round_offset), YUV_SHIFT);
+
+      /* Saturate into 8-bit. */
+      r0 = _mm_packus_epi16(r0, r1);
+      g0 = _mm_packus_epi16(g0, g1);
+      b0 = _mm_packus_epi16(b0, b1);
+
+      /* Interleave into ARGB. */
+      __m128i res_lo_bg = _mm_unpacklo_epi8(b0, g0);
+      __m128i res_hi_bg = _mm_unpackhi_epi8(b0, g0);
+      __m128i res_lo_ra = _mm_unpacklo_epi8(r0, a);
+      __m128i res_hi_ra = _mm_unpackhi_epi8(r0, a);
+      __m128i res0 = _mm_unpacklo_epi16(res_lo_bg, res_lo_ra);
+      __m128i res1 = _mm_unpackhi_epi16(res_lo_bg, res_lo_ra);
+      __m128i res2 = _mm_unpacklo_epi16(res_hi_bg, res_hi_ra);
+      __m128i res3 = _mm_unpackhi_epi16(res_hi_bg, res_hi_ra);
+
+      _mm_storeu_si128((__m128i*)(dst +  0), res0);
+      _mm_storeu_si128((__m128i*)(dst +  4), res1);
+      _mm_storeu_si128((__m128i*)(dst +  8), res2);
+      _mm_storeu_si128((__m128i*)(dst + 12), res3);
    }
+
+   /* Finish off the rest (if any) in C. */
+   conv_yuyv_argb8888_line_c(dst, src, width - w);
 }
-#else
-void conv_yuyv_argb8888(void *output_, const void *input_,
-      int width, int height,
-      int out_stride, int in_stride)
+#endif
+
+#if defined(PIXCONV_RUNTIME_X86)
+/* Packs 16 ARGB8888 pixels into 48 bytes of BGR24. */
+static INLINE PIXCONV_TARGET("ssse3") void store_bgr24_ssse3(void *output,
+      __m128i a, __m128i b, __m128i c, __m128i d)
+{
+   const __m128i pack = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10,
+         12, 13, 14, -1, -1, -1, -1);
+   __m128i *out = (__m128i*)output;
+
+   a = _mm_shuffle_epi8(a, pack);
+   b = _mm_shuffle_epi8(b, pack);
+   c = _mm_shuffle_epi8(c, pack);
+   d = _mm_shuffle_epi8(d, pack);
+
+   _mm_storeu_si128(out + 0, _mm_or_si128(a, _mm_slli_si128(b, 12)));
+   _mm_storeu_si128(out + 1, _mm_or_si128(_mm_srli_si128(b, 4),
+            _mm_slli_si128(c, 8)));
+   _mm_storeu_si128(out + 2, _mm_or_si128(_mm_srli_si128(c, 8),
+            _mm_slli_si128(d, 4)));
+}
+
+static PIXCONV_TARGET("ssse3") void conv_bgr24_argb8888_line_ssse3(
+      void *output_, const void *input_, int width)
 {
-   int h, w;
+   int w;
    const uint8_t *input = (const uint8_t*)input_;
    uint32_t *output     = (uint32_t*)output_;
 
-   for (h = 0; h < height;
-         h++, output += out_stride >> 2, input += in_stride)
+   const __m128i unpack = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1,
+         6, 7, 8, -1, 9, 10, 11, -1);
+   const __m128i a      = _mm_set1_epi32(0xff000000);
+
+   for (w = 0; w + 16 <= width; w += 16)
+   {
+      const __m128i in0 = _mm_loadu_si128((const __m128i*)(input + w * 3 +  0));
+      const __m128i in1 = _mm_loadu_si128((const __m128i*)(input + w * 3 + 16));
+      const __m128i in2 = _mm_loadu_si128((const __m128i*)(input + w * 3 + 32));
+
+      __m128i res0 = _mm_shuffle_epi8(in0, unpack);
+      __m128i res1 = _mm_shuffle_epi8(_mm_alignr_epi8(in1, in0, 12), unpack);
+      __m128i res2 = _mm_shuffle_epi8(_mm_alignr_epi8(in2, in1,  8), unpack);
+      __m128i res3 = _mm_shuffle_epi8(_mm_srli_si128(in2, 4), unpack);
+
+      _mm_storeu_si128((__m128i*)(output + w +  0), _mm_or_si128(res0, a));
+      _mm_storeu_si128((__m128i*)(output + w +  4), _mm_or_si128(res1, a));
+      _mm_storeu_si128((__m128i*)(output + w +  8), _mm_or_si128(res2, a));
+      _mm_storeu_si128((__m128i*)(output + w + 12), _mm_or_si128(res3, a));
+   }
+
+   conv_bgr24_argb8888_line_c(output + w, input + w * 3, width - w);
+}
+
+static PIXCONV_TARGET("ssse3") void conv_argb8888_bgr24_line_ssse3(
+      void *output_, const void *input_, int width)
+{
+   int w;
+   const uint32_t *input = (const uint32_t*)input_;
+   uint8_t *output       = (uint8_t*)output_;
+
+   for (w = 0; w + 16 <= width; w += 16)
+   {
+      store_bgr24_ssse3(output + w * 3,
+            _mm_loadu_si128((const __m128i*)(input + w +  0)),
+            _mm_loadu_si128((const __m128i*)(input + w +  4)),
+            _mm_loadu_si128((const __m128i*)(input + w +  8)),
+            _mm_loadu_si128((const __m128i*)(input + w + 12)));
+   }
+
+   conv_argb8888_bgr24_line_c(output + w * 3, input + w, width - w);
+}
+
+static PIXCONV_TARGET("ssse3") void conv_argb8888_abgr8888_line_ssse3(
+      void *output_, const void *input_, int width)
+{
+   int w;
+   const uint32_t *input = (const uint32_t*)input_;
+   uint32_t *output      = (uint32_t*)output_;
+
+   const __m128i swap = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7,
+         10, 9, 8, 11, 14, 13, 12, 15);
+
+   for (w = 0; w + 4 <= width; w += 4)
+   {
+      const __m128i in = _mm_loadu_si128((const __m128i*)(input + w));
+      _mm_storeu_si128((__m128i*)(output + w), _mm_shuffle_epi8(in, swap));
+   }
+
+   conv_argb8888_abgr8888_line_c(output + w, input + w, width - w);
+}
+
+static PIXCONV_TARGET("ssse3") void conv_0rgb1555_bgr24_line_ssse3(
+      void *output_, const void *input_, int width)
+{
+   int w;
+   const uint16_t *input = (const uint16_t*)input_;
+   uint8_t *output       = (uint8_t*)output_;
+
+   for (w = 0; w + 16 <= width; w += 16)
+   {
+      __m128i res_lo0, res_hi0, res_lo1, res_hi1;
+      conv_expand_0rgb1555_sse2(_mm_loadu_si128((const __m128i*)(input + w + 0)),
+            &res_lo0, &res_hi0);
+      conv_expand_0rgb1555_sse2(_mm_loadu_si128((const __m128i*)(input + w + 8)),
+            &res_lo1, &res_hi1);
+
+      store_bgr24_ssse3(output + w * 3, res_lo0, res_hi0, res_lo1, res_hi1);
+   }
+
+   conv_0rgb1555_bgr24_line_c(output + w * 3, input + w, width - w);
+}
+
+static PIXCONV_TARGET("ssse3") void conv_rgb565_bgr24_line_ssse3(
+      void *output_, const void *input_, int width)
+{
+   int w;
+   const uint16_t *input = (const uint16_t*)input_;
+   uint8_t *output       = (uint8_t*)output_;
+
+   for (w = 0; w + 16 <= width; w += 16)
+   {
+      __m128i res_lo0, res_hi0, res_lo1, res_hi1;
+      conv_expand_rgb565_sse2(_mm_loadu_si128((const __m128i*)(input + w + 0)),
+            &res_lo0, &res_hi0);
+      conv_expand_rgb565_sse2(_mm_loadu_si128((const __m128i*)(input + w + 8)),
+            &res_lo1, &res_hi1);
+
+      store_bgr24_ssse3(output + w * 3, res_lo0, res_hi0, res_lo1, res_hi1);
+   }
+
+   conv_rgb565_bgr24_line_c(output + w * 3, input + w, width - w);
+}
+
+/* AVX2 versions of the 16/32-bit converters. unpack/pack instructions
+ * work within 128-bit lanes, so results are permuted back in order. */
+static PIXCONV_TARGET("avx2") void conv_rgb565_0rgb1555_line_avx2(
+      void *output_, const void *input_, int width)
+{
+   int w;
+   const uint16_t *input = (const uint16_t*)input_;
+   uint16_t *output      = (uint16_t*)output_;
+
+   const __m256i hi_mask = _mm256_set1_epi16(0x7fe0);
+   const __m256i lo_mask = _mm256_set1_epi16(0x1f);
+
+   for (w = 0; w + 16 <= width; w += 16)
+   {
+      const __m256i in = _mm256_loadu_si256((const __m256i*)(input + w));
+      __m256i hi = _mm256_and_si256(_mm256_srli_epi16(in, 1), hi_mask);
+      __m256i lo = _mm256_and_si256(in, lo_mask);
+      _mm256_storeu_si256((__m256i*)(output + w), _mm256_or_si256(hi, lo));
+   }
+
+   conv_rgb565_0rgb1555_line_c(output + w, input + w, width - w);
+}
+
+static PIXCONV_TARGET("avx2") void conv_0rgb1555_rgb565_line_avx2(
+      void *output_, const void *input_, int width)
+{
+   int w;
+   const uint16_t *input = (const uint16_t*)input_;
+   uint16_t *output      = (uint16_t*)output_;
+
+   const __m256i hi_mask   = _mm256_set1_epi16(
+         (int16_t)((0x1f << 11) | (0x1f << 6)));
+   const __m256i lo_mask   = _mm256_set1_epi16(0x1f);
+   const __m256i glow_mask = _mm256_set1_epi16(1 << 5);
+
+   for (w = 0; w + 16 <= width; w += 16)
    {
-      const uint8_t *src = input;
-      uint32_t *dst = output;
+      const __m256i in = _mm256_loadu_si256((const __m256i*)(input + w));
+      __m256i rg   = _mm256_and_si256(_mm256_slli_epi16(in, 1), hi_mask);
+      __m256i b    = _mm256_and_si256(in, lo_mask);
+      __m256i glow = _mm256_and_si256(_mm256_srli_epi16(in, 4), glow_mask);
+      _mm256_storeu_si256((__m256i*)(output + w),
+            _mm256_or_si256(rg, _mm256_or_si256(b, glow)));
+   }
+
+   conv_0rgb1555_rgb565_line_c(output + w, input + w, width - w);
+}
+
+/* Interleaves 16-bit B, G, R and A channels of 16 pixels
+ * into ARGB8888 and stores them. */
+static INLINE PIXCONV_TARGET("avx2") void store_argb8888_avx2(
+      uint32_t *output, __m256i b, __m256i g, __m256i r, __m256i a)
+{
+   __m256i bg     = _mm256_or_si256(b, _mm256_slli_epi16(g, 8));
+   __m256i ra     = _mm256_or_si256(r, _mm256_slli_epi16(a, 8));
+   __m256i res_lo = _mm256_unpacklo_epi16(bg, ra); /* 0-3, 8-11 */
+   __m256i res_hi = _mm256_unpackhi_epi16(bg, ra); /* 4-7, 12-15 */
+
+   _mm256_storeu_si256((__m256i*)(output + 0),
+         _mm256_permute2x128_si256(res_lo, res_hi, 0x20));
+   _mm256_storeu_si256((__m256i*)(output + 8),
+         _mm256_permute2x128_si256(res_lo, res_hi, 0x31));
+}
+
+static PIXCONV_TARGET("avx2") void conv_0rgb1555_argb8888_line_avx2(
+      void *output_, const void *input_, int width)
+{
+   int w;
+   const uint16_t *input = (const uint16_t*)input_;
+   uint32_t *output      = (uint32_t*)output_;
 
-      for (w = 0; w < width; w += 2, src += 4, dst += 2)
-      {
-         int _y0 = src[0];
-         int  u = src[1] - 128;
-         int _y1 = src[2];
-         int  v = src[3] - 128;
+   const __m256i pix_mask_r  = _mm256_set1_epi16(0x1f << 10);
+   const __m256i pix_mask_gb = _mm256_set1_epi16(0x1f <<  5);
+   const __m256i mul15_mid   = _mm256_set1_epi16(0x4200);
+   const __m256i mul15_hi    = _mm256_set1_epi16(0x0210);
+   const __m256i a           = _mm256_set1_epi16(0x00ff);
 
-         uint8_t r0 = clamp_8bit((YUV_MAT_Y * _y0 +                   YUV_MAT_V_R * v + YUV_OFFSET) >> YUV_SHIFT);
-         uint8_t g0 = clamp_8bit((YUV_MAT_Y * _y0 + YUV_MAT_U_G * u + YUV_MAT_V_G * v + YUV_OFFSET) >> YUV_SHIFT);
-         uint8_t b0 = clamp_8bit((YUV_MAT_Y * _y0 + YUV_MAT_U_B * u                   + YUV_OFFSET) >> YUV_SHIFT);
+   for (w = 0; w + 16 <= width; w += 16)
+   {
+      const __m256i in = _mm256_loadu_si256((const __m256i*)(input + w));
+      __m256i r = _mm256_and_si256(in, pix_mask_r);
+      __m256i g = _mm256_and_si256(in, pix_mask_gb);
+      __m256i b = _mm256_and_si256(_mm256_slli_epi16(in, 5), pix_mask_gb);
 
-         uint8_t r1 = clamp_8bit((YUV_MAT_Y * _y1 +                   YUV_MAT_V_R * v + YUV_OFFSET) >> YUV_SHIFT);
-         uint8_t g1 = clamp_8bit((YUV_MAT_Y * _y1 + YUV_MAT_U_G * u + YUV_MAT_V_G * v + YUV_OFFSET) >> YUV_SHIFT);
-         uint8_t b1 = clamp_8bit((YUV_MAT_Y * _y1 + YUV_MAT_U_B * u                   + YUV_OFFSET) >> YUV_SHIFT);
+      r = _mm256_mulhi_epi16(r, mul15_hi);
+      g = _mm256_mulhi_epi16(g, mul15_mid);
+      b = _mm256_mulhi_epi16(b, mul15_mid);
 
-         dst[0] = 0xff000000u | (r0 << 16) | (g0 << 8) | (b0 << 0);
-         dst[1] = 0xff000000u | (r1 << 16) | (g1 << 8) | (b1 << 0);
-      }
+      store_argb8888_avx2(output + w, b, g, r, a);
    }
+
+   conv_0rgb1555_argb8888_line_c(output + w, input + w, width - w);
+}
+
+static PIXCONV_TARGET("avx2") void conv_rgb565_argb8888_line_avx2(
+      void *output_, const void *input_, int width)
+{
+   int w;
+   const uint16_t *input = (const uint16_t*)input_;
+   uint32_t *output      = (uint32_t*)output_;
+
+   const __m256i pix_mask_r = _mm256_set1_epi16(0x1f << 10);
+   const __m256i pix_mask_g = _mm256_set1_epi16(0x3f <<  5);
+   const __m256i pix_mask_b = _mm256_set1_epi16(0x1f <<  5);
+   const __m256i mul16_r    = _mm256_set1_epi16(0x0210);
+   const __m256i mul16_g    = _mm256_set1_epi16(0x2080);
+   const __m256i mul16_b    = _mm256_set1_epi16(0x4200);
+   const __m256i a          = _mm256_set1_epi16(0x00ff);
+
+   for (w = 0; w + 16 <= width; w += 16)
+   {
+      const __m256i in = _mm256_loadu_si256((const __m256i*)(input + w));
+      __m256i r = _mm256_and_si256(_mm256_srli_epi16(in, 1), pix_mask_r);
+      __m256i g = _mm256_and_si256(in, pix_mask_g);
+      __m256i b = _mm256_and_si256(_mm256_slli_epi16(in, 5), pix_mask_b);
+
+      r = _mm256_mulhi_epi16(r, mul16_r);
+      g = _mm256_mulhi_epi16(g, mul16_g);
+      b = _mm256_mulhi_epi16(b, mul16_b);
+
+      store_argb8888_avx2(output + w, b, g, r, a);
+   }
+
+   conv_rgb565_argb8888_line_c(output + w, input + w, width - w);
+}
+
+static PIXCONV_TARGET("avx2") void conv_rgba4444_argb8888_line_avx2(
+      void *output_, const void *input_, int width)
+{
+   int w;
+   const uint16_t *input = (const uint16_t*)input_;
+   uint32_t *output      = (uint32_t*)output_;
+
+   const __m256i mask  = _mm256_set1_epi16(0xf);
+   const __m256i mul17 = _mm256_set1_epi16(0x11);
+
+   for (w = 0; w + 16 <= width; w += 16)
+   {
+      const __m256i in = _mm256_loadu_si256((const __m256i*)(input + w));
+      __m256i r = _mm256_and_si256(_mm256_srli_epi16(in, 12), mask);
+      __m256i g = _mm256_and_si256(_mm256_srli_epi16(in,  8), mask);
+      __m256i b = _mm256_and_si256(_mm256_srli_epi16(in,  4), mask);
+      __m256i a = _mm256_and_si256(in, mask);
+
+      store_argb8888_avx2(output + w,
+            _mm256_mullo_epi16(b, mul17), _mm256_mullo_epi16(g, mul17),
+            _mm256_mullo_epi16(r, mul17), _mm256_mullo_epi16(a, mul17));
+   }
+
+   conv_rgba4444_argb8888_line_c(output + w, input + w, width - w);
+}
+
+static PIXCONV_TARGET("avx2") void conv_argb8888_0rgb1555_line_avx2(
+      void *output_, const void *input_, int width)
+{
+   int w;
+   const uint32_t *input = (const uint32_t*)input_;
+   uint16_t *output      = (uint16_t*)output_;
+
+   const __m256i mask_r = _mm256_set1_epi32(0x1f << 10);
+   const __m256i mask_g = _mm256_set1_epi32(0x1f <<  5);
+   const __m256i mask_b = _mm256_set1_epi32(0x1f <<  0);
+
+   for (w = 0; w + 16 <= width; w += 16)
+   {
+      const __m256i in0 = _mm256_loadu_si256((const __m256i*)(input + w + 0));
+      const __m256i in1 = _mm256_loadu_si256((const __m256i*)(input + w + 8));
+
+      __m256i res0 = _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi32(in0, 9), mask_r),
+            _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi32(in0, 6), mask_g),
+               _mm256_and_si256(_mm256_srli_epi32(in0, 3), mask_b)));
+      __m256i res1 = _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi32(in1, 9), mask_r),
+            _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi32(in1, 6), mask_g),
+               _mm256_and_si256(_mm256_srli_epi32(in1, 3), mask_b)));
+
+      _mm256_storeu_si256((__m256i*)(output + w),
+            _mm256_permute4x64_epi64(_mm256_packs_epi32(res0, res1), 0xd8));
+   }
+
+   conv_argb8888_0rgb1555_line_c(output + w, input + w, width - w);
+}
+
+static PIXCONV_TARGET("avx2") void conv_argb8888_rgb565_line_avx2(
+      void *output_, const void *input_, int width)
+{
+   int w;
+   const uint32_t *input = (const uint32_t*)input_;
+   uint16_t *output      = (uint16_t*)output_;
+
+   const __m256i mask_r = _mm256_set1_epi32(0x1f << 11);
+   const __m256i mask_g = _mm256_set1_epi32(0x3f <<  5);
+   const __m256i mask_b = _mm256_set1_epi32(0x1f <<  0);
+
+   for (w = 0; w + 16 <= width; w += 16)
+   {
+      const __m256i in0 = _mm256_loadu_si256((const __m256i*)(input + w + 0));
+      const __m256i in1 = _mm256_loadu_si256((const __m256i*)(input + w + 8));
+
+      __m256i res0 = _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi32(in0, 8), mask_r),
+            _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi32(in0, 5), mask_g),
+               _mm256_and_si256(_mm256_srli_epi32(in0, 3), mask_b)));
+      __m256i res1 = _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi32(in1, 8), mask_r),
+            _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi32(in1, 5), mask_g),
+               _mm256_and_si256(_mm256_srli_epi32(in1, 3), mask_b)));
+
+      /* No saturation with unsigned packing, values are 16-bit. */
+      _mm256_storeu_si256((__m256i*)(output + w),
+            _mm256_permute4x64_epi64(_mm256_packus_epi32(res0, res1), 0xd8));
+   }
+
+   conv_argb8888_rgb565_line_c(output + w, input + w, width - w);
+}
+
+static PIXCONV_TARGET("avx2") void conv_argb8888_abgr8888_line_avx2(
+      void *output_, const void *input_, int width)
+{
+   int w;
+   const uint32_t *input = (const uint32_t*)input_;
+   uint32_t *output      = (uint32_t*)output_;
+
+   const __m256i swap = _mm256_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7,
+         10, 9, 8, 11, 14, 13, 12, 15,
+         2, 1, 0, 3, 6, 5, 4, 7,
+         10, 9, 8, 11, 14, 13, 12, 15);
+
+   for (w = 0; w + 8 <= width; w += 8)
+   {
+      const __m256i in = _mm256_loadu_si256((const __m256i*)(input + w));
+      _mm256_storeu_si256((__m256i*)(output + w), _mm256_shuffle_epi8(in, swap));
+   }
+
+   conv_argb8888_abgr8888_line_c(output + w, input + w, width - w);
 }
 #endif
 
+#if defined(__ARM_NEON__)
+static void conv_rgb565_0rgb1555_line_neon(void *output_,
+      const void *input_, int width)
+{
+   int w;
+   const uint16_t *input = (const uint16_t*)input_;
+   uint16_t *output      = (uint16_t*)output_;
+
+   const uint16x8_t hi_mask = vdupq_n_u16(0x7fe0);
+   const uint16x8_t lo_mask = vdupq_n_u16(0x1f);
+
+   for (w = 0; w + 8 <= width; w += 8)
+   {
+      uint16x8_t in = vld1q_u16(input + w);
+      uint16x8_t hi = vandq_u16(vshrq_n_u16(in, 1), hi_mask);
+      uint16x8_t lo = vandq_u16(in, lo_mask);
+      vst1q_u16(output + w, vorrq_u16(hi, lo));
+   }
+
+   conv_rgb565_0rgb1555_line_c(output + w, input + w, width - w);
+}
+
+static void conv_0rgb1555_rgb565_line_neon(void *output_,
+      const void *input_, int width)
+{
+   int w;
+   const uint16_t *input = (const uint16_t*)input_;
+   uint16_t *output      = (uint16_t*)output_;
+
+   const uint16x8_t hi_mask   = vdupq_n_u16((0x1f << 11) | (0x1f << 6));
+   const uint16x8_t lo_mask   = vdupq_n_u16(0x1f);
+   const uint16x8_t glow_mask = vdupq_n_u16(1 << 5);
+
+   for (w = 0; w + 8 <= width; w += 8)
+   {
+      uint16x8_t in   = vld1q_u16(input + w);
+      uint16x8_t rg   = vandq_u16(vshlq_n_u16(in, 1), hi_mask);
+      uint16x8_t b    = vandq_u16(in, lo_mask);
+      uint16x8_t glow = vandq_u16(vshrq_n_u16(in, 4), glow_mask);
+      vst1q_u16(output + w, vorrq_u16(rg, vorrq_u16(b, glow)));
+   }
+
+   conv_0rgb1555_rgb565_line_c(output + w, input + w, width - w);
+}
+
+/* Splits 8 0RGB1555 pixels into 8-bit B, G and R channels. */
+static INLINE uint8x8x3_t conv_expand_0rgb1555_neon(uint16x8_t in)
+{
+   uint8x8x3_t res;
+   const uint8x8_t mask = vdup_n_u8(0x1f);
+   uint8x8_t b = vand_u8(vmovn_u16(in), mask);
+   uint8x8_t g = vand_u8(vmovn_u16(vshrq_n_u16(in,  5)), mask);
+   uint8x8_t r = vand_u8(vmovn_u16(vshrq_n_u16(in, 10)), mask);
+
+   res.val[0] = vorr_u8(vshl_n_u8(b, 3), vshr_n_u8(b, 2));
+   res.val[1] = vorr_u8(vshl_n_u8(g, 3), vshr_n_u8(g, 2));
+   res.val[2] = vorr_u8(vshl_n_u8(r, 3), vshr_n_u8(r, 2));
+   return res;
+}
+
+/* Splits 8 RGB565 pixels into 8-bit B, G and R channels. */
+static INLINE uint8x8x3_t conv_expand_rgb565_neon(uint16x8_t in)
+{
+   uint8x8x3_t res;
+   uint8x8_t b = vand_u8(vmovn_u16(in), vdup_n_u8(0x1f));
+   uint8x8_t g = vand_u8(vmovn_u16(vshrq_n_u16(in, 5)), vdup_n_u8(0x3f));
+   uint8x8_t r = vmovn_u16(vshrq_n_u16(in, 11));
+
+   res.val[0] = vorr_u8(vshl_n_u8(b, 3), vshr_n_u8(b, 2));
+   res.val[1] = vorr_u8(vshl_n_u8(g, 2), vshr_n_u8(g, 4));
+   res.val[2] = vorr_u8(vshl_n_u8(r, 3), vshr_n_u8(r, 2));
+   return res;
+}
+
+static void conv_0rgb1555_argb8888_line_neon(void *output_,
+      const void *input_, int width)
+{
+   int w;
+   const uint16_t *input = (const uint16_t*)input_;
+   uint32_t *output      = (uint32_t*)output_;
+
+   for (w = 0; w + 8 <= width; w += 8)
+   {
+      uint8x8x4_t res;
+      uint8x8x3_t bgr = conv_expand_0rgb1555_neon(vld1q_u16(input + w));
+
+      res.val[0] = bgr.val[0];
+      res.val[1] = bgr.val[1];
+      res.val[2] = bgr.val[2];
+      res.val[3] = vdup_n_u8(0xff);
+      vst4_u8((uint8_t*)(output + w), res);
+   }
+
+   conv_0rgb1555_argb8888_line_c(output + w, input + w, width - w);
+}
+
+static void conv_rgb565_argb8888_line_neon(void *output_,
+      const void *input_, int width)
+{
+   int w;
+   const uint16_t *input = (const uint16_t*)input_;
+   uint32_t *output      = (uint32_t*)output_;
+
+   for (w = 0; w + 8 <= width; w += 8)
+   {
+      uint8x8x4_t res;
+      uint8x8x3_t bgr = conv_expand_rgb565_neon(vld1q_u16(input + w));
+
+      res.val[0] = bgr.val[0];
+      res.val[1] = bgr.val[1];
+      res.val[2] = bgr.val[2];
+      res.val[3] = vdup_n_u8(0xff);
+      vst4_u8((uint8_t*)(output + w), res);
+   }
+
+   conv_rgb565_argb8888_line_c(output + w, input + w, width - w);
+}
+
+static void conv_rgba4444_argb8888_line_neon(void *output_,
+      const void *input_, int width)
+{
+   int w;
+   const uint16_t *input = (const uint16_t*)input_;
+   uint32_t *output      = (uint32_t*)output_;
+
+   const uint8x8_t mask = vdup_n_u8(0xf);
+
+   for (w = 0; w + 8 <= width; w += 8)
+   {
+      uint8x8x4_t res;
+      uint16x8_t in = vld1q_u16(input + w);
+      uint8x8_t a   = vand_u8(vmovn_u16(in), mask);
+      uint8x8_t b   = vand_u8(vmovn_u16(vshrq_n_u16(in,  4)), mask);
+      uint8x8_t g   = vand_u8(vmovn_u16(vshrq_n_u16(in,  8)), mask);
+      uint8x8_t r   = vmovn_u16(vshrq_n_u16(in, 12));
+
+      res.val[0] = vorr_u8(vshl_n_u8(b, 4), b);
+      res.val[1] = vorr_u8(vshl_n_u8(g, 4), g);
+      res.val[2] = vorr_u8(vshl_n_u8(r, 4), r);
+      res.val[3] = vorr_u8(vshl_n_u8(a, 4), a);
+      vst4_u8((uint8_t*)(output + w), res);
+   }
+
+   conv_rgba4444_argb8888_line_c(output + w, input + w, width - w);
+}
+
+static void conv_bgr24_argb8888_line_neon(void *output_,
+      const void *input_, int width)
+{
+   int w;
+   const uint8_t *input = (const uint8_t*)input_;
+   uint32_t *output     = (uint32_t*)output_;
+
+   for (w = 0; w + 16 <= width; w += 16)
+   {
+      uint8x16x4_t res;
+      uint8x16x3_t bgr = vld3q_u8(input + w * 3);
+
+      res.val[0] = bgr.val[0];
+      res.val[1] = bgr.val[1];
+      res.val[2] = bgr.val[2];
+      res.val[3] = vdupq_n_u8(0xff);
+      vst4q_u8((uint8_t*)(output + w), res);
+   }
+
+   conv_bgr24_argb8888_line_c(output + w, input + w * 3, width - w);
+}
+
+static void conv_argb8888_0rgb1555_line_neon(void *output_,
+      const void *input_, int width)
+{
+   int w;
+   const uint32_t *input = (const uint32_t*)input_;
+   uint16_t *output      = (uint16_t*)output_;
+
+   for (w = 0; w + 8 <= width; w += 8)
+   {
+      uint8x8x4_t in = vld4_u8((const uint8_t*)(input + w));
+      uint16x8_t b   = vmovl_u8(vshr_n_u8(in.val[0], 3));
+      uint16x8_t g   = vmovl_u8(vshr_n_u8(in.val[1], 3));
+      uint16x8_t r   = vmovl_u8(vshr_n_u8(in.val[2], 3));
+
+      vst1q_u16(output + w, vorrq_u16(vshlq_n_u16(r, 10),
+               vorrq_u16(vshlq_n_u16(g, 5), b)));
+   }
+
+   conv_argb8888_0rgb1555_line_c(output + w, input + w, width - w);
+}
+
+static void conv_argb8888_rgb565_line_neon(void *output_,
+      const void *input_, int width)
+{
+   int w;
+   const uint32_t *input = (const uint32_t*)input_;
+   uint16_t *output      = (uint16_t*)output_;
+
+   for (w = 0; w + 8 <= width; w += 8)
+   {
+      uint8x8x4_t in = vld4_u8((const uint8_t*)(input + w));
+      uint16x8_t b   = vmovl_u8(vshr_n_u8(in.val[0], 3));
+      uint16x8_t g   = vmovl_u8(vshr_n_u8(in.val[1], 2));
+      uint16x8_t r   = vmovl_u8(vshr_n_u8(in.val[2], 3));
+
+      vst1q_u16(output + w, vorrq_u16(vshlq_n_u16(r, 11),
+               vorrq_u16(vshlq_n_u16(g, 5), b)));
+   }
+
+   conv_argb8888_rgb565_line_c(output + w, input + w, width - w);
+}
+
+static void conv_argb8888_bgr24_line_neon(void *output_,
+      const void *input_, int width)
+{
+   int w;
+   const uint32_t *input = (const uint32_t*)input_;
+   uint8_t *output       = (uint8_t*)output_;
+
+   for (w = 0; w + 16 <= width; w += 16)
+   {
+      uint8x16x3_t res;
+      uint8x16x4_t in = vld4q_u8((const uint8_t*)(input + w));
+
+      res.val[0] = in.val[0];
+      res.val[1] = in.val[1];
+      res.val[2] = in.val[2];
+      vst3q_u8(output + w * 3, res);
+   }
+
+   conv_argb8888_bgr24_line_c(output + w * 3, input + w, width - w);
+}
+
+static void conv_argb8888_abgr8888_line_neon(void *output_,
+      const void *input_, int width)
+{
+   int w;
+   const uint32_t *input = (const uint32_t*)input_;
+   uint32_t *output      = (uint32_t*)output_;
+
+   for (w = 0; w + 16 <= width; w += 16)
+   {
+      uint8x16x4_t in = vld4q_u8((const uint8_t*)(input + w));
+      uint8x16_t tmp  = in.val[0];
+
+      in.val[0] = in.val[2];
+      in.val[2] = tmp;
+      vst4q_u8((uint8_t*)(output + w), in);
+   }
+
+   conv_argb8888_abgr8888_line_c(output + w, input + w, width - w);
+}
+
+static void conv_0rgb1555_bgr24_line_neon(void *output_,
+      const void *input_, int width)
+{
+   int w;
+   const uint16_t *input = (const uint16_t*)input_;
+   uint8_t *output       = (uint8_t*)output_;
+
+   for (w = 0; w + 8 <= width; w += 8)
+      vst3_u8(output + w * 3, conv_expand_0rgb1555_neon(vld1q_u16(input + w)));
+
+   conv_0rgb1555_bgr24_line_c(output + w * 3, input + w, width - w);
+}
+
+static void conv_rgb565_bgr24_line_neon(void *output_,
+      const void *input_, int width)
+{
+   int w;
+   const uint16_t *input = (const uint16_t*)input_;
+   uint8_t *output       = (uint8_t*)output_;
+
+   for (w = 0; w + 8 <= width; w += 8)
+      vst3_u8(output + w * 3, conv_expand_rgb565_neon(vld1q_u16(input + w)));
+
+   conv_rgb565_bgr24_line_c(output + w * 3, input + w, width - w);
+}
+
+static void conv_yuyv_argb8888_line_neon(void *output_,
+      const void *input_, int width)
+{
+   int w;
+   const uint8_t *src = (const uint8_t*)input_;
+   uint32_t *dst      = (uint32_t*)output_;
+
+   const int16x8_t chroma_offset = vdupq_n_s16(128);
+   const int16x8_t round_offset  = vdupq_n_s16(YUV_OFFSET);
+
+   /* Each loop processes 16 pixels. */
+   for (w = 0; w + 16 <= width; w += 16, src += 32, dst += 16)
+   {
+      uint8x8x4_t res;
+      uint8x8x2_t r, g, b;
+      /* [Y0 Y2 ...], [U0 U1 ...], [Y1 Y3 ...], [V0 V1 ...] */
+      uint8x8x4_t yuv = vld4_u8(src);
+
+      int16x8_t y0 = vreinterpretq_s16_u16(vshll_n_u8(yuv.val[0], YUV_SHIFT));
+      int16x8_t y1 = vreinterpretq_s16_u16(vshll_n_u8(yuv.val[2], YUV_SHIFT));
+      int16x8_t u  = vsubq_s16(vreinterpretq_s16_u16(
+               vmovl_u8(yuv.val[1])), chroma_offset);
+      int16x8_t v  = vsubq_s16(vreinterpretq_s16_u16(
+               vmovl_u8(yuv.val[3])), chroma_offset);
+
+      int16x8_t r_uv = vaddq_s16(vmulq_n_s16(v, YUV_MAT_V_R), round_offset);
+      int16x8_t g_uv = vaddq_s16(vaddq_s16(vmulq_n_s16(u, YUV_MAT_U_G),
+               vmulq_n_s16(v, YUV_MAT_V_G)), round_offset);
+      int16x8_t b_uv = vaddq_s16(vmulq_n_s16(u, YUV_MAT_U_B), round_offset);
+
+      /* Shift and saturate into 8-bit, then interleave even/odd pixels. */
+      r = vzip_u8(vqshrun_n_s16(vaddq_s16(y0, r_uv), YUV_SHIFT),
+            vqshrun_n_s16(vaddq_s16(y1, r_uv), YUV_SHIFT));
+      g = vzip_u8(vqshrun_n_s16(vaddq_s16(y0, g_uv), YUV_SHIFT),
+            vqshrun_n_s16(vaddq_s16(y1, g_uv), YUV_SHIFT));
+      b = vzip_u8(vqshrun_n_s16(vaddq_s16(y0, b_uv), YUV_SHIFT),
+            vqshrun_n_s16(vaddq_s16(y1, b_uv), YUV_SHIFT));
+
+      res.val[3] = vdup_n_u8(0xff);
+
+      res.val[0] = b.val[0];
+      res.val[1] = g.val[0];
+      res.val[2] = r.val[0];
+      vst4_u8((uint8_t*)(dst + 0), res);
+
+      res.val[0] = b.val[1];
+      res.val[1] = g.val[1];
+      res.val[2] = r.val[1];
+      vst4_u8((uint8_t*)(dst + 8), res);
+   }
+
+   conv_yuyv_argb8888_line_c(dst, src, width - w);
+}
+#endif
+
+struct conv_line_impl
+{
+   conv_line_t rgb565_0rgb1555;
+   conv_line_t _0rgb1555_rgb565;
+   conv_line_t _0rgb1555_argb8888;
+   conv_line_t rgb565_argb8888;
+   conv_line_t rgba4444_argb8888;
+   conv_line_t bgr24_argb8888;
+   conv_line_t argb8888_0rgb1555;
+   conv_line_t argb8888_rgb565;
+   conv_line_t argb8888_bgr24;
+   conv_line_t argb8888_abgr8888;
+   conv_line_t _0rgb1555_bgr24;
+   conv_line_t rgb565_bgr24;
+   conv_line_t yuyv_argb8888;
+};
+
+#define CONV_LINE_IMPL(isa) { \
+   conv_rgb565_0rgb1555_line_##isa, \
+   conv_0rgb1555_rgb565_line_##isa, \
+   conv_0rgb1555_argb8888_line_##isa, \
+   conv_rgb565_argb8888_line_##isa, \
+   conv_rgba4444_argb8888_line_##isa, \
+   conv_bgr24_argb8888_line_##isa, \
+   conv_argb8888_0rgb1555_line_##isa, \
+   conv_argb8888_rgb565_line_##isa, \
+   conv_argb8888_bgr24_line_##isa, \
+   conv_argb8888_abgr8888_line_##isa, \
+   conv_0rgb1555_bgr24_line_##isa, \
+   conv_rgb565_bgr24_line_##isa, \
+   conv_yuyv_argb8888_line_##isa }
+
+static const struct conv_line_impl conv_impl_c = CONV_LINE_IMPL(c);
+
+/* Until conv_init_simd() is called, use whatever
+ * the compiler guarantees to be available. */
+#if defined(__SSE2__)
+static const struct conv_line_impl conv_impl_sse2 = CONV_LINE_IMPL(sse2);
+static struct conv_line_impl conv_impl            = CONV_LINE_IMPL(sse2);
+#elif defined(__ARM_NEON__)
+static const struct conv_line_impl conv_impl_neon = CONV_LINE_IMPL(neon);
+static struct conv_line_impl conv_impl            = CONV_LINE_IMPL(neon);
+#else
+static struct conv_line_impl conv_impl            = CONV_LINE_IMPL(c);
+#endif
+
+void conv_init_simd(pixconv_simd_mask_t simd)
+{
+   conv_impl = conv_impl_c;
+
+#if defined(__SSE2__)
+   if (simd & PIXCONV_SIMD_SSE2)
+      conv_impl = conv_impl_sse2;
+
+#if defined(PIXCONV_RUNTIME_X86)
+   if (simd & PIXCONV_SIMD_SSSE3)
+   {
+      conv_impl.bgr24_argb8888    = conv_bgr24_argb8888_line_ssse3;
+      conv_impl.argb8888_bgr24    = conv_argb8888_bgr24_line_ssse3;
+      conv_impl.argb8888_abgr8888 = conv_argb8888_abgr8888_line_ssse3;
+      conv_impl._0rgb1555_bgr24   = conv_0rgb1555_bgr24_line_ssse3;
+      conv_impl.rgb565_bgr24      = conv_rgb565_bgr24_line_ssse3;
+   }
+
+   /* AVX2 needs OS support for YMM state, which is part of the AVX check. */
+   if ((simd & PIXCONV_SIMD_AVX) && (simd & PIXCONV_SIMD_AVX2))
+   {
+      conv_impl.rgb565_0rgb1555    = conv_rgb565_0rgb1555_line_avx2;
+      conv_impl._0rgb1555_rgb565   = conv_0rgb1555_rgb565_line_avx2;
+      conv_impl._0rgb1555_argb8888 = conv_0rgb1555_argb8888_line_avx2;
+      conv_impl.rgb565_argb8888    = conv_rgb565_argb8888_line_avx2;
+      conv_impl.rgba4444_argb8888  = conv_rgba4444_argb8888_line_avx2;
+      conv_impl.argb8888_0rgb1555  = conv_argb8888_0rgb1555_line_avx2;
+      conv_impl.argb8888_rgb565    = conv_argb8888_rgb565_line_avx2;
+      conv_impl.argb8888_abgr8888  = conv_argb8888_abgr8888_line_avx2;
+   }
+#endif
+#elif defined(__ARM_NEON__)
+   if (simd & PIXCONV_SIMD_NEON)
+      conv_impl = conv_impl_neon;
+#else
+   (void)simd;
+#endif
+}
+
+void conv_rgb565_0rgb1555(void *output, const void *input,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   conv_lines(conv_impl.rgb565_0rgb1555, output, input,
+         width, height, out_stride, in_stride);
+}
+
+void conv_0rgb1555_rgb565(void *output, const void *input,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   conv_lines(conv_impl._0rgb1555_rgb565, output, input,
+         width, height, out_stride, in_stride);
+}
+
+void conv_0rgb1555_argb8888(void *output, const void *input,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   conv_lines(conv_impl._0rgb1555_argb8888, output, input,
+         width, height, out_stride, in_stride);
+}
+
+void conv_rgb565_argb8888(void *output, const void *input,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   conv_lines(conv_impl.rgb565_argb8888, output, input,
+         width, height, out_stride, in_stride);
+}
+
+void conv_rgba4444_argb8888(void *output, const void *input,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   conv_lines(conv_impl.rgba4444_argb8888, output, input,
+         width, height, out_stride, in_stride);
+}
+
+void conv_bgr24_argb8888(void *output, const void *input,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   conv_lines(conv_impl.bgr24_argb8888, output, input,
+         width, height, out_stride, in_stride);
+}
+
+void conv_argb8888_0rgb1555(void *output, const void *input,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   conv_lines(conv_impl.argb8888_0rgb1555, output, input,
+         width, height, out_stride, in_stride);
+}
+
+void conv_argb8888_rgb565(void *output, const void *input,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   conv_lines(conv_impl.argb8888_rgb565, output, input,
+         width, height, out_stride, in_stride);
+}
+
+void conv_argb8888_bgr24(void *output, const void *input,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   conv_lines(conv_impl.argb8888_bgr24, output, input,
+         width, height, out_stride, in_stride);
+}
+
+void conv_argb8888_abgr8888(void *output, const void *input,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   conv_lines(conv_impl.argb8888_abgr8888, output, input,
+         width, height, out_stride, in_stride);
+}
+
+void conv_0rgb1555_bgr24(void *output, const void *input,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   conv_lines(conv_impl._0rgb1555_bgr24, output, input,
+         width, height, out_stride, in_stride);
+}
+
+void conv_rgb565_bgr24(void *output, const void *input,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   conv_lines(conv_impl.rgb565_bgr24, output, input,
+         width, height, out_stride, in_stride);
+}
+
+void conv_yuyv_argb8888(void *output, const void *input,
+      int width, int height,
+      int out_stride, int in_stride)
+{
+   conv_lines(conv_impl.yuyv_argb8888, output, input,
+         width, height, out_stride, in_stride);
+}
+
 void conv_copy(void *output_, const void *input_,
       int width, int height,
       int out_stride, int in_stride)
@@ -931,4 +1730,3 @@ void conv_copy(void *output_, const void *input_,
          h++, output += out_stride, input += in_stride)
       memcpy(output, input, copy_len);
 }
-
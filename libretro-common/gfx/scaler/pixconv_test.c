@@ -0,0 +1,290 @@
+/* Copyright  (C) 2010-2015 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (pixconv_test.c).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Checks that every SIMD converter is bit-exact with the C converters
+ * and benchmarks them.
+ *
+ * Usage: pixconv_test [iterations]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include <gfx/scaler/pixconv.h>
+
+#define GUARD_BYTE 0xa5
+#define GUARD_SIZE 64
+
+#define BENCH_WIDTH  1920
+#define BENCH_HEIGHT 1080
+
+typedef void (*conv_func_t)(void *output, const void *input,
+      int width, int height,
+      int out_stride, int in_stride);
+
+struct conv_test
+{
+   const char *ident;
+   conv_func_t func;
+   unsigned in_bpp;
+   unsigned out_bpp;
+   unsigned width_align;
+};
+
+static const struct conv_test conv_tests[] = {
+   { "rgb565_0rgb1555",    conv_rgb565_0rgb1555,   2, 2, 1 },
+   { "0rgb1555_rgb565",    conv_0rgb1555_rgb565,   2, 2, 1 },
+   { "0rgb1555_argb8888",  conv_0rgb1555_argb8888, 2, 4, 1 },
+   { "rgb565_argb8888",    conv_rgb565_argb8888,   2, 4, 1 },
+   { "rgba4444_argb8888",  conv_rgba4444_argb8888, 2, 4, 1 },
+   { "bgr24_argb8888",     conv_bgr24_argb8888,    3, 4, 1 },
+   { "argb8888_0rgb1555",  conv_argb8888_0rgb1555, 4, 2, 1 },
+   { "argb8888_rgb565",    conv_argb8888_rgb565,   4, 2, 1 },
+   { "argb8888_bgr24",     conv_argb8888_bgr24,    4, 3, 1 },
+   { "argb8888_abgr8888",  conv_argb8888_abgr8888, 4, 4, 1 },
+   { "0rgb1555_bgr24",     conv_0rgb1555_bgr24,    2, 3, 1 },
+   { "rgb565_bgr24",       conv_rgb565_bgr24,      2, 3, 1 },
+   { "yuyv_argb8888",      conv_yuyv_argb8888,     2, 4, 2 },
+};
+
+struct simd_tier
+{
+   const char *ident;
+   pixconv_simd_mask_t simd;
+   int supported;
+};
+
+static struct simd_tier simd_tiers[] = {
+   { "c",     0, 1 },
+#if defined(__i386__) || defined(__x86_64__)
+   { "sse2",  PIXCONV_SIMD_SSE | PIXCONV_SIMD_SSE2, 0 },
+   { "ssse3", PIXCONV_SIMD_SSE | PIXCONV_SIMD_SSE2 |
+      PIXCONV_SIMD_SSE3 | PIXCONV_SIMD_SSSE3, 0 },
+   { "avx2",  PIXCONV_SIMD_SSE | PIXCONV_SIMD_SSE2 |
+      PIXCONV_SIMD_SSE3 | PIXCONV_SIMD_SSSE3 |
+      PIXCONV_SIMD_AVX | PIXCONV_SIMD_AVX2, 0 },
+#elif defined(__ARM_NEON__)
+   { "neon",  PIXCONV_SIMD_NEON, 0 },
+#endif
+};
+
+#define NUM_CONV_TESTS (sizeof(conv_tests) / sizeof(conv_tests[0]))
+#define NUM_SIMD_TIERS (sizeof(simd_tiers) / sizeof(simd_tiers[0]))
+
+static void detect_simd_tiers(void)
+{
+#if defined(__i386__) || defined(__x86_64__)
+   __builtin_cpu_init();
+   simd_tiers[1].supported = __builtin_cpu_supports("sse2");
+   simd_tiers[2].supported = __builtin_cpu_supports("ssse3");
+   simd_tiers[3].supported = __builtin_cpu_supports("avx")
+      && __builtin_cpu_supports("avx2");
+#elif defined(__ARM_NEON__)
+   simd_tiers[1].supported = 1;
+#endif
+}
+
+static void fill_random(uint8_t *data, size_t size)
+{
+   size_t i;
+   for (i = 0; i < size; i++)
+      data[i] = rand() >> 7;
+}
+
+/* Converts into a guarded buffer, so that overruns
+ * past the last line or into the stride padding show up as mismatches. */
+static uint8_t *run_conv(const struct conv_test *test,
+      const uint8_t *input, int width, int height,
+      int out_stride, int in_stride)
+{
+   size_t size    = out_stride * height + 2 * GUARD_SIZE;
+   uint8_t *out   = (uint8_t*)malloc(size);
+
+   if (!out)
+      return NULL;
+
+   memset(out, GUARD_BYTE, size);
+   test->func(out + GUARD_SIZE, input, width, height, out_stride, in_stride);
+   return out;
+}
+
+static unsigned check_conv(const struct conv_test *test,
+      const struct simd_tier *tier, int width, int height, int offset)
+{
+   unsigned failed = 0;
+   int in_stride   = (width * test->in_bpp + 16 + offset) & ~3;
+   int out_stride  = width * test->out_bpp + 16;
+   uint8_t *input  = NULL;
+   uint8_t *ref    = NULL;
+   uint8_t *out    = NULL;
+
+   /* Keep 16-bit and 32-bit lines naturally aligned
+    * as the C converters expect, but not vector aligned. */
+   if (test->in_bpp != 3)
+      offset &= ~(test->in_bpp - 1);
+
+   input = (uint8_t*)malloc(in_stride * height + 64);
+   if (!input)
+      return 1;
+
+   fill_random(input, in_stride * height + 64);
+
+   conv_init_simd(0);
+   ref = run_conv(test, input + offset, width, height, out_stride, in_stride);
+   conv_init_simd(tier->simd);
+   out = run_conv(test, input + offset, width, height, out_stride, in_stride);
+
+   if (!ref || !out || memcmp(ref, out,
+            out_stride * height + 2 * GUARD_SIZE) != 0)
+   {
+      fprintf(stderr, "FAIL: %s (%s), %dx%d, offset %d.\n",
+            test->ident, tier->ident, width, height, offset);
+      failed = 1;
+   }
+
+   free(input);
+   free(ref);
+   free(out);
+   return failed;
+}
+
+static unsigned run_tests(void)
+{
+   unsigned i, j;
+   unsigned failed = 0;
+   static const int widths[] = { 255, 256, 257, 320, 640, 1919, 1920 };
+
+   for (i = 0; i < NUM_SIMD_TIERS; i++)
+   {
+      if (!simd_tiers[i].supported || !simd_tiers[i].simd)
+         continue;
+
+      for (j = 0; j < NUM_CONV_TESTS; j++)
+      {
+         int width, offset;
+         unsigned k;
+         const struct conv_test *test = &conv_tests[j];
+
+         for (width = 0; width <= 80; width += test->width_align)
+            for (offset = 0; offset < 8; offset += 2)
+               failed += check_conv(test, &simd_tiers[i], width, 3, offset);
+
+         for (k = 0; k < sizeof(widths) / sizeof(widths[0]); k++)
+         {
+            width = widths[k] & ~(test->width_align - 1);
+            failed += check_conv(test, &simd_tiers[i], width, 7, 4);
+         }
+      }
+
+      printf("%-6s %s\n", simd_tiers[i].ident, failed ? "FAILED" : "bit-exact");
+   }
+
+   return failed;
+}
+
+static double get_time(void)
+{
+   struct timespec tv;
+   clock_gettime(CLOCK_MONOTONIC, &tv);
+   return tv.tv_sec + tv.tv_nsec / 1000000000.0;
+}
+
+static void run_benchmarks(unsigned iterations)
+{
+   unsigned i, j, k;
+   uint8_t *input  = (uint8_t*)malloc(BENCH_WIDTH * BENCH_HEIGHT * 4);
+   uint8_t *output = (uint8_t*)malloc(BENCH_WIDTH * BENCH_HEIGHT * 4);
+
+   if (!input || !output)
+      goto end;
+
+   fill_random(input, BENCH_WIDTH * BENCH_HEIGHT * 4);
+
+   printf("\n%dx%d, %u iterations, ms per frame:\n",
+         BENCH_WIDTH, BENCH_HEIGHT, iterations);
+   printf("%-20s", "");
+   for (i = 0; i < NUM_SIMD_TIERS; i++)
+      if (simd_tiers[i].supported)
+         printf("%10s", simd_tiers[i].ident);
+   printf("\n");
+
+   for (j = 0; j < NUM_CONV_TESTS; j++)
+   {
+      const struct conv_test *test = &conv_tests[j];
+      printf("%-20s", test->ident);
+
+      for (i = 0; i < NUM_SIMD_TIERS; i++)
+      {
+         double start;
+
+         if (!simd_tiers[i].supported)
+            continue;
+
+         conv_init_simd(simd_tiers[i].simd);
+
+         start = get_time();
+         for (k = 0; k < iterations; k++)
+            test->func(output, input, BENCH_WIDTH, BENCH_HEIGHT,
+                  BENCH_WIDTH * test->out_bpp, BENCH_WIDTH * test->in_bpp);
+
+         printf("%10.3f", (get_time() - start) * 1000.0 / iterations);
+      }
+      printf("\n");
+   }
+
+end:
+   free(input);
+   free(output);
+}
+
+int main(int argc, char *argv[])
+{
+   unsigned failed;
+   unsigned iterations = 100;
+
+   if (argc > 2)
+   {
+      fprintf(stderr, "Usage: %s [iterations]\n", argv[0]);
+      return 1;
+   }
+
+   if (argc == 2)
+      iterations = strtoul(argv[1], NULL, 0);
+
+   srand(1);
+   detect_simd_tiers();
+
+   failed = run_tests();
+   if (failed)
+   {
+      fprintf(stderr, "%u conversions did not match.\n", failed);
+      return 1;
+   }
+
+   if (iterations)
+      run_benchmarks(iterations);
+
+   return 0;
+}
@@ -29,6 +29,60 @@
 #include <stdio.h>
 #include <math.h>
 
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
+
+struct scaler_band
+{
+   unsigned index;
+
+   /* Output rows [y_start, y_end) are produced by this band. */
+   int y_start;
+   int y_end;
+
+   /* Input line converted to ARGB8888, tagged by input row. */
+   uint32_t *input;
+   int input_tag;
+
+   /* Output line before conversion to the output format. */
+   uint32_t *output;
+
+   /* Ring of horizontally scaled lines.
+    * Input row y lives in slot (y % scaled.height). */
+   uint64_t *lines;
+   int *line_tags;
+   const uint64_t **taps;
+};
+
+#ifdef HAVE_THREADS
+struct scaler_pool_worker
+{
+   struct scaler_pool *pool;
+   sthread_t *thread;
+   unsigned band;
+};
+
+struct scaler_pool
+{
+   slock_t *lock;
+   scond_t *cond;
+   scond_t *done_cond;
+
+   struct scaler_pool_worker workers[SCALER_MAX_THREADS];
+   unsigned num_workers;
+
+   /* Bumped every time a new frame is handed out. */
+   unsigned generation;
+   unsigned pending;
+   bool quit;
+
+   const struct scaler_ctx *ctx;
+   void *output;
+   const void *input;
+};
+#endif
+
 /* In case aligned allocs are needed later. */
 
 /**
@@ -61,23 +115,69 @@ void scaler_free(void *ptr)
       free(ptr);
 }
 
+static unsigned scaler_num_bands(const struct scaler_ctx *ctx)
+{
+#ifdef HAVE_THREADS
+   unsigned bands     = ctx->threads;
+   unsigned max_bands = ctx->out_height / SCALER_MIN_BAND_ROWS;
+
+   if (bands > SCALER_MAX_THREADS)
+      bands = SCALER_MAX_THREADS;
+
+   /* Unscaled contexts are allowed to change dimensions 
+    * after scaler_ctx_gen_filter(), so the split is decided
+    * in scaler_ctx_scale() instead. */
+   if (!ctx->unscaled && bands > max_bands)
+      bands = max_bands;
+   if (bands < 1)
+      bands = 1;
+   return bands;
+#else
+   return 1;
+#endif
+}
+
 static bool allocate_frames(struct scaler_ctx *ctx)
 {
+   unsigned i;
+
+   ctx->num_bands = scaler_num_bands(ctx);
+   ctx->bands     = (struct scaler_band*)
+      scaler_alloc(sizeof(struct scaler_band), ctx->num_bands);
+   if (!ctx->bands)
+      return false;
+
+   for (i = 0; i < ctx->num_bands; i++)
+   {
+      ctx->bands[i].index   = i;
+      ctx->bands[i].y_start = ctx->out_height * i / ctx->num_bands;
+      ctx->bands[i].y_end   = ctx->out_height * (i + 1) / ctx->num_bands;
+   }
+
+   if (ctx->unscaled)
+      return true;
+
+   /* Only a ring of filter_len lines is needed per band,
+    * point sampling works straight off the input lines. */
    ctx->scaled.stride = ((ctx->out_width + 7) & ~7) * sizeof(uint64_t);
    ctx->scaled.width  = ctx->out_width;
-   ctx->scaled.height = ctx->in_height;
-   ctx->scaled.frame  = (uint64_t*)
-      scaler_alloc(sizeof(uint64_t),
-            (ctx->scaled.stride * ctx->scaled.height) >> 3);
-   if (!ctx->scaled.frame)
-      return false;
+   ctx->scaled.height = ctx->scaler_special ? 0 : ctx->vert.filter_len;
+
+   if (ctx->scaled.height)
+   {
+      ctx->scaled.frame  = (uint64_t*)
+         scaler_alloc(sizeof(uint64_t),
+               (ctx->scaled.stride * ctx->scaled.height * ctx->num_bands) >> 3);
+      if (!ctx->scaled.frame)
+         return false;
+   }
 
    if (ctx->in_fmt != SCALER_FMT_ARGB8888)
    {
       ctx->input.stride = ((ctx->in_width + 7) & ~7) * sizeof(uint32_t);
       ctx->input.frame = (uint32_t*)
          scaler_alloc(sizeof(uint32_t),
-               (ctx->input.stride * ctx->in_height) >> 2);
+               (ctx->input.stride * ctx->num_bands) >> 2);
       if (!ctx->input.frame)
          return false;
    }
@@ -87,11 +187,33 @@ static bool allocate_frames(struct scaler_ctx *ctx)
       ctx->output.stride = ((ctx->out_width + 7) & ~7) * sizeof(uint32_t);
       ctx->output.frame  = (uint32_t*)
          scaler_alloc(sizeof(uint32_t),
-               (ctx->output.stride * ctx->out_height) >> 2);
+               (ctx->output.stride * ctx->num_bands) >> 2);
       if (!ctx->output.frame)
          return false;
    }
 
+   for (i = 0; i < ctx->num_bands; i++)
+   {
+      struct scaler_band *band = &ctx->bands[i];
+
+      if (ctx->input.frame)
+         band->input  = ctx->input.frame + i * (ctx->input.stride >> 2);
+      if (ctx->output.frame)
+         band->output = ctx->output.frame + i * (ctx->output.stride >> 2);
+
+      if (!ctx->scaled.height)
+         continue;
+
+      band->lines     = ctx->scaled.frame +
+         i * ctx->scaled.height * (ctx->scaled.stride >> 3);
+      band->line_tags = (int*)scaler_alloc(sizeof(int), ctx->scaled.height);
+      band->taps      = (const uint64_t**)
+         scaler_alloc(sizeof(uint64_t*), ctx->scaled.height);
+
+      if (!band->line_tags || !band->taps)
+         return false;
+   }
+
    return true;
 }
 
@@ -138,6 +260,8 @@ static bool set_direct_pix_conv(struct scaler_ctx *ctx)
       case SCALER_FMT_ARGB8888:
          if (ctx->out_fmt == SCALER_FMT_0RGB1555)
             ctx->direct_pixconv = conv_argb8888_0rgb1555;
+         else if (ctx->out_fmt == SCALER_FMT_RGB565)
+            ctx->direct_pixconv = conv_argb8888_rgb565;
          else if (ctx->out_fmt == SCALER_FMT_BGR24)
             ctx->direct_pixconv = conv_argb8888_bgr24;
          else if (ctx->out_fmt == SCALER_FMT_ABGR8888)
@@ -200,6 +324,10 @@ static bool set_pix_conv(struct scaler_ctx *ctx)
          ctx->out_pixconv = conv_argb8888_0rgb1555;
          break;
 
+      case SCALER_FMT_RGB565:
+         ctx->out_pixconv = conv_argb8888_rgb565;
+         break;
+
       case SCALER_FMT_BGR24:
          ctx->out_pixconv = conv_argb8888_bgr24;
          break;
@@ -211,6 +339,232 @@ static bool set_pix_conv(struct scaler_ctx *ctx)
    return true;
 }
 
+static const uint32_t *scaler_band_input_line(const struct scaler_ctx *ctx,
+      struct scaler_band *band, const void *input, int y)
+{
+   const uint8_t *line = (const uint8_t*)input + y * ctx->in_stride;
+
+   if (ctx->in_fmt == SCALER_FMT_ARGB8888)
+      return (const uint32_t*)line;
+
+   if (band->input_tag != y)
+   {
+      ctx->in_pixconv(band->input, line, ctx->in_width, 1,
+            ctx->input.stride, ctx->in_stride);
+      band->input_tag = y;
+   }
+
+   return band->input;
+}
+
+static const uint64_t *scaler_band_scaled_line(const struct scaler_ctx *ctx,
+      struct scaler_band *band, const void *input, int y)
+{
+   /* filter_pos is monotonic, so the filter_len lines needed for
+    * one output line never evict each other from the ring. */
+   int slot       = y % ctx->scaled.height;
+   uint64_t *line = band->lines + slot * (ctx->scaled.stride >> 3);
+
+   if (band->line_tags[slot] != y)
+   {
+      ctx->scaler_horiz(ctx, line,
+            scaler_band_input_line(ctx, band, input, y));
+      band->line_tags[slot] = y;
+   }
+
+   return line;
+}
+
+/**
+ * scaler_band_scale:
+ * @ctx          : pointer to scaler context object.
+ * @band         : band of output rows to produce.
+ * @output       : pointer to output image.
+ * @input        : pointer to input image.
+ *
+ * Scales the rows of one band. Bands only share read-only
+ * state, so they can be processed concurrently.
+ **/
+static void scaler_band_scale(const struct scaler_ctx *ctx,
+      struct scaler_band *band, void *output, const void *input)
+{
+   int h, y;
+
+   if (ctx->unscaled)
+   {
+      int y_start = ctx->out_height * band->index / ctx->num_bands;
+      int y_end   = ctx->out_height * (band->index + 1) / ctx->num_bands;
+
+      /* Just perform straight pixel conversion. */
+      ctx->direct_pixconv(
+            (uint8_t*)output + y_start * ctx->out_stride,
+            (const uint8_t*)input + y_start * ctx->in_stride,
+            ctx->out_width, y_end - y_start,
+            ctx->out_stride, ctx->in_stride);
+      return;
+   }
+
+   band->input_tag = -1;
+   for (y = 0; y < ctx->scaled.height; y++)
+      band->line_tags[y] = -1;
+
+   for (h = band->y_start; h < band->y_end; h++)
+   {
+      uint8_t *output_line = (uint8_t*)output + h * ctx->out_stride;
+      uint32_t *line       = (ctx->out_fmt == SCALER_FMT_ARGB8888)
+         ? (uint32_t*)output_line : band->output;
+      int pos              = ctx->vert.filter_pos[h];
+
+      if (ctx->scaler_special)
+      {
+         /* Take some special, and (hopefully) more optimized path. */
+         ctx->scaler_special(ctx, line,
+               scaler_band_input_line(ctx, band, input, pos));
+      }
+      else
+      {
+         /* Take generic filter path. */
+         for (y = 0; y < ctx->vert.filter_len; y++)
+            band->taps[y] = scaler_band_scaled_line(ctx, band, input, pos + y);
+
+         ctx->scaler_vert(ctx, line, band->taps,
+               ctx->vert.filter + h * ctx->vert.filter_stride);
+      }
+
+      if (ctx->out_fmt != SCALER_FMT_ARGB8888)
+         ctx->out_pixconv(output_line, line, ctx->out_width, 1,
+               ctx->out_stride, ctx->output.stride);
+   }
+}
+
+#ifdef HAVE_THREADS
+static void scaler_pool_thread(void *data)
+{
+   struct scaler_pool_worker *worker = (struct scaler_pool_worker*)data;
+   struct scaler_pool *pool          = worker->pool;
+   unsigned generation               = 0;
+
+   for (;;)
+   {
+      const struct scaler_ctx *ctx = NULL;
+
+      slock_lock(pool->lock);
+      while (!pool->quit && pool->generation == generation)
+         scond_wait(pool->cond, pool->lock);
+
+      if (pool->quit)
+      {
+         slock_unlock(pool->lock);
+         break;
+      }
+
+      generation = pool->generation;
+      ctx        = pool->ctx;
+      slock_unlock(pool->lock);
+
+      scaler_band_scale(ctx, &ctx->bands[worker->band],
+            pool->output, pool->input);
+
+      slock_lock(pool->lock);
+      if (--pool->pending == 0)
+         scond_signal(pool->done_cond);
+      slock_unlock(pool->lock);
+   }
+}
+
+static void scaler_pool_free(struct scaler_pool *pool)
+{
+   unsigned i;
+
+   if (!pool)
+      return;
+
+   if (pool->lock && pool->cond)
+   {
+      slock_lock(pool->lock);
+      pool->quit = true;
+      scond_broadcast(pool->cond);
+      slock_unlock(pool->lock);
+
+      for (i = 0; i < pool->num_workers; i++)
+         sthread_join(pool->workers[i].thread);
+   }
+
+   if (pool->lock)
+      slock_free(pool->lock);
+   if (pool->cond)
+      scond_free(pool->cond);
+   if (pool->done_cond)
+      scond_free(pool->done_cond);
+   free(pool);
+}
+
+/* Band 0 is always handled by the calling thread,
+ * workers take care of the remaining bands. */
+static struct scaler_pool *scaler_pool_new(unsigned num_bands)
+{
+   unsigned i;
+   struct scaler_pool *pool = (struct scaler_pool*)
+      calloc(1, sizeof(*pool));
+
+   if (!pool)
+      return NULL;
+
+   pool->lock      = slock_new();
+   pool->cond      = scond_new();
+   pool->done_cond = scond_new();
+
+   if (!pool->lock || !pool->cond || !pool->done_cond)
+      goto error;
+
+   for (i = 1; i < num_bands; i++)
+   {
+      struct scaler_pool_worker *worker = &pool->workers[pool->num_workers];
+
+      worker->pool   = pool;
+      worker->band   = i;
+      worker->thread = sthread_create(scaler_pool_thread, worker);
+      if (!worker->thread)
+         goto error;
+
+      pool->num_workers++;
+   }
+
+   return pool;
+
+error:
+   scaler_pool_free(pool);
+   return NULL;
+}
+
+static void scaler_pool_scale(struct scaler_pool *pool,
+      const struct scaler_ctx *ctx, void *output, const void *input)
+{
+   slock_lock(pool->lock);
+   pool->ctx     = ctx;
+   pool->output  = output;
+   pool->input   = input;
+   pool->pending = pool->num_workers;
+   pool->generation++;
+   scond_broadcast(pool->cond);
+   slock_unlock(pool->lock);
+
+   scaler_band_scale(ctx, &ctx->bands[0], output, input);
+
+   slock_lock(pool->lock);
+   while (pool->pending)
+      scond_wait(pool->done_cond, pool->lock);
+   slock_unlock(pool->lock);
+}
+#endif
+
+static unsigned scaler_simd;
+
+void scaler_init_simd(unsigned simd)
+{
+   scaler_simd = simd;
+}
+
 bool scaler_ctx_gen_filter(struct scaler_ctx *ctx)
 {
    scaler_ctx_gen_reset(ctx);
@@ -222,13 +576,19 @@ bool scaler_ctx_gen_filter(struct scaler_ctx *ctx)
       ctx->scaler_horiz = scaler_argb8888_horiz;
       ctx->scaler_vert  = scaler_argb8888_vert;
       ctx->unscaled     = false;
+
+#ifdef SCALER_RUNTIME_AVX2
+      /* AVX2 needs OS support for YMM state, which is part of the AVX check. */
+      if ((scaler_simd & PIXCONV_SIMD_AVX) && (scaler_simd & PIXCONV_SIMD_AVX2))
+      {
+         ctx->scaler_horiz = scaler_argb8888_horiz_avx2;
+         ctx->scaler_vert  = scaler_argb8888_vert_avx2;
+      }
+#endif
    }
 
    ctx->scaler_special = NULL;
 
-   if (!allocate_frames(ctx))
-      return false;
-
    if (ctx->unscaled)
    {
       if (!set_direct_pix_conv(ctx))
@@ -243,11 +603,37 @@ bool scaler_ctx_gen_filter(struct scaler_ctx *ctx)
    if (!ctx->unscaled && !scaler_gen_filter(ctx))
       return false;
 
+   if (!allocate_frames(ctx))
+      return false;
+
+#ifdef HAVE_THREADS
+   /* Not fatal, bands are then scaled one after another. */
+   if (ctx->num_bands > 1)
+      ctx->pool = scaler_pool_new(ctx->num_bands);
+#endif
+
    return true;
 }
 
 void scaler_ctx_gen_reset(struct scaler_ctx *ctx)
 {
+   unsigned i;
+
+#ifdef HAVE_THREADS
+   scaler_pool_free(ctx->pool);
+#endif
+   ctx->pool = NULL;
+
+   if (ctx->bands)
+   {
+      for (i = 0; i < ctx->num_bands; i++)
+      {
+         scaler_free(ctx->bands[i].line_tags);
+         scaler_free((void*)ctx->bands[i].taps);
+      }
+   }
+
+   scaler_free(ctx->bands);
    scaler_free(ctx->horiz.filter);
    scaler_free(ctx->horiz.filter_pos);
    scaler_free(ctx->vert.filter);
@@ -256,6 +642,8 @@ void scaler_ctx_gen_reset(struct scaler_ctx *ctx)
    scaler_free(ctx->input.frame);
    scaler_free(ctx->output.frame);
 
+   ctx->bands     = NULL;
+   ctx->num_bands = 0;
    memset(&ctx->horiz, 0, sizeof(ctx->horiz));
    memset(&ctx->vert, 0, sizeof(ctx->vert));
    memset(&ctx->scaled, 0, sizeof(ctx->scaled));
@@ -270,14 +658,22 @@ void scaler_ctx_gen_reset(struct scaler_ctx *ctx)
  * @input        : pointer to input image.
  *
  * Scales an input image to an output image.
+ * With ctx->threads > 1, bands of output rows
+ * are scaled in parallel.
  **/
 void scaler_ctx_scale(struct scaler_ctx *ctx,
       void *output, const void *input)
 {
-   const void *input_frame = input;
-   void *output_frame      = output;
-   int input_stride        = ctx->in_stride;
-   int output_stride       = ctx->out_stride;
+   unsigned i;
+
+#ifdef HAVE_THREADS
+   if (ctx->pool && (!ctx->unscaled ||
+            ctx->out_height >= (int)(ctx->num_bands * SCALER_MIN_BAND_ROWS)))
+   {
+      scaler_pool_scale(ctx->pool, ctx, output, input);
+      return;
+   }
+#endif
 
    if (ctx->unscaled)
    {
@@ -288,41 +684,6 @@ void scaler_ctx_scale(struct scaler_ctx *ctx,
       return;
    }
 
-   if (ctx->in_fmt != SCALER_FMT_ARGB8888)
-   {
-      ctx->in_pixconv(ctx->input.frame, input,
-            ctx->in_width, ctx->in_height,
-            ctx->input.stride, ctx->in_stride);
-
-      input_frame       = ctx->input.frame;
-      input_stride      = ctx->input.stride;
-   }
-
-   if (ctx->out_fmt != SCALER_FMT_ARGB8888)
-   {
-      output_frame  = ctx->output.frame;
-      output_stride = ctx->output.stride;
-   }
-
-   if (ctx->scaler_special)
-   {
-      /* Take some special, and (hopefully) more optimized path. */
-      ctx->scaler_special(ctx, output_frame, input_frame,
-            ctx->out_width, ctx->out_height,
-            ctx->in_width, ctx->in_height,
-            output_stride, input_stride);
-   }
-   else
-   {
-      /* Take generic filter path. */
-      if (ctx->scaler_horiz)
-         ctx->scaler_horiz(ctx, input_frame, input_stride);
-      if (ctx->scaler_vert)
-         ctx->scaler_vert (ctx, output, output_stride);
-   }
-
-   if (ctx->out_fmt != SCALER_FMT_ARGB8888)
-      ctx->out_pixconv(output, ctx->output.frame,
-            ctx->out_width, ctx->out_height,
-            ctx->out_stride, ctx->output.stride);
+   for (i = 0; i < ctx->num_bands; i++)
+      scaler_band_scale(ctx, &ctx->bands[i], output, input);
 }
@@ -66,6 +66,11 @@ static bool gen_filter_point(struct scaler_ctx *ctx)
    y_pos  = (1 << 15) * ctx->in_height / ctx->out_height - (1 << 15);
    y_step = (1 << 16) * ctx->in_height / ctx->out_height;
 
+   if (x_pos < 0)
+      x_pos = 0;
+   if (y_pos < 0)
+      y_pos = 0;
+
    gen_filter_point_sub(&ctx->horiz, ctx->out_width, x_pos, x_step);
    gen_filter_point_sub(&ctx->vert, ctx->out_height, y_pos, y_step);
 
@@ -172,6 +177,130 @@ static bool gen_filter_sinc(struct scaler_ctx *ctx)
 }
 
 
+/* Catmull-Rom spline, radius 2. */
+static double filter_bicubic(double x)
+{
+   x = fabs(x);
+   if (x < 1.0)
+      return 1.5 * x * x * x - 2.5 * x * x + 1.0;
+   if (x < 2.0)
+      return -0.5 * x * x * x + 2.5 * x * x - 4.0 * x + 2.0;
+   return 0.0;
+}
+
+/* Lanczos-3, radius 3. */
+static double filter_lanczos(double x)
+{
+   if (fabs(x) >= 3.0)
+      return 0.0;
+   return filter_sinc(M_PI * x) * filter_sinc(M_PI * x / 3.0);
+}
+
+/**
+ * gen_filter_kernel_len:
+ * @radius       : radius of the kernel in input pixels.
+ * @out_len      : output length.
+ * @in_len       : input length.
+ *
+ * The kernel is stretched when downsampling
+ * to get a proper low-pass effect.
+ *
+ * Returns: amount of taps needed per output pixel.
+ **/
+static int gen_filter_kernel_len(double radius, int out_len, int in_len)
+{
+   double scale = in_len > out_len ? (double)in_len / out_len : 1.0;
+   int len      = 2 * (int)ceil(radius * scale);
+
+   if (len > in_len)
+      len = in_len;
+   return len;
+}
+
+static void gen_filter_kernel_sub(struct scaler_filter *filter,
+      int out_len, int in_len, double (*kernel)(double), double radius)
+{
+   int i, j;
+   const int len  = filter->filter_len;
+   double scale   = in_len > out_len ? (double)in_len / out_len : 1.0;
+   double support = radius * scale;
+
+   for (i = 0; i < out_len; i++)
+   {
+      double weights[256];
+      double sum       = 0.0;
+      int taps_sum     = 0;
+      int max_tap      = 0;
+      double center    = (i + 0.5) * in_len / out_len - 0.5;
+      int start        = (int)floor(center - support) + 1;
+      int pos          = start;
+      int16_t *taps    = filter->filter + i * filter->filter_stride;
+
+      if (pos > in_len - len)
+         pos = in_len - len;
+      if (pos < 0)
+         pos = 0;
+
+      filter->filter_pos[i] = pos;
+
+      for (j = 0; j < len; j++)
+         weights[j] = 0.0;
+
+      /* Taps falling off the edges are folded onto the edge pixels. */
+      for (j = 0; j < len; j++)
+      {
+         int x    = start + j;
+         double w = kernel((x - center) / scale);
+
+         if (x < 0)
+            x = 0;
+         else if (x > in_len - 1)
+            x = in_len - 1;
+
+         weights[x - pos] += w;
+         sum              += w;
+      }
+
+      for (j = 0; j < len; j++)
+      {
+         taps[j]   = (int16_t)floor(FILTER_UNITY * weights[j] / sum + 0.5);
+         taps_sum += taps[j];
+         if (taps[j] > taps[max_tap])
+            max_tap = j;
+      }
+
+      /* Make the taps sum up to exactly unity, 
+       * so flat areas stay flat. */
+      taps[max_tap] += FILTER_UNITY - taps_sum;
+   }
+}
+
+static bool gen_filter_kernel(struct scaler_ctx *ctx,
+      double (*kernel)(double), double radius)
+{
+   ctx->horiz.filter_len    = gen_filter_kernel_len(radius,
+         ctx->out_width, ctx->in_width);
+   ctx->horiz.filter_stride = ctx->horiz.filter_len;
+   ctx->vert.filter_len     = gen_filter_kernel_len(radius,
+         ctx->out_height, ctx->in_height);
+   ctx->vert.filter_stride  = ctx->vert.filter_len;
+
+   /* Keeps the weights on the stack. */
+   if (ctx->horiz.filter_len > 256 || ctx->vert.filter_len > 256)
+      return false;
+
+   if (!allocate_filters(ctx))
+      return false;
+
+   gen_filter_kernel_sub(&ctx->horiz, ctx->out_width, ctx->in_width,
+         kernel, radius);
+   gen_filter_kernel_sub(&ctx->vert, ctx->out_height, ctx->in_height,
+         kernel, radius);
+
+   return true;
+}
+
+
 static bool validate_filter(struct scaler_ctx *ctx)
 {
    int i;
@@ -272,6 +401,14 @@ bool scaler_gen_filter(struct scaler_ctx *ctx)
          ret = gen_filter_sinc(ctx);
          break;
 
+      case SCALER_TYPE_BICUBIC:
+         ret = gen_filter_kernel(ctx, filter_bicubic, 2.0);
+         break;
+
+      case SCALER_TYPE_LANCZOS:
+         ret = gen_filter_kernel(ctx, filter_lanczos, 3.0);
+         break;
+
       default:
          return false;
    }
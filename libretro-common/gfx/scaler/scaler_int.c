@@ -20,17 +20,24 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
 
+
 #include <gfx/scaler/scaler_int.h>
 
 #ifdef SCALER_NO_SIMD
 #undef __SSE2__
+#undef __ARM_NEON__
 #endif
 
 #if defined(__SSE2__)
 #include <emmintrin.h>
+#if defined(SCALER_RUNTIME_AVX2)
+#include <immintrin.h>
+#endif
 #ifdef _WIN32
 #include <intrin.h>
 #endif
+#elif defined(__ARM_NEON__)
+#include <arm_neon.h>
 #endif
 
 // ARGB8888 scaler is split in two:
@@ -48,153 +55,293 @@
 // Another 2 bits of precision is lost, which ends up as 11 bits.
 // Scaling is now complete. Channels are shifted right by 3, and saturated into 8-bit values.
 //
+// Both scalers work on one line at a time, so the caller only has to keep
+// vert.filter_len horizontally scaled lines around.
+//
 // The C version of scalers perform the exact same operations as the SIMD code for testing purposes.
 
 #if defined(__SSE2__)
-void scaler_argb8888_vert(const struct scaler_ctx *ctx, void *output_, int stride)
+/* Filters the pixels of the line from @w on. */
+static inline void scaler_argb8888_vert_sse2(const struct scaler_ctx *ctx,
+      uint32_t *output, const uint64_t * const *lines,
+      const int16_t *filter, int w)
 {
-   int h, w, y;
-   const uint64_t *input = ctx->scaled.frame;
-   uint32_t *output = (uint32_t*)output_;
-
-   const int16_t *filter_vert = ctx->vert.filter;
+   int y;
+   const int len = ctx->vert.filter_len;
 
-   for (h = 0; h < ctx->out_height; h++, filter_vert += ctx->vert.filter_stride, output += stride >> 2)
+   for (; (w + 1) < ctx->out_width; w += 2)
    {
-      const uint64_t *input_base = input + ctx->vert.filter_pos[h] * (ctx->scaled.stride >> 3);
+      __m128i res = _mm_setzero_si128();
 
-      for (w = 0; w < ctx->out_width; w++)
+      for (y = 0; y < len; y++)
       {
-         __m128i res = _mm_setzero_si128();
+         __m128i coeff = _mm_set1_epi16(filter[y]);
+         __m128i col   = _mm_loadu_si128((const __m128i*)(lines[y] + w));
 
-         const uint64_t *input_base_y = input_base + w;
+         res = _mm_adds_epi16(_mm_mulhi_epi16(col, coeff), res);
+      }
 
-         for (y = 0; (y + 1) < ctx->vert.filter_len; y += 2, input_base_y += (ctx->scaled.stride >> 2))
-         {
-            __m128i coeff = _mm_set_epi64x(filter_vert[y + 1] * 0x0001000100010001ll, filter_vert[y + 0] * 0x0001000100010001ll);
-            __m128i col   = _mm_set_epi64x(input_base_y[ctx->scaled.stride >> 3], input_base_y[0]);
+      res = _mm_srai_epi16(res, (7 - 2 - 2));
+      _mm_storel_epi64((__m128i*)(output + w), _mm_packus_epi16(res, res));
+   }
 
-            res = _mm_adds_epi16(_mm_mulhi_epi16(col, coeff), res);
-         }
+   for (; w < ctx->out_width; w++)
+   {
+      __m128i res = _mm_setzero_si128();
 
-         for (; y < ctx->vert.filter_len; y++, input_base_y += (ctx->scaled.stride >> 3))
-         {
-            __m128i coeff = _mm_set_epi64x(0, filter_vert[y] * 0x0001000100010001ll);
-            __m128i col   = _mm_set_epi64x(0, input_base_y[0]);
+      for (y = 0; y < len; y++)
+      {
+         __m128i coeff = _mm_set1_epi16(filter[y]);
+         __m128i col   = _mm_loadl_epi64((const __m128i*)(lines[y] + w));
 
-            res = _mm_adds_epi16(_mm_mulhi_epi16(col, coeff), res);
-         }
+         res = _mm_adds_epi16(_mm_mulhi_epi16(col, coeff), res);
+      }
 
-         res = _mm_adds_epi16(_mm_srli_si128(res, 8), res);
-         res = _mm_srai_epi16(res, (7 - 2 - 2));
+      res       = _mm_srai_epi16(res, (7 - 2 - 2));
+      output[w] = _mm_cvtsi128_si32(_mm_packus_epi16(res, res));
+   }
+}
 
-         __m128i final = _mm_packus_epi16(res, res);
+void scaler_argb8888_vert(const struct scaler_ctx *ctx,
+      uint32_t *output, const uint64_t * const *lines,
+      const int16_t *filter)
+{
+   scaler_argb8888_vert_sse2(ctx, output, lines, filter, 0);
+}
 
-         output[w] = _mm_cvtsi128_si32(final);
+#if defined(SCALER_RUNTIME_AVX2)
+SCALER_TARGET("avx2") void scaler_argb8888_vert_avx2(
+      const struct scaler_ctx *ctx, uint32_t *output,
+      const uint64_t * const *lines, const int16_t *filter)
+{
+   int w = 0, y;
+   const int len = ctx->vert.filter_len;
+
+   for (; (w + 3) < ctx->out_width; w += 4)
+   {
+      __m256i res = _mm256_setzero_si256();
+
+      for (y = 0; y < len; y++)
+      {
+         __m256i coeff = _mm256_set1_epi16(filter[y]);
+         __m256i col   = _mm256_loadu_si256((const __m256i*)(lines[y] + w));
+
+         res = _mm256_adds_epi16(_mm256_mulhi_epi16(col, coeff), res);
       }
+
+      res = _mm256_srai_epi16(res, (7 - 2 - 2));
+
+      /* packus works within 128-bit lanes, gather pixels 0-1 and 2-3. */
+      res = _mm256_permute4x64_epi64(_mm256_packus_epi16(res, res), 0x08);
+
+      _mm_storeu_si128((__m128i*)(output + w), _mm256_castsi256_si128(res));
    }
+
+   scaler_argb8888_vert_sse2(ctx, output, lines, filter, w);
 }
-#else
-void scaler_argb8888_vert(const struct scaler_ctx *ctx, void *output_, int stride)
+#endif
+#elif defined(__ARM_NEON__)
+void scaler_argb8888_vert(const struct scaler_ctx *ctx,
+      uint32_t *output, const uint64_t * const *lines,
+      const int16_t *filter)
 {
-   int h, w, y;
-   const uint64_t *input = ctx->scaled.frame;
-   uint32_t *output = (uint32_t*)output_;
+   int w = 0, y;
+   const int len = ctx->vert.filter_len;
 
-   const int16_t *filter_vert = ctx->vert.filter;
+   for (; (w + 1) < ctx->out_width; w += 2)
+   {
+      int16x8_t res = vdupq_n_s16(0);
 
-   for (h = 0; h < ctx->out_height; h++, filter_vert += ctx->vert.filter_stride, output += stride >> 2)
+      for (y = 0; y < len; y++)
+      {
+         int16x8_t col = vld1q_s16((const int16_t*)(lines[y] + w));
+         int16x4_t lo  = vshrn_n_s32(vmull_n_s16(vget_low_s16(col), filter[y]), 16);
+         int16x4_t hi  = vshrn_n_s32(vmull_n_s16(vget_high_s16(col), filter[y]), 16);
+
+         res = vqaddq_s16(vcombine_s16(lo, hi), res);
+      }
+
+      vst1_u8((uint8_t*)(output + w), vqshrun_n_s16(res, (7 - 2 - 2)));
+   }
+
+   for (; w < ctx->out_width; w++)
    {
-      const uint64_t *input_base = input + ctx->vert.filter_pos[h] * (ctx->scaled.stride >> 3);
+      uint8x8_t final;
+      int16x4_t res = vdup_n_s16(0);
 
-      for (w = 0; w < ctx->out_width; w++)
+      for (y = 0; y < len; y++)
       {
-         int16_t res_a = 0;
-         int16_t res_r = 0;
-         int16_t res_g = 0;
-         int16_t res_b = 0;
+         int16x4_t col = vld1_s16((const int16_t*)(lines[y] + w));
+         res = vqadd_s16(vshrn_n_s32(vmull_n_s16(col, filter[y]), 16), res);
+      }
 
-         const uint64_t *input_base_y = input_base + w;
-         for (y = 0; y < ctx->vert.filter_len; y++, input_base_y += (ctx->scaled.stride >> 3))
-         {
-            uint64_t col = *input_base_y;
+      final     = vqshrun_n_s16(vcombine_s16(res, res), (7 - 2 - 2));
+      output[w] = vget_lane_u32(vreinterpret_u32_u8(final), 0);
+   }
+}
+#else
+void scaler_argb8888_vert(const struct scaler_ctx *ctx,
+      uint32_t *output, const uint64_t * const *lines,
+      const int16_t *filter)
+{
+   int w, y;
 
-            int16_t a = (col >> 48) & 0xffff;
-            int16_t r = (col >> 32) & 0xffff;
-            int16_t g = (col >> 16) & 0xffff;
-            int16_t b = (col >>  0) & 0xffff;
+   for (w = 0; w < ctx->out_width; w++)
+   {
+      int16_t res_a = 0;
+      int16_t res_r = 0;
+      int16_t res_g = 0;
+      int16_t res_b = 0;
 
-            int16_t coeff = filter_vert[y];
+      for (y = 0; y < ctx->vert.filter_len; y++)
+      {
+         uint64_t col = lines[y][w];
 
-            res_a += (a * coeff) >> 16;
-            res_r += (r * coeff) >> 16;
-            res_g += (g * coeff) >> 16;
-            res_b += (b * coeff) >> 16;
-         }
+         int16_t a = (col >> 48) & 0xffff;
+         int16_t r = (col >> 32) & 0xffff;
+         int16_t g = (col >> 16) & 0xffff;
+         int16_t b = (col >>  0) & 0xffff;
 
-         res_a >>= (7 - 2 - 2);
-         res_r >>= (7 - 2 - 2);
-         res_g >>= (7 - 2 - 2);
-         res_b >>= (7 - 2 - 2);
+         int16_t coeff = filter[y];
 
-         output[w] = (clamp_8bit(res_a) << 24) | (clamp_8bit(res_r) << 16) | (clamp_8bit(res_g) << 8) | (clamp_8bit(res_b) << 0);
+         res_a += (a * coeff) >> 16;
+         res_r += (r * coeff) >> 16;
+         res_g += (g * coeff) >> 16;
+         res_b += (b * coeff) >> 16;
       }
+
+      res_a >>= (7 - 2 - 2);
+      res_r >>= (7 - 2 - 2);
+      res_g >>= (7 - 2 - 2);
+      res_b >>= (7 - 2 - 2);
+
+      output[w] = (clamp_8bit(res_a) << 24) | (clamp_8bit(res_r) << 16) | (clamp_8bit(res_g) << 8) | (clamp_8bit(res_b) << 0);
    }
 }
 #endif
 
 #if defined(__SSE2__)
-void scaler_argb8888_horiz(const struct scaler_ctx *ctx, const void *input_, int stride)
+/* Broadcasts a (possibly negative) tap into four 16-bit lanes. */
+static inline int64_t build_coeff64(int16_t coeff)
 {
-   int h, w, x;
-   const uint32_t *input = (const uint32_t*)input_;
-   uint64_t *output      = ctx->scaled.frame;
+   return (int64_t)((uint16_t)coeff * 0x0001000100010001ull);
+}
 
-   for (h = 0; h < ctx->scaled.height; h++, input += stride >> 2, output += ctx->scaled.stride >> 3)
+/* Adds the taps of one output pixel from @x on to @res. */
+static inline __m128i scaler_argb8888_horiz_sse2(const struct scaler_ctx *ctx,
+      __m128i res, const int16_t *filter_horiz,
+      const uint32_t *input_base_x, int x)
+{
+   for (; (x + 1) < ctx->horiz.filter_len; x += 2)
    {
-      const int16_t *filter_horiz = ctx->horiz.filter;
+      __m128i coeff = _mm_set_epi64x(build_coeff64(filter_horiz[x + 1]), build_coeff64(filter_horiz[x + 0]));
 
-      for (w = 0; w < ctx->scaled.width; w++, filter_horiz += ctx->horiz.filter_stride)
-      {
-         __m128i res = _mm_setzero_si128();
+      __m128i col = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(input_base_x + x)), _mm_setzero_si128());
 
-         const uint32_t *input_base_x = input + ctx->horiz.filter_pos[w];
+      col = _mm_slli_epi16(col, 7);
+      res = _mm_adds_epi16(_mm_mulhi_epi16(col, coeff), res);
+   }
 
-         for (x = 0; (x + 1) < ctx->horiz.filter_len; x += 2)
-         {
-            __m128i coeff = _mm_set_epi64x(filter_horiz[x + 1] * 0x0001000100010001ll, filter_horiz[x + 0] * 0x0001000100010001ll);
+   for (; x < ctx->horiz.filter_len; x++)
+   {
+      __m128i coeff = _mm_set_epi64x(0, build_coeff64(filter_horiz[x]));
+      __m128i col   = _mm_unpacklo_epi8(_mm_cvtsi32_si128(input_base_x[x]), _mm_setzero_si128());
 
-            __m128i col = _mm_unpacklo_epi8(_mm_set_epi64x(0,
-                     ((uint64_t)input_base_x[x + 1] << 32) | input_base_x[x + 0]), _mm_setzero_si128());
+      col = _mm_slli_epi16(col, 7);
+      res = _mm_adds_epi16(_mm_mulhi_epi16(col, coeff), res);
+   }
 
-            col = _mm_slli_epi16(col, 7);
-            res = _mm_adds_epi16(_mm_mulhi_epi16(col, coeff), res);
-         }
+   return _mm_adds_epi16(_mm_srli_si128(res, 8), res);
+}
 
-         for (; x < ctx->horiz.filter_len; x++)
-         {
-            __m128i coeff = _mm_set_epi64x(0, filter_horiz[x] * 0x0001000100010001ll);
-            __m128i col   = _mm_unpacklo_epi8(_mm_set_epi32(0, 0, 0, input_base_x[x]), _mm_setzero_si128());
+void scaler_argb8888_horiz(const struct scaler_ctx *ctx,
+      uint64_t *output, const uint32_t *input)
+{
+   int w;
+   const int16_t *filter_horiz = ctx->horiz.filter;
 
-            col = _mm_slli_epi16(col, 7);
-            res = _mm_adds_epi16(_mm_mulhi_epi16(col, coeff), res);
-         }
+   for (w = 0; w < ctx->out_width; w++, filter_horiz += ctx->horiz.filter_stride)
+   {
+      __m128i res = scaler_argb8888_horiz_sse2(ctx, _mm_setzero_si128(),
+            filter_horiz, input + ctx->horiz.filter_pos[w], 0);
+
+      _mm_storel_epi64((__m128i*)(output + w), res);
+   }
+}
+
+#if defined(SCALER_RUNTIME_AVX2)
+SCALER_TARGET("avx2") void scaler_argb8888_horiz_avx2(
+      const struct scaler_ctx *ctx, uint64_t *output, const uint32_t *input)
+{
+   int w, x;
+   const int16_t *filter_horiz = ctx->horiz.filter;
 
-         res       = _mm_adds_epi16(_mm_srli_si128(res, 8), res);
+   for (w = 0; w < ctx->out_width; w++, filter_horiz += ctx->horiz.filter_stride)
+   {
+      __m128i res = _mm_setzero_si128();
+
+      const uint32_t *input_base_x = input + ctx->horiz.filter_pos[w];
 
-#ifdef __x86_64__
-         output[w] = _mm_cvtsi128_si64(res);
-#else // 32-bit doesn't have si64. Do it in two steps.
-         union
+      x = 0;
+
+      if (ctx->horiz.filter_len >= 4)
+      {
+         __m256i res256 = _mm256_setzero_si256();
+
+         for (; (x + 3) < ctx->horiz.filter_len; x += 4)
          {
-            uint32_t *u32;
-            uint64_t *u64;
-         } u;
-         u.u64 = output + w;
-         u.u32[0] = _mm_cvtsi128_si32(res);
-         u.u32[1] = _mm_cvtsi128_si32(_mm_srli_si128(res, 4));
+            __m256i coeff = _mm256_set_epi64x(
+                  build_coeff64(filter_horiz[x + 3]), build_coeff64(filter_horiz[x + 2]),
+                  build_coeff64(filter_horiz[x + 1]), build_coeff64(filter_horiz[x + 0]));
+            __m256i col   = _mm256_cvtepu8_epi16(
+                  _mm_loadu_si128((const __m128i*)(input_base_x + x)));
+
+            col    = _mm256_slli_epi16(col, 7);
+            res256 = _mm256_adds_epi16(_mm256_mulhi_epi16(col, coeff), res256);
+         }
+
+         res = _mm_adds_epi16(_mm256_castsi256_si128(res256),
+               _mm256_extracti128_si256(res256, 1));
+      }
+
+      res = scaler_argb8888_horiz_sse2(ctx, res,
+            filter_horiz, input_base_x, x);
+
+      _mm_storel_epi64((__m128i*)(output + w), res);
+   }
+}
 #endif
+#elif defined(__ARM_NEON__)
+void scaler_argb8888_horiz(const struct scaler_ctx *ctx,
+      uint64_t *output, const uint32_t *input)
+{
+   int w, x;
+   const int16_t *filter_horiz = ctx->horiz.filter;
+
+   for (w = 0; w < ctx->out_width; w++, filter_horiz += ctx->horiz.filter_stride)
+   {
+      int16x4_t res = vdup_n_s16(0);
+
+      const uint32_t *input_base_x = input + ctx->horiz.filter_pos[w];
+
+      for (x = 0; (x + 1) < ctx->horiz.filter_len; x += 2)
+      {
+         int16x8_t col = vreinterpretq_s16_u16(
+               vshll_n_u8(vld1_u8((const uint8_t*)(input_base_x + x)), 7));
+
+         res = vqadd_s16(vshrn_n_s32(vmull_n_s16(vget_low_s16(col), filter_horiz[x + 0]), 16), res);
+         res = vqadd_s16(vshrn_n_s32(vmull_n_s16(vget_high_s16(col), filter_horiz[x + 1]), 16), res);
       }
+
+      for (; x < ctx->horiz.filter_len; x++)
+      {
+         int16x8_t col = vreinterpretq_s16_u16(
+               vshll_n_u8(vreinterpret_u8_u32(vdup_n_u32(input_base_x[x])), 7));
+
+         res = vqadd_s16(vshrn_n_s32(vmull_n_s16(vget_low_s16(col), filter_horiz[x]), 16), res);
+      }
+
+      vst1_s16((int16_t*)(output + w), res);
    }
 }
 #else
@@ -203,79 +350,49 @@ static inline uint64_t build_argb64(uint16_t a, uint16_t r, uint16_t g, uint16_t
    return ((uint64_t)a << 48) | ((uint64_t)r << 32) | ((uint64_t)g << 16) | ((uint64_t)b << 0);
 }
 
-void scaler_argb8888_horiz(const struct scaler_ctx *ctx, const void *input_, int stride)
+void scaler_argb8888_horiz(const struct scaler_ctx *ctx,
+      uint64_t *output, const uint32_t *input)
 {
-   int h, w, x;
-   const uint32_t *input = (uint32_t*)input_;
-   uint64_t *output      = ctx->scaled.frame;
+   int w, x;
+   const int16_t *filter_horiz = ctx->horiz.filter;
 
-   for (h = 0; h < ctx->scaled.height; h++, input += stride >> 2, output += ctx->scaled.stride >> 3)
+   for (w = 0; w < ctx->out_width; w++, filter_horiz += ctx->horiz.filter_stride)
    {
-      const int16_t *filter_horiz = ctx->horiz.filter;
-
-      for (w = 0; w < ctx->scaled.width; w++, filter_horiz += ctx->horiz.filter_stride)
-      {
-         const uint32_t *input_base_x = input + ctx->horiz.filter_pos[w];
+      const uint32_t *input_base_x = input + ctx->horiz.filter_pos[w];
 
-         int16_t res_a = 0;
-         int16_t res_r = 0;
-         int16_t res_g = 0;
-         int16_t res_b = 0;
+      int16_t res_a = 0;
+      int16_t res_r = 0;
+      int16_t res_g = 0;
+      int16_t res_b = 0;
 
-         for (x = 0; x < ctx->horiz.filter_len; x++)
-         {
-            uint32_t col = input_base_x[x];
-
-            int16_t a = (col >> (24 - 7)) & (0xff << 7);
-            int16_t r = (col >> (16 - 7)) & (0xff << 7);
-            int16_t g = (col >> ( 8 - 7)) & (0xff << 7);
-            int16_t b = (col << ( 0 + 7)) & (0xff << 7);
+      for (x = 0; x < ctx->horiz.filter_len; x++)
+      {
+         uint32_t col = input_base_x[x];
 
-            int16_t coeff = filter_horiz[x];
+         int16_t a = (col >> (24 - 7)) & (0xff << 7);
+         int16_t r = (col >> (16 - 7)) & (0xff << 7);
+         int16_t g = (col >> ( 8 - 7)) & (0xff << 7);
+         int16_t b = (col << ( 0 + 7)) & (0xff << 7);
 
-            res_a += (a * coeff) >> 16;
-            res_r += (r * coeff) >> 16;
-            res_g += (g * coeff) >> 16;
-            res_b += (b * coeff) >> 16;
-         }
+         int16_t coeff = filter_horiz[x];
 
-         output[w] = build_argb64(res_a, res_r, res_g, res_b);
+         res_a += (a * coeff) >> 16;
+         res_r += (r * coeff) >> 16;
+         res_g += (g * coeff) >> 16;
+         res_b += (b * coeff) >> 16;
       }
+
+      output[w] = build_argb64(res_a, res_r, res_g, res_b);
    }
 }
 #endif
 
 void scaler_argb8888_point_special(const struct scaler_ctx *ctx,
-      void *output_, const void *input_,
-      int out_width, int out_height,
-      int in_width, int in_height,
-      int out_stride, int in_stride)
+      uint32_t *output, const uint32_t *input)
 {
-   const uint32_t *input = NULL;
-   uint32_t *output      = NULL;
-   int h, w;
-   int x_pos  = (1 << 15) * in_width / out_width - (1 << 15);
-   int x_step = (1 << 16) * in_width / out_width;
-   int y_pos  = (1 << 15) * in_height / out_height - (1 << 15);
-   int y_step = (1 << 16) * in_height / out_height;
-
-   (void)ctx;
+   int w;
+   const int *filter_pos = ctx->horiz.filter_pos;
 
-   if (x_pos < 0)
-      x_pos = 0;
-   if (y_pos < 0)
-      y_pos = 0;
-
-   input = (const uint32_t*)input_;
-   output = (uint32_t*)output_;
-
-   for (h = 0; h < out_height; h++, y_pos += y_step, output += out_stride >> 2)
-   {
-      int x = x_pos;
-      const uint32_t *inp = input + (y_pos >> 16) * (in_stride >> 2);
-
-      for (w = 0; w < out_width; w++, x += x_step)
-         output[w] = inp[x >> 16];
-   }
+   for (w = 0; w < ctx->out_width; w++)
+      output[w] = input[filter_pos[w]];
 }
-
@@ -60,6 +60,30 @@ struct png_ihdr
    uint8_t interlace;
 };
 
+enum rpng_process_status
+{
+   RPNG_PROCESS_ERROR = -1,
+   RPNG_PROCESS_NEXT  = 0,
+   RPNG_PROCESS_END   = 1
+};
+
+struct rpng_process_t
+{
+   bool initialized;
+   /* Current Adam7 pass, 0 for non-interlaced images. */
+   unsigned pass;
+   unsigned pass_width;
+   unsigned pass_height;
+   unsigned h;
+   unsigned bpp;
+   unsigned pitch;
+   uint8_t *inflate_scanline;
+   uint8_t *prev_scanline;
+   uint8_t *decoded_scanline;
+   uint32_t *pass_line;
+   void *stream;
+};
+
 struct rpng_t
 {
    bool has_ihdr;
@@ -73,6 +97,7 @@ struct rpng_t
    uint8_t *buff_data;
    uint32_t palette[256];
    struct png_chunk chunk;
+   struct rpng_process_t process;
 };
 
 bool rpng_load_image_argb(const char *path, uint32_t **data,
@@ -88,13 +113,30 @@ bool rpng_nbio_load_image_argb_iterate(uint8_t *buf,
 bool rpng_nbio_load_image_argb_process(struct rpng_t *rpng,
       uint32_t **data, unsigned *width, unsigned *height);
 
+int rpng_nbio_load_image_argb_process_iterate(struct rpng_t *rpng,
+      uint32_t **data, unsigned *width, unsigned *height,
+      unsigned max_rows);
+
 bool rpng_nbio_load_image_argb_start(struct rpng_t *rpng);
 
 #ifdef HAVE_ZLIB_DEFLATE
+#define RPNG_ENCODE_MAX_THREADS 8
+
 bool rpng_save_image_argb(const char *path, const uint32_t *data,
       unsigned width, unsigned height, unsigned pitch);
 bool rpng_save_image_bgr24(const char *path, const uint8_t *data,
       unsigned width, unsigned height, unsigned pitch);
+
+/**
+ * rpng_save_image_bgr24_ext:
+ * @compression       : zlib compression level (0-9). Lower levels
+ *                      also try fewer PNG filters per line.
+ * @threads           : number of threads to filter lines on,
+ *                      only used with HAVE_THREADS.
+ **/
+bool rpng_save_image_bgr24_ext(const char *path, const uint8_t *data,
+      unsigned width, unsigned height, unsigned pitch,
+      int compression, unsigned threads);
 #endif
 
 #ifdef __cplusplus
@@ -25,6 +25,30 @@
 
 #include <clamping.h>
 
+/* Same bit layout as RETRO_SIMD_* in libretro.h. */
+#define PIXCONV_SIMD_SSE      (1 << 0)
+#define PIXCONV_SIMD_SSE2     (1 << 1)
+#define PIXCONV_SIMD_AVX      (1 << 4)
+#define PIXCONV_SIMD_NEON     (1 << 5)
+#define PIXCONV_SIMD_SSE3     (1 << 6)
+#define PIXCONV_SIMD_SSSE3    (1 << 7)
+#define PIXCONV_SIMD_SSE4     (1 << 10)
+#define PIXCONV_SIMD_SSE42    (1 << 11)
+#define PIXCONV_SIMD_AVX2     (1 << 12)
+
+typedef unsigned pixconv_simd_mask_t;
+
+/**
+ * conv_init_simd:
+ * @simd                 : Mask of SIMD features the CPU supports.
+ *
+ * Picks the fastest line converters for the CPU.
+ * Until called, converters only use the SIMD instructions
+ * the compiler targets by default. Passing 0 selects
+ * the plain C converters.
+ **/
+void conv_init_simd(pixconv_simd_mask_t simd);
+
 void conv_0rgb1555_argb8888(void *output, const void *input,
       int width, int height,
       int out_stride, int in_stride);
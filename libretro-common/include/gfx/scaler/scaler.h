@@ -34,6 +34,12 @@ extern "C" {
 
 #define FILTER_UNITY (1 << 14)
 
+/* Upper bound for scaler_ctx::threads. */
+#define SCALER_MAX_THREADS 8
+
+/* Smallest amount of output rows worth handing to a thread of its own. */
+#define SCALER_MIN_BAND_ROWS 32
+
 enum scaler_pix_fmt
 {
    SCALER_FMT_ARGB8888 = 0,
@@ -50,7 +56,9 @@ enum scaler_type
    SCALER_TYPE_UNKNOWN = 0,
    SCALER_TYPE_POINT,
    SCALER_TYPE_BILINEAR,
-   SCALER_TYPE_SINC
+   SCALER_TYPE_SINC,
+   SCALER_TYPE_BICUBIC,
+   SCALER_TYPE_LANCZOS
 };
 
 struct scaler_filter
@@ -61,6 +69,9 @@ struct scaler_filter
    int *filter_pos;
 };
 
+struct scaler_band;
+struct scaler_pool;
+
 struct scaler_ctx
 {
    int in_width;
@@ -75,12 +86,17 @@ struct scaler_ctx
    enum scaler_pix_fmt out_fmt;
    enum scaler_type scaler_type;
 
+   /* Amount of threads scaler_ctx_scale() may split the output rows
+    * over. 0 or 1 scales on the calling thread only. */
+   unsigned threads;
+
+   /* Scalers work on a single line at a time. */
    void (*scaler_horiz)(const struct scaler_ctx*,
-         const void*, int);
+         uint64_t*, const uint32_t*);
    void (*scaler_vert)(const struct scaler_ctx*,
-         void*, int);
+         uint32_t*, const uint64_t * const*, const int16_t*);
    void (*scaler_special)(const struct scaler_ctx*,
-         void*, const void*, int, int, int, int, int, int);
+         uint32_t*, const uint32_t*);
 
    void (*in_pixconv)(void*, const void*, int, int, int, int);
    void (*out_pixconv)(void*, const void*, int, int, int, int);
@@ -108,8 +124,27 @@ struct scaler_ctx
       uint32_t *frame;
       int stride;
    } output;
+
+   /* Output is processed in horizontal bands of rows.
+    * Every band owns one line of input.frame and output.frame,
+    * and a ring of scaled.height horizontally filtered lines
+    * in scaled.frame. */
+   struct scaler_band *bands;
+   unsigned num_bands;
+   struct scaler_pool *pool;
 };
 
+/**
+ * scaler_init_simd:
+ * @simd         : Mask of SIMD features the CPU supports,
+ *                 as PIXCONV_SIMD_* bits.
+ *
+ * Picks the fastest scalers for the CPU in contexts generated
+ * from now on. Until called, scalers only use the SIMD
+ * instructions the compiler targets by default.
+ **/
+void scaler_init_simd(unsigned simd);
+
 bool scaler_ctx_gen_filter(struct scaler_ctx *ctx);
 
 void scaler_ctx_gen_reset(struct scaler_ctx *ctx);
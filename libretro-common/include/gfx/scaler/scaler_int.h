@@ -25,17 +25,58 @@
 
 #include <gfx/scaler/scaler.h>
 
+/* AVX2 scalers are compiled with per-function target
+ * attributes and only picked at runtime, see scaler_init_simd(). */
+#if defined(__SSE2__) && !defined(SCALER_NO_SIMD) && (defined(__clang__) || \
+      (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+#define SCALER_RUNTIME_AVX2
+#define SCALER_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+/**
+ * scaler_argb8888_vert:
+ * @ctx          : pointer to scaler context object.
+ * @output       : output line, ctx->out_width pixels.
+ * @lines        : ctx->vert.filter_len horizontally scaled lines.
+ * @filter       : vertical filter taps of this output line.
+ *
+ * Vertically filters one output line.
+ **/
 void scaler_argb8888_vert(const struct scaler_ctx *ctx,
-      void *output, int stride);
+      uint32_t *output, const uint64_t * const *lines,
+      const int16_t *filter);
 
+/**
+ * scaler_argb8888_horiz:
+ * @ctx          : pointer to scaler context object.
+ * @output       : scaled line, ctx->out_width 16-bit/channel pixels.
+ * @input        : input line, ctx->in_width pixels.
+ *
+ * Horizontally filters one input line.
+ **/
 void scaler_argb8888_horiz(const struct scaler_ctx *ctx,
-      const void *input, int stride);
+      uint64_t *output, const uint32_t *input);
 
+#ifdef SCALER_RUNTIME_AVX2
+void scaler_argb8888_vert_avx2(const struct scaler_ctx *ctx,
+      uint32_t *output, const uint64_t * const *lines,
+      const int16_t *filter);
+
+void scaler_argb8888_horiz_avx2(const struct scaler_ctx *ctx,
+      uint64_t *output, const uint32_t *input);
+#endif
+
+/**
+ * scaler_argb8888_point_special:
+ * @ctx          : pointer to scaler context object.
+ * @output       : output line, ctx->out_width pixels.
+ * @input        : input line, ctx->in_width pixels.
+ *
+ * Point samples one line. The source line is picked
+ * by the caller through ctx->vert.filter_pos.
+ **/
 void scaler_argb8888_point_special(const struct scaler_ctx *ctx,
-      void *output, const void *input,
-      int out_width, int out_height,
-      int in_width, int in_height,
-      int out_stride, int in_stride);
+      uint32_t *output, const uint32_t *input);
 
 #endif
 
@@ -73,6 +73,14 @@
 #define GL_MAP_INVALIDATE_BUFFER_BIT 0x0008
 #endif
 
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+
 #ifndef GL_RED_INTEGER
 #define GL_RED_INTEGER 0x8D94
 #endif
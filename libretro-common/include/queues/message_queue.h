@@ -51,7 +51,9 @@ msg_queue_t *msg_queue_new(size_t size);
  *                      before it vanishes (E.g. show a message for
  *                      3 seconds @ 60fps = 180 duration).
  *
- * Push a new message onto the queue.
+ * Push a new message onto the queue. Safe to call from any
+ * thread, never blocks or allocates. The message is dropped
+ * if the queue is full.
  **/
 void msg_queue_push(msg_queue_t *queue, const char *msg,
       unsigned prio, unsigned duration);
@@ -61,6 +63,7 @@ void msg_queue_push(msg_queue_t *queue, const char *msg,
  * @queue             : pointer to queue object
  *
  * Pulls highest priority message in queue.
+ * Must only be called from a single consumer thread.
  *
  * Returns: NULL if no message in queue, otherwise a string
  * containing the message.
@@ -71,7 +74,8 @@ const char *msg_queue_pull(msg_queue_t *queue);
  * msg_queue_clear:
  * @queue             : pointer to queue object
  *
- * Clears out everything in the queue.
+ * Clears out everything in the queue. Safe to call from any
+ * thread; messages pushed after this call are kept.
  **/
 void msg_queue_clear(msg_queue_t *queue);
 
@@ -24,23 +24,183 @@
 #include <string.h>
 #include <boolean.h>
 #include <queues/message_queue.h>
-#include <compat/posix_string.h>
 
-struct queue_elem
+#if defined(_MSC_VER) && !defined(_XBOX)
+#include <windows.h>
+#endif
+
+/* Messages are stored in a fixed pool of slots. Any thread may
+ * push (lock-free, multi-producer); pull, free and the deferred
+ * part of clear happen on a single consumer thread, which merges
+ * published slots into a priority heap it owns. */
+
+#if defined(__GNUC__)
+#define MSG_ATOMIC_CAS(ptr, old_val, new_val) \
+   __sync_bool_compare_and_swap((ptr), (old_val), (new_val))
+#define MSG_ATOMIC_INC(ptr) __sync_fetch_and_add((ptr), 1)
+#define MSG_BARRIER() __sync_synchronize()
+#elif defined(_MSC_VER) && !defined(_XBOX)
+#define MSG_ATOMIC_CAS(ptr, old_val, new_val) \
+   (InterlockedCompareExchange((volatile LONG*)(ptr), \
+      (new_val), (old_val)) == (old_val))
+#define MSG_ATOMIC_INC(ptr) (InterlockedIncrement((volatile LONG*)(ptr)) - 1)
+#define MSG_BARRIER() MemoryBarrier()
+#else
+/* No atomics available, queue is only safe to use from one thread. */
+#define MSG_ATOMIC_CAS(ptr, old_val, new_val) \
+   ((*(ptr) == (old_val)) ? (*(ptr) = (new_val), true) : false)
+#define MSG_ATOMIC_INC(ptr) ((*(ptr))++)
+#define MSG_BARRIER()
+#endif
+
+#define MSG_QUEUE_MAX_MSG_LENGTH 1024
+
+enum queue_slot_state
+{
+   SLOT_FREE = 0,
+   SLOT_WRITING,
+   SLOT_READY,
+   SLOT_OWNED
+};
+
+struct queue_slot
 {
+   volatile int state;
+   int epoch;
+   int seq;
    unsigned duration;
    unsigned prio;
-   char *msg;
+   char msg[MSG_QUEUE_MAX_MSG_LENGTH];
 };
 
 struct msg_queue
 {
-   struct queue_elem **elems;
-   size_t ptr;
+   struct queue_slot *slots;
    size_t size;
-   char *tmp_msg;
+
+   /* Bumped by msg_queue_clear(). Messages pushed under an older
+    * epoch are dropped by the consumer. */
+   volatile int epoch;
+   volatile int seq;
+
+   /* Consumer-owned priority heap of slot indices. */
+   size_t *heap;
+   size_t heap_size;
+
+   char tmp_msg[MSG_QUEUE_MAX_MSG_LENGTH];
 };
 
+static bool msg_queue_higher(const msg_queue_t *queue, size_t a, size_t b)
+{
+   const struct queue_slot *slot_a = &queue->slots[queue->heap[a]];
+   const struct queue_slot *slot_b = &queue->slots[queue->heap[b]];
+
+   if (slot_a->prio != slot_b->prio)
+      return slot_a->prio > slot_b->prio;
+   /* Equal priority, first pushed comes first. */
+   return (slot_a->seq - slot_b->seq) < 0;
+}
+
+static void msg_queue_swap(msg_queue_t *queue, size_t a, size_t b)
+{
+   size_t tmp     = queue->heap[a];
+   queue->heap[a] = queue->heap[b];
+   queue->heap[b] = tmp;
+}
+
+static void msg_queue_sift_up(msg_queue_t *queue, size_t i)
+{
+   while (i > 0 && msg_queue_higher(queue, i, (i - 1) >> 1))
+   {
+      msg_queue_swap(queue, i, (i - 1) >> 1);
+      i = (i - 1) >> 1;
+   }
+}
+
+static void msg_queue_sift_down(msg_queue_t *queue, size_t i)
+{
+   for (;;)
+   {
+      size_t best  = i;
+      size_t left  = 2 * i + 1;
+      size_t right = 2 * i + 2;
+
+      if (left < queue->heap_size && msg_queue_higher(queue, left, best))
+         best = left;
+      if (right < queue->heap_size && msg_queue_higher(queue, right, best))
+         best = right;
+      if (best == i)
+         break;
+
+      msg_queue_swap(queue, i, best);
+      i = best;
+   }
+}
+
+/* Pushed before the clear that bumped the epoch to @epoch.
+ * Messages from a later clear than the one seen are kept. */
+static bool msg_queue_cleared(const struct queue_slot *slot, int epoch)
+{
+   return (int)((unsigned)slot->epoch - (unsigned)epoch) < 0;
+}
+
+static void msg_queue_release(msg_queue_t *queue, size_t idx)
+{
+   MSG_ATOMIC_CAS(&queue->slots[idx].state, SLOT_OWNED, SLOT_FREE);
+}
+
+/**
+ * msg_queue_collect:
+ * @queue             : pointer to queue object
+ *
+ * Consumer side. Takes ownership of newly published messages,
+ * merges them into the priority heap and drops messages which
+ * were cleared.
+ **/
+static void msg_queue_collect(msg_queue_t *queue)
+{
+   size_t i, j;
+   int epoch = queue->epoch;
+
+   MSG_BARRIER();
+
+   /* Drop cleared messages from the heap. */
+   for (i = 0, j = 0; i < queue->heap_size; i++)
+   {
+      size_t idx = queue->heap[i];
+
+      if (msg_queue_cleared(&queue->slots[idx], epoch))
+         msg_queue_release(queue, idx);
+      else
+         queue->heap[j++] = idx;
+   }
+
+   if (j != queue->heap_size)
+   {
+      queue->heap_size = j;
+      for (i = queue->heap_size / 2; i-- > 0; )
+         msg_queue_sift_down(queue, i);
+   }
+
+   for (i = 0; i < queue->size; i++)
+   {
+      struct queue_slot *slot = &queue->slots[i];
+
+      if (slot->state != SLOT_READY
+            || !MSG_ATOMIC_CAS(&slot->state, SLOT_READY, SLOT_OWNED))
+         continue;
+
+      if (msg_queue_cleared(slot, epoch))
+      {
+         msg_queue_release(queue, i);
+         continue;
+      }
+
+      queue->heap[queue->heap_size] = i;
+      msg_queue_sift_up(queue, queue->heap_size++);
+   }
+}
+
 /**
  * msg_queue_new:
  * @size              : maximum size of message
@@ -56,16 +216,15 @@ msg_queue_t *msg_queue_new(size_t size)
    if (!queue)
       return NULL;
 
-   queue->size = size + 1;
-   queue->elems = (struct queue_elem**)
-      calloc(queue->size,sizeof(struct queue_elem*)); 
+   queue->size  = size;
+   queue->slots = (struct queue_slot*)calloc(size, sizeof(*queue->slots));
+   queue->heap  = (size_t*)calloc(size, sizeof(*queue->heap));
 
-   if (!queue->elems)
+   if (!queue->slots || !queue->heap)
    {
-      free(queue);
+      msg_queue_free(queue);
       return NULL;
    }
-   queue->ptr = 1;
 
    return queue;
 }
@@ -80,8 +239,8 @@ void msg_queue_free(msg_queue_t *queue)
 {
    if (queue)
    {
-      msg_queue_clear(queue);
-      free(queue->elems);
+      free(queue->slots);
+      free(queue->heap);
    }
    free(queue);
 }
@@ -95,40 +254,36 @@ void msg_queue_free(msg_queue_t *queue)
  *                      before it vanishes (E.g. show a message for
  *                      3 seconds @ 60fps = 180 duration).
  *
- * Push a new message onto the queue.
+ * Push a new message onto the queue. Safe to call from any
+ * thread, never blocks or allocates. The message is dropped
+ * if the queue is full.
  **/
 void msg_queue_push(msg_queue_t *queue, const char *msg,
       unsigned prio, unsigned duration)
 {
-   size_t tmp_ptr = 0;
-   struct queue_elem *new_elem = NULL;
-
-   if (!queue || queue->ptr >= queue->size)
-      return;
+   size_t i;
 
-   new_elem = (struct queue_elem*)calloc(1, sizeof(struct queue_elem));
-   if (!new_elem)
+   if (!queue || !msg)
       return;
 
-   new_elem->prio = prio;
-   new_elem->duration = duration;
-   new_elem->msg = msg ? strdup(msg) : NULL;
-
-   queue->elems[queue->ptr] = new_elem;
-   tmp_ptr = queue->ptr++;
-
-   while (tmp_ptr > 1)
+   for (i = 0; i < queue->size; i++)
    {
-      struct queue_elem *parent = queue->elems[tmp_ptr >> 1];
-      struct queue_elem *child  = queue->elems[tmp_ptr];
+      struct queue_slot *slot = &queue->slots[i];
 
-      if (child->prio <= parent->prio)
-         break;
+      if (slot->state != SLOT_FREE
+            || !MSG_ATOMIC_CAS(&slot->state, SLOT_FREE, SLOT_WRITING))
+         continue;
 
-      queue->elems[tmp_ptr >> 1] = child;
-      queue->elems[tmp_ptr] = parent;
+      slot->prio     = prio;
+      slot->duration = duration;
+      slot->seq      = MSG_ATOMIC_INC(&queue->seq);
+      slot->epoch    = queue->epoch;
+      strncpy(slot->msg, msg, sizeof(slot->msg) - 1);
+      slot->msg[sizeof(slot->msg) - 1] = '\0';
 
-      tmp_ptr >>= 1;
+      /* Publish the message to the consumer. */
+      MSG_ATOMIC_CAS(&slot->state, SLOT_WRITING, SLOT_READY);
+      return;
    }
 }
 
@@ -136,27 +291,15 @@ void msg_queue_push(msg_queue_t *queue, const char *msg,
  * msg_queue_clear:
  * @queue             : pointer to queue object
  *
- * Clears out everything in the queue.
+ * Clears out everything in the queue. Safe to call from any
+ * thread; messages pushed after this call are kept.
  **/
 void msg_queue_clear(msg_queue_t *queue)
 {
-   size_t i;
-
    if (!queue)
       return;
 
-   for (i = 1; i < queue->ptr; i++)
-   {
-      if (queue->elems[i])
-      {
-         free(queue->elems[i]->msg);
-         free(queue->elems[i]);
-         queue->elems[i] = NULL;
-      }
-   }
-   queue->ptr = 1;
-   free(queue->tmp_msg);
-   queue->tmp_msg = NULL;
+   MSG_ATOMIC_INC(&queue->epoch);
 }
 
 /**
@@ -164,68 +307,41 @@ void msg_queue_clear(msg_queue_t *queue)
  * @queue             : pointer to queue object
  *
  * Pulls highest priority message in queue.
+ * Must only be called from a single consumer thread.
  *
  * Returns: NULL if no message in queue, otherwise a string
  * containing the message.
  **/
 const char *msg_queue_pull(msg_queue_t *queue)
 {
-   struct queue_elem *front  = NULL, *last = NULL,
-                     *parent = NULL, *child = NULL;
-   size_t tmp_ptr = 1;
-    
-   (void)parent;
-   (void)child;
-   (void)tmp_ptr;
-    
-   /* Nothing in queue. */
-   if (!queue || queue->ptr == 1)
+   size_t idx;
+   struct queue_slot *front = NULL;
+
+   if (!queue)
       return NULL;
 
-   front = (struct queue_elem*)queue->elems[1];
-   front->duration--;
-   if (front->duration > 0)
-      return front->msg;
+   msg_queue_collect(queue);
 
-   free(queue->tmp_msg);
-   queue->tmp_msg = front->msg;
-   front->msg = NULL;
+   /* Nothing in queue. */
+   if (!queue->heap_size)
+      return NULL;
 
-   front = (struct queue_elem*)queue->elems[1];
-   last  = (struct queue_elem*)queue->elems[--queue->ptr];
-   queue->elems[1] = last;
-   free(front);
+   idx   = queue->heap[0];
+   front = &queue->slots[idx];
 
-   for (;;)
+   if (front->duration > 1)
    {
-      size_t switch_index = tmp_ptr;
-      bool left = (tmp_ptr * 2 <= queue->ptr)
-         && (queue->elems[tmp_ptr] < queue->elems[tmp_ptr * 2]);
-      bool right = (tmp_ptr * 2 + 1 <= queue->ptr)
-         && (queue->elems[tmp_ptr] < queue->elems[tmp_ptr * 2 + 1]);
-
-      if (!left && !right)
-         break;
+      front->duration--;
+      return front->msg;
+   }
 
-      if (left && !right)
-         switch_index <<= 1;
-      else if (right && !left)
-         switch_index += switch_index + 1;
-      else
-      {
-         if (queue->elems[tmp_ptr * 2]
-               >= queue->elems[tmp_ptr * 2 + 1])
-            switch_index <<= 1;
-         else
-            switch_index += switch_index + 1;
-      }
+   /* Last time this message is shown. Keep a copy around so
+    * the slot can be reused right away. */
+   memcpy(queue->tmp_msg, front->msg, sizeof(queue->tmp_msg));
 
-      parent = (struct queue_elem*)queue->elems[tmp_ptr];
-      child  = (struct queue_elem*)queue->elems[switch_index];
-      queue->elems[tmp_ptr] = child;
-      queue->elems[switch_index] = parent;
-      tmp_ptr = switch_index;
-   }
+   queue->heap[0] = queue->heap[--queue->heap_size];
+   msg_queue_sift_down(queue, 0);
+   msg_queue_release(queue, idx);
 
    return queue->tmp_msg;
 }
@@ -1,5 +1,9 @@
 #include "libretrodb.h"
 
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
 #include <sys/types.h>
 #ifdef _WIN32
 #include <direct.h>
@@ -11,6 +15,9 @@
 #include <sys/stat.h>
 #include <stdlib.h>
 #include <fcntl.h>
+#ifdef HAVE_MMAP
+#include <sys/mman.h>
+#endif
 
 #include <stdio.h>
 
@@ -26,12 +33,36 @@ struct node_iter_ctx
 	libretrodb_index_t *idx;
 };
 
-static struct rmsgpack_dom_value sentinal;
+struct libretrodb_hash_node
+{
+   uint64_t offset;
+   /* Next record with the same key, 0 for none. */
+   uint32_t next;
+};
 
-static int libretrodb_read_metadata(int fd, libretrodb_metadata_t *md)
+struct libretrodb_hash_entry
 {
-   return rmsgpack_dom_read_into(fd, "count", &md->count, NULL);
-}
+   /* Records with the key, in file order. Nodes are
+    * numbered from 1, so 0 marks an empty slot. */
+   uint32_t head;
+   uint32_t tail;
+   uint32_t hash;
+};
+
+/* Open addressing with linear probing, one slot per distinct key.
+ * Keys are not stored, they are compared against the records,
+ * which are in memory anyway. */
+struct libretrodb_hash_index
+{
+   char *field_name;
+   struct libretrodb_hash_entry *entries;
+   size_t mask;
+   struct libretrodb_hash_node *nodes;
+   size_t node_count;
+   struct libretrodb_hash_index *next;
+};
+
+static struct rmsgpack_dom_value sentinal;
 
 static int libretrodb_write_metadata(int fd, libretrodb_metadata_t *md)
 {
@@ -119,92 +150,287 @@ clean:
    return rv;
 }
 
-static int libretrodb_read_index_header(int fd, libretrodb_index_t *idx)
-{
-   uint64_t name_len = 50;
-   return rmsgpack_dom_read_into(fd,
-         "name", idx->name, &name_len,
-         "key_size", &idx->key_size,
-         "next", &idx->next, NULL);
-}
 
 static void libretrodb_write_index_header(int fd, libretrodb_index_t * idx)
 {
-	rmsgpack_write_map_header(fd, 3);
+	rmsgpack_write_map_header(fd, 4);
 	rmsgpack_write_string(fd, "name", strlen("name"));
 	rmsgpack_write_string(fd, idx->name, strlen(idx->name));
+	rmsgpack_write_string(fd, "field", strlen("field"));
+	rmsgpack_write_string(fd, idx->field, strlen(idx->field));
 	rmsgpack_write_string(fd, "key_size", strlen("key_size"));
 	rmsgpack_write_uint(fd, idx->key_size);
 	rmsgpack_write_string(fd, "next", strlen("next"));
 	rmsgpack_write_uint(fd, idx->next);
 }
 
-void libretrodb_close(libretrodb_t *db)
+static void libretrodb_unmap(libretrodb_t *db)
 {
-	close(db->fd);
-	db->fd = -1;
+#ifdef HAVE_MMAP
+   if (db->mapped)
+      munmap((void*)db->data, db->size);
+   else
+#endif
+      free((void*)db->data);
+
+   free(db->disk_indexes);
+
+   db->data             = NULL;
+   db->size             = 0;
+   db->mapped           = 0;
+   db->disk_indexes     = NULL;
+   db->disk_index_count = 0;
 }
 
-int libretrodb_open(const char *path, libretrodb_t *db)
+static int libretrodb_read_all(int fd, uint8_t *buf, uint64_t size)
+{
+   uint64_t nread = 0;
+
+   if (lseek(fd, 0, SEEK_SET) == -1)
+      return -errno;
+
+   while (nread < size)
+   {
+      ssize_t rv = read(fd, buf + nread, size - nread);
+
+      if (rv <= 0)
+         return rv < 0 ? -errno : -EINVAL;
+      nread += rv;
+   }
+
+   return 0;
+}
+
+/**
+ * libretrodb_load_indexes:
+ * @db                  : Handle to database.
+ *
+ * Walks the index headers following the metadata and
+ * keeps track of where the tables are. A truncated index
+ * ends the list.
+ **/
+static void libretrodb_load_indexes(libretrodb_t *db)
 {
+   size_t cap = 0;
+   size_t pos = db->first_index_offset;
+
+   while (pos < db->size)
+   {
+      struct rmsgpack_dom_value item, key, *value;
+      libretrodb_disk_index_t idx = {};
+      const char *fields[]        = { "name", "key_size", "next" };
+      unsigned i;
+
+      if (rmsgpack_dom_read_buf(db->data, db->size, &pos, &item) < 0)
+         return;
+
+      for (i = 0; i < 3; i++)
+      {
+         key.type        = RDT_STRING;
+         key.string.len  = strlen(fields[i]);
+         key.string.buff = (char*)fields[i];
+
+         value = rmsgpack_dom_value_map_value(&item, &key);
+         if (!value)
+            break;
+
+         if (i == 0)
+         {
+            if (value->type != RDT_STRING)
+               break;
+            strncpy(idx.header.name, value->string.buff,
+                  sizeof(idx.header.name) - 1);
+         }
+         else if (value->type == RDT_UINT || value->type == RDT_INT)
+         {
+            if (i == 1)
+               idx.header.key_size = value->uint_;
+            else
+               idx.header.next     = value->uint_;
+         }
+         else
+            break;
+      }
+
+      /* Optional, older indexes only have a name. */
+      key.type        = RDT_STRING;
+      key.string.len  = strlen("field");
+      key.string.buff = (char*)"field";
+
+      value = rmsgpack_dom_value_map_value(&item, &key);
+      if (value && value->type == RDT_STRING)
+         strncpy(idx.header.field, value->string.buff,
+               sizeof(idx.header.field) - 1);
+
+      rmsgpack_dom_value_free(&item);
+
+      if (i < 3 || !idx.header.key_size ||
+            idx.header.next > db->size - pos)
+         return;
+
+      idx.table = pos;
+      idx.count = idx.header.next /
+         (idx.header.key_size + sizeof(uint64_t));
+      pos      += idx.header.next;
+
+      if (db->disk_index_count == cap)
+      {
+         libretrodb_disk_index_t *indexes = NULL;
+
+         cap     = cap ? cap * 2 : 4;
+         indexes = (libretrodb_disk_index_t*)realloc(db->disk_indexes,
+               cap * sizeof(*indexes));
+         if (!indexes)
+            return;
+         db->disk_indexes = indexes;
+      }
+
+      db->disk_indexes[db->disk_index_count++] = idx;
+   }
+}
+
+/**
+ * libretrodb_map:
+ * @db                  : Handle to database.
+ *
+ * Maps the database file, or reads it whole where mapping
+ * is unavailable, then loads the metadata and indexes.
+ *
+ * Returns: 0 if successful, otherwise negative.
+ **/
+static int libretrodb_map(libretrodb_t *db)
+{
+   struct stat st;
    libretrodb_header_t header;
-   libretrodb_metadata_t md;
+   struct rmsgpack_dom_value md, key, *count;
+   size_t pos;
    int rv;
-   int fd = open(path, O_RDWR);
 
-   if (fd == -1)
+   if (fstat(db->fd, &st) == -1)
       return -errno;
 
-   strcpy(db->path, path);
-   db->root = lseek(fd, 0, SEEK_CUR);
+   if ((uint64_t)st.st_size < db->root + sizeof(header))
+      return -EINVAL;
 
-   if ((rv = read(fd, &header, sizeof(header))) == -1)
+   db->size = st.st_size;
+
+#ifdef HAVE_MMAP
    {
-      rv = -errno;
-      goto error;
+      void *data = mmap(NULL, db->size, PROT_READ, MAP_PRIVATE, db->fd, 0);
+
+      if (data != MAP_FAILED)
+      {
+         db->data   = (const uint8_t*)data;
+         db->mapped = 1;
+      }
    }
+#endif
 
-   if (strncmp(header.magic_number, MAGIC_NUMBER, sizeof(MAGIC_NUMBER)) != 0)
+   if (!db->data)
    {
-      rv = -EINVAL;
-      goto error;
+      uint8_t *data = (uint8_t*)malloc(db->size);
+
+      if (!data)
+         return -ENOMEM;
+
+      db->data = data;
+
+      if ((rv = libretrodb_read_all(db->fd, data, db->size)) < 0)
+         return rv;
    }
 
-   header.metadata_offset = betoht64(header.metadata_offset);
-   lseek(fd, header.metadata_offset, SEEK_SET);
+   memcpy(&header, db->data + db->root, sizeof(header));
+
+   if (memcmp(header.magic_number, MAGIC_NUMBER, sizeof(MAGIC_NUMBER)-1) != 0)
+      return -EINVAL;
+
+   pos = betoht64(header.metadata_offset);
+
+   if (rmsgpack_dom_read_buf(db->data, db->size, &pos, &md) < 0)
+      return -EINVAL;
+
+   key.type        = RDT_STRING;
+   key.string.len  = strlen("count");
+   key.string.buff = (char*)"count";
+
+   count = rmsgpack_dom_value_map_value(&md, &key);
+   rv    = (count && (count->type == RDT_UINT || count->type == RDT_INT))
+      ? 0 : -EINVAL;
+
+   if (rv == 0)
+      db->count = count->uint_;
+   rmsgpack_dom_value_free(&md);
+
+   if (rv < 0)
+      return rv;
+
+   db->first_index_offset = pos;
+   libretrodb_load_indexes(db);
+   return 0;
+}
 
-   if (libretrodb_read_metadata(fd, &md) < 0)
+static void libretrodb_free_hash_indexes(libretrodb_t *db)
+{
+   while (db->hash_indexes)
    {
-      rv = -EINVAL;
-      goto error;
+      struct libretrodb_hash_index *next = db->hash_indexes->next;
+
+      free(db->hash_indexes->field_name);
+      free(db->hash_indexes->entries);
+      free(db->hash_indexes->nodes);
+      free(db->hash_indexes);
+      db->hash_indexes = next;
    }
+}
 
-   db->count = md.count;
-   db->first_index_offset = lseek(fd, 0, SEEK_CUR);
-   db->fd = fd;
-   return 0;
-error:
-   close(fd);
-   return rv;
+void libretrodb_close(libretrodb_t *db)
+{
+   libretrodb_free_hash_indexes(db);
+   libretrodb_unmap(db);
+	close(db->fd);
+	db->fd = -1;
 }
 
-static int libretrodb_find_index(libretrodb_t *db, const char *index_name,
-      libretrodb_index_t *idx)
+int libretrodb_open(const char *path, libretrodb_t *db)
 {
-   off_t eof    = lseek(db->fd, 0, SEEK_END);
-   off_t offset = lseek(db->fd, db->first_index_offset, SEEK_SET);
+   int rv;
+   int fd = open(path, O_RDWR);
 
-   while (offset < eof)
+   /* Only creating indexes needs to write. */
+   if (fd == -1)
+      fd = open(path, O_RDONLY);
+
+   if (fd == -1)
+      return -errno;
+
+   memset(db, 0, sizeof(*db));
+   strncpy(db->path, path, sizeof(db->path) - 1);
+   db->fd   = fd;
+   db->root = lseek(fd, 0, SEEK_CUR);
+
+   if ((rv = libretrodb_map(db)) < 0)
    {
-      libretrodb_read_index_header(db->fd, idx);
+      libretrodb_close(db);
+      return rv;
+   }
 
-      if (strncmp(index_name, idx->name, strlen(idx->name)) == 0)
-         return 0;
+   return 0;
+}
+
+static libretrodb_disk_index_t *libretrodb_find_index(libretrodb_t *db,
+      const char *index_name)
+{
+   size_t i;
+
+   for (i = 0; i < db->disk_index_count; i++)
+   {
+      const char *name = db->disk_indexes[i].header.name;
 
-      offset = lseek(db->fd, idx->next, SEEK_CUR);
+      if (strncmp(index_name, name, strlen(name)) == 0)
+         return &db->disk_indexes[i];
    }
 
-   return -1;
+   return NULL;
 }
 
 static int node_compare(const void * a, const void * b, void * ctx)
@@ -215,70 +441,426 @@ static int node_compare(const void * a, const void * b, void * ctx)
 static int binsearch(const void * buff, const void * item,
       uint64_t count, uint8_t field_size, uint64_t * offset)
 {
-   int mid            = count / 2;
-   int item_size      = field_size + sizeof(uint64_t);
-   uint64_t * current = (uint64_t *)buff + (mid * item_size);
-   int rv             = node_compare(current, item, &field_size);
+   int rv;
+   uint64_t mid;
+   const uint8_t * current;
+   size_t item_size = field_size + sizeof(uint64_t);
+
+   if (count == 0)
+      return -1;
+
+   mid     = count / 2;
+   current = (const uint8_t *)buff + (mid * item_size);
+   rv      = node_compare(current, item, &field_size);
 
    if (rv == 0)
    {
-      *offset = *(uint64_t *)(current + field_size);
+      memcpy(offset, current + field_size, sizeof(uint64_t));
       return 0;
    }
 
-   if (count == 0)
-      return -1;
-
    if (rv > 0)
       return binsearch(buff, item, mid, field_size, offset);
 
    return binsearch(current + item_size, item,
-         count - mid, field_size, offset);
+         count - mid - 1, field_size, offset);
+}
+
+int libretrodb_read_entry(libretrodb_t *db, uint64_t offset,
+      struct rmsgpack_dom_value *out)
+{
+   size_t pos = offset;
+
+   if (offset >= db->size)
+      return -EINVAL;
+
+   return rmsgpack_dom_read_buf(db->data, db->size, &pos, out);
+}
+
+/**
+ * libretrodb_seek_field:
+ * @db                  : Handle to database.
+ * @offset              : Offset of the record.
+ * @field_name          : Field to look for.
+ * @pos                 : Offset of the value of the field.
+ *
+ * Walks the keys of a record, skipping over the values
+ * without decoding them.
+ *
+ * Returns: 0 if the field was found, -1 if not,
+ * otherwise negative.
+ **/
+static int libretrodb_seek_field(const libretrodb_t *db, uint64_t offset,
+      const char *field_name, size_t *pos)
+{
+   int rv;
+   uint32_t i, count;
+   struct rmsgpack_token token;
+   size_t name_len = strlen(field_name);
+
+   *pos = offset;
+
+   if ((rv = rmsgpack_read_token(db->data, db->size, pos, &token)) < 0)
+      return rv;
+
+   if (token.type != RMT_MAP)
+      return -1;
+
+   count = token.len;
+
+   for (i = 0; i < count; i++)
+   {
+      if ((rv = rmsgpack_read_token(db->data, db->size, pos, &token)) < 0)
+         return rv;
+
+      if (token.type == RMT_STRING && token.len == name_len &&
+            memcmp(token.buff, field_name, name_len) == 0)
+         return 0;
+
+      if ((rv = rmsgpack_skip(db->data, db->size, pos)) < 0)
+         return rv;
+   }
+
+   return -1;
+}
+
+int libretrodb_read_field(libretrodb_t *db, uint64_t offset,
+      const char *field_name, struct rmsgpack_dom_value *out)
+{
+   int rv;
+   size_t pos;
+
+   if ((rv = libretrodb_seek_field(db, offset, field_name, &pos)) != 0)
+      return rv;
+
+   return rmsgpack_dom_read_buf(db->data, db->size, &pos, out);
 }
 
 int libretrodb_find_entry(libretrodb_t *db, const char *index_name,
         const void *key, struct rmsgpack_dom_value *out)
 {
-   libretrodb_index_t idx;
-   int rv;
-   void * buff;
    uint64_t offset;
-   ssize_t bufflen, nread = 0;
+   libretrodb_disk_index_t *idx = libretrodb_find_index(db, index_name);
+
+   if (!idx)
+      return -1;
+
+   /* The table is in memory already, search it in place. */
+   if (binsearch(db->data + idx->table, key, idx->count,
+            idx->header.key_size, &offset) != 0)
+      return -1;
+
+   return libretrodb_read_entry(db, offset, out);
+}
+
+/* First entry of a sorted index table whose key is not below @key. */
+static uint64_t libretrodb_lower_bound(const libretrodb_disk_index_t *idx,
+      const uint8_t *table, const void *key)
+{
+   uint64_t lo        = 0;
+   uint64_t hi        = idx->count;
+   size_t   key_size  = idx->header.key_size;
+   size_t   item_size = key_size + sizeof(uint64_t);
+
+   while (lo < hi)
+   {
+      uint64_t mid = lo + (hi - lo) / 2;
+
+      if (memcmp(table + mid * item_size, key, key_size) < 0)
+         lo = mid + 1;
+      else
+         hi = mid;
+   }
+
+   return lo;
+}
+
+int libretrodb_find_range(libretrodb_t *db, const char *field_name,
+      const void *lo, const void *hi, size_t len,
+      uint64_t *offsets, size_t max)
+{
+   size_t i;
+   int found = 0;
+   const uint8_t *table;
+   size_t item_size;
+   libretrodb_disk_index_t *idx = NULL;
 
-   if (libretrodb_find_index(db, index_name, &idx) < 0)
+   for (i = 0; i < db->disk_index_count && !idx; i++)
+   {
+      if (!strcmp(db->disk_indexes[i].header.field, field_name))
+         idx = &db->disk_indexes[i];
+   }
+
+   if (!idx || idx->header.key_size != len)
       return -1;
 
-   bufflen = idx.next;
-   buff = malloc(bufflen);
+   table     = db->data + idx->table;
+   item_size = len + sizeof(uint64_t);
+
+   for (i = libretrodb_lower_bound(idx, table, lo); i < idx->count; i++)
+   {
+      const uint8_t *item = table + i * item_size;
+
+      if (memcmp(item, hi, len) > 0)
+         break;
+
+      if ((size_t)found < max)
+         memcpy(&offsets[found], item + len, sizeof(uint64_t));
+      found++;
+   }
+
+   return found;
+}
+
+/* FNV-1a */
+static uint32_t libretrodb_hash(const void *data, size_t len)
+{
+   size_t i;
+   const uint8_t *bytes = (const uint8_t*)data;
+   uint32_t hash        = 0x811c9dc5;
+
+   for (i = 0; i < len; i++)
+      hash = (hash ^ bytes[i]) * 0x01000193;
+
+   return hash;
+}
+
+void libretrodb_number_key(uint64_t value,
+      uint8_t key[LIBRETRODB_NUMBER_KEY_SIZE])
+{
+   unsigned i;
+
+   for (i = 0; i < LIBRETRODB_NUMBER_KEY_SIZE; i++)
+      key[i] = value >> (8 * (LIBRETRODB_NUMBER_KEY_SIZE - 1 - i));
+}
+
+/**
+ * libretrodb_field_key:
+ * @db                  : Handle to database.
+ * @offset              : Offset of the record.
+ * @field_name          : Field to look for.
+ * @number              : Scratch space for the key of a number.
+ * @key                 : Key of the field.
+ * @len                 : Size of @key.
+ *
+ * Strings and binaries are keyed by their bytes, pointing
+ * into the database, numbers by libretrodb_number_key().
+ *
+ * Returns: 0 if the record has @field_name as a string,
+ * binary or number, otherwise non-zero.
+ **/
+static int libretrodb_field_key(const libretrodb_t *db, uint64_t offset,
+      const char *field_name, uint8_t *number,
+      const void **key, size_t *len)
+{
+   int rv;
+   size_t pos;
+   struct rmsgpack_token token;
+
+   if ((rv = libretrodb_seek_field(db, offset, field_name, &pos)) != 0)
+      return rv;
+
+   if ((rv = rmsgpack_read_token(db->data, db->size, &pos, &token)) < 0)
+      return rv;
+
+   switch (token.type)
+   {
+      case RMT_STRING:
+      case RMT_BINARY:
+         *key = token.buff;
+         *len = token.len;
+         return 0;
+      case RMT_INT:
+      case RMT_UINT:
+         libretrodb_number_key(token.uint_, number);
+         *key = number;
+         *len = LIBRETRODB_NUMBER_KEY_SIZE;
+         return 0;
+      default:
+         break;
+   }
+
+   return -1;
+}
+
+static int libretrodb_key_equals(const libretrodb_t *db, uint64_t offset,
+      const char *field_name, const void *key, size_t len)
+{
+   size_t entry_len;
+   const void *entry_key;
+   uint8_t number[LIBRETRODB_NUMBER_KEY_SIZE];
+
+   if (libretrodb_field_key(db, offset, field_name,
+            number, &entry_key, &entry_len) != 0)
+      return 0;
 
-   if (!buff)
+   return entry_len == len && memcmp(entry_key, key, len) == 0;
+}
+
+/**
+ * libretrodb_hash_slot:
+ * @db                  : Handle to database.
+ * @index               : Hash index to search.
+ * @key                 : Key to look for.
+ * @len                 : Size of @key.
+ * @hash                : Hash of @key.
+ *
+ * Returns: slot holding @key, or the empty slot where it belongs.
+ **/
+static struct libretrodb_hash_entry *libretrodb_hash_slot(
+      const libretrodb_t *db, const struct libretrodb_hash_index *index,
+      const void *key, size_t len, uint32_t hash)
+{
+   size_t slot;
+
+   for (slot = hash & index->mask; index->entries[slot].head;
+         slot = (slot + 1) & index->mask)
+   {
+      const struct libretrodb_hash_entry *entry = &index->entries[slot];
+
+      if (entry->hash == hash && libretrodb_key_equals(db,
+               index->nodes[entry->head - 1].offset,
+               index->field_name, key, len))
+         break;
+   }
+
+   return &index->entries[slot];
+}
+
+static struct libretrodb_hash_index *libretrodb_get_hash_index(
+      const libretrodb_t *db, const char *field_name)
+{
+   struct libretrodb_hash_index *index = db->hash_indexes;
+
+   for (; index; index = index->next)
+   {
+      if (!strcmp(index->field_name, field_name))
+         return index;
+   }
+
+   return NULL;
+}
+
+int libretrodb_create_hash_index(libretrodb_t *db, const char *field_name)
+{
+   int rv;
+   size_t pos;
+   uint32_t hash;
+   size_t cap = 16;
+   struct libretrodb_hash_index *index = NULL;
+
+   if (libretrodb_get_hash_index(db, field_name))
+      return 0;
+
+   /* Keep the table less than half full, so that
+    * every record fits and probing always ends. */
+   while (cap <= db->count * 2)
+      cap *= 2;
+
+   index = (struct libretrodb_hash_index*)calloc(1, sizeof(*index));
+   if (!index)
       return -ENOMEM;
 
-   while (nread < bufflen)
+   index->field_name = strdup(field_name);
+   index->entries    = (struct libretrodb_hash_entry*)
+      calloc(cap, sizeof(*index->entries));
+   index->mask       = cap - 1;
+   index->nodes      = (struct libretrodb_hash_node*)
+      calloc(cap / 2, sizeof(*index->nodes));
+
+   if (!index->field_name || !index->entries || !index->nodes)
+   {
+      rv = -ENOMEM;
+      goto error;
+   }
+
+   pos = db->root + sizeof(libretrodb_header_t);
+
+   for (;;)
    {
-      void * buff_ = (uint64_t *)buff + nread;
-      rv = read(db->fd, buff_, bufflen - nread);
+      size_t len;
+      const void *key;
+      uint32_t node;
+      struct rmsgpack_token token;
+      struct libretrodb_hash_entry *entry = NULL;
+      uint8_t number[LIBRETRODB_NUMBER_KEY_SIZE];
+      uint64_t offset = pos;
+
+      if ((rv = rmsgpack_read_token(db->data, db->size, &pos, &token)) < 0)
+         goto error;
+
+      /* The records end with a nil. */
+      if (token.type == RMT_NIL)
+         break;
+
+      pos = offset;
+      if ((rv = rmsgpack_skip(db->data, db->size, &pos)) < 0)
+         goto error;
+
+      if (libretrodb_field_key(db, offset, field_name,
+               number, &key, &len) != 0)
+         continue;
 
-      if (rv <= 0)
+      /* The metadata may undercount a damaged database. */
+      if (index->node_count == (index->mask + 1) / 2)
+         break;
+
+      node = ++index->node_count;
+      index->nodes[node - 1].offset = offset;
+
+      hash  = libretrodb_hash(key, len);
+      entry = libretrodb_hash_slot(db, index, key, len, hash);
+
+      if (entry->head)
+         index->nodes[entry->tail - 1].next = node;
+      else
       {
-         free(buff);
-         return -errno;
+         entry->head = node;
+         entry->hash = hash;
       }
-      nread += rv;
+      entry->tail = node;
    }
 
-   rv = binsearch(buff, key, db->count, idx.key_size, &offset);
-   free(buff);
+   index->next      = db->hash_indexes;
+   db->hash_indexes = index;
+   return 0;
 
-   if (rv == 0)
-      lseek(db->fd, offset, SEEK_SET);
+error:
+   free(index->field_name);
+   free(index->entries);
+   free(index->nodes);
+   free(index);
+   return rv;
+}
 
-   rv = rmsgpack_dom_read(db->fd, out);
+int libretrodb_find_field(libretrodb_t *db, const char *field_name,
+      const void *key, size_t len, uint64_t *offsets, size_t max)
+{
+   int rv;
+   uint32_t node;
+   int found = 0;
+   const struct libretrodb_hash_entry *entry = NULL;
+   struct libretrodb_hash_index *index =
+      libretrodb_get_hash_index(db, field_name);
 
-   if (rv < 0)
-      return rv;
+   if (!index)
+   {
+      if ((rv = libretrodb_create_hash_index(db, field_name)) < 0)
+         return rv;
+      index = db->hash_indexes;
+   }
 
-   return rv;
+   entry = libretrodb_hash_slot(db, index, key, len,
+         libretrodb_hash(key, len));
+
+   for (node = entry->head; node; node = index->nodes[node - 1].next)
+   {
+      if ((size_t)found < max)
+         offsets[found] = index->nodes[node - 1].offset;
+      found++;
+   }
+
+   return found;
 }
 
 /**
@@ -291,10 +873,10 @@ int libretrodb_find_entry(libretrodb_t *db, const char *index_name,
  **/
 int libretrodb_cursor_reset(libretrodb_cursor_t *cursor)
 {
-	cursor->eof = 0;
-	return lseek(cursor->fd,
-         cursor->db->root + sizeof(libretrodb_header_t),
-         SEEK_SET);
+	cursor->eof           = 0;
+	cursor->offset        = cursor->db->root + sizeof(libretrodb_header_t);
+	cursor->candidate_ptr = 0;
+	return 0;
 }
 
 int libretrodb_cursor_read_item(libretrodb_cursor_t *cursor,
@@ -306,20 +888,46 @@ int libretrodb_cursor_read_item(libretrodb_cursor_t *cursor,
       return EOF;
 
 retry:
-   rv = rmsgpack_dom_read(cursor->fd, out);
-   if (rv < 0)
-      return rv;
+   if (cursor->candidates)
+   {
+      if (cursor->candidate_ptr >= cursor->candidate_count)
+      {
+         cursor->eof = 1;
+         return EOF;
+      }
 
-   if (out->type == RDT_NULL)
+      rv = libretrodb_read_entry(cursor->db,
+            cursor->candidates[cursor->candidate_ptr++], out);
+      if (rv < 0)
+         return rv;
+   }
+   else
    {
-      cursor->eof = 1;
-      return EOF;
+      size_t pos = cursor->offset;
+
+      rv = rmsgpack_dom_read_buf(cursor->db->data, cursor->db->size,
+            &pos, out);
+      if (rv < 0)
+         return rv;
+
+      cursor->offset = pos;
+
+      if (out->type == RDT_NULL)
+      {
+         cursor->eof = 1;
+         return EOF;
+      }
    }
 
+   /* Candidates only narrow the search down,
+    * the query still decides. */
    if (cursor->query)
    {
       if (!libretrodb_query_filter(cursor->query, out))
+      {
+         rmsgpack_dom_value_free(out);
          goto retry;
+      }
    }
 
    return 0;
@@ -336,7 +944,8 @@ void libretrodb_cursor_close(libretrodb_cursor_t *cursor)
    if (!cursor)
       return;
 
-	close(cursor->fd);
+	if (cursor->fd != -1)
+		close(cursor->fd);
 	cursor->is_valid = 0;
 	cursor->fd = -1;
 	cursor->eof = 1;
@@ -345,7 +954,11 @@ void libretrodb_cursor_close(libretrodb_cursor_t *cursor)
 	if (cursor->query)
 		libretrodb_query_free(cursor->query);
 
-	cursor->query = NULL;
+	free(cursor->candidates);
+
+	cursor->query           = NULL;
+	cursor->candidates      = NULL;
+	cursor->candidate_count = 0;
 }
 
 /**
@@ -361,19 +974,32 @@ void libretrodb_cursor_close(libretrodb_cursor_t *cursor)
 int libretrodb_cursor_open(libretrodb_t *db, libretrodb_cursor_t *cursor,
       libretrodb_query_t *q)
 {
-   cursor->fd = dup(db->fd);
+   /* Records are read from memory, so cursors
+    * don't need a file offset of their own. */
+   cursor->fd       = -1;
+   cursor->is_valid = 0;
 
-   if (cursor->fd == -1)
-      return -errno;
+   if (!db->data)
+      return -EINVAL;
 
-   cursor->db = db;
-   cursor->is_valid = 1;
+   cursor->db              = db;
+   cursor->is_valid        = 1;
+   cursor->candidates      = NULL;
+   cursor->candidate_count = 0;
    libretrodb_cursor_reset(cursor);
    cursor->query = q;
 
    if (q)
+   {
       libretrodb_query_inc_ref(q);
 
+      /* Falls back to scanning every record
+       * when no index can answer the query. */
+      if (libretrodb_query_plan(q, db, &cursor->candidates,
+               &cursor->candidate_count) != 0)
+         cursor->candidates = NULL;
+   }
+
    return 0;
 }
 
@@ -388,11 +1014,6 @@ static int node_iter(void * value, void * ctx)
 	return -1;
 }
 
-static uint64_t libretrodb_tell(libretrodb_t *db)
-{
-	return lseek(db->fd, 0, SEEK_CUR);
-}
-
 int libretrodb_create_index(libretrodb_t *db,
       const char *name, const char *field_name)
 {
@@ -408,7 +1029,7 @@ int libretrodb_create_index(libretrodb_t *db,
 	void * buff = NULL;
 	uint64_t * buff_u64 = NULL;
 	uint8_t field_size = 0;
-	uint64_t item_loc = libretrodb_tell(db);
+	uint64_t item_loc;
 
 	bintree_new(&tree, node_compare, &field_size);
 
@@ -418,6 +1039,8 @@ int libretrodb_create_index(libretrodb_t *db,
 		goto clean;
 	}
 
+	item_loc = cur.offset;
+
 	key.type = RDT_STRING;
 	key.string.len = strlen(field_name);
 
@@ -474,7 +1097,7 @@ int libretrodb_create_index(libretrodb_t *db,
 
 		memcpy(buff, field->binary.buff, field_size);
 
-		buff_u64 = (uint64_t *)buff + field_size;
+		buff_u64 = (uint64_t *)((uint8_t *)buff + field_size);
 
 		memcpy(buff_u64, &item_loc, sizeof(uint64_t));
 
@@ -488,7 +1111,7 @@ int libretrodb_create_index(libretrodb_t *db,
 		}
 		buff = NULL;
 		rmsgpack_dom_value_free(&item);
-		item_loc = libretrodb_tell(db);
+		item_loc = cur.offset;
 	}
 
 	(void)rv;
@@ -496,8 +1119,10 @@ int libretrodb_create_index(libretrodb_t *db,
 
 	idx_header_offset = lseek(db->fd, 0, SEEK_END);
 	strncpy(idx.name, name, 50);
+	strncpy(idx.field, field_name, 50);
 
 	idx.name[49] = '\0';
+	idx.field[49] = '\0';
 	idx.key_size = field_size;
 	idx.next = db->count * (field_size + sizeof(uint64_t));
 	libretrodb_write_index_header(db->fd, &idx);
@@ -506,6 +1131,10 @@ int libretrodb_create_index(libretrodb_t *db,
 	nictx.idx = &idx;
 	bintree_iterate(&tree, node_iter, &nictx);
 	bintree_free(&tree);
+
+	/* Pick up the new index. */
+	libretrodb_unmap(db);
+	libretrodb_map(db);
 clean:
 	rmsgpack_dom_value_free(&item);
 	if (buff)
@@ -2,6 +2,7 @@
 #define __LIBRETRODB_H__
 
 #include <stdint.h>
+#include <stddef.h>
 #ifdef _WIN32
 #include <direct.h>
 #else
@@ -17,6 +18,27 @@ extern "C" {
 
 typedef struct libretrodb_query libretrodb_query_t;
 
+typedef struct libretrodb_index
+{
+	char name[50];
+	/* Field the keys were taken from. Empty for
+	 * indexes written before it was recorded. */
+	char field[50];
+	uint64_t key_size;
+	uint64_t next;
+} libretrodb_index_t;
+
+/* Index written by libretrodb_create_index(). */
+typedef struct libretrodb_disk_index
+{
+   libretrodb_index_t header;
+   /* Offset of the sorted { key, record offset } pairs. */
+   uint64_t table;
+   uint64_t count;
+} libretrodb_disk_index_t;
+
+struct libretrodb_hash_index;
+
 typedef struct libretrodb
 {
 	int fd;
@@ -24,14 +46,20 @@ typedef struct libretrodb
 	uint64_t count;
 	uint64_t first_index_offset;
    char path[1024];
-} libretrodb_t;
 
-typedef struct libretrodb_index
-{
-	char name[50];
-	uint64_t key_size;
-	uint64_t next;
-} libretrodb_index_t;
+   /* The whole file, mapped read-only, or read into memory
+    * where it can't be mapped. Records are decoded from here. */
+   const uint8_t *data;
+   uint64_t size;
+   int mapped;
+
+   /* Indexes found in the file, loaded on open. */
+   libretrodb_disk_index_t *disk_indexes;
+   size_t disk_index_count;
+
+   /* Hash indexes built so far, kept until the database is closed. */
+   struct libretrodb_hash_index *hash_indexes;
+} libretrodb_t;
 
 typedef struct libretrodb_metadata
 {
@@ -49,6 +77,13 @@ typedef struct libretrodb_cursor
 	int is_valid;
 	int fd;
 	int eof;
+   /* Offset of the next record. */
+   uint64_t offset;
+   /* Records picked from indexes by the query planner, in file
+    * order. NULL when every record has to be scanned. */
+   uint64_t *candidates;
+   size_t candidate_count;
+   size_t candidate_ptr;
 	libretrodb_query_t * query;
 	libretrodb_t * db;
 } libretrodb_cursor_t;
@@ -73,6 +108,112 @@ int libretrodb_find_entry(
         struct rmsgpack_dom_value * out
 );
 
+/**
+ * libretrodb_find_range:
+ * @db                  : Handle to database.
+ * @field_name          : Field indexed by libretrodb_create_index().
+ * @lo                  : Lowest key, inclusive.
+ * @hi                  : Highest key, inclusive.
+ * @len                 : Size of the keys.
+ * @offsets             : Offsets of the matching records, in key order.
+ * @max                 : Size of @offsets.
+ *
+ * Indexes are matched by the field they were built on, whatever
+ * their name. Indexes which do not record it are not used.
+ *
+ * Returns: number of matches, of which the first @max are stored
+ * in @offsets, or -1 if there is no index of @field_name with
+ * keys of @len.
+ **/
+int libretrodb_find_range(
+        libretrodb_t * db,
+        const char * field_name,
+        const void * lo,
+        const void * hi,
+        size_t len,
+        uint64_t * offsets,
+        size_t max
+);
+
+#define LIBRETRODB_NUMBER_KEY_SIZE 8
+
+/**
+ * libretrodb_number_key:
+ * @value               : Integer, signed or not.
+ * @key                 : Key of @value.
+ *
+ * Hash indexes key integers by their 64-bit value, big endian.
+ **/
+void libretrodb_number_key(uint64_t value,
+      uint8_t key[LIBRETRODB_NUMBER_KEY_SIZE]);
+
+/**
+ * libretrodb_create_hash_index:
+ * @db                  : Handle to database.
+ * @field_name          : Field to index. Records where it is missing,
+ *                        or not a string, binary or integer,
+ *                        are left out.
+ *
+ * Builds an in-memory hash index of @field_name, kept until the
+ * database is closed. Lookups build the index they need on first
+ * use. Once built, lookups don't modify @db, so several threads
+ * may look up entries at once.
+ *
+ * Returns: 0 if successful, otherwise negative.
+ **/
+int libretrodb_create_hash_index(libretrodb_t * db, const char * field_name);
+
+/**
+ * libretrodb_find_field:
+ * @db                  : Handle to database.
+ * @field_name          : Field to match.
+ * @key                 : Value to look for, see libretrodb_number_key()
+ *                        for integers.
+ * @len                 : Size of @key.
+ * @offsets             : Offsets of the matching records.
+ * @max                 : Size of @offsets.
+ *
+ * Finds the records where @field_name equals @key, using
+ * its hash index.
+ *
+ * Returns: number of matches, of which the first @max are
+ * stored in @offsets, or negative on error.
+ **/
+int libretrodb_find_field(
+        libretrodb_t * db,
+        const char * field_name,
+        const void * key,
+        size_t len,
+        uint64_t * offsets,
+        size_t max
+);
+
+/**
+ * libretrodb_read_entry:
+ * @db                  : Handle to database.
+ * @offset              : Offset of the record.
+ * @out                 : Decoded record.
+ *
+ * Returns: 0 if successful, otherwise negative.
+ **/
+int libretrodb_read_entry(libretrodb_t * db, uint64_t offset,
+      struct rmsgpack_dom_value * out);
+
+/**
+ * libretrodb_read_field:
+ * @db                  : Handle to database.
+ * @offset              : Offset of the record.
+ * @field_name          : Field to decode.
+ * @out                 : Decoded value of the field.
+ *
+ * Decodes only @field_name, skipping over the rest of the record.
+ *
+ * Returns: 0 if successful, -1 if the record has no such field,
+ * otherwise negative.
+ **/
+int libretrodb_read_field(libretrodb_t * db, uint64_t offset,
+      const char * field_name, struct rmsgpack_dom_value * out);
+
 /**
  * libretrodb_cursor_open:
  * @db                  : Handle to database.
@@ -20,6 +20,7 @@ int main(int argc, char ** argv)
       printf("\tlist\n");
       printf("\tcreate-index <index name> <field name>\n");
       printf("\tfind <query expression>\n");
+      printf("\tget <index name> <hex key>\n");
       return 1;
    }
 
@@ -82,6 +83,51 @@ int main(int argc, char ** argv)
          printf("\n");
          rmsgpack_dom_value_free(&item);
       }
+
+      libretrodb_cursor_close(&cur);
+      libretrodb_query_free(q);
+   }
+   else if (strcmp(command, "get") == 0)
+   {
+      size_t i, len;
+      uint8_t key[256];
+      const char *hex;
+
+      if (argc != 5)
+      {
+         printf("Usage: %s <db file> get <index name> <hex key>\n", argv[0]);
+         return 1;
+      }
+
+      hex = argv[4];
+      len = strlen(hex) / 2;
+
+      if (len == 0 || len > sizeof(key))
+      {
+         printf("Invalid key '%s'\n", hex);
+         return 1;
+      }
+
+      for (i = 0; i < len; i++)
+      {
+         unsigned byte;
+         if (sscanf(hex + i * 2, "%2x", &byte) != 1)
+         {
+            printf("Invalid key '%s'\n", hex);
+            return 1;
+         }
+         key[i] = byte;
+      }
+
+      if ((rv = libretrodb_find_entry(&db, argv[3], key, &item)) != 0)
+      {
+         printf("Key not found\n");
+         return 1;
+      }
+
+      rmsgpack_dom_value_print(&item);
+      printf("\n");
+      rmsgpack_dom_value_free(&item);
    }
    else if (strcmp(command, "create-index") == 0)
    {
@@ -9,6 +9,7 @@
 #include <string.h>
 
 #include "libretrodb.h"
+#include "query.h"
 
 #include "rmsgpack_dom.h"
 #include <compat/fnmatch.h>
@@ -58,6 +59,18 @@ static void raise_expected_string(off_t where, const char ** error)
    *error = tmp_error_buff;
 }
 
+static void raise_expected_binary(off_t where, const char ** error)
+{
+   snprintf(tmp_error_buff, MAX_ERROR_LEN,
+#ifdef _WIN32
+         "%I64u::Expected binary",
+#else
+         "%llu::Expected binary",
+#endif
+         (unsigned long long)where);
+   *error = tmp_error_buff;
+}
+
 static void raise_unexpected_eof(off_t where, const char ** error)
 {
    snprintf(tmp_error_buff, MAX_ERROR_LEN,
@@ -270,6 +283,21 @@ static struct rmsgpack_dom_value between(struct rmsgpack_dom_value input,
       return res;
    if (argv[0].type != AT_VALUE || argv[1].type != AT_VALUE)
       return res;
+
+   /* Binaries of the same size compare like index keys do. */
+   if (argv[0].value.type == RDT_BINARY && argv[1].value.type == RDT_BINARY)
+   {
+      uint32_t len = input.binary.len;
+
+      if (input.type != RDT_BINARY || argv[0].value.binary.len != len
+            || argv[1].value.binary.len != len)
+         return res;
+
+      res.bool_ = memcmp(input.binary.buff, argv[0].value.binary.buff, len) >= 0
+         && memcmp(input.binary.buff, argv[1].value.binary.buff, len) <= 0;
+      return res;
+   }
+
    if (argv[0].value.type != RDT_INT || argv[1].value.type != RDT_INT)
       return res;
 
@@ -520,6 +548,57 @@ static struct buffer parse_string(struct buffer buff,
    return buff;
 }
 
+static int hex_digit(char c)
+{
+   if (c >= '0' && c <= '9')
+      return c - '0';
+   if (c >= 'a' && c <= 'f')
+      return c - 'a' + 10;
+   if (c >= 'A' && c <= 'F')
+      return c - 'A' + 10;
+   return -1;
+}
+
+/* b"0a1b" is a binary of the bytes 0x0a, 0x1b. */
+static struct buffer parse_binary(struct buffer buff,
+      struct rmsgpack_dom_value *value, const char **error)
+{
+   uint32_t i, len;
+   char *data;
+   off_t start = buff.offset;
+
+   buff.offset++;
+   buff = parse_string(buff, value, error);
+
+   if (*error)
+      return buff;
+
+   data = value->string.buff;
+   len  = value->string.len;
+
+   for (i = 0; i < len; i++)
+   {
+      if (hex_digit(data[i]) < 0)
+         break;
+   }
+
+   if (i < len || len % 2)
+   {
+      free(data);
+      value->type = RDT_NULL;
+      raise_expected_binary(start, error);
+      return buff;
+   }
+
+   for (i = 0; i < len / 2; i++)
+      data[i] = (hex_digit(data[i * 2]) << 4) | hex_digit(data[i * 2 + 1]);
+
+   value->type        = RDT_BINARY;
+   value->binary.len  = len / 2;
+   value->binary.buff = data;
+   return buff;
+}
+
 static struct buffer parse_integer(struct buffer buff,
       struct rmsgpack_dom_value *value, const char **error)
 {
@@ -565,6 +644,8 @@ static struct buffer parse_value(struct buffer buff,
    }
    else if (peek(buff, "\"") || peek(buff, "'"))
       buff = parse_string(buff, value, error);
+   else if (peek(buff, "b\"") || peek(buff, "b'"))
+      buff = parse_binary(buff, value, error);
    else if (isdigit(buff.data[buff.offset]))
       buff = parse_integer(buff, value, error);
    return buff;
@@ -821,6 +902,8 @@ static struct buffer parse_argument(struct buffer buff,
             peek(buff, "nil")
             || peek(buff, "true")
             || peek(buff, "false")
+            || peek(buff, "b\"")
+            || peek(buff, "b'")
             )
       )
    {
@@ -907,6 +990,172 @@ void libretrodb_query_inc_ref(libretrodb_query_t *q)
       rq->ref_count += 1;
 }
 
+struct query_plan
+{
+   libretrodb_t *db;
+   /* Smallest set of candidates found so far. */
+   uint64_t *offsets;
+   size_t count;
+   int found;
+};
+
+static int query_plan_cmp_offset(const void *a, const void *b)
+{
+   uint64_t x = *(const uint64_t*)a;
+   uint64_t y = *(const uint64_t*)b;
+
+   return x < y ? -1 : x > y;
+}
+
+/**
+ * query_plan_lookup:
+ * @plan                : Plan being built.
+ * @field               : Field the predicate is on.
+ * @lo                  : Value, or lowest value of a range.
+ * @hi                  : Highest value of a range, NULL for equality.
+ *
+ * Looks the predicate up in the index written by
+ * libretrodb_create_index() for @field if there is one, otherwise
+ * in the hash index of @field for equality. Ranges need an index
+ * written by libretrodb_create_index(), so only binaries qualify.
+ * Keeps the candidates if they are fewer than any found before.
+ **/
+static void query_plan_lookup(struct query_plan *plan, const char *field,
+      const struct rmsgpack_dom_value *lo,
+      const struct rmsgpack_dom_value *hi)
+{
+   int pass, count = -1;
+   uint64_t *offsets = NULL;
+   uint8_t number[LIBRETRODB_NUMBER_KEY_SIZE];
+
+   /* The first pass counts the matches, the second collects them. */
+   for (pass = 0; pass < 2; pass++)
+   {
+      size_t max = pass ? count : 0;
+
+      if (pass)
+      {
+         /* Never NULL, an empty set still means no scan. */
+         offsets = (uint64_t*)malloc((count ? count : 1) * sizeof(*offsets));
+         if (!offsets)
+            return;
+      }
+
+      if (lo->type == RDT_BINARY)
+      {
+         const struct rmsgpack_dom_value *end = hi ? hi : lo;
+
+         if (end->type != RDT_BINARY || end->binary.len != lo->binary.len)
+            break;
+
+         count = libretrodb_find_range(plan->db, field, lo->binary.buff,
+               end->binary.buff, lo->binary.len, offsets, max);
+
+         if (count < 0 && !hi)
+            count = libretrodb_find_field(plan->db, field,
+                  lo->binary.buff, lo->binary.len, offsets, max);
+      }
+      else if (hi)
+         break;
+      else if (lo->type == RDT_STRING)
+         count = libretrodb_find_field(plan->db, field,
+               lo->string.buff, lo->string.len, offsets, max);
+      else if (lo->type == RDT_INT)
+      {
+         /* Matches unsigned fields too, see equals(). */
+         libretrodb_number_key(lo->int_, number);
+         count = libretrodb_find_field(plan->db, field,
+               number, sizeof(number), offsets, max);
+      }
+
+      if (count < 0)
+         break;
+   }
+
+   if (pass < 2 || (plan->found && (size_t)count >= plan->count))
+   {
+      free(offsets);
+      return;
+   }
+
+   free(plan->offsets);
+   plan->offsets = offsets;
+   plan->count   = count;
+   plan->found   = 1;
+}
+
+/* Predicates on the value of @field, found in a table. */
+static void query_plan_field(struct query_plan *plan, const char *field,
+      const struct argument *arg)
+{
+   unsigned i;
+   const struct invocation *inv = &arg->invocation;
+
+   if (arg->type == AT_VALUE)
+   {
+      query_plan_lookup(plan, field, &arg->value, NULL);
+      return;
+   }
+
+   if (inv->func == between && inv->argc == 2 &&
+         inv->argv[0].type == AT_VALUE && inv->argv[1].type == AT_VALUE)
+      query_plan_lookup(plan, field, &inv->argv[0].value,
+            &inv->argv[1].value);
+   else if (inv->func == operator_and)
+   {
+      for (i = 0; i < inv->argc; i++)
+         query_plan_field(plan, field, &inv->argv[i]);
+   }
+}
+
+static void query_plan_invocation(struct query_plan *plan,
+      const struct invocation *inv)
+{
+   unsigned i;
+
+   if (inv->func == all_map)
+   {
+      for (i = 0; i + 1 < inv->argc; i += 2)
+      {
+         const struct rmsgpack_dom_value *key = &inv->argv[i].value;
+
+         if (inv->argv[i].type == AT_VALUE && key->type == RDT_STRING)
+            query_plan_field(plan, key->string.buff, &inv->argv[i + 1]);
+      }
+   }
+   else if (inv->func == operator_and)
+   {
+      /* Any operand narrows the search down, keep the best one. */
+      for (i = 0; i < inv->argc; i++)
+      {
+         if (inv->argv[i].type == AT_FUNCTION)
+            query_plan_invocation(plan, &inv->argv[i].invocation);
+      }
+   }
+}
+
+int libretrodb_query_plan(libretrodb_query_t *q, libretrodb_t *db,
+      uint64_t **offsets, size_t *count)
+{
+   struct query_plan plan;
+
+   memset(&plan, 0, sizeof(plan));
+   plan.db = db;
+
+   query_plan_invocation(&plan, &((struct query *)q)->root);
+
+   if (!plan.found)
+      return -1;
+
+   /* Return records in the order a scan would. */
+   qsort(plan.offsets, plan.count, sizeof(*plan.offsets),
+         query_plan_cmp_offset);
+
+   *offsets = plan.offsets;
+   *count   = plan.count;
+   return 0;
+}
+
 int libretrodb_query_filter(libretrodb_query_t *q,
       struct rmsgpack_dom_value *v)
 {
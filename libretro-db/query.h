@@ -10,4 +10,22 @@ void libretrodb_query_dec_ref(libretrodb_query_t *q);
 int libretrodb_query_filter(libretrodb_query_t *q,
       struct rmsgpack_dom_value * v);
 
+/**
+ * libretrodb_query_plan:
+ * @q                   : Compiled query.
+ * @db                  : Database the query runs on.
+ * @offsets             : Candidate records, in file order.
+ *                        To be freed by the caller.
+ * @count               : Number of candidates.
+ *
+ * Looks for equality and range predicates which an index can
+ * answer, and collects the records which may match. The query
+ * still has to be run on each of them.
+ *
+ * Returns: 0 if candidates were found, non-zero if every
+ * record has to be scanned.
+ **/
+int libretrodb_query_plan(libretrodb_query_t *q, libretrodb_t *db,
+      uint64_t **offsets, size_t *count);
+
 #endif
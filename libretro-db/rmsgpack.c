@@ -573,3 +573,157 @@ int rmsgpack_read(int fd,
 
    return 0;
 }
+
+static int read_buf_uint(const uint8_t *buf, size_t len, size_t *pos,
+      uint64_t *out, size_t size)
+{
+   size_t i;
+
+   if (len - *pos < size)
+      return -EINVAL;
+
+   *out = 0;
+   for (i = 0; i < size; i++)
+      *out = (*out << 8) | buf[(*pos)++];
+   return 0;
+}
+
+int rmsgpack_read_token(const uint8_t *buf, size_t len, size_t *pos,
+      struct rmsgpack_token *out)
+{
+   uint64_t tmp = 0;
+   uint8_t type;
+   size_t size;
+
+   if (*pos >= len)
+      return -EINVAL;
+
+   type = buf[(*pos)++];
+
+   /* Positive fixints come out as signed, like rmsgpack_read does. */
+   if (type < MPF_FIXMAP)
+   {
+      out->type = RMT_INT;
+      out->int_ = type;
+      return 0;
+   }
+   else if (type < MPF_FIXARRAY)
+   {
+      out->type = RMT_MAP;
+      out->len  = type - MPF_FIXMAP;
+      return 0;
+   }
+   else if (type < MPF_FIXSTR)
+   {
+      out->type = RMT_ARRAY;
+      out->len  = type - MPF_FIXARRAY;
+      return 0;
+   }
+   else if (type < MPF_NIL)
+   {
+      out->type = RMT_STRING;
+      tmp       = type - MPF_FIXSTR;
+      goto buff;
+   }
+   else if (type > MPF_MAP32)
+   {
+      out->type = RMT_INT;
+      out->int_ = (int8_t)type;
+      return 0;
+   }
+
+   switch (type)
+   {
+      case 0xc0:
+         out->type = RMT_NIL;
+         return 0;
+      case 0xc2:
+      case 0xc3:
+         out->type  = RMT_BOOL;
+         out->bool_ = type == MPF_TRUE;
+         return 0;
+      case 0xc4:
+      case 0xc5:
+      case 0xc6:
+         out->type = RMT_BINARY;
+         if (read_buf_uint(buf, len, pos, &tmp, 1 << (type - 0xc4)) < 0)
+            return -EINVAL;
+         goto buff;
+      case 0xcc:
+      case 0xcd:
+      case 0xce:
+      case 0xcf:
+         out->type = RMT_UINT;
+         return read_buf_uint(buf, len, pos, &out->uint_,
+               1 << (type - 0xcc));
+      case 0xd0:
+      case 0xd1:
+      case 0xd2:
+      case 0xd3:
+         size = 1 << (type - 0xd0);
+         if (read_buf_uint(buf, len, pos, &tmp, size) < 0)
+            return -EINVAL;
+
+         /* Sign-extend from the size of the field. */
+         if (size < 8 && (tmp & (1ULL << (size * 8 - 1))))
+            tmp |= ~0ULL << (size * 8);
+
+         out->type = RMT_INT;
+         out->int_ = (int64_t)tmp;
+         return 0;
+      case 0xd9:
+      case 0xda:
+      case 0xdb:
+         out->type = RMT_STRING;
+         if (read_buf_uint(buf, len, pos, &tmp, 1 << (type - 0xd9)) < 0)
+            return -EINVAL;
+         goto buff;
+      case 0xdc:
+      case 0xdd:
+         out->type = RMT_ARRAY;
+         if (read_buf_uint(buf, len, pos, &tmp, 2 << (type - 0xdc)) < 0)
+            return -EINVAL;
+         out->len = tmp;
+         return 0;
+      case 0xde:
+      case 0xdf:
+         out->type = RMT_MAP;
+         if (read_buf_uint(buf, len, pos, &tmp, 2 << (type - 0xde)) < 0)
+            return -EINVAL;
+         out->len = tmp;
+         return 0;
+   }
+
+   /* Floats and extensions are not supported. */
+   return -EINVAL;
+
+buff:
+   if (tmp > len - *pos)
+      return -EINVAL;
+
+   out->len  = tmp;
+   out->buff = (const char*)buf + *pos;
+   *pos     += tmp;
+   return 0;
+}
+
+int rmsgpack_skip(const uint8_t *buf, size_t len, size_t *pos)
+{
+   int rv;
+   struct rmsgpack_token token;
+   /* Values still to be skipped, nested containers add to it. */
+   uint64_t left = 1;
+
+   while (left--)
+   {
+      if ((rv = rmsgpack_read_token(buf, len, pos, &token)) < 0)
+         return rv;
+
+      if (token.type == RMT_MAP)
+         left += 2 * (uint64_t)token.len;
+      else if (token.type == RMT_ARRAY)
+         left += token.len;
+   }
+
+   return 0;
+}
@@ -2,6 +2,7 @@
 #define __RARCHDB_MSGPACK_H__
 
 #include <stdint.h>
+#include <stddef.h>
 
 struct rmsgpack_read_callbacks {
 	int (* read_nil)(void *);
@@ -76,5 +77,68 @@ int rmsgpack_read(
         void * data
 );
 
+/* Reading from memory, for databases which are mapped or loaded
+ * whole. Nothing is allocated, strings and binaries point into
+ * the buffer and are not NUL-terminated. */
+
+enum rmsgpack_token_type {
+	RMT_NIL = 0,
+	RMT_BOOL,
+	RMT_INT,
+	RMT_UINT,
+	RMT_STRING,
+	RMT_BINARY,
+	RMT_MAP,
+	RMT_ARRAY
+};
+
+struct rmsgpack_token {
+	enum rmsgpack_token_type type;
+	union {
+		uint64_t uint_;
+		int64_t int_;
+		int bool_;
+	};
+	/* Size of strings and binaries, or number of
+	 * pairs or elements that follow a map or array. */
+	uint32_t len;
+	const char * buff;
+};
+
+/**
+ * rmsgpack_read_token:
+ * @buf                 : Buffer to read from.
+ * @len                 : Size of @buf.
+ * @pos                 : Offset of the token, moved past it.
+ * @out                 : Token read.
+ *
+ * Reads one token. Maps and arrays only have their header read,
+ * their contents are the tokens that follow.
+ *
+ * Returns: 0 if successful, otherwise negative.
+ **/
+int rmsgpack_read_token(
+        const uint8_t * buf,
+        size_t len,
+        size_t * pos,
+        struct rmsgpack_token * out
+);
+
+/**
+ * rmsgpack_skip:
+ * @buf                 : Buffer to read from.
+ * @len                 : Size of @buf.
+ * @pos                 : Offset of the value, moved past it.
+ *
+ * Skips a whole value, including the contents of maps and arrays.
+ *
+ * Returns: 0 if successful, otherwise negative.
+ **/
+int rmsgpack_skip(
+        const uint8_t * buf,
+        size_t len,
+        size_t * pos
+);
+
 #endif
 
@@ -406,6 +406,124 @@ int rmsgpack_dom_read(int fd, struct rmsgpack_dom_value *out)
    return rv;
 }
 
+static int dom_read_buf(const uint8_t *buf, size_t len, size_t *pos,
+      struct rmsgpack_dom_value *out, unsigned depth)
+{
+   int rv;
+   unsigned i;
+   struct rmsgpack_token token;
+
+   out->type = RDT_NULL;
+
+   if (depth == MAX_DEPTH)
+      return -ENOMEM;
+
+   if ((rv = rmsgpack_read_token(buf, len, pos, &token)) < 0)
+      return rv;
+
+   switch (token.type)
+   {
+      case RMT_NIL:
+         break;
+      case RMT_BOOL:
+         out->type  = RDT_BOOL;
+         out->bool_ = token.bool_;
+         break;
+      case RMT_INT:
+         out->type = RDT_INT;
+         out->int_ = token.int_;
+         break;
+      case RMT_UINT:
+         out->type  = RDT_UINT;
+         out->uint_ = token.uint_;
+         break;
+      case RMT_STRING:
+      case RMT_BINARY:
+         {
+            /* NUL-terminated, like the readers above. */
+            char *buff = (char *)malloc(token.len + 1);
+
+            if (!buff)
+               return -ENOMEM;
+
+            memcpy(buff, token.buff, token.len);
+            buff[token.len] = '\0';
+
+            if (token.type == RMT_STRING)
+            {
+               out->type        = RDT_STRING;
+               out->string.len  = token.len;
+               out->string.buff = buff;
+            }
+            else
+            {
+               out->type        = RDT_BINARY;
+               out->binary.len  = token.len;
+               out->binary.buff = buff;
+            }
+         }
+         break;
+      case RMT_MAP:
+         /* Every pair takes at least two bytes. */
+         if (token.len > (len - *pos) / 2)
+            return -EINVAL;
+
+         /* Zeroed items are nil, so a partial map can be freed. */
+         out->type      = RDT_MAP;
+         out->map.len   = token.len;
+         out->map.items = (struct rmsgpack_dom_pair *)calloc(token.len,
+               sizeof(struct rmsgpack_dom_pair));
+
+         if (token.len && !out->map.items)
+            return -ENOMEM;
+
+         /* Filled from the back, like the stack of
+          * rmsgpack_dom_read() does. */
+         for (i = token.len; i-- > 0; )
+         {
+            if ((rv = dom_read_buf(buf, len, pos,
+                        &out->map.items[i].key, depth + 1)) < 0)
+               return rv;
+            if ((rv = dom_read_buf(buf, len, pos,
+                        &out->map.items[i].value, depth + 1)) < 0)
+               return rv;
+         }
+         break;
+      case RMT_ARRAY:
+         if (token.len > len - *pos)
+            return -EINVAL;
+
+         out->type        = RDT_ARRAY;
+         out->array.len   = token.len;
+         out->array.items = (struct rmsgpack_dom_value *)calloc(token.len,
+               sizeof(struct rmsgpack_dom_value));
+
+         if (token.len && !out->array.items)
+            return -ENOMEM;
+
+         for (i = token.len; i-- > 0; )
+         {
+            if ((rv = dom_read_buf(buf, len, pos,
+                        &out->array.items[i], depth + 1)) < 0)
+               return rv;
+         }
+         break;
+   }
+
+   return 0;
+}
+
+int rmsgpack_dom_read_buf(const uint8_t *buf, size_t len, size_t *pos,
+      struct rmsgpack_dom_value *out)
+{
+   int rv = dom_read_buf(buf, len, pos, out, 0);
+
+   if (rv < 0)
+      rmsgpack_dom_value_free(out);
+
+   return rv;
+}
+
 int rmsgpack_dom_read_into(int fd, ...)
 {
    va_list ap;
@@ -2,6 +2,7 @@
 #define __RARCHDB_MSGPACK_DOM_H__
 
 #include <stdint.h>
+#include <stddef.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -71,6 +72,24 @@ int rmsgpack_dom_write(
 
 int rmsgpack_dom_read_into(int fd, ...);
 
+/**
+ * rmsgpack_dom_read_buf:
+ * @buf                 : Buffer to read from.
+ * @len                 : Size of @buf.
+ * @pos                 : Offset of the value, moved past it.
+ * @out                 : Value read, to be freed by the caller.
+ *
+ * Like rmsgpack_dom_read(), but reads from memory.
+ *
+ * Returns: 0 if successful, otherwise negative.
+ **/
+int rmsgpack_dom_read_buf(
+        const uint8_t * buf,
+        size_t len,
+        size_t * pos,
+        struct rmsgpack_dom_value * out
+);
+
 #ifdef __cplusplus
 }
 #endif
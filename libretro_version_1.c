@@ -31,6 +31,7 @@
 #include "audio/audio_utils.h"
 #include "retroarch_logger.h"
 #include "record/record_driver.h"
+#include "gfx/video_monitor.h"
 #include "intl/intl.h"
 
 #ifdef HAVE_NETPLAY
@@ -49,6 +50,10 @@ static bool video_frame_scale(const void *data,
       return false;
    if (data == RETRO_HW_FRAME_BUFFER_VALID)
       return false;
+   /* Only the recorder still needs a converted frame. */
+   if (driver.gfx_native_0rgb1555 &&
+         (!driver.recording_data || g_extern.record_gpu_buffer))
+      return false;
 
    RARCH_PERFORMANCE_START(video_frame_conv);
 
@@ -111,19 +116,32 @@ static void video_frame(const void *data, unsigned width,
 {
    unsigned output_width  = 0, output_height = 0, output_pitch = 0;
    const char *msg = NULL;
+   const void *record_data = NULL;
+   size_t record_pitch     = 0;
 
    if (!driver.video_active)
       return;
 
+   video_monitor_pacing_frame_ready();
+
    g_extern.frame_cache.data   = data;
    g_extern.frame_cache.width  = width;
    g_extern.frame_cache.height = height;
    g_extern.frame_cache.pitch  = pitch;
 
+   record_data  = data;
+   record_pitch = pitch;
+
    if (video_frame_scale(data, width, height, pitch))
    {
-      data                        = driver.scaler_out;
-      pitch                       = driver.scaler.out_stride;
+      record_data  = driver.scaler_out;
+      record_pitch = driver.scaler.out_stride;
+
+      if (!driver.gfx_native_0rgb1555)
+      {
+         data  = record_data;
+         pitch = record_pitch;
+      }
    }
 
    /* Slightly messy code,
@@ -134,7 +152,7 @@ static void video_frame(const void *data, unsigned width,
             || !g_settings.video.post_filter_record || !data
             || g_extern.record_gpu_buffer)
       )
-      recording_dump_frame(data, width, height, pitch);
+      recording_dump_frame(record_data, width, height, record_pitch);
 
    msg                = msg_queue_pull(g_extern.msg_queue);
    driver.current_msg = msg;
@@ -150,6 +168,17 @@ static void video_frame(const void *data, unsigned width,
 
    if (!driver.video->frame(driver.video_data, data, width, height, pitch, msg))
       driver.video_active = false;
+
+   /* The threaded video driver reports presents from its own thread. */
+#ifdef HAVE_THREADS
+   if (!g_settings.video.threaded
+         || g_extern.system.hw_render_callback.context_type)
+#endif
+      video_monitor_pacing_frame_presented(rarch_get_time_usec(),
+            g_extern.frame_pacing.run_start);
+
+   /* Cached frames rendered after this point are not run by the core. */
+   g_extern.frame_pacing.run_start = 0;
 }
 
 /**
@@ -623,6 +652,98 @@ static void input_poll(void)
 #endif
 }
 
+/**
+ * video_frame_headless:
+ * @data                 : pointer to data of the video frame.
+ * @width                : width of the video frame.
+ * @height               : height of the video frame.
+ * @pitch                : pitch of the video frame.
+ *
+ * Video frame render callback function used in headless mode.
+ * Nothing is presented, the frame is only cached for hashing.
+ **/
+static void video_frame_headless(const void *data, unsigned width,
+      unsigned height, size_t pitch)
+{
+   if (!data || data == RETRO_HW_FRAME_BUFFER_VALID)
+      return;
+
+   g_extern.frame_cache.data   = data;
+   g_extern.frame_cache.width  = width;
+   g_extern.frame_cache.height = height;
+   g_extern.frame_cache.pitch  = pitch;
+}
+
+static void audio_sample_headless(int16_t left, int16_t right)
+{
+   (void)left;
+   (void)right;
+}
+
+static size_t audio_sample_batch_headless(const int16_t *data, size_t frames)
+{
+   (void)data;
+   return frames;
+}
+
+/**
+ * input_state_headless:
+ * @port                 : user number.
+ * @device               : device identifier of user.
+ * @idx                  : index value of user.
+ * @id                   : identifier of key pressed by user.
+ *
+ * Input state callback function used in headless mode.
+ * Only BSV movie playback provides input.
+ *
+ * Returns: Input state from the BSV movie being played back,
+ * otherwise 0.
+ **/
+static int16_t input_state_headless(unsigned port, unsigned device,
+      unsigned idx, unsigned id)
+{
+   int16_t res = 0;
+
+   (void)port;
+   (void)device;
+   (void)idx;
+   (void)id;
+
+   if (!g_extern.bsv.movie)
+      return 0;
+
+   if (g_extern.bsv.movie_playback)
+   {
+      if (bsv_movie_get_input(g_extern.bsv.movie, &res))
+         return res;
+
+      g_extern.bsv.movie_end = true;
+      return 0;
+   }
+
+   bsv_movie_set_input(g_extern.bsv.movie, res);
+   return res;
+}
+
+static void input_poll_headless(void)
+{
+}
+
+/**
+ * retro_set_headless_callbacks:
+ *
+ * Binds the libretro callbacks to the headless callback functions,
+ * which bypass video, audio and input drivers entirely.
+ **/
+void retro_set_headless_callbacks(void)
+{
+   pretro_set_video_refresh(video_frame_headless);
+   pretro_set_audio_sample(audio_sample_headless);
+   pretro_set_audio_sample_batch(audio_sample_batch_headless);
+   pretro_set_input_state(input_state_headless);
+   pretro_set_input_poll(input_poll_headless);
+}
+
 /**
  * retro_set_default_callbacks:
  * @data           : pointer to retro_callbacks object
@@ -50,6 +50,14 @@ void retro_init_libretro_cbs(void *data);
  **/
 void retro_set_default_callbacks(void *data);
 
+/**
+ * retro_set_headless_callbacks:
+ *
+ * Binds the libretro callbacks to the headless callback functions,
+ * which bypass video, audio and input drivers entirely.
+ **/
+void retro_set_headless_callbacks(void);
+
 /**
  * retro_set_rewind_callbacks:
  *
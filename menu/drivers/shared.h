@@ -314,6 +314,8 @@ static INLINE void get_title(const char *label, const char *dir,
       snprintf(title, sizeof_title, "SCREENSHOT DIR %s", dir);
    else if (!strcmp(label, "video_shader_dir"))
       snprintf(title, sizeof_title, "SHADER DIR %s", dir);
+   else if (!strcmp(label, "video_shader_cache_dir"))
+      snprintf(title, sizeof_title, "SHADER CACHE DIR %s", dir);
    else if (!strcmp(label, "video_filter_dir"))
       snprintf(title, sizeof_title, "FILTER DIR %s", dir);
    else if (!strcmp(label, "audio_filter_dir"))
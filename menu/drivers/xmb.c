@@ -1142,6 +1142,11 @@ static void xmb_frame(void)
 
    xmb_render_background(gl, xmb, false);
 
+   /* Labels don't overlap the icons, so queue them up
+    * and draw all of them at once. */
+   if (gl->font_driver && gl->font_driver->begin_block)
+      gl->font_driver->begin_block(xmb->font.buf);
+
    xmb_draw_text(gl, xmb,
          xmb->title_name, xmb->margins.title.left, xmb->margins.title.top, 1, 1, 0);
 
@@ -1212,6 +1217,9 @@ static void xmb_frame(void)
                node->zoom);
    }
 
+   if (gl->font_driver && gl->font_driver->flush_block)
+      gl->font_driver->flush_block(xmb->font.buf);
+
 #ifdef GEKKO
    const char *message_queue;
 
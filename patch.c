@@ -21,6 +21,7 @@
 #include <boolean.h>
 #include <compat/msvc.h>
 #include <stdint.h>
+#include <stdio.h>
 #include <string.h>
 #include "patch.h"
 #include "hash.h"
@@ -42,16 +43,26 @@ struct bps_data
    uint8_t *target_data;
    size_t modify_length, source_length, target_length;
    size_t modify_offset, source_offset, target_offset;
-   uint32_t modify_checksum, source_checksum, target_checksum;
-
-   size_t source_relative_offset, target_relative_offset, output_offset;
+   size_t output_offset;
+   bool error;
 };
 
+static uint32_t patch_read_le32(const uint8_t *data)
+{
+   return data[0] | (data[1] << 8) | (data[2] << 16) |
+      ((uint32_t)data[3] << 24);
+}
+
 static uint8_t bps_read(struct bps_data *bps)
 {
-   uint8_t data = bps->modify_data[bps->modify_offset++];
-   bps->modify_checksum = crc32_adjust(bps->modify_checksum, data);
-   return data;
+   /* The last 12 bytes are checksums, never commands. */
+   if (bps->modify_offset >= bps->modify_length - 12)
+   {
+      bps->error = true;
+      return 0x80; /* Terminates bps_decode. */
+   }
+
+   return bps->modify_data[bps->modify_offset++];
 }
 
 static uint64_t bps_decode(struct bps_data *bps)
@@ -71,177 +82,300 @@ static uint64_t bps_decode(struct bps_data *bps)
    return data;
 }
 
-static void bps_write(struct bps_data *bps, uint8_t data)
+static patch_error_t bps_read_header(struct bps_data *bps,
+      size_t *source_size, size_t *target_size)
 {
-   bps->target_data[bps->output_offset++] = data;
-   bps->target_checksum = crc32_adjust(bps->target_checksum, data);
-}
-
-patch_error_t bps_apply_patch(
-      const uint8_t *modify_data, size_t modify_length,
-      const uint8_t *source_data, size_t source_length,
-      uint8_t *target_data, size_t *target_length)
-{
-   size_t i;
-   size_t modify_source_size, modify_target_size,
-          modify_markup_size;
-   struct bps_data bps = {0};
-   uint32_t modify_source_checksum = 0, modify_target_checksum = 0,
-            modify_modify_checksum = 0, checksum;
+   uint64_t markup_size;
 
-   if (modify_length < 19)
+   if (bps->modify_length < 19)
       return PATCH_PATCH_TOO_SMALL;
 
-   bps.modify_data = modify_data;
-   bps.modify_length = modify_length;
-   bps.target_data = target_data;
-   bps.target_length = *target_length;
-   bps.source_data = source_data;
-   bps.source_length = source_length;
-   bps.modify_checksum = ~0;
-   bps.target_checksum = ~0;
-
-   if ((bps_read(&bps) != 'B') || (bps_read(&bps) != 'P') ||
-         (bps_read(&bps) != 'S') || (bps_read(&bps) != '1'))
+   if ((bps_read(bps) != 'B') || (bps_read(bps) != 'P') ||
+         (bps_read(bps) != 'S') || (bps_read(bps) != '1'))
       return PATCH_PATCH_INVALID_HEADER;
 
-   modify_source_size = bps_decode(&bps);
-   modify_target_size = bps_decode(&bps);
-   modify_markup_size = bps_decode(&bps);
-   for (i = 0; i < modify_markup_size; i++)
-      bps_read(&bps);
+   *source_size = bps_decode(bps);
+   *target_size = bps_decode(bps);
+   markup_size  = bps_decode(bps);
 
-   if (modify_source_size > bps.source_length)
-      return PATCH_SOURCE_TOO_SMALL;
-   if (modify_target_size > bps.target_length)
-      return PATCH_TARGET_TOO_SMALL;
+   if (bps->error ||
+         markup_size > bps->modify_length - 12 - bps->modify_offset)
+      return PATCH_PATCH_INVALID;
 
-   while (bps.modify_offset < bps.modify_length - 12)
+   bps->modify_offset += markup_size;
+   return PATCH_SUCCESS;
+}
+
+/**
+ * bps_run:
+ * @bps              : decoder state, positioned after the header.
+ * @in_place         : cleared if a command reads source data which
+ *                     has already been overwritten when
+ *                     target and source share one buffer.
+ *
+ * Runs the command stream of a BPS patch, copying whole runs
+ * at once. Without a target buffer, only validates the commands.
+ *
+ * Returns: PATCH_SUCCESS, or PATCH_PATCH_INVALID if a command
+ * reads or writes out of bounds.
+ **/
+static patch_error_t bps_run(struct bps_data *bps, bool *in_place)
+{
+   uint8_t *target = bps->target_data;
+
+   while (bps->modify_offset < bps->modify_length - 12)
    {
-      size_t length = bps_decode(&bps);
-      unsigned mode = length & 3;
+      uint64_t data   = bps_decode(bps);
+      unsigned mode   = data & 3;
+      uint64_t length = (data >> 2) + 1;
+      size_t   out    = bps->output_offset;
 
-      length = (length >> 2) + 1;
+      if (bps->error || length > bps->target_length - out)
+         return PATCH_PATCH_INVALID;
 
       switch (mode)
       {
          case SOURCE_READ:
-            while (length--)
-               bps_write(&bps, bps.source_data[bps.output_offset]);
+            if (out + length > bps->source_length)
+               return PATCH_PATCH_INVALID;
+            if (target && target != bps->source_data)
+               memcpy(target + out, bps->source_data + out, length);
             break;
 
          case TARGET_READ:
-            while (length--)
-               bps_write(&bps, bps_read(&bps));
+            if (length > bps->modify_length - 12 - bps->modify_offset)
+               return PATCH_PATCH_INVALID;
+            if (target)
+               memcpy(target + out,
+                     bps->modify_data + bps->modify_offset, length);
+            bps->modify_offset += length;
             break;
 
          case SOURCE_COPY:
          case TARGET_COPY:
          {
-            int offset = bps_decode(&bps);
-            bool negative = offset & 1;
-            offset >>= 1;
-            if (negative)
-               offset = -offset;
+            uint64_t offset = bps_decode(bps);
+            size_t *base    = (mode == SOURCE_COPY) ?
+               &bps->source_offset : &bps->target_offset;
+
+            if (bps->error)
+               return PATCH_PATCH_INVALID;
+
+            if (offset & 1)
+            {
+               if ((offset >> 1) > *base)
+                  return PATCH_PATCH_INVALID;
+               *base -= offset >> 1;
+            }
+            else
+            {
+               if ((offset >> 1) > bps->target_length + bps->source_length)
+                  return PATCH_PATCH_INVALID;
+               *base += offset >> 1;
+            }
 
             if (mode == SOURCE_COPY)
             {
-               bps.source_offset += offset;
-               while (length--)
-                  bps_write(&bps, bps.source_data[bps.source_offset++]);
+               if (*base > bps->source_length ||
+                     length > bps->source_length - *base)
+                  return PATCH_PATCH_INVALID;
+
+               /* In place, everything before the output
+                * offset has already been overwritten. */
+               if (*base < out)
+                  *in_place = false;
+
+               if (target)
+                  memmove(target + out, bps->source_data + *base, length);
             }
             else
             {
-               bps.target_offset += offset;
-               while (length--)
-                  bps_write(&bps, bps.target_data[bps.target_offset++]);
-               break;
+               /* Target copies may overlap the output,
+                * repeating the bytes just written. */
+               if (*base >= out)
+                  return PATCH_PATCH_INVALID;
+
+               if (target && out - *base >= length)
+                  memcpy(target + out, target + *base, length);
+               else if (target)
+               {
+                  size_t i;
+                  for (i = 0; i < length; i++)
+                     target[out + i] = target[*base + i];
+               }
             }
+
+            *base += length;
             break;
          }
       }
+
+      bps->output_offset += length;
    }
 
+   if (bps->output_offset != bps->target_length)
+      return PATCH_PATCH_INVALID;
+
+   return PATCH_SUCCESS;
+}
+
+static bool bps_patch_size(const uint8_t *modify_data, size_t modify_length,
+      size_t source_length, size_t *target_length, bool *in_place)
+{
+   size_t source_size;
+   struct bps_data bps = {0};
+
+   bps.modify_data   = modify_data;
+   bps.modify_length = modify_length;
+
+   if (bps_read_header(&bps, &source_size, target_length) != PATCH_SUCCESS)
+      return false;
+
+   bps.source_length = source_length;
+   bps.target_length = *target_length;
+
+   *in_place = *target_length <= source_length;
+   return bps_run(&bps, in_place) == PATCH_SUCCESS;
+}
+
+patch_error_t bps_apply_patch(
+      const uint8_t *modify_data, size_t modify_length,
+      const uint8_t *source_data, size_t source_length,
+      uint8_t *target_data, size_t *target_length)
+{
+   patch_error_t err;
+   size_t modify_source_size, modify_target_size;
+   struct bps_data bps = {0};
+   bool in_place = true;
+   const uint8_t *checksums = modify_data + modify_length - 12;
 
-   for (i = 0; i < 32; i += 8)
-      modify_source_checksum |= bps_read(&bps) << i;
-   for (i = 0; i < 32; i += 8)
-      modify_target_checksum |= bps_read(&bps) << i;
+   bps.modify_data   = modify_data;
+   bps.modify_length = modify_length;
 
-   checksum = ~bps.modify_checksum;
-   for (i = 0; i < 32; i += 8)
-      modify_modify_checksum |= bps_read(&bps) << i;
+   err = bps_read_header(&bps, &modify_source_size, &modify_target_size);
+   if (err != PATCH_SUCCESS)
+      return err;
 
-   bps.source_checksum = crc32_calculate(bps.source_data, bps.source_length);
-   bps.target_checksum = ~bps.target_checksum;
+   if (modify_source_size > source_length)
+      return PATCH_SOURCE_TOO_SMALL;
+   if (modify_target_size > *target_length)
+      return PATCH_TARGET_TOO_SMALL;
 
-   if (bps.source_checksum != modify_source_checksum)
+   /* Verify everything that does not depend on the output first,
+    * so a failed in-place patch leaves the source untouched. */
+   if (crc32_calculate(modify_data, modify_length - 4)
+         != patch_read_le32(checksums + 8))
+      return PATCH_PATCH_CHECKSUM_INVALID;
+   if (crc32_calculate(source_data, source_length)
+         != patch_read_le32(checksums))
       return PATCH_SOURCE_CHECKSUM_INVALID;
-   if (bps.target_checksum != modify_target_checksum)
+
+   bps.source_data   = source_data;
+   bps.source_length = source_length;
+   bps.target_length = modify_target_size;
+
+   if (target_data == source_data)
+   {
+      struct bps_data dry_run = bps;
+
+      if (bps_run(&dry_run, &in_place) != PATCH_SUCCESS)
+         return PATCH_PATCH_INVALID;
+      if (!in_place)
+         return PATCH_IN_PLACE_UNSUPPORTED;
+   }
+
+   bps.target_data = target_data;
+
+   err = bps_run(&bps, &in_place);
+   if (err != PATCH_SUCCESS)
+      return err;
+
+   if (crc32_calculate(target_data, modify_target_size)
+         != patch_read_le32(checksums + 4))
       return PATCH_TARGET_CHECKSUM_INVALID;
-   if (checksum != modify_modify_checksum)
-      return PATCH_PATCH_CHECKSUM_INVALID;
 
    *target_length = modify_target_size;
 
    return PATCH_SUCCESS;
 }
 
-struct ups_data
+static uint64_t ups_decode(const uint8_t *data, size_t length,
+      size_t *offset)
 {
-   const uint8_t *patch_data, *source_data; 
-   uint8_t *target_data;
-   unsigned patch_length, source_length, target_length;
-   unsigned patch_offset, source_offset, target_offset;
-   unsigned patch_checksum, source_checksum, target_checksum;
-};
+   uint64_t value = 0, shift = 1;
 
-static uint8_t ups_patch_read(struct ups_data *data) 
-{
-   if (data->patch_offset < data->patch_length) 
+   while (*offset < length)
    {
-      uint8_t n = data->patch_data[data->patch_offset++];
-      data->patch_checksum = crc32_adjust(data->patch_checksum, n);
-      return n;
+      uint8_t x = data[(*offset)++];
+      value += (x & 0x7f) * shift;
+      if (x & 0x80)
+         break;
+      shift <<= 7;
+      value += shift;
    }
-   return 0x00;
+
+   return value;
 }
 
-static uint8_t ups_source_read(struct ups_data *data) 
+static bool ups_read_header(const uint8_t *patch_data, size_t patch_length,
+      size_t *offset, uint64_t *source_read_length,
+      uint64_t *target_read_length)
 {
-   if (data->source_offset < data->source_length) 
-   {
-      uint8_t n = data->source_data[data->source_offset++];
-      data->source_checksum = crc32_adjust(data->source_checksum, n);
-      return n;
-   }
-   return 0x00;
+   if (patch_length < 18 || memcmp(patch_data, "UPS1", 4) != 0)
+      return false;
+
+   *offset             = 4;
+   *source_read_length = ups_decode(patch_data, patch_length - 12, offset);
+   *target_read_length = ups_decode(patch_data, patch_length - 12, offset);
+
+   return *source_read_length <= SIZE_MAX && *target_read_length <= SIZE_MAX;
 }
 
-static void ups_target_write(struct ups_data *data, uint8_t n) 
+static bool ups_patch_size(const uint8_t *patch_data, size_t patch_length,
+      size_t source_length, size_t *target_length, bool *in_place)
 {
-   if (data->target_offset < data->target_length) 
-   {
-      data->target_data[data->target_offset] = n;
-      data->target_checksum = crc32_adjust(data->target_checksum, n);
-   }
+   size_t offset;
+   uint64_t source_read_length, target_read_length;
+
+   if (!ups_read_header(patch_data, patch_length, &offset,
+            &source_read_length, &target_read_length))
+      return false;
+
+   if (source_length == source_read_length)
+      *target_length = target_read_length;
+   else if (source_length == target_read_length)
+      *target_length = source_read_length;
+   else
+      return false;
 
-   data->target_offset++;
+   /* Source and target are always read and written
+    * at the same offset, so any patch that does not
+    * grow the content can be applied in place. */
+   *in_place = *target_length <= source_length;
+   return true;
 }
 
-static uint64_t ups_decode(struct ups_data *data) 
+/* Copies source bytes into the target, reading zeroes past the end
+ * of the source, as an unmodified run of a UPS patch does. */
+static void ups_copy(uint8_t *target, size_t target_length,
+      const uint8_t *source, size_t source_length,
+      size_t offset, uint64_t length)
 {
-   uint64_t offset = 0, shift = 1;
-   while (true) 
-   {
-      uint8_t x = ups_patch_read(data);
-      offset += (x & 0x7f) * shift;
-      if (x & 0x80) 
-         break;
-      shift <<= 7;
-      offset += shift;
-   }
-   return offset;
+   size_t copy;
+
+   if (offset >= target_length)
+      return;
+   if (length > target_length - offset)
+      length = target_length - offset;
+
+   copy = offset < source_length ? source_length - offset : 0;
+   if (copy > length)
+      copy = length;
+
+   if (copy && target != source)
+      memcpy(target + offset, source + offset, copy);
+   if (copy < length)
+      memset(target + offset + copy, 0, length - copy);
 }
 
 patch_error_t ups_apply_patch(
@@ -249,118 +383,103 @@ patch_error_t ups_apply_patch(
       const uint8_t *sourcedata, size_t sourcelength,
       uint8_t *targetdata, size_t *targetlength)
 {
-   size_t i;
-   unsigned source_read_length, target_read_length;
-   uint32_t patch_read_checksum = 0, source_read_checksum = 0,
-            target_read_checksum = 0, patch_result_checksum;
-   struct ups_data data = {0};
-
-   data.patch_data = patchdata;
-   data.source_data = sourcedata;
-   data.target_data = targetdata;
-   data.patch_length = patchlength;
-   data.source_length = sourcelength;
-   data.target_length = *targetlength;
-   data.patch_checksum = ~0;
-   data.source_checksum = ~0;
-   data.target_checksum = ~0;
-
-   if (data.patch_length < 18) 
-      return PATCH_PATCH_INVALID;
-   if (ups_patch_read(&data) != 'U') 
-      return PATCH_PATCH_INVALID;
-   if (ups_patch_read(&data) != 'P') 
-      return PATCH_PATCH_INVALID;
-   if (ups_patch_read(&data) != 'S') 
+   size_t offset, output, target_length;
+   uint64_t source_read_length, target_read_length;
+   uint32_t source_checksum, target_checksum;
+   const uint8_t *checksums = patchdata + patchlength - 12;
+
+   if (!ups_read_header(patchdata, patchlength, &offset,
+            &source_read_length, &target_read_length))
       return PATCH_PATCH_INVALID;
-   if (ups_patch_read(&data) != '1') 
+
+   if (crc32_calculate(patchdata, patchlength - 4)
+         != patch_read_le32(checksums + 8))
       return PATCH_PATCH_INVALID;
 
-   source_read_length = ups_decode(&data);
-   target_read_length = ups_decode(&data);
+   /* UPS patches apply in both directions. */
+   source_checksum = crc32_calculate(sourcedata, sourcelength);
 
-   if (data.source_length != source_read_length
-         && data.source_length != target_read_length) 
+   if (sourcelength == source_read_length &&
+         source_checksum == patch_read_le32(checksums))
+   {
+      target_length   = target_read_length;
+      target_checksum = patch_read_le32(checksums + 4);
+   }
+   else if (sourcelength == target_read_length &&
+         source_checksum == patch_read_le32(checksums + 4))
+   {
+      target_length   = source_read_length;
+      target_checksum = patch_read_le32(checksums);
+   }
+   else
       return PATCH_SOURCE_INVALID;
-   *targetlength = (data.source_length == source_read_length ?
-         target_read_length : source_read_length);
-   if (data.target_length < *targetlength) 
+
+   if (*targetlength < target_length)
       return PATCH_TARGET_TOO_SMALL;
-   data.target_length = *targetlength;
+   if (targetdata == sourcedata && target_length > sourcelength)
+      return PATCH_IN_PLACE_UNSUPPORTED;
 
-   while (data.patch_offset < data.patch_length - 12) 
+   output = 0;
+
+   while (offset < patchlength - 12)
    {
-      unsigned length = ups_decode(&data);
-      while (length--) 
-         ups_target_write(&data, ups_source_read(&data));
-      while (true) 
+      uint64_t length = ups_decode(patchdata, patchlength - 12, &offset);
+
+      ups_copy(targetdata, target_length, sourcedata, sourcelength,
+            output, length);
+      if (length > SIZE_MAX - output)
+         return PATCH_PATCH_INVALID;
+      output += length;
+
+      while (offset < patchlength - 12)
       {
-         uint8_t patch_xor = ups_patch_read(&data);
-         ups_target_write(&data, patch_xor ^ ups_source_read(&data));
+         uint8_t patch_xor = patchdata[offset++];
+
+         if (output < target_length)
+            targetdata[output] = patch_xor ^
+               (output < sourcelength ? sourcedata[output] : 0);
+         output++;
+
          if (patch_xor == 0)
             break;
       }
    }
 
-   while (data.source_offset < data.source_length) 
-      ups_target_write(&data, ups_source_read(&data));
-   while (data.target_offset < data.target_length) 
-      ups_target_write(&data, ups_source_read(&data));
+   if (output < target_length)
+      ups_copy(targetdata, target_length, sourcedata, sourcelength,
+            output, target_length - output);
 
-
-   for (i = 0; i < 4; i++) 
-      source_read_checksum |= ups_patch_read(&data) << (i * 8);
-   for (i = 0; i < 4; i++) 
-      target_read_checksum |= ups_patch_read(&data) << (i * 8);
-
-   patch_result_checksum = ~data.patch_checksum;
-   data.source_checksum  = ~data.source_checksum;
-   data.target_checksum  = ~data.target_checksum;
-
-   for (i = 0; i < 4; i++) 
-      patch_read_checksum |= ups_patch_read(&data) << (i * 8);
-
-   if (patch_result_checksum != patch_read_checksum) 
-      return PATCH_PATCH_INVALID;
-
-   if (data.source_checksum == source_read_checksum
-         && data.source_length == source_read_length) 
-   {
-      if (data.target_checksum == target_read_checksum
-            && data.target_length == target_read_length) 
-         return PATCH_SUCCESS;
-      return PATCH_TARGET_INVALID;
-   } 
-   else if (data.source_checksum == target_read_checksum
-         && data.source_length == target_read_length) 
-   {
-      if (data.target_checksum == source_read_checksum
-            && data.target_length == source_read_length) 
-         return PATCH_SUCCESS;
+   if (crc32_calculate(targetdata, target_length) != target_checksum)
       return PATCH_TARGET_INVALID;
-   } 
 
-   return PATCH_SOURCE_INVALID;
+   *targetlength = target_length;
+
+   return PATCH_SUCCESS;
 }
 
-patch_error_t ips_apply_patch(
-      const uint8_t *patchdata, size_t patchlen,
-      const uint8_t *sourcedata, size_t sourcelength,
-      uint8_t *targetdata, size_t *targetlength)
+/**
+ * ips_scan:
+ * @patchdata        : IPS patch.
+ * @patchlen         : size of @patchdata.
+ * @sourcelength     : size of the content to patch.
+ * @targetlength     : size of the patched content.
+ * @end              : end of the highest record.
+ *
+ * Validates all records of an IPS patch before anything is written.
+ * Records which start past the end of the content grow it,
+ * the optional truncation size after the EOF marker overrides that.
+ *
+ * Returns: PATCH_SUCCESS, or PATCH_PATCH_INVALID.
+ **/
+static patch_error_t ips_scan(const uint8_t *patchdata, size_t patchlen,
+      size_t sourcelength, size_t *targetlength, size_t *end)
 {
-   uint32_t offset = 5;
+   size_t offset = 5;
 
-   if (patchlen < 8 ||
-         patchdata[0] != 'P' ||
-         patchdata[1] != 'A' ||
-         patchdata[2] != 'T' ||
-         patchdata[3] != 'C' ||
-         patchdata[4] != 'H')
+   if (patchlen < 8 || memcmp(patchdata, "PATCH", 5) != 0)
       return PATCH_PATCH_INVALID;
 
-   memcpy(targetdata, sourcedata, sourcelength);
-
-   *targetlength = sourcelength;
+   *end = 0;
 
    for (;;)
    {
@@ -377,7 +496,10 @@ patch_error_t ips_apply_patch(
       if (address == 0x454f46) /* EOF */
       {
          if (offset == patchlen)
+         {
+            *targetlength = *end > sourcelength ? *end : sourcelength;
             return PATCH_SUCCESS;
+         }
          else if (offset == patchlen - 3)
          {
             uint32_t size = patchdata[offset++] << 16;
@@ -398,9 +520,7 @@ patch_error_t ips_apply_patch(
       {
          if (offset > patchlen - length)
             break;
-
-         while (length--)
-            targetdata[address++] = patchdata[offset++];
+         offset += length;
       }
       else /* RLE */
       {
@@ -413,84 +533,251 @@ patch_error_t ips_apply_patch(
          if (length == 0) /* Illegal */
             break;
 
-         while (length--)
-            targetdata[address++] = patchdata[offset];
-
          offset++;
       }
 
-      if (address > *targetlength)
-         *targetlength = address;
+      if (address + length > *end)
+         *end = address + length;
    }
 
    return PATCH_PATCH_INVALID;
 }
 
-static bool apply_patch_content(uint8_t **buf,
-      ssize_t *size, const char *patch_desc, const char *patch_path,
-      patch_func_t func)
+static bool ips_patch_size(const uint8_t *patchdata, size_t patchlen,
+      size_t sourcelength, size_t *targetlength, bool *in_place)
+{
+   size_t end;
+
+   if (ips_scan(patchdata, patchlen, sourcelength,
+            targetlength, &end) != PATCH_SUCCESS)
+      return false;
+
+   /* Records only ever overwrite the copy of the source. */
+   *in_place = *targetlength <= sourcelength;
+   return true;
+}
+
+patch_error_t ips_apply_patch(
+      const uint8_t *patchdata, size_t patchlen,
+      const uint8_t *sourcedata, size_t sourcelength,
+      uint8_t *targetdata, size_t *targetlength)
+{
+   size_t size, end;
+   uint32_t offset = 5;
+   patch_error_t err = ips_scan(patchdata, patchlen,
+         sourcelength, &size, &end);
+
+   if (err != PATCH_SUCCESS)
+      return err;
+
+   if (targetdata == sourcedata)
+   {
+      if (size > sourcelength)
+         return PATCH_IN_PLACE_UNSUPPORTED;
+   }
+   else
+   {
+      if (size > *targetlength)
+         return PATCH_TARGET_TOO_SMALL;
+
+      memcpy(targetdata, sourcedata, size < sourcelength ? size : sourcelength);
+      if (size > sourcelength)
+         memset(targetdata + sourcelength, 0, size - sourcelength);
+   }
+
+   *targetlength = size;
+
+   /* Records were validated by ips_scan, only clip them
+    * to a truncated target. */
+   while (offset < patchlen - 3)
+   {
+      uint32_t address;
+      unsigned length;
+      bool rle;
+
+      address  = patchdata[offset++] << 16;
+      address |= patchdata[offset++] << 8;
+      address |= patchdata[offset++] << 0;
+
+      if (address == 0x454f46 &&
+            (offset == patchlen || offset == patchlen - 3))
+         break;
+
+      length  = patchdata[offset++] << 8;
+      length |= patchdata[offset++] << 0;
+      rle     = length == 0;
+
+      if (rle)
+      {
+         length  = patchdata[offset++] << 8;
+         length |= patchdata[offset++] << 0;
+      }
+
+      if (address < size)
+      {
+         unsigned count = length;
+         if (count > size - address)
+            count = size - address;
+
+         if (rle)
+            memset(targetdata + address, patchdata[offset], count);
+         else
+            memcpy(targetdata + address, patchdata + offset, count);
+      }
+
+      offset += rle ? 1 : length;
+   }
+
+   return PATCH_SUCCESS;
+}
+
+typedef bool (*patch_size_func_t)(const uint8_t*, size_t,
+      size_t, size_t*, bool*);
+
+struct patch_format
+{
+   const char *desc;
+   patch_func_t apply;
+   patch_size_func_t size;
+};
+
+static const struct patch_format patch_ups = {
+   "UPS", ups_apply_patch, ups_patch_size
+};
+static const struct patch_format patch_bps = {
+   "BPS", bps_apply_patch, bps_patch_size
+};
+static const struct patch_format patch_ips = {
+   "IPS", ips_apply_patch, ips_patch_size
+};
+
+/* Content being patched. Every patch in a sequence is applied
+ * to the output of the previous one. */
+struct patch_target
+{
+   uint8_t *data;
+   size_t size;
+   bool writable;  /* Can be patched in place. */
+   bool owned;     /* Allocated here, freed when replaced. */
+   bool failed;    /* Stops the sequence. */
+   bool clobbered; /* Patched in place, but the result is invalid. */
+};
+
+static bool apply_patch_content(struct patch_target *content,
+      const struct patch_format *format, const char *patch_path)
 {
    void *patch_data = NULL;
-   size_t target_size;
-   patch_error_t err = PATCH_UNKNOWN;
-   bool success = false;
-   uint8_t *patched_content = NULL;
-   ssize_t ret_size = *size;
-   uint8_t *ret_buf = *buf;
    ssize_t patch_size;
-   
-   if (!read_file(patch_desc, &patch_data, &patch_size))
-      return false;
-   if (patch_size < 0)
-      return false;
+   size_t target_size;
+   bool in_place        = false;
+   bool patch_mapped    = false;
+   uint8_t *target      = NULL;
+   patch_error_t err    = PATCH_UNKNOWN;
 
    if (!path_file_exists(patch_path))
       return false;
 
+   if (map_file(patch_path, &patch_data, &patch_size))
+      patch_mapped = true;
+   else if (!read_file(patch_path, &patch_data, &patch_size))
+      return false;
+
+   if (patch_size < 0)
+      goto end;
+
    RARCH_LOG("Found %s file in \"%s\", attempting to patch ...\n",
-         patch_desc, patch_path);
+         format->desc, patch_path);
 
-   target_size = ret_size * 4; /* Just to be sure. */
+   if (!format->size((const uint8_t*)patch_data, patch_size,
+            content->size, &target_size, &in_place))
+   {
+      err = PATCH_PATCH_INVALID;
+      goto end;
+   }
 
-   patched_content = (uint8_t*)malloc(target_size);
+   in_place = in_place && content->writable;
+   target   = in_place ? content->data : (uint8_t*)malloc(target_size + 1);
 
-   if (!patched_content)
+   if (!target)
    {
       RARCH_ERR("Failed to allocate memory for patched content ...\n");
-      goto error;
+      goto end;
    }
 
-   err = func((const uint8_t*)patch_data, patch_size, ret_buf,
-         ret_size, patched_content, &target_size);
+   err = format->apply((const uint8_t*)patch_data, patch_size,
+         content->data, content->size, target, &target_size);
+
+   if (in_place)
+      content->clobbered = err == PATCH_TARGET_INVALID
+         || err == PATCH_TARGET_CHECKSUM_INVALID;
+   else if (err != PATCH_SUCCESS)
+      free(target);
+   else
+   {
+      if (content->owned)
+         free(content->data);
+      content->data     = target;
+      content->owned    = true;
+      content->writable = true;
+   }
 
    if (err == PATCH_SUCCESS)
    {
-      RARCH_LOG("Content patched successfully (%s).\n", patch_desc);
-      success = true;
+      /* RetroArch expects a \0 at the end. Content patched in
+       * place has room for it, as it did not grow. */
+      content->data[target_size] = '\0';
+      content->size              = target_size;
    }
+
+end:
+   content->failed = err != PATCH_SUCCESS;
+
+   if (err == PATCH_SUCCESS)
+      RARCH_LOG("Content patched successfully (%s%s).\n", format->desc,
+            in_place ? ", in place" : "");
    else
-      RARCH_ERR("Failed to patch %s: Error #%u\n", patch_desc,
+      RARCH_ERR("Failed to patch %s: Error #%u\n", format->desc,
             (unsigned)err);
 
-   if (success)
+   if (patch_mapped)
+      unmap_file(patch_data, patch_size);
+   else
+      free(patch_data);
+   return true;
+}
+
+/**
+ * apply_patch_sequence:
+ * @content          : content to patch.
+ * @format           : patch format.
+ * @patch_path       : path to the first patch.
+ *
+ * Applies @patch_path, followed by @patch_path with 1, 2, ...
+ * appended for as long as such files exist and apply cleanly,
+ * e.g. "game.ips", "game.ips1", "game.ips2".
+ *
+ * Returns: true if at least one patch was found.
+ **/
+static bool apply_patch_sequence(struct patch_target *content,
+      const struct patch_format *format, const char *patch_path)
+{
+   unsigned i;
+   char path[PATH_MAX_LENGTH];
+
+   if (!apply_patch_content(content, format, patch_path))
+      return false;
+
+   for (i = 1; !content->failed; i++)
    {
-      free(ret_buf);
-      *buf = patched_content;
-      *size = target_size;
+      snprintf(path, sizeof(path), "%s%u", patch_path, i);
+      if (!apply_patch_content(content, format, path))
+         break;
    }
 
-   free(patch_data);
    return true;
-
-error:
-   *buf = ret_buf;
-   *size = ret_size;
-   free(patch_data);
-
-   return false;
 }
 
-static bool try_bps_patch(uint8_t **buf, ssize_t *size)
+static bool try_bps_patch(struct patch_target *content)
 {
    bool allow_bps = !g_extern.ups_pref && !g_extern.ips_pref;
 
@@ -499,11 +786,10 @@ static bool try_bps_patch(uint8_t **buf, ssize_t *size)
    if (g_extern.bps_name[0] == '\0')
       return false;
 
-   return apply_patch_content(buf, size, "BPS", g_extern.bps_name,
-         bps_apply_patch);
+   return apply_patch_sequence(content, &patch_bps, g_extern.bps_name);
 }
 
-static bool try_ups_patch(uint8_t **buf, ssize_t *size)
+static bool try_ups_patch(struct patch_target *content)
 {
    bool allow_ups = !g_extern.bps_pref && !g_extern.ips_pref;
 
@@ -512,11 +798,10 @@ static bool try_ups_patch(uint8_t **buf, ssize_t *size)
    if (g_extern.ups_name[0] == '\0')
       return false;
 
-   return apply_patch_content(buf, size, "UPS", g_extern.ups_name,
-         ups_apply_patch);
+   return apply_patch_sequence(content, &patch_ups, g_extern.ups_name);
 }
 
-static bool try_ips_patch(uint8_t **buf, ssize_t *size)
+static bool try_ips_patch(struct patch_target *content)
 {
    bool allow_ips = !g_extern.ups_pref && !g_extern.bps_pref;
 
@@ -525,28 +810,56 @@ static bool try_ips_patch(uint8_t **buf, ssize_t *size)
    if (g_extern.ips_name[0] == '\0')
       return false;
 
-   return apply_patch_content(buf, size, "IPS", g_extern.ips_name,
-         ips_apply_patch);
+   return apply_patch_sequence(content, &patch_ips, g_extern.ips_name);
 }
 
 /**
  * patch_content:
  * @buf          : buffer of the content file.
  * @size         : size   of the content file.
+ * @writable     : whether @buf may be patched in place.
  *
- * Apply patch to the content file in-memory.
+ * Apply patches to the content file in-memory. Numbered patches
+ * ("game.ips1", "game.ips2", ...) are applied in sequence after
+ * the first one. Patches which do not grow the content are applied
+ * in place if @writable is set, others into a newly allocated
+ * buffer, which then replaces @buf. The original buffer is still
+ * owned by the caller.
  *
+ * Returns: false if @buf was patched in place, but patching failed
+ * halfway and its contents have to be reloaded, otherwise true.
  **/
-void patch_content(uint8_t **buf, ssize_t *size)
+bool patch_content(uint8_t **buf, ssize_t *size, bool writable)
 {
+   struct patch_target content = {0};
+
    if (g_extern.ups_pref + g_extern.bps_pref + g_extern.ips_pref > 1)
    {
       RARCH_WARN("Several patches are explicitly defined, ignoring all ...\n");
-      return;
+      return true;
    }
 
-   if (!try_ups_patch(buf, size) && !try_bps_patch(buf, size) && !try_ips_patch(buf, size))
+   content.data     = *buf;
+   content.size     = *size;
+   content.writable = writable;
+
+   if (!try_ups_patch(&content) && !try_bps_patch(&content)
+         && !try_ips_patch(&content))
    {
       RARCH_WARN("Did not find a valid content patch.\n");
    }
+
+   if (content.clobbered)
+   {
+      /* Only the buffer of the caller has to be reloaded,
+       * a copy made by an earlier patch is simply dropped. */
+      if (!content.owned)
+         return false;
+      free(content.data);
+      return true;
+   }
+
+   *buf  = content.data;
+   *size = content.size;
+   return true;
 }
@@ -19,6 +19,7 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include <boolean.h>
 
 /* BPS/UPS/IPS implementation from bSNES (nall::).
  * Modified for RetroArch. */
@@ -36,9 +37,15 @@ typedef enum
    PATCH_TARGET_INVALID,
    PATCH_SOURCE_CHECKSUM_INVALID,
    PATCH_TARGET_CHECKSUM_INVALID,
-   PATCH_PATCH_CHECKSUM_INVALID
+   PATCH_PATCH_CHECKSUM_INVALID,
+   PATCH_IN_PLACE_UNSUPPORTED
 } patch_error_t;
 
+/* Target and source data may be the same buffer to patch in place,
+ * which fails with PATCH_IN_PLACE_UNSUPPORTED if the patch grows
+ * the content or, for BPS, reads source data it has already
+ * overwritten. Everything which does not depend on the output is
+ * verified before the source is modified. */
 typedef patch_error_t (*patch_func_t)(const uint8_t*, size_t,
       const uint8_t*, size_t, uint8_t*, size_t*);
 
@@ -62,10 +69,18 @@ patch_error_t ips_apply_patch(
  * patch_content:
  * @buf          : buffer of the content file.
  * @size         : size   of the content file.
+ * @writable     : whether @buf may be patched in place.
  *
- * Apply patch to the content file in-memory.
+ * Apply patches to the content file in-memory. Numbered patches
+ * ("game.ips1", "game.ips2", ...) are applied in sequence after
+ * the first one. Patches which do not grow the content are applied
+ * in place if @writable is set, others into a newly allocated
+ * buffer, which then replaces @buf. The original buffer is still
+ * owned by the caller.
  *
+ * Returns: false if @buf was patched in place, but patching failed
+ * halfway and its contents have to be reloaded, otherwise true.
  **/
-void patch_content(uint8_t **buf, ssize_t *size);
+bool patch_content(uint8_t **buf, ssize_t *size, bool writable);
 
 #endif
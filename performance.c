@@ -247,6 +247,66 @@ retro_time_t rarch_get_time_usec(void)
 #endif
 }
 
+#if !defined(_WIN32) && !defined(__CELLOS_LV2__) && !defined(GEKKO) && !defined(__MACH__) && defined(_POSIX_MONOTONIC_CLOCK) && defined(TIMER_ABSTIME)
+#define HAVE_ABSOLUTE_SLEEP
+#include <errno.h>
+#endif
+
+#define SLEEP_SPIN_MIN_USEC 50
+#define SLEEP_SPIN_MAX_USEC 4000
+
+/* Estimated OS wakeup latency. Used as the length of the
+ * spin-wait tail in rarch_sleep_until(), and adapted to how
+ * late sleeps actually return. */
+static retro_time_t sleep_wakeup_latency = 1000;
+
+/**
+ * rarch_sleep_until:
+ * @target            : deadline in microseconds, on the same clock
+ *                      as rarch_get_time_usec().
+ * @spin              : busy-wait for the tail end of the sleep.
+ *
+ * Sleeps until @target. Where available, an absolute deadline
+ * is used so timer slack and sub-millisecond remainders do not
+ * accumulate. With @spin set, the OS sleep ends early by the
+ * estimated wakeup latency and the remainder is busy-waited.
+ **/
+void rarch_sleep_until(retro_time_t target, bool spin)
+{
+   retro_time_t current = rarch_get_time_usec();
+   retro_time_t wake    = spin ? target - sleep_wakeup_latency : target;
+
+   if (wake > current)
+   {
+#ifdef HAVE_ABSOLUTE_SLEEP
+      struct timespec tv;
+      tv.tv_sec  = wake / 1000000;
+      tv.tv_nsec = (wake % 1000000) * 1000;
+      while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME,
+               &tv, NULL) == EINTR);
+#else
+      rarch_sleep((unsigned)((wake - current) / 1000));
+#endif
+
+      if (spin)
+      {
+         /* Aim for a tail of twice the observed oversleep. */
+         retro_time_t late = 2 * (rarch_get_time_usec() - wake);
+
+         sleep_wakeup_latency += (late - sleep_wakeup_latency) / 8;
+         if (sleep_wakeup_latency < SLEEP_SPIN_MIN_USEC)
+            sleep_wakeup_latency = SLEEP_SPIN_MIN_USEC;
+         else if (sleep_wakeup_latency > SLEEP_SPIN_MAX_USEC)
+            sleep_wakeup_latency = SLEEP_SPIN_MAX_USEC;
+      }
+   }
+
+   if (!spin)
+      return;
+
+   while (rarch_get_time_usec() < target);
+}
+
 #if defined(__x86_64__) || defined(__i386__) || defined(__i486__) || defined(__i686__)
 #define CPU_X86
 #endif
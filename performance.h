@@ -68,6 +68,17 @@ retro_perf_tick_t rarch_get_perf_counter(void);
  **/
 retro_time_t rarch_get_time_usec(void);
 
+/**
+ * rarch_sleep_until:
+ * @target            : deadline in microseconds, on the same clock
+ *                      as rarch_get_time_usec().
+ * @spin              : busy-wait for the tail end of the sleep.
+ *
+ * Sleeps until @target. With @spin set, the OS sleep ends early
+ * by the estimated wakeup latency and the remainder is busy-waited.
+ **/
+void rarch_sleep_until(retro_time_t target, bool spin);
+
 void rarch_perf_register(struct retro_perf_counter *perf);
 
 /* Same as rarch_perf_register, just for libretro cores. */
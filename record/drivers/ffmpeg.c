@@ -43,6 +43,7 @@ extern "C" {
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <math.h>
 #include <boolean.h>
 #include <queues/fifo_buffer.h>
 #include <rthreads/rthreads.h>
@@ -50,13 +51,17 @@ extern "C" {
 #include <gfx/scaler/scaler.h>
 #include <file/config_file.h>
 #include "../../audio/audio_utils.h"
+#include "../../performance.h"
 #include "../record_driver.h"
-#include <assert.h>
 
 #ifdef FFEMU_PERF
 #include <time.h>
 #endif
 
+/* Frames queued between the emulator, conversion and encoding. */
+#define MAX_FRAMES 32
+#define DEFAULT_FRAMES 8
+
 #if LIBAVUTIL_VERSION_INT <= AV_VERSION_INT(52, 9, 0)
 #define av_frame_alloc avcodec_alloc_frame
 #define av_frame_free avcodec_free_frame
@@ -69,7 +74,26 @@ struct ff_video_info
 
    AVFrame *conv_frame;
    uint8_t *conv_frame_buf;
-   int64_t frame_cnt;
+
+   /* Frames are placed on the ticks of the output frame rate
+    * by their emulated time. With VFR, ticks which would only
+    * repeat the frame before are left out, otherwise they are
+    * filled with repeats. */
+   double fps;
+   bool vfr;
+   /* First tick not written yet. */
+   int64_t next_pts;
+   bool has_frame;
+
+   /* Intra-only codecs without delay repeat a frame by
+    * writing its packet again, which costs nothing to encode.
+    * Only keyframes are reused, as some intra-only codecs, like
+    * FFV1, carry coder state over into the frames after them. */
+   bool reuse_packets;
+   uint8_t *last_pkt;
+   size_t last_pkt_capacity;
+   int last_pkt_size;
+   int last_pkt_flags;
 
    uint8_t *outbuf;
    size_t outbuf_size;
@@ -79,9 +103,6 @@ struct ff_video_info
    /* Input pixel format. Only used by sws. */
    enum PixelFormat in_pix_fmt;
 
-   unsigned frame_drop_ratio;
-   unsigned frame_drop_count;
-
    /* Input pixel size. */
    size_t pix_size;
 
@@ -138,6 +159,20 @@ struct ff_muxer_info
    AVStream *vstream;
 };
 
+/* What to do when the encoder falls behind and the frame queue
+ * is full. Audio is always blocked on, never dropped. */
+enum ff_backpressure
+{
+   /* Wait for the encoder, stalling the emulator. */
+   FF_BACKPRESSURE_BLOCK = 0,
+   /* Drop the frame. */
+   FF_BACKPRESSURE_DROP,
+   /* Repeat the last frame while the queue is more than half
+    * full, which keeps timing intact at a fraction of the cost,
+    * and block if it fills up nonetheless. */
+   FF_BACKPRESSURE_DEGRADE
+};
+
 struct ff_config_param
 {
    config_file_t *conf;
@@ -147,8 +182,13 @@ struct ff_config_param
    enum PixelFormat out_pix_fmt;
    unsigned threads;
    unsigned frame_drop_ratio;
+   double video_fps;
+   bool vfr;
+   bool vfr_auto;
    unsigned sample_rate;
    unsigned scale_factor;
+   unsigned frame_queue;
+   enum ff_backpressure backpressure;
 
    bool audio_enable;
    /* Keep same naming conventions as libavcodec. */
@@ -163,6 +203,40 @@ struct ff_config_param
    AVDictionary *audio_opts;
 };
 
+enum ff_slot_state
+{
+   FF_SLOT_FREE = 0,
+   FF_SLOT_CAPTURED,
+   FF_SLOT_CONVERTED
+};
+
+struct ff_frame_slot
+{
+   struct ffemu_video_data attr;
+   /* Output ticks covered by the frame. */
+   int64_t pts;
+   int64_t end_pts;
+   /* Tightly packed input frame. */
+   uint8_t *buf;
+   /* Converted frame, swapped with the last encoded frame. */
+   AVFrame *frame;
+   uint8_t *frame_buf;
+   enum ff_slot_state state;
+};
+
+struct ff_pipeline_stats
+{
+   unsigned captured;
+   unsigned skipped;
+   unsigned dropped;
+   unsigned degraded;
+   unsigned encoded;
+   unsigned repeated;
+   unsigned reused;
+   unsigned max_queued;
+   retro_time_t blocked_usec;
+};
+
 typedef struct ffmpeg
 {
    struct ff_video_info video;
@@ -172,16 +246,27 @@ typedef struct ffmpeg
    
    struct ffemu_params params;
 
+   /* Video frames go from capture to conversion to encoding
+    * through a ring of slots, audio through a FIFO.
+    * Everything below is protected by lock. */
+   struct ff_frame_slot *slots;
+   unsigned num_slots;
+   unsigned queued;
+   unsigned capture_slot;
+   unsigned convert_slot;
+   unsigned encode_slot;
+
+   fifo_buffer_t *audio_fifo;
+   struct ff_pipeline_stats stats;
+   /* End of the last frame pushed, in output ticks. */
+   int64_t end_pts;
+
    scond_t *cond;
-   slock_t *cond_lock;
    slock_t *lock;
-   fifo_buffer_t *audio_fifo;
-   fifo_buffer_t *video_fifo;
-   fifo_buffer_t *attr_fifo;
    sthread_t *thread;
+   sthread_t *convert_thread;
 
-   volatile bool alive;
-   volatile bool can_sleep;
+   bool alive;
 } ffmpeg_t;
 
 static bool ffmpeg_codec_has_sample_format(enum AVSampleFormat fmt,
@@ -354,6 +439,22 @@ static bool ffmpeg_init_audio(ffmpeg_t *handle)
    return true;
 }
 
+static bool ffmpeg_alloc_frame(ffmpeg_t *handle,
+      AVFrame **frame, uint8_t **buf)
+{
+   size_t size = avpicture_get_size(handle->video.pix_fmt,
+         handle->params.out_width, handle->params.out_height);
+
+   *buf   = (uint8_t*)av_malloc(size);
+   *frame = av_frame_alloc();
+   if (!*buf || !*frame)
+      return false;
+
+   avpicture_fill((AVPicture*)*frame, *buf, handle->video.pix_fmt,
+         handle->params.out_width, handle->params.out_height);
+   return true;
+}
+
 static bool ffmpeg_init_video(ffmpeg_t *handle)
 {
    struct ff_config_param *params = &handle->config;
@@ -447,13 +548,23 @@ static bool ffmpeg_init_video(ffmpeg_t *handle)
    video->codec->codec_type          = AVMEDIA_TYPE_VIDEO;
    video->codec->width               = param->out_width;
    video->codec->height              = param->out_height;
-   video->codec->time_base           = av_d2q((double)
-         params->frame_drop_ratio /param->fps, 1000000); /* Arbitrary big number. */
+   video->fps = params->video_fps > 0.0 ? params->video_fps :
+      param->fps / params->frame_drop_ratio;
+   video->vfr = params->vfr;
+   if (params->vfr_auto)
+      video->vfr = (handle->muxer.ctx->oformat->flags & AVFMT_VARIABLE_FPS)
+         && !(handle->muxer.ctx->oformat->flags & AVFMT_NOTIMESTAMPS);
+
+   video->codec->time_base           = av_d2q(1.0 / video->fps,
+         1000000); /* Arbitrary big number. */
    video->codec->sample_aspect_ratio = av_d2q(
          param->aspect_ratio * param->out_height / param->out_width, 255);
    video->codec->pix_fmt             = video->pix_fmt;
 
+   /* Conversion runs on its own thread already, so unless
+    * told otherwise, leave the cores to the encoder. */
    video->codec->thread_count = params->threads;
+   video->scaler.threads      = params->threads ? params->threads : 1;
 
    if (params->video_qscale)
    {
@@ -475,27 +586,35 @@ static bool ffmpeg_init_video(ffmpeg_t *handle)
    video->outbuf_size = 1 << 23;
    video->outbuf = (uint8_t*)av_malloc(video->outbuf_size);
 
-   video->frame_drop_ratio = params->frame_drop_ratio;
+   {
+      const AVCodecDescriptor *desc = avcodec_descriptor_get(codec->id);
 
-   size_t size = avpicture_get_size(video->pix_fmt, param->out_width,
-         param->out_height);
-   video->conv_frame_buf = (uint8_t*)av_malloc(size);
-   video->conv_frame = av_frame_alloc();
-   avpicture_fill((AVPicture*)video->conv_frame, video->conv_frame_buf,
-         video->pix_fmt, param->out_width, param->out_height);
+      video->reuse_packets = desc &&
+         (desc->props & AV_CODEC_PROP_INTRA_ONLY) &&
+         !(codec->capabilities & CODEC_CAP_DELAY);
+   }
 
-   return true;
+   RARCH_LOG("[FFmpeg]: Video at %.4f fps, %s, repeats %s.\n",
+         video->fps, video->vfr ? "variable rate" : "constant rate",
+         video->reuse_packets ? "reuse packets" : "are encoded");
+
+   return ffmpeg_alloc_frame(handle, &video->conv_frame,
+         &video->conv_frame_buf);
 }
 
 static bool ffmpeg_init_config(struct ff_config_param *params,
       const char *config)
 {
    char pix_fmt[64] = {0};
+   char backpressure[64] = {0};
 
    params->out_pix_fmt = PIX_FMT_NONE;
    params->scale_factor = 1;
-   params->threads = 1;
+   params->threads = 0;
    params->frame_drop_ratio = 1;
+   params->frame_queue = DEFAULT_FRAMES;
+   params->backpressure = FF_BACKPRESSURE_DEGRADE;
+   params->vfr_auto = true;
 
    if (!config)
       return true;
@@ -520,12 +639,38 @@ static bool ffmpeg_init_config(struct ff_config_param *params,
             &params->frame_drop_ratio) || !params->frame_drop_ratio)
       params->frame_drop_ratio = 1;
 
+   /* Output frame rate, defaults to the rate of the core. */
+   config_get_double(params->conf, "video_fps", &params->video_fps);
+   params->vfr_auto = !config_get_bool(params->conf, "vfr", &params->vfr);
+
    if (!config_get_bool(params->conf, "audio_enable", &params->audio_enable))
       params->audio_enable = true;
 
    config_get_uint(params->conf, "sample_rate", &params->sample_rate);
    config_get_uint(params->conf, "scale_factor", &params->scale_factor);
 
+   config_get_uint(params->conf, "frame_queue", &params->frame_queue);
+   if (params->frame_queue < 2)
+      params->frame_queue = 2;
+   if (params->frame_queue > MAX_FRAMES)
+      params->frame_queue = MAX_FRAMES;
+
+   if (config_get_array(params->conf, "backpressure",
+            backpressure, sizeof(backpressure)))
+   {
+      if (!strcmp(backpressure, "block"))
+         params->backpressure = FF_BACKPRESSURE_BLOCK;
+      else if (!strcmp(backpressure, "drop"))
+         params->backpressure = FF_BACKPRESSURE_DROP;
+      else if (!strcmp(backpressure, "degrade"))
+         params->backpressure = FF_BACKPRESSURE_DEGRADE;
+      else
+      {
+         RARCH_ERR("Unknown backpressure \"%s\".\n", backpressure);
+         return false;
+      }
+   }
+
    params->audio_qscale = config_get_int(params->conf, "audio_global_quality",
          &params->audio_global_quality);
    config_get_int(params->conf, "audio_bit_rate", &params->audio_bit_rate);
@@ -612,70 +757,94 @@ static bool ffmpeg_init_muxer_post(ffmpeg_t *handle)
    return avformat_write_header(handle->muxer.ctx, NULL) >= 0;
 }
 
-#define MAX_FRAMES 32
-
 static void ffmpeg_thread(void *data);
+static void ffmpeg_convert_thread(void *data);
 
 static bool init_thread(ffmpeg_t *handle)
 {
+   unsigned i;
+   /* For some reason, FFmpeg has a tendency to crash
+    * if we don't overallocate a bit. */
+   size_t frame_size = (handle->params.fb_height + 1) *
+      handle->params.fb_width * handle->video.pix_size;
+
    handle->lock = slock_new();
-   handle->cond_lock = slock_new();
    handle->cond = scond_new();
-   handle->audio_fifo = fifo_new(32000 * sizeof(int16_t) *
-         handle->params.channels * MAX_FRAMES / 60); /* Some arbitrary max size. */
-   handle->attr_fifo = fifo_new(sizeof(struct ffemu_video_data) * MAX_FRAMES);
-   handle->video_fifo = fifo_new(handle->params.fb_width * handle->params.fb_height *
-            handle->video.pix_size * MAX_FRAMES);
+   /* About a second of audio. */
+   handle->audio_fifo = fifo_new((unsigned)handle->params.samplerate *
+         handle->params.channels * sizeof(int16_t));
+
+   handle->num_slots = handle->config.frame_queue;
+   handle->slots     = (struct ff_frame_slot*)calloc(handle->num_slots,
+         sizeof(*handle->slots));
 
-   handle->alive = true;
-   handle->can_sleep = true;
-   handle->thread = sthread_create(ffmpeg_thread, handle);
+   if (!handle->lock || !handle->cond || !handle->audio_fifo || !handle->slots)
+      return false;
 
-   assert(handle->lock && handle->cond_lock &&
-      handle->cond && handle->audio_fifo &&
-      handle->attr_fifo && handle->video_fifo && handle->thread);
+   for (i = 0; i < handle->num_slots; i++)
+   {
+      struct ff_frame_slot *slot = &handle->slots[i];
 
-   return true;
+      slot->buf = (uint8_t*)av_malloc(frame_size);
+      if (!slot->buf || !ffmpeg_alloc_frame(handle,
+               &slot->frame, &slot->frame_buf))
+         return false;
+   }
+
+   handle->alive          = true;
+   handle->thread         = sthread_create(ffmpeg_thread, handle);
+   handle->convert_thread = sthread_create(ffmpeg_convert_thread, handle);
+
+   return handle->thread && handle->convert_thread;
 }
 
 static void deinit_thread(ffmpeg_t *handle)
 {
-   if (!handle->thread)
-      return;
-
-   slock_lock(handle->cond_lock);
-   handle->alive = false;
-   handle->can_sleep = false;
-   slock_unlock(handle->cond_lock);
+   if (handle->lock && handle->cond)
+   {
+      slock_lock(handle->lock);
+      handle->alive = false;
+      scond_broadcast(handle->cond);
+      slock_unlock(handle->lock);
+   }
 
-   scond_signal(handle->cond);
-   sthread_join(handle->thread);
+   if (handle->convert_thread)
+      sthread_join(handle->convert_thread);
+   if (handle->thread)
+      sthread_join(handle->thread);
 
-   slock_free(handle->lock);
-   slock_free(handle->cond_lock);
-   scond_free(handle->cond);
+   if (handle->lock)
+      slock_free(handle->lock);
+   if (handle->cond)
+      scond_free(handle->cond);
 
-   handle->thread = NULL;
+   handle->convert_thread = NULL;
+   handle->thread         = NULL;
+   handle->lock           = NULL;
+   handle->cond           = NULL;
 }
 
 static void deinit_thread_buf(ffmpeg_t *handle)
 {
+   unsigned i;
+
    if (handle->audio_fifo)
    {
       fifo_free(handle->audio_fifo);
       handle->audio_fifo = NULL;
    }
-   
-   if (handle->attr_fifo)
-   {
-      fifo_free(handle->attr_fifo);
-      handle->attr_fifo = NULL;
-   }
 
-   if (handle->video_fifo)
+   if (handle->slots)
    {
-      fifo_free(handle->video_fifo);
-      handle->video_fifo = NULL;
+      for (i = 0; i < handle->num_slots; i++)
+      {
+         av_free(handle->slots[i].buf);
+         av_frame_free(&handle->slots[i].frame);
+         av_free(handle->slots[i].frame_buf);
+      }
+
+      free(handle->slots);
+      handle->slots = NULL;
    }
 }
 
@@ -704,6 +873,7 @@ static void ffmpeg_free(void *data)
 
    av_frame_free(&handle->video.conv_frame);
    av_free(handle->video.conv_frame_buf);
+   av_free(handle->video.last_pkt);
 
    scaler_ctx_gen_reset(&handle->video.scaler);
 
@@ -766,72 +936,126 @@ error:
    return NULL;
 }
 
+/**
+ * ffmpeg_frame_to_pts:
+ * @handle                  : FFmpeg handle.
+ * @frame                   : Number of the frame in emulated time.
+ *
+ * Returns: first tick of the output frame rate at or
+ * after the emulated time of @frame.
+ **/
+static int64_t ffmpeg_frame_to_pts(ffmpeg_t *handle, uint64_t frame)
+{
+   /* Keeps exact multiples from rounding up. */
+   return (int64_t)ceil(frame * handle->video.fps /
+         handle->params.fps - 1e-6);
+}
+
 static bool ffmpeg_push_video(void *data,
       const struct ffemu_video_data *video_data)
 {
    unsigned y;
-   bool drop_frame;
+   bool degrade, is_dupe, alive;
+   int64_t pts, end_pts;
    struct ffemu_video_data attr_data;
+   struct ff_frame_slot *slot = NULL;
    ffmpeg_t *handle = (ffmpeg_t*)data;
 
    if (!handle || !video_data)
       return false;
 
-   drop_frame = handle->video.frame_drop_count++ %
-      handle->video.frame_drop_ratio;
+   pts     = ffmpeg_frame_to_pts(handle, video_data->frame);
+   end_pts = ffmpeg_frame_to_pts(handle, video_data->frame + 1);
 
-   handle->video.frame_drop_count %= handle->video.frame_drop_ratio;
+   slock_lock(handle->lock);
 
-   if (drop_frame)
-      return true;
+   if (end_pts > handle->end_pts)
+      handle->end_pts = end_pts;
 
-   for (;;)
+   slot    = &handle->slots[handle->capture_slot];
+   degrade = handle->config.backpressure == FF_BACKPRESSURE_DEGRADE
+      && handle->queued >= handle->num_slots / 2
+      && !video_data->is_dupe;
+   is_dupe = video_data->is_dupe || degrade;
+
+   /* The frame falls between two ticks of the output rate,
+    * or only repeats the frame before, which VFR gets for free. */
+   if (pts >= end_pts || (is_dupe && handle->video.vfr))
    {
-      unsigned avail;
-      slock_lock(handle->lock);
-      avail = fifo_write_avail(handle->attr_fifo);
+      if (degrade)
+         handle->stats.degraded++;
+      else
+         handle->stats.skipped++;
       slock_unlock(handle->lock);
+      return true;
+   }
 
-      if (!handle->alive)
-         return false;
-
-      if (avail >= sizeof(*video_data))
-         break;
+   if (slot->state != FF_SLOT_FREE)
+   {
+      retro_time_t start;
 
-      slock_lock(handle->cond_lock);
-      if (handle->can_sleep)
+      if (handle->config.backpressure == FF_BACKPRESSURE_DROP)
       {
-         handle->can_sleep = false;
-         scond_wait(handle->cond, handle->cond_lock);
-         handle->can_sleep = true;
+         handle->stats.dropped++;
+         slock_unlock(handle->lock);
+         return true;
       }
-      else
-         scond_signal(handle->cond);
 
-      slock_unlock(handle->cond_lock);
+      start = rarch_get_time_usec();
+      while (handle->alive && slot->state != FF_SLOT_FREE)
+         scond_wait(handle->cond, handle->lock);
+      handle->stats.blocked_usec += rarch_get_time_usec() - start;
    }
 
-   slock_lock(handle->lock);
+   alive = handle->alive;
+   slock_unlock(handle->lock);
 
-   /* Tightly pack our frame to conserve memory.
-    * libretro tends to use a very large pitch.
-    */
+   if (!alive)
+      return false;
+
+   /* The slot is ours until it is queued. Tightly pack
+    * our frame to conserve memory, libretro tends
+    * to use a very large pitch. */
    attr_data = *video_data;
 
+   /* Falling behind, encode a repeat of the last frame
+    * instead, which is nearly free to convert and encode. */
+   if (degrade)
+   {
+      attr_data.is_dupe = true;
+      handle->stats.degraded++;
+   }
+
    if (attr_data.is_dupe)
       attr_data.width = attr_data.height = attr_data.pitch = 0;
    else
       attr_data.pitch = attr_data.width * handle->video.pix_size;
 
-   fifo_write(handle->attr_fifo, &attr_data, sizeof(attr_data));
+   if (attr_data.pitch == video_data->pitch)
+      memcpy(slot->buf, video_data->data,
+            attr_data.height * attr_data.pitch);
+   else
+   {
+      const uint8_t *in = (const uint8_t*)video_data->data;
 
-   int offset = 0;
-   for (y = 0; y < attr_data.height; y++, offset += video_data->pitch)
-      fifo_write(handle->video_fifo,
-            (const uint8_t*)video_data->data + offset, attr_data.pitch);
+      for (y = 0; y < attr_data.height; y++, in += video_data->pitch)
+         memcpy(slot->buf + y * attr_data.pitch, in, attr_data.pitch);
+   }
+
+   attr_data.data  = slot->buf;
+   slot->attr      = attr_data;
+   slot->pts       = pts;
+   slot->end_pts   = end_pts;
 
+   slock_lock(handle->lock);
+   slot->state          = FF_SLOT_CAPTURED;
+   handle->capture_slot = (handle->capture_slot + 1) % handle->num_slots;
+   handle->queued++;
+   handle->stats.captured++;
+   if (handle->queued > handle->stats.max_queued)
+      handle->stats.max_queued = handle->queued;
+   scond_broadcast(handle->cond);
    slock_unlock(handle->lock);
-   scond_signal(handle->cond);
 
    return true;
 }
@@ -839,6 +1063,7 @@ static bool ffmpeg_push_video(void *data,
 static bool ffmpeg_push_audio(void *data,
       const struct ffemu_audio_data *audio_data)
 {
+   size_t size;
    ffmpeg_t *handle = (ffmpeg_t*)data;
 
    if (!handle || !audio_data)
@@ -847,38 +1072,29 @@ static bool ffmpeg_push_audio(void *data,
    if (!handle->config.audio_enable)
       return true;
 
-   for (;;)
-   {
-      unsigned avail;
-      slock_lock(handle->lock);
-      avail = fifo_write_avail(handle->audio_fifo);
-      slock_unlock(handle->lock);
+   size = audio_data->frames * handle->params.channels * sizeof(int16_t);
 
-      if (!handle->alive)
-         return false;
+   /* Audio is never dropped. */
+   slock_lock(handle->lock);
 
-      if (avail >= audio_data->frames * handle->params.channels
-            * sizeof(int16_t))
-         break;
+   if (handle->alive && fifo_write_avail(handle->audio_fifo) < size)
+   {
+      retro_time_t start = rarch_get_time_usec();
 
-      slock_lock(handle->cond_lock);
-      if (handle->can_sleep)
-      {
-         handle->can_sleep = false;
-         scond_wait(handle->cond, handle->cond_lock);
-         handle->can_sleep = true;
-      }
-      else
-         scond_signal(handle->cond);
+      while (handle->alive && fifo_write_avail(handle->audio_fifo) < size)
+         scond_wait(handle->cond, handle->lock);
+      handle->stats.blocked_usec += rarch_get_time_usec() - start;
+   }
 
-      slock_unlock(handle->cond_lock);
+   if (!handle->alive)
+   {
+      slock_unlock(handle->lock);
+      return false;
    }
 
-   slock_lock(handle->lock);
-   fifo_write(handle->audio_fifo, audio_data->data,
-         audio_data->frames * handle->params.channels * sizeof(int16_t));
+   fifo_write(handle->audio_fifo, audio_data->data, size);
+   scond_broadcast(handle->cond);
    slock_unlock(handle->lock);
-   scond_signal(handle->cond);
 
    return true;
 }
@@ -919,7 +1135,7 @@ static bool encode_video(ffmpeg_t *handle, AVPacket *pkt, AVFrame *frame)
 }
 
 static void ffmpeg_scale_input(ffmpeg_t *handle,
-      const struct ffemu_video_data *data)
+      const struct ffemu_video_data *data, AVFrame *frame)
 {
    /* Attempt to preserve more information if we scale down. */
    bool shrunk = handle->params.out_width < data->width
@@ -935,8 +1151,8 @@ static void ffmpeg_scale_input(ffmpeg_t *handle,
 
       int linesize = data->pitch;
       sws_scale(handle->video.sws, (const uint8_t* const*)&data->data,
-            &linesize, 0, data->height, handle->video.conv_frame->data,
-            handle->video.conv_frame->linesize);
+            &linesize, 0, data->height, frame->data,
+            frame->linesize);
    }
    else
    {
@@ -952,40 +1168,144 @@ static void ffmpeg_scale_input(ffmpeg_t *handle,
 
          handle->video.scaler.out_width  = handle->params.out_width;
          handle->video.scaler.out_height = handle->params.out_height;
-         handle->video.scaler.out_stride = 
-            handle->video.conv_frame->linesize[0];
+         handle->video.scaler.out_stride = frame->linesize[0];
 
          scaler_ctx_gen_filter(&handle->video.scaler);
       }
 
       scaler_ctx_scale(&handle->video.scaler,
-            handle->video.conv_frame->data[0], data->data);
+            frame->data[0], data->data);
    }
 }
 
-static bool ffmpeg_push_video_thread(ffmpeg_t *handle,
-      const struct ffemu_video_data *data)
+static void ffmpeg_save_packet(ffmpeg_t *handle, const AVPacket *pkt)
 {
-   AVPacket pkt;
+   struct ff_video_info *video = &handle->video;
 
-   if (!data->is_dupe)
-      ffmpeg_scale_input(handle, data);
+   video->last_pkt_size = 0;
 
-   handle->video.conv_frame->pts = handle->video.frame_cnt;
+   if (!pkt->size)
+      return;
 
-   if (!encode_video(handle, &pkt, handle->video.conv_frame))
-      return false;
+   if ((size_t)pkt->size > video->last_pkt_capacity)
+   {
+      uint8_t *buf = (uint8_t*)av_realloc(video->last_pkt, pkt->size);
+      if (!buf)
+         return;
+
+      video->last_pkt          = buf;
+      video->last_pkt_capacity = pkt->size;
+   }
 
-   if (pkt.size)
+   memcpy(video->last_pkt, pkt->data, pkt->size);
+   video->last_pkt_size  = pkt->size;
+   video->last_pkt_flags = pkt->flags;
+}
+
+/**
+ * ffmpeg_repeat_video:
+ * @handle                  : FFmpeg handle.
+ * @pts                     : Tick to repeat up to, exclusive.
+ *
+ * Fills the ticks up to @pts with the last frame.
+ *
+ * Returns: true (1) if successful, otherwise false (0).
+ **/
+static bool ffmpeg_repeat_video(ffmpeg_t *handle, int64_t pts)
+{
+   struct ff_video_info *video = &handle->video;
+
+   /* Nothing to repeat before the first frame. */
+   if (!video->has_frame)
+   {
+      if (pts > video->next_pts)
+         video->next_pts = pts;
+      return true;
+   }
+
+   for (; video->next_pts < pts; video->next_pts++)
    {
-      if (av_interleaved_write_frame(handle->muxer.ctx, &pkt) < 0)
+      AVPacket pkt;
+
+      if (video->reuse_packets && video->last_pkt_size &&
+            (video->last_pkt_flags & AV_PKT_FLAG_KEY))
+      {
+         av_init_packet(&pkt);
+         pkt.data         = video->last_pkt;
+         pkt.size         = video->last_pkt_size;
+         pkt.flags        = video->last_pkt_flags;
+         pkt.pts          = av_rescale_q(video->next_pts,
+               video->codec->time_base, handle->muxer.vstream->time_base);
+         pkt.dts          = pkt.pts;
+         pkt.stream_index = handle->muxer.vstream->index;
+         handle->stats.reused++;
+      }
+      else
+      {
+         video->conv_frame->pts = video->next_pts;
+         if (!encode_video(handle, &pkt, video->conv_frame))
+            return false;
+
+         /* The repeat may be a keyframe the next ones can reuse. */
+         if (video->reuse_packets)
+            ffmpeg_save_packet(handle, &pkt);
+      }
+
+      handle->stats.repeated++;
+
+      if (pkt.size && av_interleaved_write_frame(handle->muxer.ctx, &pkt) < 0)
          return false;
    }
 
-   handle->video.frame_cnt++;
    return true;
 }
 
+static bool ffmpeg_push_video_thread(ffmpeg_t *handle,
+      struct ff_frame_slot *slot)
+{
+   AVPacket pkt;
+
+   if (!slot->attr.is_dupe)
+   {
+      AVFrame *frame     = handle->video.conv_frame;
+      uint8_t *frame_buf = handle->video.conv_frame_buf;
+
+      /* Frames dropped before this one
+       * are filled in at constant rate. */
+      if (!handle->video.vfr && !ffmpeg_repeat_video(handle, slot->pts))
+         return false;
+
+      /* Keep the new frame around for dupes and
+       * hand the previous one back to the pool. */
+      handle->video.conv_frame     = slot->frame;
+      handle->video.conv_frame_buf = slot->frame_buf;
+      slot->frame                  = frame;
+      slot->frame_buf              = frame_buf;
+
+      handle->video.conv_frame->pts = slot->pts;
+
+      if (!encode_video(handle, &pkt, handle->video.conv_frame))
+         return false;
+
+      if (handle->video.reuse_packets)
+         ffmpeg_save_packet(handle, &pkt);
+
+      if (pkt.size)
+      {
+         if (av_interleaved_write_frame(handle->muxer.ctx, &pkt) < 0)
+            return false;
+      }
+
+      handle->video.next_pts  = slot->pts + 1;
+      handle->video.has_frame = true;
+      handle->stats.encoded++;
+   }
+
+   if (handle->video.vfr)
+      return true;
+   return ffmpeg_repeat_video(handle, slot->end_pts);
+}
+
 static void planarize_float(float *out, const float *in, size_t frames)
 {
    size_t i;
@@ -1251,11 +1571,16 @@ static void ffmpeg_flush_video(ffmpeg_t *handle)
    }
 }
 
+static void ffmpeg_release_slot(ffmpeg_t *handle)
+{
+   handle->slots[handle->encode_slot].state = FF_SLOT_FREE;
+   handle->encode_slot = (handle->encode_slot + 1) % handle->num_slots;
+   handle->queued--;
+}
+
 static void ffmpeg_flush_buffers(ffmpeg_t *handle)
 {
    bool did_work;
-   void *video_buf = av_malloc(2 * handle->params.fb_width * 
-         handle->params.fb_height * handle->video.pix_size);
    size_t audio_buf_size = handle->config.audio_enable ? 
       (handle->audio.codec->frame_size * 
        handle->params.channels * sizeof(int16_t)) : 0;
@@ -1268,7 +1593,7 @@ static void ffmpeg_flush_buffers(ffmpeg_t *handle)
 
    do
    {
-      struct ffemu_video_data attr_buf;
+      struct ff_frame_slot *slot = &handle->slots[handle->encode_slot];
 
       did_work = false;
 
@@ -1287,18 +1612,26 @@ static void ffmpeg_flush_buffers(ffmpeg_t *handle)
          }
       }
 
-      if (fifo_read_avail(handle->attr_fifo) >= sizeof(attr_buf))
+      /* Frames left in the queue are in order,
+       * converted ones first. */
+      if (slot->state != FF_SLOT_FREE)
       {
-         fifo_read(handle->attr_fifo, &attr_buf, sizeof(attr_buf));
-         fifo_read(handle->video_fifo, video_buf, 
-               attr_buf.height * attr_buf.pitch);
-         attr_buf.data = video_buf;
-         ffmpeg_push_video_thread(handle, &attr_buf);
+         if (slot->state == FF_SLOT_CAPTURED && !slot->attr.is_dupe)
+            ffmpeg_scale_input(handle, &slot->attr, slot->frame);
+
+         ffmpeg_push_video_thread(handle, slot);
+         ffmpeg_release_slot(handle);
 
          did_work = true;
       }
    } while (did_work);
 
+   /* Carry the last frame to the end of the recording,
+    * VFR only needs its last tick to get the duration right. */
+   if (handle->video.vfr && handle->video.next_pts < handle->end_pts - 1)
+      handle->video.next_pts = handle->end_pts - 1;
+   ffmpeg_repeat_video(handle, handle->end_pts);
+
    /* Flush out last audio. */
    if (handle->config.audio_enable)
       ffmpeg_flush_audio(handle, audio_buf, audio_buf_size);
@@ -1306,7 +1639,6 @@ static void ffmpeg_flush_buffers(ffmpeg_t *handle)
    /* Flush out last video. */
    ffmpeg_flush_video(handle);
 
-   av_free(video_buf);
    av_free(audio_buf);
 }
 
@@ -1327,83 +1659,104 @@ static bool ffmpeg_finalize(void *data)
    /* Write final data. */
    av_write_trailer(handle->muxer.ctx);
 
+   RARCH_LOG("[FFmpeg]: Recorded %u frames, %u skipped for the output"
+         " rate or as repeats, %u dropped, %u repeated to catch up.\n",
+         handle->stats.captured, handle->stats.skipped,
+         handle->stats.dropped, handle->stats.degraded);
+   RARCH_LOG("[FFmpeg]: Encoded %u frames, %u repeats (%u reusing packets),"
+         " queue peak %u/%u, blocked for %.1f ms.\n",
+         handle->stats.encoded, handle->stats.repeated,
+         handle->stats.reused, handle->stats.max_queued,
+         handle->num_slots, handle->stats.blocked_usec / 1000.0);
+
    return true;
 }
 
-static void ffmpeg_thread(void *data)
+/* Converts captured frames into the pixel format and size
+ * of the encoder, so the encoder thread only encodes. */
+static void ffmpeg_convert_thread(void *data)
 {
    ffmpeg_t *ff = (ffmpeg_t*)data;
 
-   /* For some reason, FFmpeg has a tendency to crash 
-    * if we don't overallocate a bit. */
-   void *video_buf = av_malloc(2 * ff->params.fb_width *
-         ff->params.fb_height * ff->video.pix_size);
-   assert(video_buf);
-
-   size_t audio_buf_size = ff->config.audio_enable ? 
-      (ff->audio.codec->frame_size * ff->params.channels * sizeof(int16_t)) : 0;
-   void *audio_buf = audio_buf_size ? av_malloc(audio_buf_size) : NULL;
+   slock_lock(ff->lock);
 
    while (ff->alive)
    {
-      struct ffemu_video_data attr_buf;
+      struct ff_frame_slot *slot = &ff->slots[ff->convert_slot];
+
+      if (slot->state != FF_SLOT_CAPTURED)
+      {
+         scond_wait(ff->cond, ff->lock);
+         continue;
+      }
+
+      slock_unlock(ff->lock);
 
-      bool avail_video = false;
-      bool avail_audio = false;
+      if (!slot->attr.is_dupe)
+         ffmpeg_scale_input(ff, &slot->attr, slot->frame);
 
       slock_lock(ff->lock);
-      if (fifo_read_avail(ff->attr_fifo) >= sizeof(attr_buf))
-         avail_video = true;
+      slot->state      = FF_SLOT_CONVERTED;
+      ff->convert_slot = (ff->convert_slot + 1) % ff->num_slots;
+      scond_broadcast(ff->cond);
+   }
 
-      if (ff->config.audio_enable)
-         if (fifo_read_avail(ff->audio_fifo) >= audio_buf_size)
-            avail_audio = true;
-      slock_unlock(ff->lock);
+   slock_unlock(ff->lock);
+}
 
-      if (!avail_video && !avail_audio)
-      {
-         slock_lock(ff->cond_lock);
-         if (ff->can_sleep)
-         {
-            ff->can_sleep = false;
-            scond_wait(ff->cond, ff->cond_lock);
-            ff->can_sleep = true;
-         }
-         else
-            scond_signal(ff->cond);
+static void ffmpeg_thread(void *data)
+{
+   ffmpeg_t *ff = (ffmpeg_t*)data;
+   size_t audio_buf_size = ff->config.audio_enable ? 
+      (ff->audio.codec->frame_size * ff->params.channels * sizeof(int16_t)) : 0;
+   void *audio_buf = audio_buf_size ? av_malloc(audio_buf_size) : NULL;
 
-         slock_unlock(ff->cond_lock);
-      }
+   slock_lock(ff->lock);
 
-      if (avail_video)
+   while (ff->alive)
+   {
+      struct ff_frame_slot *slot = &ff->slots[ff->encode_slot];
+      bool avail_video = slot->state == FF_SLOT_CONVERTED;
+      bool avail_audio = ff->config.audio_enable &&
+         fifo_read_avail(ff->audio_fifo) >= audio_buf_size;
+
+      if (!avail_video && !avail_audio)
       {
-         slock_lock(ff->lock);
-         fifo_read(ff->attr_fifo, &attr_buf, sizeof(attr_buf));
-         fifo_read(ff->video_fifo, video_buf,
-               attr_buf.height * attr_buf.pitch);
-         slock_unlock(ff->lock);
-         scond_signal(ff->cond);
-
-         attr_buf.data = video_buf;
-         ffmpeg_push_video_thread(ff, &attr_buf);
+         scond_wait(ff->cond, ff->lock);
+         continue;
       }
 
       if (avail_audio)
       {
-         slock_lock(ff->lock);
          fifo_read(ff->audio_fifo, audio_buf, audio_buf_size);
-         slock_unlock(ff->lock);
-         scond_signal(ff->cond);
+         scond_broadcast(ff->cond);
+      }
 
+      slock_unlock(ff->lock);
+
+      if (avail_video)
+         ffmpeg_push_video_thread(ff, slot);
+
+      if (avail_audio)
+      {
          struct ffemu_audio_data aud = {0};
          aud.frames = ff->audio.codec->frame_size;
          aud.data = audio_buf;
 
          ffmpeg_push_audio_thread(ff, &aud, true);
       }
+
+      slock_lock(ff->lock);
+
+      if (avail_video)
+      {
+         ffmpeg_release_slot(ff);
+         scond_broadcast(ff->cond);
+      }
    }
 
-   av_free(video_buf);
+   slock_unlock(ff->lock);
+
    av_free(audio_buf);
 }
 
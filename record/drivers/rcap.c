@@ -0,0 +1,525 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Lossless capture backend. Records every frame and sample exactly
+ * as the core produced them into an .rcap capture, which
+ * tools/retroarch-rcap verifies and transcodes afterwards. */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <boolean.h>
+#include <compat/posix_string.h>
+#include <file/file_path.h>
+#include <file/config_file.h>
+
+#ifdef HAVE_THREADS
+#include <queues/fifo_buffer.h>
+#include <rthreads/rthreads.h>
+#endif
+
+#include "../../general.h"
+#include "../../performance.h"
+#include "../record_driver.h"
+#include "../rcap.h"
+
+#define RCAP_DEFAULT_FRAMES   8
+#define RCAP_MAX_FRAMES      64
+#define RCAP_KEYFRAME_SECONDS 10
+
+#ifdef HAVE_THREADS
+enum rcap_queue_type
+{
+   RCAP_QUEUE_VIDEO = 0,
+   RCAP_QUEUE_AUDIO
+};
+
+/* Video and audio share one queue, so the capture
+ * keeps them in the order the core produced them. */
+struct rcap_queue_entry
+{
+   enum rcap_queue_type type;
+   unsigned width;
+   unsigned height;
+   bool is_dupe;
+   size_t size;
+};
+#endif
+
+typedef struct rcap
+{
+   rcap_writer_t *writer;
+   struct ffemu_params params;
+   unsigned pix_size;
+   size_t max_frame_size;
+   bool failed;
+
+#ifdef HAVE_THREADS
+   fifo_buffer_t *queue;
+   slock_t *lock;
+   scond_t *cond;
+   sthread_t *thread;
+   bool alive;
+   uint8_t *buf;
+   size_t buf_size;
+#endif
+
+   /* Next frame in emulated time. */
+   uint64_t next_frame;
+
+   struct
+   {
+      unsigned dropped;
+      unsigned repeated;
+      retro_time_t blocked_usec;
+   } stats;
+} rcap_t;
+
+static bool rcap_init_config(rcap_t *handle,
+      unsigned *frame_queue, unsigned *keyframe_interval)
+{
+   config_file_t *conf = NULL;
+
+   *frame_queue       = RCAP_DEFAULT_FRAMES;
+   *keyframe_interval = (unsigned)(handle->params.fps *
+         RCAP_KEYFRAME_SECONDS);
+
+   if (handle->params.config)
+   {
+      conf = config_file_new(handle->params.config);
+      if (!conf)
+      {
+         RARCH_ERR("[rcap]: Failed to load config \"%s\".\n",
+               handle->params.config);
+         return false;
+      }
+
+      config_get_uint(conf, "frame_queue", frame_queue);
+      config_get_uint(conf, "keyframe_interval", keyframe_interval);
+      config_file_free(conf);
+   }
+
+   if (*frame_queue < 2)
+      *frame_queue = 2;
+   if (*frame_queue > RCAP_MAX_FRAMES)
+      *frame_queue = RCAP_MAX_FRAMES;
+   if (!*keyframe_interval)
+      *keyframe_interval = 1;
+
+   return true;
+}
+
+static bool rcap_write_video(rcap_t *handle, const void *data,
+      unsigned width, unsigned height, ptrdiff_t pitch)
+{
+   if (handle->failed)
+      return false;
+
+   if (!rcap_writer_push_video(handle->writer, data, width, height, pitch))
+   {
+      RARCH_ERR("[rcap]: Failed to write frame, capture is incomplete.\n");
+      handle->failed = true;
+      return false;
+   }
+
+   return true;
+}
+
+static bool rcap_write_audio(rcap_t *handle,
+      const int16_t *samples, size_t frames)
+{
+   if (handle->failed)
+      return false;
+
+   if (!rcap_writer_push_audio(handle->writer, samples, frames))
+   {
+      RARCH_ERR("[rcap]: Failed to write audio, capture is incomplete.\n");
+      handle->failed = true;
+      return false;
+   }
+
+   return true;
+}
+
+#ifdef HAVE_THREADS
+/* Drains the queue into the writer. Anything queued
+ * before shutdown is still written. */
+static void rcap_thread(void *data)
+{
+   rcap_t *handle = (rcap_t*)data;
+
+   slock_lock(handle->lock);
+
+   for (;;)
+   {
+      struct rcap_queue_entry entry;
+
+      if (fifo_read_avail(handle->queue) < sizeof(entry))
+      {
+         if (!handle->alive)
+            break;
+
+         scond_wait(handle->cond, handle->lock);
+         continue;
+      }
+
+      fifo_read(handle->queue, &entry, sizeof(entry));
+      fifo_read(handle->queue, handle->buf, entry.size);
+      scond_broadcast(handle->cond);
+      slock_unlock(handle->lock);
+
+      if (entry.type == RCAP_QUEUE_AUDIO)
+         rcap_write_audio(handle, (const int16_t*)handle->buf,
+               entry.size / (handle->params.channels * sizeof(int16_t)));
+      else
+         rcap_write_video(handle, entry.is_dupe ? NULL : handle->buf,
+               entry.width, entry.height, entry.width * handle->pix_size);
+
+      slock_lock(handle->lock);
+   }
+
+   slock_unlock(handle->lock);
+}
+
+static bool rcap_init_thread(rcap_t *handle, unsigned frame_queue)
+{
+   /* About a second of audio, which is written in much smaller pieces. */
+   size_t audio_size = (size_t)handle->params.samplerate *
+      handle->params.channels * sizeof(int16_t);
+
+   handle->buf_size = handle->max_frame_size;
+   if (audio_size > handle->buf_size)
+      handle->buf_size = audio_size;
+
+   handle->lock  = slock_new();
+   handle->cond  = scond_new();
+   handle->buf   = (uint8_t*)malloc(handle->buf_size);
+   handle->queue = fifo_new(frame_queue *
+         (handle->max_frame_size + sizeof(struct rcap_queue_entry)) +
+         audio_size + sizeof(struct rcap_queue_entry));
+
+   if (!handle->lock || !handle->cond || !handle->buf || !handle->queue)
+      return false;
+
+   handle->alive  = true;
+   handle->thread = sthread_create(rcap_thread, handle);
+   return handle->thread != NULL;
+}
+
+static void rcap_deinit_thread(rcap_t *handle)
+{
+   if (handle->lock && handle->cond)
+   {
+      slock_lock(handle->lock);
+      handle->alive = false;
+      scond_broadcast(handle->cond);
+      slock_unlock(handle->lock);
+   }
+
+   if (handle->thread)
+      sthread_join(handle->thread);
+
+   if (handle->lock)
+      slock_free(handle->lock);
+   if (handle->cond)
+      scond_free(handle->cond);
+   if (handle->queue)
+      fifo_free(handle->queue);
+   free(handle->buf);
+
+   handle->thread = NULL;
+   handle->lock   = NULL;
+   handle->cond   = NULL;
+   handle->queue  = NULL;
+   handle->buf    = NULL;
+}
+
+/* Waits until @size bytes fit into the queue. Lossless captures
+ * never drop anything, the core is stalled instead. */
+static bool rcap_queue_reserve(rcap_t *handle, size_t size)
+{
+   if (handle->alive && fifo_write_avail(handle->queue) < size)
+   {
+      retro_time_t start = rarch_get_time_usec();
+
+      while (handle->alive && fifo_write_avail(handle->queue) < size)
+         scond_wait(handle->cond, handle->lock);
+      handle->stats.blocked_usec += rarch_get_time_usec() - start;
+   }
+
+   return handle->alive;
+}
+#endif
+
+static void rcap_free(void *data)
+{
+   rcap_t *handle = (rcap_t*)data;
+   if (!handle)
+      return;
+
+#ifdef HAVE_THREADS
+   rcap_deinit_thread(handle);
+#endif
+
+   if (handle->writer)
+      rcap_writer_free(handle->writer, NULL);
+
+   free(handle);
+}
+
+static void *rcap_new(const struct ffemu_params *params)
+{
+   struct rcap_header header = {0};
+   unsigned frame_queue, keyframe_interval;
+   const char *ext = params->filename ?
+      path_get_extension(params->filename) : NULL;
+   rcap_t *handle  = NULL;
+
+   /* Only used when asked for explicitly. */
+   if (!ext || strcasecmp(ext, "rcap"))
+      return NULL;
+
+   handle = (rcap_t*)calloc(1, sizeof(*handle));
+   if (!handle)
+      return NULL;
+
+   handle->params = *params;
+
+   switch (params->pix_fmt)
+   {
+      case FFEMU_PIX_BGR24:
+         header.pix_fmt = RCAP_PIX_BGR24;
+         break;
+      case FFEMU_PIX_ARGB8888:
+         header.pix_fmt = RCAP_PIX_XRGB8888;
+         break;
+      case FFEMU_PIX_RGB565:
+      default:
+         header.pix_fmt = RCAP_PIX_RGB565;
+         break;
+   }
+
+   handle->pix_size       = rcap_pix_size(header.pix_fmt);
+   handle->max_frame_size = (size_t)params->fb_width *
+      params->fb_height * handle->pix_size;
+
+   if (!rcap_init_config(handle, &frame_queue, &keyframe_interval))
+      goto error;
+
+   header.width        = params->out_width;
+   header.height       = params->out_height;
+   header.aspect_ratio = params->aspect_ratio;
+   header.fps          = params->fps;
+   header.samplerate   = params->samplerate;
+   header.channels     = params->channels;
+
+   handle->writer = rcap_writer_new(params->filename,
+         &header, keyframe_interval);
+   if (!handle->writer)
+   {
+      RARCH_ERR("[rcap]: Failed to create \"%s\".\n", params->filename);
+      goto error;
+   }
+
+#ifdef HAVE_THREADS
+   if (!rcap_init_thread(handle, frame_queue))
+      goto error;
+#endif
+
+   RARCH_LOG("[rcap]: Lossless capture, keyframe every %u frames.\n",
+         keyframe_interval);
+
+   return handle;
+
+error:
+   rcap_free(handle);
+   return NULL;
+}
+
+static bool rcap_queue_video(rcap_t *handle,
+      const struct ffemu_video_data *video_data)
+{
+   size_t line, size;
+#ifdef HAVE_THREADS
+   unsigned y;
+   struct rcap_queue_entry entry = {RCAP_QUEUE_VIDEO};
+#endif
+
+   line = video_data->width * handle->pix_size;
+   size = video_data->is_dupe ? 0 : line * video_data->height;
+
+   if (size > handle->max_frame_size)
+   {
+      RARCH_WARN("[rcap]: Frame of %ux%u exceeds the framebuffer, dropped.\n",
+            video_data->width, video_data->height);
+      handle->stats.dropped++;
+      return false;
+   }
+
+#ifdef HAVE_THREADS
+   entry.width   = video_data->width;
+   entry.height  = video_data->height;
+   entry.is_dupe = video_data->is_dupe;
+   entry.size    = size;
+
+   slock_lock(handle->lock);
+
+   if (!rcap_queue_reserve(handle, sizeof(entry) + size))
+   {
+      slock_unlock(handle->lock);
+      return false;
+   }
+
+   /* Tightly pack the frame into the queue,
+    * libretro tends to use a very large pitch. */
+   fifo_write(handle->queue, &entry, sizeof(entry));
+   if (size && video_data->pitch == (int)line)
+      fifo_write(handle->queue, video_data->data, size);
+   else if (size)
+   {
+      const uint8_t *in = (const uint8_t*)video_data->data;
+
+      for (y = 0; y < video_data->height; y++, in += video_data->pitch)
+         fifo_write(handle->queue, in, line);
+   }
+
+   scond_broadcast(handle->cond);
+   slock_unlock(handle->lock);
+   return true;
+#else
+   return rcap_write_video(handle,
+         video_data->is_dupe ? NULL : video_data->data,
+         video_data->width, video_data->height, video_data->pitch);
+#endif
+}
+
+static bool rcap_push_video(void *data,
+      const struct ffemu_video_data *video_data)
+{
+   rcap_t *handle = (rcap_t*)data;
+
+   if (!handle || !video_data)
+      return false;
+
+   /* Keeps emulated time, frames which never
+    * arrived repeat the one before. */
+   while (handle->next_frame < video_data->frame)
+   {
+      struct ffemu_video_data dupe = *video_data;
+
+      dupe.is_dupe = true;
+      handle->next_frame++;
+      handle->stats.repeated++;
+
+      if (!rcap_queue_video(handle, &dupe))
+         return false;
+   }
+
+   handle->next_frame = video_data->frame + 1;
+   return rcap_queue_video(handle, video_data);
+}
+
+static bool rcap_push_audio(void *data,
+      const struct ffemu_audio_data *audio_data)
+{
+   rcap_t *handle = (rcap_t*)data;
+#ifdef HAVE_THREADS
+   size_t size, max_frames;
+   struct rcap_queue_entry entry = {RCAP_QUEUE_AUDIO};
+   const int16_t *samples = NULL;
+   size_t frames          = 0;
+#endif
+
+   if (!handle || !audio_data)
+      return false;
+
+#ifdef HAVE_THREADS
+   samples    = (const int16_t*)audio_data->data;
+   frames     = audio_data->frames;
+   max_frames = handle->buf_size /
+      (handle->params.channels * sizeof(int16_t));
+
+   slock_lock(handle->lock);
+
+   while (frames)
+   {
+      size_t chunk = frames < max_frames ? frames : max_frames;
+
+      size       = chunk * handle->params.channels * sizeof(int16_t);
+      entry.size = size;
+
+      if (!rcap_queue_reserve(handle, sizeof(entry) + size))
+      {
+         slock_unlock(handle->lock);
+         return false;
+      }
+
+      fifo_write(handle->queue, &entry, sizeof(entry));
+      fifo_write(handle->queue, samples, size);
+      scond_broadcast(handle->cond);
+
+      samples += chunk * handle->params.channels;
+      frames  -= chunk;
+   }
+
+   slock_unlock(handle->lock);
+   return true;
+#else
+   return rcap_write_audio(handle,
+         (const int16_t*)audio_data->data, audio_data->frames);
+#endif
+}
+
+static bool rcap_finalize(void *data)
+{
+   bool ret;
+   struct rcap_info info = {0};
+   rcap_t *handle = (rcap_t*)data;
+
+   if (!handle || !handle->writer)
+      return false;
+
+#ifdef HAVE_THREADS
+   /* Writes out everything still queued. */
+   rcap_deinit_thread(handle);
+#endif
+
+   ret            = rcap_writer_free(handle->writer, &info) && !handle->failed;
+   handle->writer = NULL;
+
+   RARCH_LOG("[rcap]: Captured %u frames (%u keyframes, %u dropped,"
+         " %u missing filled in) and %llu audio frames,"
+         " blocked for %.1f ms.\n",
+         info.frames, info.keyframes, handle->stats.dropped,
+         handle->stats.repeated,
+         (unsigned long long)info.audio_frames,
+         handle->stats.blocked_usec / 1000.0);
+
+   if (!ret)
+      RARCH_ERR("[rcap]: Capture \"%s\" is incomplete.\n",
+            handle->params.filename);
+
+   return ret;
+}
+
+const ffemu_backend_t ffemu_rcap = {
+   rcap_new,
+   rcap_free,
+   rcap_push_video,
+   rcap_push_audio,
+   rcap_finalize,
+   "rcap",
+};
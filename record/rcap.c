@@ -0,0 +1,1042 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <retro_inline.h>
+#include <retro_endianness.h>
+
+#include "rcap.h"
+#include "../hash.h"
+
+#define RCAP_FOURCC(a, b, c, d) ((uint32_t)(a) | ((uint32_t)(b) << 8) | \
+      ((uint32_t)(c) << 16) | ((uint32_t)(d) << 24))
+
+#define RCAP_CHUNK_KEY   RCAP_FOURCC('V', 'K', 'E', 'Y')
+#define RCAP_CHUNK_DELTA RCAP_FOURCC('V', 'D', 'L', 'T')
+#define RCAP_CHUNK_AUDIO RCAP_FOURCC('A', 'U', 'D', 'I')
+#define RCAP_CHUNK_INDEX RCAP_FOURCC('I', 'N', 'D', 'X')
+
+static const char rcap_magic[4]         = { 'R', 'C', 'A', 'P' };
+static const char rcap_trailer_magic[8] = { 'R', 'C', 'A', 'P', 'I', 'N', 'D', 'X' };
+
+/* File header: magic, version, pix_fmt, flags, width, height,
+ * channels, reserved, aspect ratio, fps, sample rate, reserved. */
+#define RCAP_HEADER_SIZE        64
+/* Chunk header: fourcc, payload size. */
+#define RCAP_CHUNK_HEADER_SIZE   8
+/* Video payload: frame, width, height, CRC32, then pixels or runs. */
+#define RCAP_FRAME_HEADER_SIZE  16
+/* Run of changed words: words to skip, words changed, then the words. */
+#define RCAP_RUN_HEADER_SIZE     8
+/* Audio payload: frames, then samples. */
+#define RCAP_AUDIO_HEADER_SIZE   4
+/* Index payload: frames, keyframes, audio frames, max width, max height,
+ * then one entry of frame, reserved, audio frames, offset per keyframe. */
+#define RCAP_INDEX_HEADER_SIZE  24
+#define RCAP_INDEX_ENTRY_SIZE   24
+/* Trailer: offset of the index chunk, trailer magic. */
+#define RCAP_TRAILER_SIZE       16
+
+/* Unchanged stretches shorter than this are folded into
+ * the surrounding run, they would cost more than they save. */
+#define RCAP_MIN_SKIP (RCAP_RUN_HEADER_SIZE / sizeof(uint16_t))
+
+struct rcap_index_entry
+{
+   uint32_t frame;
+   uint64_t audio_frames;
+   uint64_t offset;
+};
+
+struct rcap_index
+{
+   struct rcap_index_entry *entries;
+   size_t size;
+   size_t capacity;
+};
+
+struct rcap_writer
+{
+   FILE *file;
+   struct rcap_header header;
+   struct rcap_info info;
+   struct rcap_index index;
+   unsigned pix_size;
+   unsigned keyframe_interval;
+   unsigned since_keyframe;
+
+   /* Previous and current frame, packed. The words scanned for
+    * changes may extend one byte past the frame, which is kept zero. */
+   uint8_t *prev;
+   uint8_t *cur;
+   uint8_t *delta;
+   size_t capacity;
+
+   bool have_frame;
+   unsigned width;
+   unsigned height;
+   uint32_t crc;
+
+   uint64_t offset;
+   bool error;
+};
+
+struct rcap_reader
+{
+   FILE *file;
+   struct rcap_header header;
+   struct rcap_info info;
+   struct rcap_index index;
+   unsigned pix_size;
+
+   /* Chunks end here, the index and trailer follow. */
+   uint64_t data_end;
+   uint64_t offset;
+
+   uint8_t *frame;
+   size_t frame_capacity;
+   bool have_frame;
+   unsigned width;
+   unsigned height;
+
+   uint8_t *payload;
+   size_t payload_capacity;
+
+   /* Packet decoded by rcap_reader_seek(), returned next. */
+   struct rcap_packet pending;
+   bool has_pending;
+};
+
+static INLINE void rcap_write_le32(uint8_t *data, uint32_t val)
+{
+   data[0] = val;
+   data[1] = val >> 8;
+   data[2] = val >> 16;
+   data[3] = val >> 24;
+}
+
+static INLINE void rcap_write_le64(uint8_t *data, uint64_t val)
+{
+   rcap_write_le32(data, (uint32_t)val);
+   rcap_write_le32(data + 4, (uint32_t)(val >> 32));
+}
+
+static INLINE void rcap_write_double(uint8_t *data, double val)
+{
+   uint64_t bits;
+   memcpy(&bits, &val, sizeof(bits));
+   rcap_write_le64(data, bits);
+}
+
+static INLINE uint32_t rcap_read_le32(const uint8_t *data)
+{
+   return (uint32_t)data[0] | ((uint32_t)data[1] << 8) |
+      ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+static INLINE uint64_t rcap_read_le64(const uint8_t *data)
+{
+   return rcap_read_le32(data) | ((uint64_t)rcap_read_le32(data + 4) << 32);
+}
+
+static INLINE double rcap_read_double(const uint8_t *data)
+{
+   double val;
+   uint64_t bits = rcap_read_le64(data);
+   memcpy(&val, &bits, sizeof(val));
+   return val;
+}
+
+unsigned rcap_pix_size(uint32_t pix_fmt)
+{
+   switch (pix_fmt)
+   {
+      case RCAP_PIX_RGB565:
+         return 2;
+      case RCAP_PIX_BGR24:
+         return 3;
+      case RCAP_PIX_XRGB8888:
+         return 4;
+   }
+
+   return 0;
+}
+
+static bool rcap_index_append(struct rcap_index *index,
+      uint32_t frame, uint64_t audio_frames, uint64_t offset)
+{
+   if (index->size == index->capacity)
+   {
+      size_t capacity = index->capacity ? index->capacity * 2 : 64;
+      struct rcap_index_entry *entries = (struct rcap_index_entry*)
+         realloc(index->entries, capacity * sizeof(*entries));
+
+      if (!entries)
+         return false;
+
+      index->entries  = entries;
+      index->capacity = capacity;
+   }
+
+   index->entries[index->size].frame        = frame;
+   index->entries[index->size].audio_frames = audio_frames;
+   index->entries[index->size].offset       = offset;
+   index->size++;
+   return true;
+}
+
+/* Bounded variants of the scanners in rewind.c. Frame buffers
+ * come from malloc(), so word and size_t accesses are aligned. */
+static INLINE size_t rcap_find_change(const uint16_t *a,
+      const uint16_t *b, size_t pos, size_t num16s)
+{
+   const size_t step = sizeof(size_t) / sizeof(uint16_t);
+
+   while ((pos & (step - 1)) && pos < num16s && a[pos] == b[pos])
+      pos++;
+
+   while (pos + step <= num16s &&
+         *(const size_t*)(a + pos) == *(const size_t*)(b + pos))
+      pos += step;
+
+   while (pos < num16s && a[pos] == b[pos])
+      pos++;
+
+   return pos;
+}
+
+static INLINE size_t rcap_find_same(const uint16_t *a,
+      const uint16_t *b, size_t pos, size_t num16s)
+{
+   while (pos < num16s)
+   {
+      if (a[pos] == b[pos])
+      {
+         size_t i;
+         size_t end = pos + RCAP_MIN_SKIP;
+
+         if (end > num16s)
+            end = num16s;
+
+         for (i = pos + 1; i < end && a[i] == b[i]; i++);
+
+         if (i == end)
+            return pos;
+
+         pos = i;
+      }
+
+      pos++;
+   }
+
+   return num16s;
+}
+
+/**
+ * rcap_encode_delta:
+ * @prev             : Previous frame.
+ * @cur              : Current frame.
+ * @num16s           : Size of the frames in words.
+ * @out              : Encoded runs.
+ * @limit            : Maximum size of the runs in bytes.
+ *
+ * Returns: size of the runs, or (size_t)-1 if they
+ * would not fit into @limit bytes.
+ **/
+static size_t rcap_encode_delta(const uint8_t *prev, const uint8_t *cur,
+      size_t num16s, uint8_t *out, size_t limit)
+{
+   const uint16_t *old16 = (const uint16_t*)prev;
+   const uint16_t *new16 = (const uint16_t*)cur;
+   size_t pos            = 0;
+   size_t size           = 0;
+
+   for (;;)
+   {
+      size_t start, end, bytes;
+      size_t skip_from = pos;
+
+      pos = rcap_find_change(old16, new16, pos, num16s);
+      if (pos >= num16s)
+         break;
+
+      start = pos;
+      end   = rcap_find_same(old16, new16, pos, num16s);
+      bytes = (end - start) * sizeof(uint16_t);
+
+      if (size + RCAP_RUN_HEADER_SIZE + bytes > limit)
+         return (size_t)-1;
+
+      rcap_write_le32(out + size, (uint32_t)(start - skip_from));
+      rcap_write_le32(out + size + 4, (uint32_t)(end - start));
+      memcpy(out + size + RCAP_RUN_HEADER_SIZE, new16 + start, bytes);
+
+      size += RCAP_RUN_HEADER_SIZE + bytes;
+      pos   = end;
+   }
+
+   return size;
+}
+
+static bool rcap_apply_delta(uint8_t *frame, size_t num16s,
+      const uint8_t *runs, size_t size)
+{
+   size_t pos = 0;
+
+   while (size)
+   {
+      size_t skip, count;
+
+      if (size < RCAP_RUN_HEADER_SIZE)
+         return false;
+
+      skip   = rcap_read_le32(runs);
+      count  = rcap_read_le32(runs + 4);
+      runs  += RCAP_RUN_HEADER_SIZE;
+      size  -= RCAP_RUN_HEADER_SIZE;
+
+      if (skip > num16s - pos || count > num16s - pos - skip ||
+            count > size / sizeof(uint16_t))
+         return false;
+
+      pos += skip;
+      memcpy(frame + pos * sizeof(uint16_t), runs,
+            count * sizeof(uint16_t));
+      pos  += count;
+      runs += count * sizeof(uint16_t);
+      size -= count * sizeof(uint16_t);
+   }
+
+   return true;
+}
+
+static bool rcap_writer_write(rcap_writer_t *writer,
+      const void *data, size_t size)
+{
+   if (writer->error)
+      return false;
+
+   if (size && fwrite(data, 1, size, writer->file) != size)
+   {
+      writer->error = true;
+      return false;
+   }
+
+   writer->offset += size;
+   return true;
+}
+
+rcap_writer_t *rcap_writer_new(const char *path,
+      const struct rcap_header *header, unsigned keyframe_interval)
+{
+   uint8_t data[RCAP_HEADER_SIZE] = {0};
+   rcap_writer_t *writer = NULL;
+
+   if (!rcap_pix_size(header->pix_fmt))
+      return NULL;
+
+   writer = (rcap_writer_t*)calloc(1, sizeof(*writer));
+   if (!writer)
+      return NULL;
+
+   writer->header         = *header;
+   writer->header.version = RCAP_VERSION;
+   writer->header.flags   = is_little_endian() ? 0 : RCAP_FLAG_BIG_ENDIAN;
+   writer->pix_size       = rcap_pix_size(header->pix_fmt);
+   writer->keyframe_interval = keyframe_interval ? keyframe_interval : 1;
+
+   writer->file = fopen(path, "wb");
+   if (!writer->file)
+   {
+      free(writer);
+      return NULL;
+   }
+
+   /* Frames are written in one go, avoid copying them into stdio. */
+   setvbuf(writer->file, NULL, _IOFBF, 1 << 16);
+
+   memcpy(data, rcap_magic, sizeof(rcap_magic));
+   rcap_write_le32(data + 4, writer->header.version);
+   rcap_write_le32(data + 8, writer->header.pix_fmt);
+   rcap_write_le32(data + 12, writer->header.flags);
+   rcap_write_le32(data + 16, writer->header.width);
+   rcap_write_le32(data + 20, writer->header.height);
+   rcap_write_le32(data + 24, writer->header.channels);
+   rcap_write_double(data + 32, writer->header.aspect_ratio);
+   rcap_write_double(data + 40, writer->header.fps);
+   rcap_write_double(data + 48, writer->header.samplerate);
+
+   if (!rcap_writer_write(writer, data, sizeof(data)))
+   {
+      fclose(writer->file);
+      free(writer);
+      return NULL;
+   }
+
+   return writer;
+}
+
+static bool rcap_writer_reserve(rcap_writer_t *writer, size_t size)
+{
+   uint8_t *prev, *cur, *delta;
+
+   /* Round up to whole words, plus the zero pad byte. */
+   size = (size + 1) & ~(size_t)1;
+   if (size <= writer->capacity)
+      return true;
+
+   prev  = (uint8_t*)realloc(writer->prev, size);
+   if (prev)
+      writer->prev = prev;
+   cur   = (uint8_t*)realloc(writer->cur, size);
+   if (cur)
+      writer->cur = cur;
+   delta = (uint8_t*)realloc(writer->delta, size);
+   if (delta)
+      writer->delta = delta;
+
+   if (!prev || !cur || !delta)
+      return false;
+
+   /* Contents of the previous frame are gone, force a keyframe. */
+   writer->capacity   = size;
+   writer->have_frame = false;
+   return true;
+}
+
+static bool rcap_writer_write_frame(rcap_writer_t *writer,
+      uint32_t type, const uint8_t *data, size_t size)
+{
+   uint8_t head[RCAP_CHUNK_HEADER_SIZE + RCAP_FRAME_HEADER_SIZE];
+
+   rcap_write_le32(head, type);
+   rcap_write_le32(head + 4, (uint32_t)(RCAP_FRAME_HEADER_SIZE + size));
+   rcap_write_le32(head + 8, writer->info.frames);
+   rcap_write_le32(head + 12, writer->width);
+   rcap_write_le32(head + 16, writer->height);
+   rcap_write_le32(head + 20, writer->crc);
+
+   if (type == RCAP_CHUNK_KEY)
+   {
+      if (!rcap_index_append(&writer->index, writer->info.frames,
+               writer->info.audio_frames, writer->offset))
+      {
+         writer->error = true;
+         return false;
+      }
+      writer->since_keyframe = 0;
+   }
+
+   if (!rcap_writer_write(writer, head, sizeof(head)) ||
+         !rcap_writer_write(writer, data, size))
+      return false;
+
+   writer->since_keyframe++;
+   writer->info.frames++;
+   return true;
+}
+
+bool rcap_writer_push_video(rcap_writer_t *writer, const void *data,
+      unsigned width, unsigned height, ptrdiff_t pitch)
+{
+   unsigned y;
+   uint8_t *tmp;
+   size_t delta_size;
+   size_t line, size;
+   bool keyframe;
+
+   if (!writer || writer->error)
+      return false;
+
+   if (!data)
+   {
+      /* Repeats the previous frame, which is an empty delta.
+       * Without one, repeat an empty frame. */
+      if (!writer->have_frame)
+      {
+         writer->width  = 0;
+         writer->height = 0;
+         writer->crc    = crc32_calculate(NULL, 0);
+         return rcap_writer_write_frame(writer, RCAP_CHUNK_KEY, NULL, 0);
+      }
+
+      return rcap_writer_write_frame(writer, RCAP_CHUNK_DELTA, NULL, 0);
+   }
+
+   line = (size_t)width * writer->pix_size;
+   size = line * height;
+
+   if (!rcap_writer_reserve(writer, size))
+   {
+      writer->error = true;
+      return false;
+   }
+
+   if (pitch == (ptrdiff_t)line)
+      memcpy(writer->cur, data, size);
+   else
+   {
+      const uint8_t *src = (const uint8_t*)data;
+      for (y = 0; y < height; y++, src += pitch)
+         memcpy(writer->cur + y * line, src, line);
+   }
+
+   if (size & 1)
+      writer->cur[size] = 0;
+
+   keyframe = !writer->have_frame ||
+      width != writer->width || height != writer->height ||
+      writer->since_keyframe >= writer->keyframe_interval;
+
+   delta_size = (size_t)-1;
+   if (!keyframe)
+      delta_size = rcap_encode_delta(writer->prev, writer->cur,
+            (size + 1) / sizeof(uint16_t), writer->delta, size);
+
+   writer->width      = width;
+   writer->height     = height;
+   writer->crc        = crc32_calculate(writer->cur, size);
+   writer->have_frame = true;
+
+   tmp          = writer->prev;
+   writer->prev = writer->cur;
+   writer->cur  = tmp;
+
+   if (width > writer->info.max_width)
+      writer->info.max_width = width;
+   if (height > writer->info.max_height)
+      writer->info.max_height = height;
+
+   /* Frames which hardly compress are stored raw,
+    * and double as seek points. */
+   if (delta_size == (size_t)-1)
+      return rcap_writer_write_frame(writer, RCAP_CHUNK_KEY,
+            writer->prev, size);
+
+   return rcap_writer_write_frame(writer, RCAP_CHUNK_DELTA,
+         writer->delta, delta_size);
+}
+
+bool rcap_writer_push_audio(rcap_writer_t *writer,
+      const int16_t *samples, size_t frames)
+{
+   uint8_t head[RCAP_CHUNK_HEADER_SIZE + RCAP_AUDIO_HEADER_SIZE];
+   size_t size;
+
+   if (!writer || writer->error)
+      return false;
+   if (!frames)
+      return true;
+
+   size = frames * writer->header.channels * sizeof(int16_t);
+
+   rcap_write_le32(head, RCAP_CHUNK_AUDIO);
+   rcap_write_le32(head + 4, (uint32_t)(RCAP_AUDIO_HEADER_SIZE + size));
+   rcap_write_le32(head + 8, (uint32_t)frames);
+
+   if (!rcap_writer_write(writer, head, sizeof(head)) ||
+         !rcap_writer_write(writer, samples, size))
+      return false;
+
+   writer->info.audio_frames += frames;
+   return true;
+}
+
+static bool rcap_writer_write_index(rcap_writer_t *writer)
+{
+   size_t i;
+   uint8_t head[RCAP_CHUNK_HEADER_SIZE + RCAP_INDEX_HEADER_SIZE];
+   uint8_t trailer[RCAP_TRAILER_SIZE];
+   uint64_t index_offset = writer->offset;
+
+   rcap_write_le32(head, RCAP_CHUNK_INDEX);
+   rcap_write_le32(head + 4, (uint32_t)(RCAP_INDEX_HEADER_SIZE +
+            writer->index.size * RCAP_INDEX_ENTRY_SIZE));
+   rcap_write_le32(head + 8, writer->info.frames);
+   rcap_write_le32(head + 12, (uint32_t)writer->index.size);
+   rcap_write_le64(head + 16, writer->info.audio_frames);
+   rcap_write_le32(head + 24, writer->info.max_width);
+   rcap_write_le32(head + 28, writer->info.max_height);
+
+   if (!rcap_writer_write(writer, head, sizeof(head)))
+      return false;
+
+   for (i = 0; i < writer->index.size; i++)
+   {
+      uint8_t entry[RCAP_INDEX_ENTRY_SIZE] = {0};
+      const struct rcap_index_entry *e = &writer->index.entries[i];
+
+      rcap_write_le32(entry, e->frame);
+      rcap_write_le64(entry + 8, e->audio_frames);
+      rcap_write_le64(entry + 16, e->offset);
+
+      if (!rcap_writer_write(writer, entry, sizeof(entry)))
+         return false;
+   }
+
+   rcap_write_le64(trailer, index_offset);
+   memcpy(trailer + 8, rcap_trailer_magic, sizeof(rcap_trailer_magic));
+   return rcap_writer_write(writer, trailer, sizeof(trailer));
+}
+
+bool rcap_writer_free(rcap_writer_t *writer, struct rcap_info *info)
+{
+   bool ret;
+
+   if (!writer)
+      return false;
+
+   writer->info.keyframes = (uint32_t)writer->index.size;
+   writer->info.indexed   = !writer->error;
+
+   rcap_writer_write_index(writer);
+   if (fclose(writer->file) != 0)
+      writer->error = true;
+
+   ret = !writer->error;
+   if (info)
+      *info = writer->info;
+
+   free(writer->index.entries);
+   free(writer->prev);
+   free(writer->cur);
+   free(writer->delta);
+   free(writer);
+   return ret;
+}
+
+static bool rcap_reader_read(rcap_reader_t *reader,
+      void *data, size_t size)
+{
+   if (size && fread(data, 1, size, reader->file) != size)
+      return false;
+
+   reader->offset += size;
+   return true;
+}
+
+static bool rcap_reader_seek_to(rcap_reader_t *reader, uint64_t offset)
+{
+   if (fseek(reader->file, (long)offset, SEEK_SET) != 0)
+      return false;
+
+   reader->offset = offset;
+   return true;
+}
+
+static bool rcap_reader_load_index(rcap_reader_t *reader,
+      uint64_t file_size)
+{
+   uint32_t i, keyframes;
+   uint64_t index_offset;
+   uint8_t trailer[RCAP_TRAILER_SIZE];
+   uint8_t head[RCAP_CHUNK_HEADER_SIZE + RCAP_INDEX_HEADER_SIZE];
+
+   if (file_size < RCAP_HEADER_SIZE + sizeof(head) + sizeof(trailer))
+      return false;
+
+   if (!rcap_reader_seek_to(reader, file_size - sizeof(trailer)) ||
+         !rcap_reader_read(reader, trailer, sizeof(trailer)))
+      return false;
+
+   if (memcmp(trailer + 8, rcap_trailer_magic, sizeof(rcap_trailer_magic)))
+      return false;
+
+   index_offset = rcap_read_le64(trailer);
+   if (index_offset < RCAP_HEADER_SIZE ||
+         index_offset > file_size - sizeof(trailer) - sizeof(head))
+      return false;
+
+   if (!rcap_reader_seek_to(reader, index_offset) ||
+         !rcap_reader_read(reader, head, sizeof(head)))
+      return false;
+
+   keyframes = rcap_read_le32(head + 12);
+
+   if (rcap_read_le32(head) != RCAP_CHUNK_INDEX ||
+         rcap_read_le32(head + 4) != RCAP_INDEX_HEADER_SIZE +
+         (uint64_t)keyframes * RCAP_INDEX_ENTRY_SIZE ||
+         index_offset + sizeof(head) + (uint64_t)keyframes *
+         RCAP_INDEX_ENTRY_SIZE + sizeof(trailer) != file_size)
+      return false;
+
+   reader->info.frames       = rcap_read_le32(head + 8);
+   reader->info.audio_frames = rcap_read_le64(head + 16);
+   reader->info.max_width    = rcap_read_le32(head + 24);
+   reader->info.max_height   = rcap_read_le32(head + 28);
+
+   for (i = 0; i < keyframes; i++)
+   {
+      uint8_t entry[RCAP_INDEX_ENTRY_SIZE];
+
+      if (!rcap_reader_read(reader, entry, sizeof(entry)) ||
+            !rcap_index_append(&reader->index, rcap_read_le32(entry),
+               rcap_read_le64(entry + 8), rcap_read_le64(entry + 16)))
+         return false;
+   }
+
+   reader->info.keyframes = keyframes;
+   reader->info.indexed   = true;
+   reader->data_end       = index_offset;
+   return true;
+}
+
+/* Captures which were not closed have no index. Rebuild it
+ * from the chunk headers, up to the last complete chunk. */
+static bool rcap_reader_scan(rcap_reader_t *reader, uint64_t file_size)
+{
+   uint64_t offset = RCAP_HEADER_SIZE;
+
+   reader->index.size = 0;
+   memset(&reader->info, 0, sizeof(reader->info));
+
+   while (offset + RCAP_CHUNK_HEADER_SIZE <= file_size)
+   {
+      uint8_t head[RCAP_CHUNK_HEADER_SIZE + RCAP_FRAME_HEADER_SIZE];
+      uint32_t type, size;
+
+      if (!rcap_reader_seek_to(reader, offset) ||
+            !rcap_reader_read(reader, head, RCAP_CHUNK_HEADER_SIZE))
+         break;
+
+      type = rcap_read_le32(head);
+      size = rcap_read_le32(head + 4);
+
+      if (size > file_size - offset - RCAP_CHUNK_HEADER_SIZE)
+         break;
+
+      if (type == RCAP_CHUNK_INDEX)
+         break;
+
+      if (type == RCAP_CHUNK_KEY || type == RCAP_CHUNK_DELTA)
+      {
+         unsigned width, height;
+
+         if (size < RCAP_FRAME_HEADER_SIZE ||
+               !rcap_reader_read(reader, head + RCAP_CHUNK_HEADER_SIZE,
+                  RCAP_FRAME_HEADER_SIZE))
+            break;
+
+         width  = rcap_read_le32(head + 12);
+         height = rcap_read_le32(head + 16);
+
+         if (type == RCAP_CHUNK_KEY &&
+               !rcap_index_append(&reader->index, reader->info.frames,
+                  reader->info.audio_frames, offset))
+            return false;
+
+         if (width > reader->info.max_width)
+            reader->info.max_width = width;
+         if (height > reader->info.max_height)
+            reader->info.max_height = height;
+         reader->info.frames++;
+      }
+      else if (type == RCAP_CHUNK_AUDIO)
+      {
+         if (size < RCAP_AUDIO_HEADER_SIZE ||
+               !rcap_reader_read(reader, head + RCAP_CHUNK_HEADER_SIZE,
+                  RCAP_AUDIO_HEADER_SIZE))
+            break;
+
+         reader->info.audio_frames += rcap_read_le32(
+               head + RCAP_CHUNK_HEADER_SIZE);
+      }
+
+      offset += RCAP_CHUNK_HEADER_SIZE + size;
+   }
+
+   reader->info.keyframes = (uint32_t)reader->index.size;
+   reader->info.indexed   = false;
+   reader->data_end       = offset;
+   return true;
+}
+
+rcap_reader_t *rcap_reader_open(const char *path)
+{
+   long file_size;
+   uint8_t data[RCAP_HEADER_SIZE];
+   rcap_reader_t *reader = (rcap_reader_t*)calloc(1, sizeof(*reader));
+
+   if (!reader)
+      return NULL;
+
+   reader->file = fopen(path, "rb");
+   if (!reader->file)
+      goto error;
+
+   if (!rcap_reader_read(reader, data, sizeof(data)) ||
+         memcmp(data, rcap_magic, sizeof(rcap_magic)))
+      goto error;
+
+   reader->header.version      = rcap_read_le32(data + 4);
+   reader->header.pix_fmt      = rcap_read_le32(data + 8);
+   reader->header.flags        = rcap_read_le32(data + 12);
+   reader->header.width        = rcap_read_le32(data + 16);
+   reader->header.height       = rcap_read_le32(data + 20);
+   reader->header.channels     = rcap_read_le32(data + 24);
+   reader->header.aspect_ratio = rcap_read_double(data + 32);
+   reader->header.fps          = rcap_read_double(data + 40);
+   reader->header.samplerate   = rcap_read_double(data + 48);
+   reader->pix_size            = rcap_pix_size(reader->header.pix_fmt);
+
+   if (reader->header.version != RCAP_VERSION || !reader->pix_size)
+      goto error;
+
+   if (fseek(reader->file, 0, SEEK_END) != 0)
+      goto error;
+   file_size = ftell(reader->file);
+   if (file_size < RCAP_HEADER_SIZE)
+      goto error;
+
+   if (!rcap_reader_load_index(reader, file_size))
+   {
+      reader->index.size = 0;
+      memset(&reader->info, 0, sizeof(reader->info));
+
+      if (!rcap_reader_scan(reader, file_size))
+         goto error;
+   }
+
+   if (!rcap_reader_seek_to(reader, RCAP_HEADER_SIZE))
+      goto error;
+
+   return reader;
+
+error:
+   rcap_reader_close(reader);
+   return NULL;
+}
+
+const struct rcap_header *rcap_reader_header(const rcap_reader_t *reader)
+{
+   return &reader->header;
+}
+
+const struct rcap_info *rcap_reader_info(const rcap_reader_t *reader)
+{
+   return &reader->info;
+}
+
+static bool rcap_reader_decode_frame(rcap_reader_t *reader,
+      uint32_t type, const uint8_t *payload, size_t size,
+      struct rcap_packet *packet)
+{
+   uint32_t crc;
+   size_t frame_size;
+   unsigned width  = rcap_read_le32(payload + 4);
+   unsigned height = rcap_read_le32(payload + 8);
+
+   frame_size = (size_t)width * height * reader->pix_size;
+   if (height && frame_size / height != (size_t)width * reader->pix_size)
+      return false;
+
+   payload += RCAP_FRAME_HEADER_SIZE;
+   size    -= RCAP_FRAME_HEADER_SIZE;
+
+   if (type == RCAP_CHUNK_KEY)
+   {
+      size_t capacity = (frame_size + 1) & ~(size_t)1;
+
+      if (size != frame_size)
+         return false;
+
+      if (capacity > reader->frame_capacity)
+      {
+         uint8_t *frame = (uint8_t*)realloc(reader->frame, capacity);
+         if (!frame)
+            return false;
+         reader->frame          = frame;
+         reader->frame_capacity = capacity;
+      }
+
+      if (frame_size)
+         memcpy(reader->frame, payload, frame_size);
+      if (frame_size & 1)
+         reader->frame[frame_size] = 0;
+   }
+   else
+   {
+      if (!reader->have_frame ||
+            width != reader->width || height != reader->height)
+         return false;
+
+      if (!rcap_apply_delta(reader->frame,
+               (frame_size + 1) / sizeof(uint16_t), payload, size))
+         return false;
+   }
+
+   reader->have_frame = true;
+   reader->width      = width;
+   reader->height     = height;
+
+   crc = crc32_calculate(reader->frame, frame_size);
+   if (crc != rcap_read_le32(payload - RCAP_FRAME_HEADER_SIZE + 12))
+      return false;
+
+   packet->type     = RCAP_PACKET_VIDEO;
+   packet->data     = reader->frame;
+   packet->width    = width;
+   packet->height   = height;
+   packet->pitch    = (size_t)width * reader->pix_size;
+   packet->frame    = rcap_read_le32(payload - RCAP_FRAME_HEADER_SIZE);
+   packet->crc      = crc;
+   packet->keyframe = type == RCAP_CHUNK_KEY;
+   return true;
+}
+
+enum rcap_packet_type rcap_reader_next(rcap_reader_t *reader,
+      struct rcap_packet *packet)
+{
+   memset(packet, 0, sizeof(*packet));
+
+   if (reader->has_pending)
+   {
+      *packet             = reader->pending;
+      reader->has_pending = false;
+      return packet->type;
+   }
+
+   while (reader->offset < reader->data_end)
+   {
+      uint8_t head[RCAP_CHUNK_HEADER_SIZE];
+      uint32_t type, size;
+
+      if (reader->data_end - reader->offset < sizeof(head) ||
+            !rcap_reader_read(reader, head, sizeof(head)))
+         return RCAP_PACKET_ERROR;
+
+      type = rcap_read_le32(head);
+      size = rcap_read_le32(head + 4);
+
+      if (size > reader->data_end - reader->offset)
+         return RCAP_PACKET_ERROR;
+
+      if (type != RCAP_CHUNK_KEY && type != RCAP_CHUNK_DELTA &&
+            type != RCAP_CHUNK_AUDIO)
+      {
+         /* Unknown chunk, skip over it. */
+         if (!rcap_reader_seek_to(reader, reader->offset + size))
+            return RCAP_PACKET_ERROR;
+         continue;
+      }
+
+      if (size > reader->payload_capacity)
+      {
+         uint8_t *payload = (uint8_t*)realloc(reader->payload, size);
+         if (!payload)
+            return RCAP_PACKET_ERROR;
+         reader->payload          = payload;
+         reader->payload_capacity = size;
+      }
+
+      if (!rcap_reader_read(reader, reader->payload, size))
+         return RCAP_PACKET_ERROR;
+
+      if (type == RCAP_CHUNK_AUDIO)
+      {
+         size_t frames;
+
+         if (size < RCAP_AUDIO_HEADER_SIZE)
+            return RCAP_PACKET_ERROR;
+
+         frames = rcap_read_le32(reader->payload);
+         if ((uint64_t)frames * reader->header.channels * sizeof(int16_t)
+               != size - RCAP_AUDIO_HEADER_SIZE)
+            return RCAP_PACKET_ERROR;
+
+         packet->type    = RCAP_PACKET_AUDIO;
+         packet->samples = (const int16_t*)
+            (reader->payload + RCAP_AUDIO_HEADER_SIZE);
+         packet->frames  = frames;
+         return RCAP_PACKET_AUDIO;
+      }
+
+      if (size < RCAP_FRAME_HEADER_SIZE ||
+            !rcap_reader_decode_frame(reader, type,
+               reader->payload, size, packet))
+         return RCAP_PACKET_ERROR;
+
+      return RCAP_PACKET_VIDEO;
+   }
+
+   return RCAP_PACKET_END;
+}
+
+bool rcap_reader_seek(rcap_reader_t *reader, uint32_t frame,
+      uint64_t *audio_frames)
+{
+   struct rcap_packet packet;
+   uint64_t audio;
+   size_t lo = 0, hi = reader->index.size;
+
+   if (frame >= reader->info.frames)
+      return false;
+
+   /* Last keyframe at or before the frame. */
+   while (hi - lo > 1)
+   {
+      size_t mid = (lo + hi) / 2;
+      if (reader->index.entries[mid].frame <= frame)
+         lo = mid;
+      else
+         hi = mid;
+   }
+
+   if (!reader->index.size || reader->index.entries[lo].frame > frame)
+      return false;
+
+   if (!rcap_reader_seek_to(reader, reader->index.entries[lo].offset))
+      return false;
+
+   audio               = reader->index.entries[lo].audio_frames;
+   reader->have_frame  = false;
+   reader->has_pending = false;
+
+   for (;;)
+   {
+      switch (rcap_reader_next(reader, &packet))
+      {
+         case RCAP_PACKET_AUDIO:
+            audio += packet.frames;
+            break;
+         case RCAP_PACKET_VIDEO:
+            if (packet.frame < frame)
+               break;
+            reader->pending     = packet;
+            reader->has_pending = true;
+            if (audio_frames)
+               *audio_frames = audio;
+            return true;
+         default:
+            return false;
+      }
+   }
+}
+
+void rcap_reader_close(rcap_reader_t *reader)
+{
+   if (!reader)
+      return;
+
+   if (reader->file)
+      fclose(reader->file);
+   free(reader->index.entries);
+   free(reader->frame);
+   free(reader->payload);
+   free(reader);
+}
@@ -0,0 +1,222 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __RCAP_H
+#define __RCAP_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <boolean.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Lossless capture container (.rcap).
+ *
+ * A fixed header is followed by chunks of { fourcc, payload size }.
+ * Video frames are stored either raw (keyframes) or as runs of
+ * 16-bit words which changed since the previous frame, like the
+ * rewind buffer does for savestates. Audio is stored as raw
+ * interleaved S16 PCM. Every frame carries the CRC32 of its pixels,
+ * so captures can be verified bit-exactly after decoding.
+ *
+ * On close, an index of keyframes is appended, followed by a trailer
+ * pointing to it, which makes the capture seekable. A capture which
+ * was not closed properly is still readable, the index is then
+ * rebuilt by scanning the chunks.
+ *
+ * All header and chunk fields are little endian. Pixels and samples
+ * are stored in host order, RCAP_FLAG_BIG_ENDIAN tells which. */
+
+#define RCAP_VERSION 1
+
+enum rcap_pix_format
+{
+   RCAP_PIX_RGB565 = 0,
+   RCAP_PIX_BGR24,
+   RCAP_PIX_XRGB8888
+};
+
+#define RCAP_FLAG_BIG_ENDIAN (1 << 0)
+
+struct rcap_header
+{
+   uint32_t version;
+   uint32_t pix_fmt;
+   uint32_t flags;
+
+   /* Nominal output size and aspect ratio. Frames carry their own size. */
+   uint32_t width;
+   uint32_t height;
+   double aspect_ratio;
+
+   double fps;
+   double samplerate;
+   uint32_t channels;
+};
+
+/* Summary of a capture, taken from its index. */
+struct rcap_info
+{
+   uint32_t frames;
+   uint64_t audio_frames;
+
+   /* Largest frame in the capture. */
+   uint32_t max_width;
+   uint32_t max_height;
+
+   uint32_t keyframes;
+   bool indexed;
+};
+
+enum rcap_packet_type
+{
+   RCAP_PACKET_ERROR = -1,
+   RCAP_PACKET_END   = 0,
+   RCAP_PACKET_VIDEO,
+   RCAP_PACKET_AUDIO
+};
+
+struct rcap_packet
+{
+   enum rcap_packet_type type;
+
+   /* Video: decoded frame, owned by the reader
+    * and valid until the next call. */
+   const void *data;
+   unsigned width;
+   unsigned height;
+   size_t pitch;
+   uint32_t frame;
+   uint32_t crc;
+   bool keyframe;
+
+   /* Audio: interleaved samples, owned by the reader. */
+   const int16_t *samples;
+   size_t frames;
+};
+
+typedef struct rcap_writer rcap_writer_t;
+typedef struct rcap_reader rcap_reader_t;
+
+/**
+ * rcap_pix_size:
+ * @pix_fmt          : Pixel format (enum rcap_pix_format).
+ *
+ * Returns: bytes per pixel of @pix_fmt, or 0 if it is unknown.
+ **/
+unsigned rcap_pix_size(uint32_t pix_fmt);
+
+/**
+ * rcap_writer_new:
+ * @path             : Path of the capture to create.
+ * @header           : Stream parameters. Version and flags are filled in.
+ * @keyframe_interval: Maximum number of frames between keyframes.
+ *
+ * Returns: writer handle if successful, otherwise NULL.
+ **/
+rcap_writer_t *rcap_writer_new(const char *path,
+      const struct rcap_header *header, unsigned keyframe_interval);
+
+/**
+ * rcap_writer_push_video:
+ * @writer           : Writer handle.
+ * @data             : Pixels of the frame, or NULL to repeat the last frame.
+ * @width            : Width of the frame.
+ * @height           : Height of the frame.
+ * @pitch            : Distance between lines in bytes. May be negative
+ *                     for bottom-up frames.
+ *
+ * Encodes a frame against the previous one and writes it.
+ *
+ * Returns: true (1) if successful, otherwise false (0).
+ **/
+bool rcap_writer_push_video(rcap_writer_t *writer, const void *data,
+      unsigned width, unsigned height, ptrdiff_t pitch);
+
+/**
+ * rcap_writer_push_audio:
+ * @writer           : Writer handle.
+ * @samples          : Interleaved samples.
+ * @frames           : Number of audio frames in @samples.
+ *
+ * Returns: true (1) if successful, otherwise false (0).
+ **/
+bool rcap_writer_push_audio(rcap_writer_t *writer,
+      const int16_t *samples, size_t frames);
+
+/**
+ * rcap_writer_free:
+ * @writer           : Writer handle.
+ * @info             : Summary of the capture. Optional.
+ *
+ * Writes the index and closes the capture.
+ *
+ * Returns: true (1) if everything was written, otherwise false (0).
+ **/
+bool rcap_writer_free(rcap_writer_t *writer, struct rcap_info *info);
+
+/**
+ * rcap_reader_open:
+ * @path             : Path of the capture.
+ *
+ * Opens a capture and loads, or rebuilds, its index.
+ *
+ * Returns: reader handle if successful, otherwise NULL.
+ **/
+rcap_reader_t *rcap_reader_open(const char *path);
+
+const struct rcap_header *rcap_reader_header(const rcap_reader_t *reader);
+
+const struct rcap_info *rcap_reader_info(const rcap_reader_t *reader);
+
+/**
+ * rcap_reader_next:
+ * @reader           : Reader handle.
+ * @packet           : Decoded packet.
+ *
+ * Reads and decodes the next packet. Decoded frames are checked
+ * against their CRC, a mismatch is reported as an error.
+ *
+ * Returns: type of the packet, RCAP_PACKET_END at the end of the
+ * capture or RCAP_PACKET_ERROR if it is corrupt.
+ **/
+enum rcap_packet_type rcap_reader_next(rcap_reader_t *reader,
+      struct rcap_packet *packet);
+
+/**
+ * rcap_reader_seek:
+ * @reader           : Reader handle.
+ * @frame            : Frame to seek to.
+ * @audio_frames     : Number of audio frames in the capture
+ *                     before @frame. Optional.
+ *
+ * Seeks to the nearest keyframe at or before @frame and decodes
+ * forward, so that the next packet is @frame.
+ *
+ * Returns: true (1) if successful, otherwise false (0).
+ **/
+bool rcap_reader_seek(rcap_reader_t *reader, uint32_t frame,
+      uint64_t *audio_frames);
+
+void rcap_reader_close(rcap_reader_t *reader);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
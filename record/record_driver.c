@@ -29,6 +29,8 @@
 #endif
 
 static const ffemu_backend_t *ffemu_backends[] = {
+   /* Only picks up .rcap paths, so it goes first. */
+   &ffemu_rcap,
 #ifdef HAVE_FFMPEG
    &ffemu_ffmpeg,
 #endif
@@ -87,6 +89,39 @@ bool ffemu_init_first(const ffemu_backend_t **backend, void **data,
    return false;
 }
 
+/**
+ * recording_push_gpu_frame:
+ * @userdata                : Number of the frame.
+ * @buffer                  : Viewport in BGR24, bottom-up.
+ * @width                   : Width of viewport.
+ * @height                  : Height of viewport.
+ *
+ * Pushes a frame which the video driver read back
+ * asynchronously to the recording driver.
+ **/
+static void recording_push_gpu_frame(void *userdata,
+      const uint8_t *buffer, unsigned width, unsigned height)
+{
+   struct ffemu_video_data ffemu_data = {0};
+
+   /* Recording might have stopped while the read was in flight. */
+   if (!buffer || !driver.recording_data || !g_extern.record_gpu_buffer)
+      return;
+   if (width != g_extern.record_gpu_width ||
+         height != g_extern.record_gpu_height)
+      return;
+
+   ffemu_data.pitch  = width * 3;
+   ffemu_data.width  = width;
+   ffemu_data.height = height;
+   ffemu_data.data   = buffer + (height - 1) * ffemu_data.pitch;
+   ffemu_data.pitch  = -ffemu_data.pitch;
+   ffemu_data.frame  = (uintptr_t)userdata;
+
+   if (driver.recording && driver.recording->push_video)
+      driver.recording->push_video(driver.recording_data, &ffemu_data);
+}
+
 void recording_dump_frame(const void *data, unsigned width,
       unsigned height, size_t pitch)
 {
@@ -99,6 +134,7 @@ void recording_dump_frame(const void *data, unsigned width,
    ffemu_data.width   = width;
    ffemu_data.height  = height;
    ffemu_data.data    = data;
+   ffemu_data.frame   = g_extern.record_frame_count++;
 
    if (g_extern.record_gpu_buffer)
    {
@@ -112,6 +148,8 @@ void recording_dump_frame(const void *data, unsigned width,
          RARCH_WARN("Viewport size calculation failed! Will continue using raw data. This will probably not work right ...\n");
          rarch_main_command(RARCH_CMD_GPU_RECORD_DEINIT);
 
+         /* Retry the same frame without GPU recording. */
+         g_extern.record_frame_count = ffemu_data.frame;
          recording_dump_frame(data, width, height, pitch);
          return;
       }
@@ -129,9 +167,16 @@ void recording_dump_frame(const void *data, unsigned width,
          return;
       }
 
-      /* Big bottleneck.
-       * Since we might need to do read-backs asynchronously,
-       * it might take 3-4 times before this returns true. */
+      /* Frames arrive in recording_push_gpu_frame() a few
+       * frames later, without stalling the GPU. */
+      if (driver.video && driver.video->read_viewport_async)
+      {
+         driver.video->read_viewport_async(driver.video_data,
+               recording_push_gpu_frame, (void*)(uintptr_t)ffemu_data.frame);
+         return;
+      }
+
+      /* Big bottleneck. */
       if (driver.video && driver.video->read_viewport)
          if (!driver.video->read_viewport(driver.video_data,
                   g_extern.record_gpu_buffer))
@@ -295,6 +340,8 @@ bool recording_init(void)
          params.fb_width, params.fb_height,
          (unsigned)params.pix_fmt);
 
+   g_extern.record_frame_count = 0;
+
    if (!ffemu_init_first(&driver.recording, &driver.recording_data, &params))
    {
       RARCH_ERR(RETRO_LOG_INIT_RECORDING_FAILED);
@@ -73,6 +73,11 @@ struct ffemu_video_data
    unsigned height;
    int pitch;
    bool is_dupe;
+
+   /* Number of the frame in emulated time, counted from the start
+    * of the recording. Frames which never reach the backend leave
+    * a gap, which is filled with the frame before. */
+   uint64_t frame;
 };
 
 struct ffemu_audio_data
@@ -92,6 +97,7 @@ typedef struct ffemu_backend
 } ffemu_backend_t;
 
 extern const ffemu_backend_t ffemu_ffmpeg;
+extern const ffemu_backend_t ffemu_rcap;
 
 /**
  * ffemu_find_backend:
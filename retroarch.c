@@ -29,13 +29,17 @@
 #include <file/dir_list.h>
 #include "general.h"
 #include "retroarch.h"
+#include "runloop.h"
 #include "settings.h"
 #include <compat/strl.h>
 #include "screenshot.h"
 #include "performance.h"
 #include "cheats.h"
+#include "batch.h"
 #include <compat/getopt.h>
 #include <compat/posix_string.h>
+#include <gfx/scaler/pixconv.h>
+#include <gfx/scaler/scaler.h>
 
 #include "input/keyboard_line.h"
 #include "input/input_remapping.h"
@@ -231,6 +235,7 @@ static void print_help(void)
 #endif
 
    puts("\t-r/--record: Path to record video file.\n\t\tUsing .mkv extension is recommended.");
+   puts("\t\tUsing .rcap extension records losslessly, convert with retroarch-rcap.");
    puts("\t--recordconfig: Path to settings used during recording.");
    puts("\t--size: Overrides output video size when recording (format: WIDTHxHEIGHT).");
    puts("\t-v/--verbose: Verbose logging.");
@@ -239,7 +244,14 @@ static void print_help(void)
    puts("\t--ips: Specifies path for IPS patch that will be applied to content.");
    puts("\t--no-patch: Disables all forms of content patching.");
    puts("\t-D/--detach: Detach " RETRO_FRONTEND " from the running console. Not relevant for all platforms.");
-   puts("\t--max-frames: Runs for the specified number of frames, then exits.\n");
+   puts("\t--max-frames: Runs for the specified number of frames, then exits.");
+   puts("\t--headless: Runs the core as fast as possible without video, audio or input,");
+   puts("\t\tthen prints a frames per second report. Use with --max-frames or --bsvplay and --eof-exit.");
+   puts("\t--hash-interval: Prints a CRC32 of the framebuffer every N frames when running headless.");
+   puts("\t--hash-state: Hashes the serialized core state instead of the framebuffer.");
+   puts("\t--batch: Runs every job of a job list in parallel headless worker processes, then prints a report.");
+   puts("\t\tEach line holds tab-separated content path, frame count and optionally a BSV movie.");
+   puts("\t--batch-workers: Number of parallel batch workers. Defaults to one per CPU.\n");
 }
 
 static void set_basename(const char *path)
@@ -401,6 +413,10 @@ static void parse_input(int argc, char *argv[])
 
    *g_extern.subsystem = '\0';
 
+   g_extern.headless.enable        = false;
+   g_extern.headless.hash_state    = false;
+   g_extern.headless.hash_interval = 0;
+
    if (argc < 2)
    {
       g_extern.libretro_dummy = true;
@@ -411,6 +427,8 @@ static void parse_input(int argc, char *argv[])
    optind = 0;
 
    int val = 0;
+   const char *batch_path = NULL;
+   unsigned batch_workers = 0;
 
    const struct option opts[] = {
 #ifdef HAVE_DYNAMIC
@@ -453,6 +471,11 @@ static void parse_input(int argc, char *argv[])
       { "subsystem", 1, NULL, 'Z' },
       { "max-frames", 1, NULL, 'm' },
       { "eof-exit", 0, &val, 'e' },
+      { "headless", 0, &val, 'x' },
+      { "hash-interval", 1, &val, 'i' },
+      { "hash-state", 0, &val, 't' },
+      { "batch", 1, &val, 'b' },
+      { "batch-workers", 1, &val, 'w' },
       { NULL, 0, NULL, 0 }
    };
 
@@ -736,6 +759,27 @@ static void parse_input(int argc, char *argv[])
                   g_extern.bsv.eof_exit = true;
                   break;
 
+               case 'x':
+                  g_extern.headless.enable = true;
+                  break;
+
+               case 'i':
+                  g_extern.headless.hash_interval = 
+                     strtoul(optarg, NULL, 0);
+                  break;
+
+               case 't':
+                  g_extern.headless.hash_state = true;
+                  break;
+
+               case 'b':
+                  batch_path = optarg;
+                  break;
+
+               case 'w':
+                  batch_workers = strtoul(optarg, NULL, 0);
+                  break;
+
                default:
                   break;
             }
@@ -751,6 +795,9 @@ static void parse_input(int argc, char *argv[])
       }
    }
 
+   if (batch_path)
+      exit(rarch_batch_run(argv[0], batch_path, batch_workers));
+
    if (g_extern.libretro_dummy)
    {
       if (optind < argc)
@@ -1760,11 +1807,14 @@ static void validate_cpu_features(void)
 static void init_system_av_info(void)
 {
    pretro_get_system_av_info(&g_extern.system.av_info);
+   memset(&g_extern.frame_limit, 0, sizeof(g_extern.frame_limit));
    g_extern.frame_limit.last_frame_time = rarch_get_time_usec();
 }
 
 static void deinit_core(void)
 {
+   rarch_main_frame_limit_statistics();
+
    pretro_unload_game();
    pretro_deinit();
 
@@ -1819,6 +1869,28 @@ static bool init_core(void)
    return true;
 }
 
+/**
+ * init_headless:
+ *
+ * Overrides configuration so that no real video, audio or
+ * input devices are opened when running headless.
+ **/
+static void init_headless(void)
+{
+   strlcpy(g_settings.video.driver, "null", sizeof(g_settings.video.driver));
+   strlcpy(g_settings.audio.driver, "null", sizeof(g_settings.audio.driver));
+   strlcpy(g_settings.input.driver, "null", sizeof(g_settings.input.driver));
+
+   g_settings.video.threaded  = false;
+   g_settings.video.vsync     = false;
+   g_settings.audio.enable    = false;
+   g_settings.audio.sync      = false;
+   g_settings.rewind_enable   = false;
+   g_settings.fps_show        = false;
+   g_settings.camera.allow    = false;
+   g_settings.location.allow  = false;
+}
+
 /**
  * rarch_main_init:
  * @argc                 : Count of (commandline) arguments.
@@ -1854,8 +1926,13 @@ int rarch_main_init(int argc, char *argv[])
    }
 
    validate_cpu_features();
+   conv_init_simd(rarch_get_cpu_features());
+   scaler_init_simd(rarch_get_cpu_features());
    config_load();
 
+   if (g_extern.headless.enable)
+      init_headless();
+
    init_libretro_sym(g_extern.libretro_dummy);
    init_system_info();
 
@@ -2812,6 +2889,8 @@ void rarch_main_deinit(void)
    rarch_main_command(RARCH_CMD_RECORD_DEINIT);
    rarch_main_command(RARCH_CMD_SAVEFILES);
 
+   screenshot_deinit();
+
    rarch_main_command(RARCH_CMD_REWIND_DEINIT);
    rarch_main_command(RARCH_CMD_CHEATS_DEINIT);
    rarch_main_command(RARCH_CMD_BSV_MOVIE_DEINIT);
@@ -23,6 +23,9 @@
 #include "intl/intl.h"
 #include "retroarch.h"
 #include "runloop.h"
+#include "gfx/video_monitor.h"
+#include "libretro_version_1.h"
+#include "hash.h"
 
 #ifdef HAVE_MENU
 #include "menu/menu.h"
@@ -689,11 +692,13 @@ static void update_frame_time(void)
  * limit_frame_time:
  *
  * Limit frame time if fast forward ratio throttle is enabled.
+ * Frames are scheduled on absolute deadlines, so rounding and
+ * wakeup latency of one frame does not carry into the next.
  **/
 static void limit_frame_time(void)
 {
    double effective_fps, mft_f;
-   retro_time_t current, target = 0, to_sleep_ms = 0;
+   retro_time_t current, target = 0;
 
    current       = rarch_get_time_usec();
    effective_fps = g_extern.system.av_info.timing.fps 
@@ -704,19 +709,49 @@ static void limit_frame_time(void)
 
    target        = g_extern.frame_limit.last_frame_time + 
                    g_extern.frame_limit.minimum_frame_time;
-   to_sleep_ms   = (target - current) / 1000;
 
-   if (to_sleep_ms <= 0)
+   if (target <= current)
    {
-      g_extern.frame_limit.last_frame_time = rarch_get_time_usec();
+      /* Running behind, resynchronize. */
+      g_extern.frame_limit.last_frame_time = current;
       return;
    }
 
-   rarch_sleep((unsigned int)to_sleep_ms);
+   rarch_sleep_until(target, true);
 
-   /* Combat jitter a bit. */
-   g_extern.frame_limit.last_frame_time += 
-      g_extern.frame_limit.minimum_frame_time;
+   current = rarch_get_time_usec();
+
+   if (!g_extern.frame_limit.frames++)
+      g_extern.frame_limit.start_time = current;
+   g_extern.frame_limit.lateness_accum += current - target;
+   if (current - target > g_extern.frame_limit.lateness_max)
+      g_extern.frame_limit.lateness_max = current - target;
+
+   g_extern.frame_limit.last_frame_time = target;
+}
+
+/**
+ * rarch_main_frame_limit_statistics:
+ *
+ * Logs achieved versus target frame time of the frame limiter.
+ **/
+void rarch_main_frame_limit_statistics(void)
+{
+   double achieved;
+   uint64_t frames = g_extern.frame_limit.frames;
+
+   if (frames < 2 || !g_extern.frame_limit.minimum_frame_time)
+      return;
+
+   achieved = (double)(g_extern.frame_limit.last_frame_time
+         - g_extern.frame_limit.start_time) / (frames - 1);
+
+   RARCH_LOG("Frame limiter: %.3f ms target, %.3f ms achieved frame time, %.1f usec average lateness (%d usec max), based on %u frames.\n",
+         g_extern.frame_limit.minimum_frame_time / 1000.0,
+         achieved / 1000.0,
+         (double)g_extern.frame_limit.lateness_accum / frames,
+         (int)g_extern.frame_limit.lateness_max,
+         (unsigned)frames);
 }
 
 /**
@@ -992,7 +1027,7 @@ int rarch_main_iterate(void)
    {
       /* RetroArch has been paused */
       driver.retro_ctx.poll_cb();
-      rarch_sleep(10);
+      rarch_sleep_until(rarch_get_time_usec() + 10000, false);
 
       return 1;
    }
@@ -1024,9 +1059,16 @@ int rarch_main_iterate(void)
             g_settings.input.analog_dpad_mode[i]);
    }
 
-   if ((g_settings.video.frame_delay > 0) && !driver.nonblock_state)
+   if (g_settings.video.frame_delay_auto && !driver.nonblock_state)
+   {
+      retro_time_t delay = video_monitor_pacing_frame_delay();
+      if (delay >= 1000)
+         rarch_sleep((unsigned)(delay / 1000));
+   }
+   else if ((g_settings.video.frame_delay > 0) && !driver.nonblock_state)
       rarch_sleep(g_settings.video.frame_delay);
 
+   video_monitor_pacing_run_start();
 
    /* Run libretro for one frame. */
    pretro_run();
@@ -1058,3 +1100,138 @@ success:
 
    return ret;
 }
+
+/**
+ * headless_buffer_reserve:
+ * @size                 : Required size of the scratch buffer.
+ *
+ * Returns: true (1) if the headless scratch buffer holds at
+ * least @size bytes, otherwise false (0).
+ **/
+static bool headless_buffer_reserve(size_t size)
+{
+   uint8_t *buffer = NULL;
+
+   if (size <= g_extern.headless.buffer_size)
+      return true;
+
+   buffer = (uint8_t*)realloc(g_extern.headless.buffer, size);
+   if (!buffer)
+      return false;
+
+   g_extern.headless.buffer      = buffer;
+   g_extern.headless.buffer_size = size;
+   return true;
+}
+
+/**
+ * headless_hash:
+ *
+ * Hashes the last frame output by the core or, with --hash-state,
+ * the serialized core state. Framebuffer rows are packed first
+ * so the hash does not depend on the core's pitch.
+ *
+ * Returns: true (1) if a hash was computed, otherwise false (0).
+ **/
+static bool headless_hash(void)
+{
+   unsigned h;
+   size_t size, row_size;
+   const uint8_t *src = (const uint8_t*)g_extern.frame_cache.data;
+
+   if (g_extern.headless.hash_state)
+   {
+      size = pretro_serialize_size();
+
+      if (!size || !headless_buffer_reserve(size))
+         return false;
+      if (!pretro_serialize(g_extern.headless.buffer, size))
+         return false;
+
+      g_extern.headless.hash = crc32_calculate(
+            g_extern.headless.buffer, size);
+      return true;
+   }
+
+   if (!src)
+      return false;
+
+   row_size = g_extern.frame_cache.width * 
+      (g_extern.system.pix_fmt == RETRO_PIXEL_FORMAT_XRGB8888 ?
+       sizeof(uint32_t) : sizeof(uint16_t));
+   size     = row_size * g_extern.frame_cache.height;
+
+   if (!headless_buffer_reserve(size))
+      return false;
+
+   for (h = 0; h < g_extern.frame_cache.height;
+         h++, src += g_extern.frame_cache.pitch)
+      memcpy(g_extern.headless.buffer + h * row_size, src, row_size);
+
+   g_extern.headless.hash = crc32_calculate(g_extern.headless.buffer, size);
+   return true;
+}
+
+/**
+ * rarch_main_run_headless:
+ *
+ * Runs the libretro core in a tight loop, bypassing video,
+ * audio and input drivers, overlays and the message queue.
+ *
+ * Runs until --max-frames is reached, the core requests shutdown,
+ * or BSV movie playback ends with --eof-exit. Every --hash-interval
+ * frames, and after the last frame, a CRC32 of the framebuffer (or
+ * of the serialized state with --hash-state) is printed.
+ * Finishes with a frames per second report.
+ **/
+void rarch_main_run_headless(void)
+{
+   retro_time_t start, elapsed;
+   unsigned frames   = 0;
+   unsigned interval = g_extern.headless.hash_interval;
+
+   retro_set_headless_callbacks();
+   g_extern.frame_cache.data = NULL;
+
+   start = rarch_get_time_usec();
+
+   while (!g_extern.system.shutdown
+         && !(g_extern.max_frames && frames >= g_extern.max_frames)
+         && !(g_extern.bsv.movie_end && g_extern.bsv.eof_exit))
+   {
+      if (g_extern.bsv.movie)
+         bsv_movie_set_frame_start(g_extern.bsv.movie);
+
+      pretro_run();
+
+      if (g_extern.bsv.movie)
+         bsv_movie_set_frame_end(g_extern.bsv.movie);
+
+      frames++;
+      g_extern.frame_count++;
+
+      if (interval && (frames % interval) == 0 && headless_hash())
+         printf("Frame %u: %08x\n", frames,
+               (unsigned)g_extern.headless.hash);
+   }
+
+   elapsed = rarch_get_time_usec() - start;
+
+   if (frames && headless_hash())
+      printf("Final %s hash: %08x\n",
+            g_extern.headless.hash_state ? "state" : "framebuffer",
+            (unsigned)g_extern.headless.hash);
+
+   printf("Ran %u frames in %.3f seconds (%.1f FPS).\n", frames,
+         elapsed / 1000000.0,
+         elapsed ? frames * 1000000.0 / elapsed : 0.0);
+
+   free(g_extern.headless.buffer);
+   g_extern.headless.buffer      = NULL;
+   g_extern.headless.buffer_size = 0;
+
+   /* Cached frame points into core memory, which is about to go away. */
+   g_extern.frame_cache.data = NULL;
+
+   retro_init_libretro_cbs(&driver.retro_ctx);
+}
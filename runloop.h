@@ -33,6 +33,23 @@ int rarch_main_iterate(void);
 
 void do_data_state_checks(void);
 
+/**
+ * rarch_main_frame_limit_statistics:
+ *
+ * Logs achieved versus target frame time of the frame limiter.
+ **/
+void rarch_main_frame_limit_statistics(void);
+
+/**
+ * rarch_main_run_headless:
+ *
+ * Runs the libretro core in a tight loop, bypassing video,
+ * audio and input drivers, until the exit conditions are met.
+ * Prints periodic framebuffer or state hashes and a
+ * final frames per second report.
+ **/
+void rarch_main_run_headless(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -17,6 +17,7 @@
  */
 
 #include "general.h"
+#include "performance.h"
 #ifdef HAVE_NETWORKING
 #include "net_http.h"
 
@@ -202,17 +203,63 @@ static int rarch_main_iterate_image_poll(void)
    return 0;
 }
 
+/* Time budget for image decoding per frame, in microseconds. */
+#define IMAGE_TRANSFER_BUDGET_USEC 2000
+
+/* Scanlines decoded between budget checks. */
+#define IMAGE_PROCESS_ROWS 16
+
+static int rarch_main_iterate_image_process(retro_time_t deadline)
+{
+   do
+   {
+      int ret = rpng_nbio_load_image_argb_process_iterate(
+            g_extern.images.handle,
+            &g_extern.images.data,
+            &g_extern.images.width,
+            &g_extern.images.height,
+            IMAGE_PROCESS_ROWS);
+
+      if (ret == RPNG_PROCESS_END)
+         return 0;
+      if (ret == RPNG_PROCESS_ERROR)
+         return -2;
+   }while (rarch_get_time_usec() < deadline);
+
+   return -1;
+}
+
+/**
+ * rarch_main_iterate_image_transfer:
+ *
+ * Reads PNG chunks, then inflates and unfilters the image
+ * a few scanlines at a time, until the per-frame time
+ * budget runs out.
+ *
+ * Returns: 0 when the image is decoded, -1 when we should
+ * continue on the next frame, -2 on error.
+ **/
 static int rarch_main_iterate_image_transfer(void)
 {
-   if (rpng_nbio_load_image_argb_iterate(
-            g_extern.images.handle->buff_data,
-            g_extern.images.handle))
+   struct rpng_t *rpng   = g_extern.images.handle;
+   retro_time_t deadline = rarch_get_time_usec()
+      + IMAGE_TRANSFER_BUDGET_USEC;
+
+   if (g_extern.images.is_processing)
+      return rarch_main_iterate_image_process(deadline);
+
+   while (rpng_nbio_load_image_argb_iterate(rpng->buff_data, rpng))
    {
-      g_extern.images.handle->buff_data += 
-         4 + 4 + g_extern.images.handle->chunk.size + 4;
-      return 0;
+      rpng->buff_data += 4 + 4 + rpng->chunk.size + 4;
+
+      if (rarch_get_time_usec() >= deadline)
+         return -1;
    }
 
+   if (!rpng->has_ihdr || !rpng->has_idat || !rpng->has_iend)
+      return -2;
+
+   g_extern.images.is_processing = true;
    return -1;
 }
 
@@ -222,9 +269,12 @@ static int rarch_main_iterate_image_parse_free(void)
       return -1;
 
    rpng_nbio_load_image_free(g_extern.images.handle);
-   g_extern.images.handle      = NULL;
-   g_extern.images.is_blocking = false;
-   g_extern.images.is_finished = false;
+   free(g_extern.images.data);
+   g_extern.images.handle        = NULL;
+   g_extern.images.data          = NULL;
+   g_extern.images.is_blocking   = false;
+   g_extern.images.is_finished   = false;
+   g_extern.images.is_processing = false;
 
    msg_queue_clear(g_extern.images.msg_queue);
 
@@ -235,8 +285,12 @@ static int rarch_main_iterate_image_parse(void)
 {
    size_t len = 0;
 
+   g_extern.images.is_blocking = true;
+
    if (g_extern.images.handle && g_extern.images.cb)
       g_extern.images.cb(g_extern.images.handle, len);
+   else
+      g_extern.images.is_finished = true;
 
    return 0;
 }
@@ -410,8 +464,16 @@ void do_data_state_checks(void)
    {
       if (!g_extern.images.is_blocking)
       {
-         if (!rarch_main_iterate_image_transfer())
+         int ret = rarch_main_iterate_image_transfer();
+
+         if (ret == 0)
             rarch_main_iterate_image_parse();
+         else if (ret == -2)
+         {
+            RARCH_ERR("Failed to decode image.\n");
+            g_extern.images.is_blocking = true;
+            g_extern.images.is_finished = true;
+         }
       }
       else if (g_extern.images.is_finished)
          rarch_main_iterate_image_parse_free();
@@ -27,6 +27,7 @@
 #include "gfx/scaler/scaler.h"
 #include "retroarch.h"
 #include "retroarch_logger.h"
+#include "performance.h"
 #include "screenshot.h"
 #include "gfx/video_viewport.h"
 
@@ -39,6 +40,151 @@
 #include <formats/rpng.h>
 #define IMG_EXT "png"
 
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+
+/* Screenshots waiting to be encoded. Buffers are kept
+ * around to be reused by later screenshots. */
+#define SCREENSHOT_POOL_SIZE 4
+
+struct screenshot_task
+{
+   char filename[PATH_MAX_LENGTH];
+   uint8_t *buffer;
+   size_t buffer_size;
+   unsigned width;
+   unsigned height;
+};
+
+static struct
+{
+   sthread_t *thread;
+   slock_t *lock;
+   scond_t *cond;
+   bool quit;
+
+   struct screenshot_task tasks[SCREENSHOT_POOL_SIZE];
+   /* Task currently being encoded. */
+   unsigned head;
+   unsigned count;
+} screenshot_worker;
+#endif
+
+static bool screenshot_encode(const char *filename, const uint8_t *buffer,
+      unsigned width, unsigned height)
+{
+   bool ret = rpng_save_image_bgr24_ext(filename, buffer,
+         width, height, width * 3,
+         g_settings.video.screenshot_compression,
+         g_settings.video.screenshot_filter_threads);
+
+   if (!ret)
+      RARCH_ERR("Failed to take screenshot.\n");
+   return ret;
+}
+
+#ifdef HAVE_THREADS
+static void screenshot_thread_loop(void *data)
+{
+   (void)data;
+
+   slock_lock(screenshot_worker.lock);
+
+   for (;;)
+   {
+      struct screenshot_task *task = NULL;
+
+      while (!screenshot_worker.count && !screenshot_worker.quit)
+         scond_wait(screenshot_worker.cond, screenshot_worker.lock);
+
+      /* Pending screenshots are still written out on quit. */
+      if (!screenshot_worker.count)
+         break;
+
+      task = &screenshot_worker.tasks[screenshot_worker.head];
+      slock_unlock(screenshot_worker.lock);
+
+      if (!screenshot_encode(task->filename, task->buffer,
+               task->width, task->height))
+         msg_queue_push(g_extern.msg_queue,
+               RETRO_MSG_TAKE_SCREENSHOT_FAILED, 1, 180);
+
+      slock_lock(screenshot_worker.lock);
+      screenshot_worker.head = (screenshot_worker.head + 1)
+         % SCREENSHOT_POOL_SIZE;
+      screenshot_worker.count--;
+      scond_signal(screenshot_worker.cond);
+   }
+
+   slock_unlock(screenshot_worker.lock);
+}
+
+static bool screenshot_worker_init(void)
+{
+   if (screenshot_worker.thread)
+      return true;
+
+   screenshot_worker.lock = slock_new();
+   screenshot_worker.cond = scond_new();
+
+   if (screenshot_worker.lock && screenshot_worker.cond)
+      screenshot_worker.thread = sthread_create(
+            screenshot_thread_loop, NULL);
+
+   if (!screenshot_worker.thread)
+   {
+      RARCH_WARN("Failed to start screenshot thread.\n");
+      screenshot_deinit();
+      return false;
+   }
+
+   return true;
+}
+
+/**
+ * screenshot_worker_acquire:
+ * @size              : required size of the buffer.
+ *
+ * Gets the next free task from the pool, waiting for the
+ * worker if all of them are still pending.
+ *
+ * Returns: task to fill in, or NULL if no buffer could be
+ * allocated.
+ **/
+static struct screenshot_task *screenshot_worker_acquire(size_t size)
+{
+   struct screenshot_task *task = NULL;
+
+   slock_lock(screenshot_worker.lock);
+   while (screenshot_worker.count == SCREENSHOT_POOL_SIZE)
+      scond_wait(screenshot_worker.cond, screenshot_worker.lock);
+   task = &screenshot_worker.tasks[(screenshot_worker.head
+         + screenshot_worker.count) % SCREENSHOT_POOL_SIZE];
+   slock_unlock(screenshot_worker.lock);
+
+   /* The worker does not touch tasks past count,
+    * so the buffer can be filled in without the lock. */
+   if (task->buffer_size < size)
+   {
+      uint8_t *buffer = (uint8_t*)realloc(task->buffer, size);
+      if (!buffer)
+         return NULL;
+      task->buffer      = buffer;
+      task->buffer_size = size;
+   }
+
+   return task;
+}
+
+static void screenshot_worker_submit(void)
+{
+   slock_lock(screenshot_worker.lock);
+   screenshot_worker.count++;
+   scond_signal(screenshot_worker.cond);
+   slock_unlock(screenshot_worker.lock);
+}
+#endif
+
 #else
 
 #define IMG_EXT "bmp"
@@ -170,10 +316,43 @@ end:
 }
 #endif
 
-static bool take_screenshot_viewport(void)
+/**
+ * screenshot_dump_viewport:
+ * @buffer               : Viewport in BGR24, bottom-up.
+ * @width                : Width of viewport.
+ * @height               : Height of viewport.
+ *
+ * Returns: true (1) if successful, otherwise false (0).
+ **/
+static bool screenshot_dump_viewport(const uint8_t *buffer,
+      unsigned width, unsigned height)
 {
    char screenshot_path[PATH_MAX_LENGTH];
-   const char *screenshot_dir = NULL;
+   const char *screenshot_dir = g_settings.screenshot_directory;
+
+   if (!*g_settings.screenshot_directory)
+   {
+      fill_pathname_basedir(screenshot_path, g_extern.basename,
+            sizeof(screenshot_path));
+      screenshot_dir = screenshot_path;
+   }
+
+   /* Data read from viewport is in bottom-up order, suitable for BMP. */
+   return screenshot_dump(screenshot_dir, buffer, width, height,
+         width * 3, true);
+}
+
+static void screenshot_viewport_read(void *userdata,
+      const uint8_t *buffer, unsigned width, unsigned height)
+{
+   (void)userdata;
+
+   if (!buffer || !screenshot_dump_viewport(buffer, width, height))
+      RARCH_WARN(RETRO_LOG_TAKE_SCREENSHOT_FAILED);
+}
+
+static bool take_screenshot_viewport(void)
+{
    uint8_t *buffer = NULL;
    bool retval = false;
    struct video_viewport vp = {0};
@@ -191,21 +370,7 @@ static bool take_screenshot_viewport(void)
       if (!driver.video->read_viewport(driver.video_data, buffer))
          goto done;
 
-   screenshot_dir = g_settings.screenshot_directory;
-
-   if (!*g_settings.screenshot_directory)
-   {
-      fill_pathname_basedir(screenshot_path, g_extern.basename,
-            sizeof(screenshot_path));
-      screenshot_dir = screenshot_path;
-   }
-
-   /* Data read from viewport is in bottom-up order, suitable for BMP. */
-   if (!screenshot_dump(screenshot_dir, buffer, vp.width, vp.height,
-            vp.width * 3, true))
-      goto done;
-
-   retval = true;
+   retval = screenshot_dump_viewport(buffer, vp.width, vp.height);
 
 done:
    if (buffer)
@@ -237,6 +402,39 @@ static bool take_screenshot_raw(void)
          width, height, -pitch, false);
 }
 
+/**
+ * screenshot_deinit:
+ *
+ * Waits for pending screenshots to be written and
+ * frees the screenshot thread and its buffers.
+ **/
+void screenshot_deinit(void)
+{
+#if defined(HAVE_ZLIB_DEFLATE) && defined(HAVE_THREADS)
+   unsigned i;
+
+   if (screenshot_worker.thread)
+   {
+      slock_lock(screenshot_worker.lock);
+      screenshot_worker.quit = true;
+      scond_signal(screenshot_worker.cond);
+      slock_unlock(screenshot_worker.lock);
+
+      sthread_join(screenshot_worker.thread);
+   }
+
+   if (screenshot_worker.lock)
+      slock_free(screenshot_worker.lock);
+   if (screenshot_worker.cond)
+      scond_free(screenshot_worker.cond);
+
+   for (i = 0; i < SCREENSHOT_POOL_SIZE; i++)
+      free(screenshot_worker.tasks[i].buffer);
+
+   memset(&screenshot_worker, 0, sizeof(screenshot_worker));
+#endif
+}
+
 /**
  * take_screenshot:
  *
@@ -244,7 +442,8 @@ static bool take_screenshot_raw(void)
  **/
 bool take_screenshot(void)
 {
-   bool viewport_read = false;
+   bool viewport_read  = false;
+   bool viewport_async = false;
    bool ret = true;
    const char *msg = NULL;
 
@@ -257,6 +456,11 @@ bool take_screenshot(void)
          != RETRO_HW_CONTEXT_NONE) && driver.video->read_viewport &&
       driver.video->viewport_info;
 
+   /* Read back without stalling, unless paused,
+    * where no further frames would pick up the result. */
+   viewport_async = viewport_read && driver.video->read_viewport_async &&
+      !g_extern.is_paused;
+
    /* Clear out message queue to avoid OSD fonts to appear on screenshot. */
    msg_queue_clear(g_extern.msg_queue);
 
@@ -269,12 +473,21 @@ bool take_screenshot(void)
                false, false);
 #endif
 
+      /* The read is started by the cached frame rendered below. */
+      if (viewport_async)
+         ret = driver.video->read_viewport_async(driver.video_data,
+               screenshot_viewport_read, NULL);
+
       if (driver.video)
          rarch_render_cached_frame();
    }
 
    if (viewport_read)
-      ret = take_screenshot_viewport();
+   {
+      /* Otherwise written by screenshot_viewport_read() later. */
+      if (!viewport_async)
+         ret = take_screenshot_viewport();
+   }
    else if (g_extern.frame_cache.data &&
          (g_extern.frame_cache.data != RETRO_HW_FRAME_BUFFER_VALID))
       ret = take_screenshot_raw();
@@ -311,6 +524,9 @@ bool screenshot_dump(const char *folder, const void *frame,
    FILE *file          = NULL;
    uint8_t *out_buffer = NULL;
    bool ret            = false;
+#if defined(HAVE_ZLIB_DEFLATE) && defined(HAVE_THREADS)
+   struct screenshot_task *task = NULL;
+#endif
 
    (void)file;
    (void)out_buffer;
@@ -320,6 +536,16 @@ bool screenshot_dump(const char *folder, const void *frame,
    fill_pathname_join(filename, folder, shotname, sizeof(filename));
 
 #ifdef HAVE_ZLIB_DEFLATE
+#ifdef HAVE_THREADS
+   if (g_settings.video.screenshot_threaded && screenshot_worker_init())
+   {
+      task = screenshot_worker_acquire(width * height * 3);
+      if (!task)
+         return false;
+      out_buffer = task->buffer;
+   }
+   else
+#endif
    out_buffer = (uint8_t*)malloc(width * height * 3);
    if (!out_buffer)
       return false;
@@ -332,6 +558,7 @@ bool screenshot_dump(const char *folder, const void *frame,
    scaler.out_stride = width * 3;
    scaler.out_fmt = SCALER_FMT_BGR24;
    scaler.scaler_type = SCALER_TYPE_POINT;
+   scaler.threads     = rarch_get_cpu_cores();
 
    if (bgr24)
       scaler.in_fmt = SCALER_FMT_BGR24;
@@ -345,11 +572,19 @@ bool screenshot_dump(const char *folder, const void *frame,
          (const uint8_t*)frame + ((int)height - 1) * pitch);
    scaler_ctx_gen_reset(&scaler);
 
-   RARCH_LOG("Using RPNG for PNG screenshots.\n");
-   ret = rpng_save_image_bgr24(filename,
-         out_buffer, width, height, width * 3);
-   if (!ret)
-      RARCH_ERR("Failed to take screenshot.\n");
+#ifdef HAVE_THREADS
+   if (task)
+   {
+      /* Encoding and writing the file is left to the worker. */
+      strlcpy(task->filename, filename, sizeof(task->filename));
+      task->width  = width;
+      task->height = height;
+      screenshot_worker_submit();
+      return true;
+   }
+#endif
+
+   ret = screenshot_encode(filename, out_buffer, width, height);
    free(out_buffer);
 #else
    file = fopen(filename, "wb");
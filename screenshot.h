@@ -28,4 +28,6 @@ void screenshot_generate_filename(char *filename, size_t size);
 
 bool take_screenshot(void);
 
+void screenshot_deinit(void);
+
 #endif
@@ -400,6 +400,7 @@ static void config_set_defaults(void)
    g_settings.video.hard_sync = hard_sync;
    g_settings.video.hard_sync_frames = hard_sync_frames;
    g_settings.video.frame_delay = frame_delay;
+   g_settings.video.frame_delay_auto = frame_delay_auto;
    g_settings.video.black_frame_insertion = black_frame_insertion;
    g_settings.video.swap_interval = swap_interval;
    g_settings.video.threaded = video_threaded;
@@ -409,6 +410,7 @@ static void config_set_defaults(void)
 
    g_settings.video.shared_context = video_shared_context;
    g_settings.video.force_srgb_disable = false;
+   g_settings.video.gpu_pixel_convert = false;
 #ifdef GEKKO
    g_settings.video.viwidth = video_viwidth;
    g_settings.video.vfilter = video_vfilter;
@@ -441,6 +443,9 @@ static void config_set_defaults(void)
    g_settings.video.post_filter_record = post_filter_record;
    g_settings.video.gpu_record = gpu_record;
    g_settings.video.gpu_screenshot = gpu_screenshot;
+   g_settings.video.screenshot_threaded = screenshot_threaded;
+   g_settings.video.screenshot_compression = screenshot_compression;
+   g_settings.video.screenshot_filter_threads = screenshot_filter_threads;
    g_settings.video.rotation = ORIENTATION_NORMAL;
 
    g_settings.audio.enable = audio_enable;
@@ -606,6 +611,7 @@ static void config_set_defaults(void)
    *g_settings.playlist_directory = '\0';
    *g_settings.video.shader_path = '\0';
    *g_settings.video.shader_dir = '\0';
+   *g_settings.video.shader_cache_dir = '\0';
    *g_settings.video.filter_dir = '\0';
    *g_settings.audio.filter_dir = '\0';
    *g_settings.video.softfilter_plugin = '\0';
@@ -1128,6 +1134,7 @@ static bool config_load_file(const char *path, bool set_defaults)
    CONFIG_GET_INT(video.frame_delay, "video_frame_delay");
    if (g_settings.video.frame_delay > 15)
       g_settings.video.frame_delay = 15;
+   CONFIG_GET_BOOL(video.frame_delay_auto, "video_frame_delay_auto");
 
    CONFIG_GET_BOOL(video.black_frame_insertion, "video_black_frame_insertion");
    CONFIG_GET_INT(video.swap_interval, "video_swap_interval");
@@ -1161,6 +1168,7 @@ static bool config_load_file(const char *path, bool set_defaults)
    CONFIG_GET_INT(video.rotation, "video_rotation");
 
    CONFIG_GET_BOOL(video.force_srgb_disable, "video_force_srgb_disable");
+   CONFIG_GET_BOOL(video.gpu_pixel_convert, "video_gpu_pixel_convert");
 
 #ifdef RARCH_CONSOLE
    /* TODO - will be refactored later to make it more clean - it's more 
@@ -1204,11 +1212,21 @@ static bool config_load_file(const char *path, bool set_defaults)
    CONFIG_GET_BOOL(video.post_filter_record, "video_post_filter_record");
    CONFIG_GET_BOOL(video.gpu_record, "video_gpu_record");
    CONFIG_GET_BOOL(video.gpu_screenshot, "video_gpu_screenshot");
+   CONFIG_GET_BOOL(video.screenshot_threaded, "video_screenshot_threaded");
+   CONFIG_GET_INT(video.screenshot_compression, "video_screenshot_compression");
+   if (g_settings.video.screenshot_compression > 9)
+      g_settings.video.screenshot_compression = 9;
+   CONFIG_GET_INT(video.screenshot_filter_threads,
+         "video_screenshot_filter_threads");
 
    CONFIG_GET_PATH(video.shader_dir, "video_shader_dir");
    if (!strcmp(g_settings.video.shader_dir, "default"))
       *g_settings.video.shader_dir = '\0';
 
+   CONFIG_GET_PATH(video.shader_cache_dir, "video_shader_cache_dir");
+   if (!strcmp(g_settings.video.shader_cache_dir, "default"))
+      *g_settings.video.shader_cache_dir = '\0';
+
    CONFIG_GET_PATH(video.filter_dir, "video_filter_dir");
    if (!strcmp(g_settings.video.filter_dir, "default"))
       *g_settings.video.filter_dir = '\0';
@@ -1873,6 +1891,8 @@ bool config_save_file(const char *path)
          g_settings.video.shared_context);
    config_set_bool(conf,  "video_force_srgb_disable",
          g_settings.video.force_srgb_disable);
+   config_set_bool(conf,  "video_gpu_pixel_convert",
+         g_settings.video.gpu_pixel_convert);
    config_set_bool(conf,  "video_fullscreen", g_settings.video.fullscreen);
    config_set_float(conf, "video_refresh_rate", g_settings.video.refresh_rate);
    config_set_int(conf,   "video_monitor_index",
@@ -1894,6 +1914,8 @@ bool config_save_file(const char *path)
    config_set_int(conf,   "video_hard_sync_frames",
          g_settings.video.hard_sync_frames);
    config_set_int(conf,   "video_frame_delay", g_settings.video.frame_delay);
+   config_set_bool(conf,  "video_frame_delay_auto",
+         g_settings.video.frame_delay_auto);
    config_set_bool(conf,  "video_black_frame_insertion",
          g_settings.video.black_frame_insertion);
    config_set_bool(conf,  "video_disable_composition",
@@ -1901,6 +1923,12 @@ bool config_save_file(const char *path)
    config_set_bool(conf,  "pause_nonactive", g_settings.pause_nonactive);
    config_set_int(conf, "video_swap_interval", g_settings.video.swap_interval);
    config_set_bool(conf, "video_gpu_screenshot", g_settings.video.gpu_screenshot);
+   config_set_bool(conf, "video_screenshot_threaded",
+         g_settings.video.screenshot_threaded);
+   config_set_int(conf, "video_screenshot_compression",
+         g_settings.video.screenshot_compression);
+   config_set_int(conf, "video_screenshot_filter_threads",
+         g_settings.video.screenshot_filter_threads);
    config_set_int(conf, "video_rotation", g_settings.video.rotation);
    config_set_path(conf, "screenshot_directory",
          *g_settings.screenshot_directory ?
@@ -1957,6 +1985,9 @@ bool config_save_file(const char *path)
    config_set_path(conf, "video_shader_dir",
          *g_settings.video.shader_dir ?
          g_settings.video.shader_dir : "default");
+   config_set_path(conf, "video_shader_cache_dir",
+         *g_settings.video.shader_cache_dir ?
+         g_settings.video.shader_cache_dir : "default");
    config_set_path(conf, "video_filter_dir",
          *g_settings.video.filter_dir ?
          g_settings.video.filter_dir : "default");
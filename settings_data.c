@@ -2121,6 +2121,17 @@ int setting_data_get_description(const char *label, char *msg,
             " \n"
             "Maximum is 15.");
    }
+   else if (!strcmp(label, "video_frame_delay_auto"))
+   {
+      snprintf(msg, sizeof_msg,
+            " -- Determines frame delay automatically\n"
+            "from measured VSync timing and core\n"
+            "run time.\n"
+            " \n"
+            "Runs the core as late as possible\n"
+            "before the next VSync. Overrides\n"
+            "'Frame Delay'.");
+   }
    else if (!strcmp(label, "audio_rate_control_delta"))
    {
       snprintf(msg, sizeof_msg,
@@ -2301,6 +2312,27 @@ int setting_data_get_description(const char *label, char *msg,
             " -- Screenshots output of GPU shaded \n"
             "material if available.");
    }
+   else if (!strcmp(label, "video_screenshot_threaded"))
+   {
+      snprintf(msg, sizeof_msg,
+            " -- Encodes and saves screenshots on a \n"
+            "background thread, so taking one does \n"
+            "not stall the game.");
+   }
+   else if (!strcmp(label, "video_screenshot_compression"))
+   {
+      snprintf(msg, sizeof_msg,
+            " -- PNG compression level of screenshots.\n"
+            " \n"
+            "Lower levels encode faster but produce \n"
+            "larger files. 0 stores images uncompressed.");
+   }
+   else if (!strcmp(label, "video_screenshot_filter_threads"))
+   {
+      snprintf(msg, sizeof_msg,
+            " -- Number of threads used to filter \n"
+            "screenshot lines before compression.");
+   }
    else if (!strcmp(label, "autosave_interval"))
    {
       snprintf(msg, sizeof_msg,
@@ -3888,6 +3920,20 @@ static bool setting_data_append_list_video_options(
    settings_list_current_add_cmd(list, list_info, RARCH_CMD_REINIT);
    settings_data_list_current_add_flags(list, list_info, SD_FLAG_CMD_APPLY_AUTO);
 
+   CONFIG_BOOL(
+         g_settings.video.gpu_pixel_convert,
+         "video_gpu_pixel_convert",
+         "GPU Pixel Conversion",
+         false,
+         "OFF",
+         "ON",
+         group_info.name,
+         subgroup_info.name,
+         general_write_handler,
+         general_read_handler);
+   settings_list_current_add_cmd(list, list_info, RARCH_CMD_REINIT);
+   settings_data_list_current_add_flags(list, list_info, SD_FLAG_CMD_APPLY_AUTO);
+
    END_SUB_GROUP(list, list_info);
 
    START_SUB_GROUP(list, list_info, "Aspect", group_info.name, subgroup_info);
@@ -4192,6 +4238,18 @@ static bool setting_data_append_list_video_options(
          general_write_handler,
          general_read_handler);
    settings_list_current_add_range(list, list_info, 0, 15, 1, true, true);
+
+   CONFIG_BOOL(
+         g_settings.video.frame_delay_auto,
+         "video_frame_delay_auto",
+         "Automatic Frame Delay",
+         frame_delay_auto,
+         "OFF",
+         "ON",
+         group_info.name,
+         subgroup_info.name,
+         general_write_handler,
+         general_read_handler);
 #if !defined(RARCH_MOBILE)
    CONFIG_BOOL(
          g_settings.video.black_frame_insertion,
@@ -4250,6 +4308,40 @@ static bool setting_data_append_list_video_options(
          general_write_handler,
          general_read_handler);
 
+   CONFIG_BOOL(
+         g_settings.video.screenshot_threaded,
+         "video_screenshot_threaded",
+         "Threaded Screenshots",
+         screenshot_threaded,
+         "OFF",
+         "ON",
+         group_info.name,
+         subgroup_info.name,
+         general_write_handler,
+         general_read_handler);
+
+   CONFIG_UINT(
+         g_settings.video.screenshot_compression,
+         "video_screenshot_compression",
+         "Screenshot Compression",
+         screenshot_compression,
+         group_info.name,
+         subgroup_info.name,
+         general_write_handler,
+         general_read_handler);
+   settings_list_current_add_range(list, list_info, 0, 9, 1, true, true);
+
+   CONFIG_UINT(
+         g_settings.video.screenshot_filter_threads,
+         "video_screenshot_filter_threads",
+         "Screenshot Filter Threads",
+         screenshot_filter_threads,
+         group_info.name,
+         subgroup_info.name,
+         general_write_handler,
+         general_read_handler);
+   settings_list_current_add_range(list, list_info, 1, 8, 1, true, true);
+
    CONFIG_BOOL(
          g_settings.video.allow_rotate,
          "video_allow_rotate",
@@ -5896,6 +5988,21 @@ static bool setting_data_append_list_path_options(
          list_info,
          SD_FLAG_ALLOW_EMPTY | SD_FLAG_PATH_DIR | SD_FLAG_BROWSER_ACTION);
 
+   CONFIG_DIR(
+         g_settings.video.shader_cache_dir,
+         "video_shader_cache_dir",
+         "Shader Cache Directory",
+         "",
+         "<None>",
+         group_info.name,
+         subgroup_info.name,
+         general_write_handler,
+         general_read_handler);
+   settings_data_list_current_add_flags(
+         list,
+         list_info,
+         SD_FLAG_ALLOW_EMPTY | SD_FLAG_PATH_DIR | SD_FLAG_BROWSER_ACTION);
+
 #ifdef HAVE_OVERLAY
    CONFIG_DIR(
          g_extern.overlay_dir,
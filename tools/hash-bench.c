@@ -0,0 +1,201 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2015 - Daniel De Matteis
+ * 
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Checks the content hashes against known vectors and each other,
+ * then benchmarks them.
+ *
+ * Usage: hash-bench [megabytes]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "../hash.h"
+
+static double get_time(void)
+{
+   struct timespec tv;
+   clock_gettime(CLOCK_MONOTONIC, &tv);
+   return tv.tv_sec + tv.tv_nsec / 1000000000.0;
+}
+
+static uint32_t crc32_bytewise(const uint8_t *data, size_t length)
+{
+   uint32_t crc = ~0;
+   while (length--)
+      crc = crc32_adjust(crc, *data++);
+   return ~crc;
+}
+
+static unsigned check_string(const char *ident,
+      const char *result, const char *expected)
+{
+   if (!strcmp(result, expected))
+      return 0;
+
+   fprintf(stderr, "FAIL: %s: got %s, expected %s.\n",
+         ident, result, expected);
+   return 1;
+}
+
+static unsigned check_vectors(void)
+{
+   char out[65];
+   unsigned failed = 0;
+   uint8_t *million = (uint8_t*)malloc(1000000);
+
+   if (!million)
+      return 1;
+   memset(million, 'a', 1000000);
+
+   if (crc32_calculate((const uint8_t*)"123456789", 9) != 0xcbf43926)
+   {
+      fprintf(stderr, "FAIL: crc32 check value.\n");
+      failed++;
+   }
+
+   sha1_hash(out, (const uint8_t*)"abc", 3);
+   failed += check_string("sha1 abc", out,
+         "a9993e364706816aba3e25717850c26c9cd0d89d");
+   sha1_hash(out, million, 1000000);
+   failed += check_string("sha1 million a", out,
+         "34aa973cd4c4daa4f61eeb2bdbad27316534016f");
+
+   sha256_hash(out, (const uint8_t*)"abc", 3);
+   failed += check_string("sha256 abc", out,
+         "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+   sha256_hash(out, million, 1000000);
+   failed += check_string("sha256 million a", out,
+         "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+
+   free(million);
+   return failed;
+}
+
+/* Every length and alignment around the block sizes
+ * of the fast paths, whole and split in two. */
+static unsigned check_crc32(const uint8_t *data, bool hardware)
+{
+   size_t length, offset, split;
+   unsigned failed = 0;
+
+   for (offset = 0; offset < 16; offset++)
+   {
+      for (length = 0; length < 600; length++)
+      {
+         uint32_t ref = crc32_bytewise(data + offset, length);
+
+         if (crc32_calculate(data + offset, length) != ref)
+            failed++;
+
+         split = length / 3;
+         if (crc32_update(crc32_update(0, data + offset, split),
+                  data + offset + split, length - split) != ref)
+            failed++;
+      }
+   }
+
+   if (failed)
+      fprintf(stderr, "FAIL: crc32 (%s) mismatched %u times.\n",
+            hardware ? "hardware" : "slicing-by-8", failed);
+   return failed;
+}
+
+static void bench(const char *ident, const uint8_t *data, size_t size,
+      unsigned kind)
+{
+   char out[65];
+   double start = get_time();
+   double elapsed;
+
+   switch (kind)
+   {
+      case 0:
+         crc32_bytewise(data, size);
+         break;
+      case 1:
+         crc32_calculate(data, size);
+         break;
+      case 2:
+         sha1_hash(out, data, size);
+         break;
+      case 3:
+         sha256_hash(out, data, size);
+         break;
+   }
+
+   elapsed = get_time() - start;
+   printf("%-24s %10.1f MB/s\n", ident, size / elapsed / (1024.0 * 1024.0));
+}
+
+int main(int argc, char *argv[])
+{
+   size_t i, size;
+   bool hardware;
+   unsigned failed   = 0;
+   unsigned mbytes   = 256;
+   uint8_t *data     = NULL;
+
+   if (argc > 2)
+   {
+      fprintf(stderr, "Usage: %s [megabytes]\n", argv[0]);
+      return 1;
+   }
+
+   if (argc == 2)
+      mbytes = strtoul(argv[1], NULL, 0);
+
+   size = (size_t)mbytes * 1024 * 1024;
+   data = (uint8_t*)malloc(size < 1024 ? 1024 : size);
+   if (!data)
+      return 1;
+
+   srand(1);
+   for (i = 0; i < (size < 1024 ? 1024 : size); i++)
+      data[i] = rand() >> 7;
+
+   failed += check_vectors();
+   crc32_set_hardware(false);
+   failed += check_crc32(data, false);
+   hardware = crc32_set_hardware(true);
+   if (hardware)
+      failed += check_crc32(data, true);
+
+   if (failed)
+   {
+      free(data);
+      return 1;
+   }
+
+   printf("All hashes match.\n");
+
+   if (size)
+   {
+      printf("\n%u MB:\n", mbytes);
+      bench("crc32 (bytewise)", data, size, 0);
+      crc32_set_hardware(false);
+      bench("crc32 (slicing-by-8)", data, size, 1);
+      if (crc32_set_hardware(true))
+         bench("crc32 (hardware)", data, size, 1);
+      bench("sha1", data, size, 2);
+      bench("sha256", data, size, 3);
+   }
+
+   free(data);
+   return 0;
+}
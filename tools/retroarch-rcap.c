@@ -0,0 +1,479 @@
+/*  RetroArch - A frontend for libretro.
+ *  Copyright (C) 2010-2014 - Hans-Kristian Arntzen
+ *  Copyright (C) 2011-2015 - Daniel De Matteis
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Inspects, verifies and converts lossless .rcap captures.
+ *
+ * Usage: retroarch-rcap <command> <capture> [args]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "../record/rcap.h"
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#define popen _popen
+#define pclose _pclose
+#define RCAP_QUOTE "\""
+#else
+#define RCAP_QUOTE "'"
+#endif
+
+static const char *pix_fmt_name(const struct rcap_header *header)
+{
+   bool big_endian = header->flags & RCAP_FLAG_BIG_ENDIAN;
+
+   switch (header->pix_fmt)
+   {
+      case RCAP_PIX_RGB565:
+         return big_endian ? "rgb565be" : "rgb565le";
+      case RCAP_PIX_BGR24:
+         return "bgr24";
+      case RCAP_PIX_XRGB8888:
+         return big_endian ? "0rgb" : "bgr0";
+   }
+
+   return "unknown";
+}
+
+static void canvas_size(rcap_reader_t *reader,
+      unsigned *width, unsigned *height)
+{
+   const struct rcap_info *info     = rcap_reader_info(reader);
+   const struct rcap_header *header = rcap_reader_header(reader);
+
+   *width  = info->max_width  ? info->max_width  : header->width;
+   *height = info->max_height ? info->max_height : header->height;
+}
+
+/* Frames smaller than the canvas are placed in its top left corner. */
+static void blit_frame(uint8_t *canvas, unsigned canvas_width,
+      unsigned canvas_height, unsigned pix_size,
+      const struct rcap_packet *packet)
+{
+   unsigned y;
+   size_t line = (size_t)canvas_width * pix_size;
+
+   memset(canvas, 0, line * canvas_height);
+
+   for (y = 0; y < packet->height && y < canvas_height; y++)
+      memcpy(canvas + y * line,
+            (const uint8_t*)packet->data + y * packet->pitch,
+            packet->pitch < line ? packet->pitch : line);
+}
+
+static bool write_le16(FILE *file, unsigned val)
+{
+   uint8_t data[2] = { val & 0xff, (val >> 8) & 0xff };
+   return fwrite(data, 1, sizeof(data), file) == sizeof(data);
+}
+
+static bool write_le32(FILE *file, uint32_t val)
+{
+   uint8_t data[4] = { val & 0xff, (val >> 8) & 0xff,
+      (val >> 16) & 0xff, val >> 24 };
+   return fwrite(data, 1, sizeof(data), file) == sizeof(data);
+}
+
+static bool write_wav_header(FILE *file,
+      const struct rcap_header *header, uint64_t audio_frames)
+{
+   unsigned rate        = (unsigned)(header->samplerate + 0.5);
+   unsigned block_align = header->channels * sizeof(int16_t);
+   uint64_t data_size   = audio_frames * block_align;
+
+   if (data_size > UINT32_MAX - 36)
+      data_size = (UINT32_MAX - 36) / block_align * block_align;
+
+   return fwrite("RIFF", 1, 4, file) == 4 &&
+      write_le32(file, (uint32_t)(36 + data_size)) &&
+      fwrite("WAVEfmt ", 1, 8, file) == 8 &&
+      write_le32(file, 16) &&
+      write_le16(file, 1) &&
+      write_le16(file, header->channels) &&
+      write_le32(file, rate) &&
+      write_le32(file, rate * block_align) &&
+      write_le16(file, block_align) &&
+      write_le16(file, 16) &&
+      fwrite("data", 1, 4, file) == 4 &&
+      write_le32(file, (uint32_t)data_size);
+}
+
+static int cmd_info(rcap_reader_t *reader)
+{
+   const struct rcap_header *header = rcap_reader_header(reader);
+   const struct rcap_info *info     = rcap_reader_info(reader);
+
+   printf("Pixel format:  %s\n", pix_fmt_name(header));
+   printf("Size:          %ux%u (aspect %.4f), frames up to %ux%u\n",
+         header->width, header->height, header->aspect_ratio,
+         info->max_width, info->max_height);
+   printf("Frame rate:    %.4f\n", header->fps);
+   printf("Audio:         %u channels @ %.4f Hz\n",
+         header->channels, header->samplerate);
+   printf("Frames:        %u (%u keyframes)\n",
+         info->frames, info->keyframes);
+   printf("Audio frames:  %llu\n", (unsigned long long)info->audio_frames);
+   if (header->fps > 0.0)
+      printf("Duration:      %.3f s\n", info->frames / header->fps);
+   if (!info->indexed)
+      printf("Index:         missing, capture was not closed properly\n");
+
+   return 0;
+}
+
+/* Decodes every frame, which checks it against its CRC.
+ * With @list, prints the CRC of every frame, so two
+ * captures of the same input can be compared with diff. */
+static int cmd_verify(rcap_reader_t *reader, bool list)
+{
+   struct rcap_packet packet;
+   enum rcap_packet_type type;
+   unsigned frames       = 0;
+   uint64_t audio_frames = 0;
+
+   while ((type = rcap_reader_next(reader, &packet)) > RCAP_PACKET_END)
+   {
+      if (type == RCAP_PACKET_AUDIO)
+      {
+         audio_frames += packet.frames;
+         continue;
+      }
+
+      if (list)
+         printf("%u %ux%u %08x\n", packet.frame,
+               packet.width, packet.height, packet.crc);
+      frames++;
+   }
+
+   if (type == RCAP_PACKET_ERROR)
+   {
+      fprintf(stderr, "Capture is corrupt after frame %u.\n", frames);
+      return 1;
+   }
+
+   if (!list)
+      printf("OK: %u frames, %llu audio frames.\n",
+            frames, (unsigned long long)audio_frames);
+
+   return 0;
+}
+
+static int write_video(rcap_reader_t *reader, FILE *out)
+{
+   struct rcap_packet packet;
+   enum rcap_packet_type type;
+   unsigned width, height;
+   unsigned pix_size = rcap_pix_size(rcap_reader_header(reader)->pix_fmt);
+   uint8_t *canvas   = NULL;
+   size_t size;
+   int ret           = 1;
+
+   canvas_size(reader, &width, &height);
+   size   = (size_t)width * height * pix_size;
+   canvas = (uint8_t*)malloc(size ? size : 1);
+   if (!canvas)
+      return 1;
+
+   while ((type = rcap_reader_next(reader, &packet)) > RCAP_PACKET_END)
+   {
+      const void *frame = packet.data;
+
+      if (type != RCAP_PACKET_VIDEO)
+         continue;
+
+      if (packet.width != width || packet.height != height)
+      {
+         blit_frame(canvas, width, height, pix_size, &packet);
+         frame = canvas;
+      }
+
+      if (fwrite(frame, 1, size, out) != size)
+      {
+         fprintf(stderr, "Failed to write frame %u.\n", packet.frame);
+         goto end;
+      }
+   }
+
+   if (type == RCAP_PACKET_ERROR)
+      fprintf(stderr, "Capture is corrupt, output is incomplete.\n");
+   else
+      ret = 0;
+
+end:
+   free(canvas);
+   return ret;
+}
+
+static int write_audio(rcap_reader_t *reader, const char *path)
+{
+   struct rcap_packet packet;
+   enum rcap_packet_type type;
+   const struct rcap_header *header = rcap_reader_header(reader);
+   FILE *out = fopen(path, "wb");
+   int ret   = 1;
+
+   if (!out)
+   {
+      fprintf(stderr, "Failed to create \"%s\".\n", path);
+      return 1;
+   }
+
+   if (!write_wav_header(out, header, rcap_reader_info(reader)->audio_frames))
+      goto end;
+
+   while ((type = rcap_reader_next(reader, &packet)) > RCAP_PACKET_END)
+   {
+      size_t i, samples = packet.frames * header->channels;
+
+      if (type != RCAP_PACKET_AUDIO)
+         continue;
+
+      if (header->flags & RCAP_FLAG_BIG_ENDIAN)
+      {
+         for (i = 0; i < samples; i++)
+            if (!write_le16(out, (uint16_t)packet.samples[i]))
+               goto end;
+      }
+      else if (fwrite(packet.samples, sizeof(int16_t), samples, out)
+            != samples)
+         goto end;
+   }
+
+   if (type == RCAP_PACKET_ERROR)
+      fprintf(stderr, "Capture is corrupt, output is incomplete.\n");
+   else
+      ret = 0;
+
+end:
+   if (fclose(out) != 0)
+      ret = 1;
+   if (ret)
+      fprintf(stderr, "Failed to write \"%s\".\n", path);
+   return ret;
+}
+
+static int cmd_video(rcap_reader_t *reader, const char *path)
+{
+   int ret;
+   FILE *out = NULL;
+
+   if (!strcmp(path, "-"))
+   {
+#ifdef _WIN32
+      _setmode(_fileno(stdout), _O_BINARY);
+#endif
+      return write_video(reader, stdout);
+   }
+
+   out = fopen(path, "wb");
+   if (!out)
+   {
+      fprintf(stderr, "Failed to create \"%s\".\n", path);
+      return 1;
+   }
+
+   ret = write_video(reader, out);
+   if (fclose(out) != 0)
+      ret = 1;
+   return ret;
+}
+
+/* Appends @arg to @cmd, quoted for the shell. */
+static bool append_arg(char *cmd, size_t size, const char *arg)
+{
+   size_t len = strlen(cmd);
+
+   if (len + 3 >= size)
+      return false;
+
+   cmd[len++] = ' ';
+   cmd[len++] = RCAP_QUOTE[0];
+
+   for (; *arg; arg++)
+   {
+#ifndef _WIN32
+      if (*arg == '\'')
+      {
+         if (len + 5 >= size)
+            return false;
+         memcpy(cmd + len, "'\\''", 4);
+         len += 4;
+         continue;
+      }
+#endif
+      if (len + 2 >= size)
+         return false;
+      cmd[len++] = *arg;
+   }
+
+   cmd[len++] = RCAP_QUOTE[0];
+   cmd[len]   = '\0';
+   return true;
+}
+
+/* Pipes the frames into the ffmpeg program, together with
+ * the audio, which is written to a temporary WAV file first. */
+static int cmd_transcode(rcap_reader_t *reader, const char *output,
+      int argc, char *argv[])
+{
+   int i;
+   unsigned width, height;
+   char cmd[8192]  = "ffmpeg -y -loglevel warning";
+   char arg[64];
+   char wav[4096];
+   FILE *pipe      = NULL;
+   int ret         = 1;
+   const struct rcap_header *header = rcap_reader_header(reader);
+   bool has_audio  = rcap_reader_info(reader)->audio_frames > 0;
+
+   canvas_size(reader, &width, &height);
+   if (!width || !height)
+   {
+      fprintf(stderr, "Capture has no video.\n");
+      return 1;
+   }
+
+   snprintf(wav, sizeof(wav), "%s.audio.wav", output);
+
+   if (has_audio)
+   {
+      if (write_audio(reader, wav) != 0)
+         goto end;
+      if (!rcap_reader_seek(reader, 0, NULL))
+      {
+         fprintf(stderr, "Failed to rewind capture.\n");
+         goto end;
+      }
+   }
+
+   append_arg(cmd, sizeof(cmd), "-f");
+   append_arg(cmd, sizeof(cmd), "rawvideo");
+   append_arg(cmd, sizeof(cmd), "-pixel_format");
+   append_arg(cmd, sizeof(cmd), pix_fmt_name(header));
+   snprintf(arg, sizeof(arg), "%ux%u", width, height);
+   append_arg(cmd, sizeof(cmd), "-video_size");
+   append_arg(cmd, sizeof(cmd), arg);
+   snprintf(arg, sizeof(arg), "%.6f", header->fps);
+   append_arg(cmd, sizeof(cmd), "-framerate");
+   append_arg(cmd, sizeof(cmd), arg);
+   append_arg(cmd, sizeof(cmd), "-i");
+   append_arg(cmd, sizeof(cmd), "-");
+
+   if (has_audio)
+   {
+      append_arg(cmd, sizeof(cmd), "-i");
+      append_arg(cmd, sizeof(cmd), wav);
+   }
+
+   if (header->aspect_ratio > 0.0)
+   {
+      snprintf(arg, sizeof(arg), "%.6f", header->aspect_ratio);
+      append_arg(cmd, sizeof(cmd), "-aspect");
+      append_arg(cmd, sizeof(cmd), arg);
+   }
+
+   for (i = 0; i < argc; i++)
+      append_arg(cmd, sizeof(cmd), argv[i]);
+
+   if (!append_arg(cmd, sizeof(cmd), output))
+   {
+      fprintf(stderr, "Command line too long.\n");
+      goto end;
+   }
+
+#ifdef _WIN32
+   pipe = popen(cmd, "wb");
+#else
+   pipe = popen(cmd, "w");
+#endif
+   if (!pipe)
+   {
+      fprintf(stderr, "Failed to run: %s\n", cmd);
+      goto end;
+   }
+
+   ret = write_video(reader, pipe);
+   if (pclose(pipe) != 0)
+   {
+      fprintf(stderr, "ffmpeg failed: %s\n", cmd);
+      ret = 1;
+   }
+
+end:
+   if (has_audio)
+      remove(wav);
+   return ret;
+}
+
+static void print_usage(const char *argv0)
+{
+   fprintf(stderr, "Usage: %s <command> <capture> [args]\n\n", argv0);
+   fprintf(stderr, "Commands:\n");
+   fprintf(stderr, "\tinfo                     Shows stream parameters.\n");
+   fprintf(stderr, "\tverify                   Decodes and checks every frame.\n");
+   fprintf(stderr, "\tcrc                      Prints the CRC32 of every frame.\n");
+   fprintf(stderr, "\tvideo <file|->           Writes raw frames.\n");
+   fprintf(stderr, "\taudio <file.wav>         Writes audio as WAV.\n");
+   fprintf(stderr, "\ttranscode <file> [opts]  Converts with the ffmpeg program,\n"
+         "\t                         passing on options for the output.\n");
+}
+
+int main(int argc, char *argv[])
+{
+   int ret;
+   const char *cmd       = NULL;
+   rcap_reader_t *reader = NULL;
+
+   if (argc < 3)
+   {
+      print_usage(argv[0]);
+      return 1;
+   }
+
+   cmd    = argv[1];
+   reader = rcap_reader_open(argv[2]);
+   if (!reader)
+   {
+      fprintf(stderr, "Failed to open capture \"%s\".\n", argv[2]);
+      return 1;
+   }
+
+   if (!strcmp(cmd, "info"))
+      ret = cmd_info(reader);
+   else if (!strcmp(cmd, "verify"))
+      ret = cmd_verify(reader, false);
+   else if (!strcmp(cmd, "crc"))
+      ret = cmd_verify(reader, true);
+   else if (!strcmp(cmd, "video") && argc == 4)
+      ret = cmd_video(reader, argv[3]);
+   else if (!strcmp(cmd, "audio") && argc == 4)
+      ret = write_audio(reader, argv[3]);
+   else if (!strcmp(cmd, "transcode") && argc >= 4)
+      ret = cmd_transcode(reader, argv[3], argc - 4, argv + 4);
+   else
+   {
+      print_usage(argv[0]);
+      ret = 1;
+   }
+
+   rcap_reader_close(reader);
+   return ret;
+}
@@ -50,3 +50,7 @@ bool screenshot_dump(const char *folder, const void *frame,
 
    return false;
 }
+
+void screenshot_deinit(void)
+{
+}